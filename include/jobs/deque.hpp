@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @brief Work-stealing deque used by the job scheduler.
+ */
+#pragma once
+
+#include <utils/array.hpp>
+
+#include <atomic>
+
+namespace jobs
+{
+    /// @brief Bounded Chase-Lev work-stealing deque.
+    /// @tparam type The type of the elements, usually a pointer.
+    ///
+    /// The owner thread pushes and pops at the bottom, without contention in the common
+    /// case, while any other thread can steal from the top. The capacity is a power of two
+    /// fixed at construction: push fails instead of growing, so the owner can run the work
+    /// inline when the deque overflows.
+    ///
+    /// The memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory
+    /// Models" (Lê, Pop, Cohen, Zappa Nardelli).
+    template<typename type>
+    class work_stealing_deque
+    {
+    public:
+        /** The type of the elements of the deque. */
+        typedef type value_type;
+
+        /** The type of the deque. */
+        typedef work_stealing_deque<value_type> work_stealing_deque_type;
+
+        static_assert(::std::is_trivially_copyable_v<value_type>, "work_stealing_deque needs trivially copyable elements");
+
+        /// @brief Constructs an empty deque.
+        /// @param capacity The minimum capacity of the deque, rounded up to a power of two.
+        inline work_stealing_deque(usize capacity) noexcept :
+            slots(round_capacity(capacity)), mask(slots.size() - 1), top(0), bottom(0)
+        {
+            for(usize i = 0; i != slots.size(); i++)
+                new (&slots[i]) ::std::atomic<value_type>();
+        }
+
+        work_stealing_deque(const work_stealing_deque_type&) = delete;
+        work_stealing_deque_type& operator=(const work_stealing_deque_type&) = delete;
+
+        /// @brief Pushes an element at the bottom of the deque. Owner only.
+        /// @param value The element to push.
+        /// @return true if the element was pushed, false if the deque is full.
+        inline bool push(value_type value) noexcept
+        {
+            i64 b = bottom.load(::std::memory_order_relaxed);
+            i64 t = top.load(::std::memory_order_acquire);
+            if(b - t > static_cast<i64>(mask))
+                return false;
+
+            slots[b & mask].store(value, ::std::memory_order_relaxed);
+            ::std::atomic_thread_fence(::std::memory_order_release);
+            bottom.store(b + 1, ::std::memory_order_relaxed);
+            return true;
+        }
+
+        /// @brief Pops the element at the bottom of the deque. Owner only.
+        /// @param out The object that receives the popped element.
+        /// @return true if an element was popped, false if the deque is empty.
+        inline bool pop(value_type& out) noexcept
+        {
+            i64 b = bottom.load(::std::memory_order_relaxed) - 1;
+            bottom.store(b, ::std::memory_order_relaxed);
+            ::std::atomic_thread_fence(::std::memory_order_seq_cst);
+            i64 t = top.load(::std::memory_order_relaxed);
+
+            if(t > b)
+            {
+                bottom.store(b + 1, ::std::memory_order_relaxed);
+                return false;
+            }
+
+            out = slots[b & mask].load(::std::memory_order_relaxed);
+            if(t == b)
+            {
+                bool won = top.compare_exchange_strong(t, t + 1, ::std::memory_order_seq_cst, ::std::memory_order_relaxed);
+                bottom.store(b + 1, ::std::memory_order_relaxed);
+                return won;
+            }
+
+            return true;
+        }
+
+        /// @brief Steals the element at the top of the deque. Any thread.
+        /// @param out The object that receives the stolen element.
+        /// @return true if an element was stolen, false if the deque is empty or another thief won the race.
+        inline bool steal(value_type& out) noexcept
+        {
+            i64 t = top.load(::std::memory_order_acquire);
+            ::std::atomic_thread_fence(::std::memory_order_seq_cst);
+            i64 b = bottom.load(::std::memory_order_acquire);
+
+            if(t >= b)
+                return false;
+
+            out = slots[t & mask].load(::std::memory_order_relaxed);
+            return top.compare_exchange_strong(t, t + 1, ::std::memory_order_seq_cst, ::std::memory_order_relaxed);
+        }
+
+        /// @brief Returns an estimate of the number of elements in the deque.
+        /// @return The number of elements in the deque at some recent point in time.
+        inline usize size_approx() const noexcept
+        {
+            i64 b = bottom.load(::std::memory_order_relaxed);
+            i64 t = top.load(::std::memory_order_relaxed);
+            return b > t ? static_cast<usize>(b - t) : 0;
+        }
+
+        /// @brief Returns the capacity of the deque.
+        /// @return The maximum number of elements in the deque.
+        inline usize capacity() const noexcept { return slots.size(); }
+
+    private:
+        static inline usize round_capacity(usize n) noexcept
+        {
+            usize capacity = 2;
+            while(capacity < n)
+                capacity <<= 1;
+            return capacity;
+        }
+
+    private:
+        utils::buffer<::std::atomic<value_type>> slots;
+        usize mask;
+
+        alignas(utils::cache_line_size) ::std::atomic<i64> top;
+        alignas(utils::cache_line_size) ::std::atomic<i64> bottom;
+    };
+};
@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Graphs of jobs with dependencies between them.
+ */
+#pragma once
+
+#include "scheduler.hpp"
+
+#include <utils/arena.hpp>
+
+namespace jobs
+{
+    /// @brief A directed acyclic graph of jobs, run on a scheduler.
+    ///
+    /// Nodes live in a basic_arena and keep their successors in a utils::array. Every node
+    /// has an atomic counter of unfinished dependencies: when a node finishes, it decrements
+    /// the counters of its successors and submits the ones that reach zero, so no lock is
+    /// ever taken while the graph runs.
+    ///
+    /// A graph is built once and can be run any number of times, for example once per
+    /// frame. It must not be modified while it runs.
+    class task_graph
+    {
+    public:
+        /** The type of the index of a node. */
+        typedef u32 node_index;
+
+        /// @brief Constructs an empty graph.
+        task_graph() noexcept;
+
+        task_graph(const task_graph&) = delete;
+        task_graph& operator=(const task_graph&) = delete;
+
+        /// @brief Reserves space for some number of nodes.
+        /// @param n The number of nodes to reserve.
+        inline void reserve(usize n) noexcept { nodes.reserve(n); }
+
+        /// @brief Adds a node to the graph.
+        /// @param function The function run by the node.
+        /// @param data User data passed to the function.
+        /// @param begin The beginning of the range of work of the node.
+        /// @param end The end of the range of work of the node.
+        /// @return The index of the new node.
+        node_index add(job::function_type function, void* data = nullptr, usize begin = 0, usize end = 0) noexcept;
+
+        /// @brief Adds a node that calls a function object.
+        /// @param f The function object, called with no arguments. It must outlive every run of the graph.
+        /// @return The index of the new node.
+        template<typename function>
+        inline node_index add(function& f) noexcept
+        {
+            return add(&invoke<function>, static_cast<void*>(&f));
+        }
+
+        /// @brief Makes a node run before another one.
+        /// @param before The node that must finish first.
+        /// @param after The node that depends on before.
+        void precede(node_index before, node_index after) noexcept;
+
+        /// @brief Removes all the nodes from the graph.
+        void clear() noexcept;
+
+        /// @brief Starts running the graph.
+        /// @param s The scheduler that runs the nodes.
+        /// @param group The counter that reaches zero once every node has finished.
+        void submit(scheduler& s, counter& group) noexcept;
+
+        /// @brief Runs the graph, returning once every node has finished.
+        /// @param s The scheduler that runs the nodes.
+        ///
+        /// The calling thread runs jobs while waiting.
+        void run(scheduler& s) noexcept;
+
+        /// @brief Returns the number of nodes in the graph.
+        /// @return The number of nodes in the graph.
+        inline usize size() const noexcept { return nodes.size(); }
+
+        /// @brief Returns the number of dependencies of a node.
+        /// @param i The index of the node.
+        /// @return The number of nodes that must finish before node i.
+        inline usize dependencies(node_index i) const noexcept { return nodes[i].dependencies; }
+
+        /// @brief Returns the successors of a node.
+        /// @param i The index of the node.
+        /// @return A const span over the nodes that depend on node i.
+        inline utils::const_span<node_index> successors(node_index i) const noexcept { return nodes[i].successors; }
+
+    private:
+        struct node
+        {
+            node(const job& work) noexcept;
+            node(node&& other) noexcept;
+            node& operator=(node&& other) noexcept;
+
+            job work;
+            job task;
+            utils::array<node_index> successors;
+            u32 dependencies;
+            ::std::atomic<u32> remaining;
+        };
+
+        template<typename function>
+        static inline void invoke(job& j) noexcept
+        {
+            (*static_cast<function*>(j.data))();
+        }
+
+        static void execute(job& j) noexcept;
+
+    private:
+        utils::basic_arena<node> nodes;
+        scheduler* running;
+    };
+};
@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief Basic units of work run by the job scheduler.
+ */
+#pragma once
+
+#include <utils/type.hpp>
+
+#include <atomic>
+
+namespace jobs
+{
+    /// @brief Counts the jobs that are still pending in a group.
+    ///
+    /// Every job submitted with a counter increments it, and decrements it once it has
+    /// finished running. Waiting on a counter means waiting for it to reach zero.
+    class counter
+    {
+    public:
+        /// @brief Constructs a counter with no pending jobs.
+        inline counter() noexcept :
+            pending(0)
+        {
+        }
+
+        counter(const counter&) = delete;
+        counter& operator=(const counter&) = delete;
+
+        /// @brief Adds pending jobs to the counter.
+        /// @param n The number of jobs to add.
+        inline void add(usize n = 1) noexcept { pending.fetch_add(n, ::std::memory_order_relaxed); }
+
+        /// @brief Marks pending jobs as finished.
+        /// @param n The number of jobs that finished.
+        /// @return true if this was the last pending job, false otherwise.
+        inline bool done(usize n = 1) noexcept { return pending.fetch_sub(n, ::std::memory_order_acq_rel) == n; }
+
+        /// @brief Checks if all the jobs counted have finished.
+        /// @return true if there are no pending jobs, false otherwise.
+        inline bool finished() const noexcept { return pending.load(::std::memory_order_acquire) == 0; }
+
+        /// @brief Returns the number of pending jobs.
+        /// @return The number of pending jobs.
+        inline usize size() const noexcept { return pending.load(::std::memory_order_relaxed); }
+
+    private:
+        ::std::atomic<usize> pending;
+    };
+
+    /// @brief A unit of work.
+    ///
+    /// Jobs are plain data: a function pointer and its arguments. The scheduler only keeps
+    /// pointers to submitted jobs, so a job must stay alive until it has run, which is
+    /// usually guaranteed by waiting on its counter from the frame that owns it.
+    class job
+    {
+    public:
+        /** The type of the function run by a job. */
+        typedef void (*function_type)(job& self);
+
+        /// @brief Constructs an empty job.
+        inline job() noexcept :
+            function(nullptr), data(nullptr), begin(0), end(0), group(nullptr)
+        {
+        }
+
+        /// @brief Constructs a job.
+        /// @param function The function to run.
+        /// @param data User data passed to the function through the job.
+        /// @param begin The beginning of the range of work of the job.
+        /// @param end The end of the range of work of the job.
+        inline job(function_type function, void* data = nullptr, usize begin = 0, usize end = 0) noexcept :
+            function(function), data(data), begin(begin), end(end), group(nullptr)
+        {
+        }
+
+        /// @brief Runs the job and marks it as finished in its counter.
+        ///
+        /// The job itself isn't touched after its counter is decremented, so the owner of
+        /// the job may destroy it as soon as the counter reaches zero.
+        inline void run() noexcept
+        {
+            counter* c = group;
+            function(*this);
+            if(c != nullptr)
+                c->done();
+        }
+
+    public:
+        /** The function run by the job. */
+        function_type function;
+        /** User data for the function. */
+        void* data;
+        /** The beginning of the range of work of the job. */
+        usize begin;
+        /** The end of the range of work of the job. */
+        usize end;
+        /** The counter notified when the job finishes, set by the scheduler on submission. */
+        counter* group;
+    };
+};
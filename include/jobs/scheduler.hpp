@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @brief Work-stealing job scheduler.
+ */
+#pragma once
+
+#include "deque.hpp"
+#include "job.hpp"
+
+#include <utils/concurrent_queue.hpp>
+
+#include <thread>
+
+namespace jobs
+{
+    /// @brief A fixed pool of worker threads that run jobs.
+    ///
+    /// Every worker owns a work_stealing_deque. Jobs submitted from a worker go to the
+    /// bottom of its own deque, and idle workers steal from the top of the others' deques.
+    /// Jobs submitted from any other thread go through a shared injection queue.
+    ///
+    /// Waiting is never blocking: a thread that waits on a counter keeps running jobs
+    /// until the counter reaches zero, so nested parallelism can't deadlock the pool.
+    class scheduler
+    {
+    public:
+        /** The capacity of the deque of every worker. */
+        static constexpr usize deque_capacity = 4096;
+        /** The capacity of the queue of jobs submitted from outside the workers. */
+        static constexpr usize injection_capacity = 8192;
+        /** The number of chunks parallel_for aims for on every thread, when sizing grains automatically. */
+        static constexpr usize chunks_per_thread = 4;
+
+        /// @brief Starts the worker threads.
+        /// @param workers The number of worker threads, or 0 to use one less than the number of hardware threads.
+        scheduler(usize workers = 0) noexcept;
+
+        scheduler(const scheduler&) = delete;
+        scheduler& operator=(const scheduler&) = delete;
+
+        /// @brief Stops and joins the worker threads.
+        ///
+        /// All the jobs submitted must have finished beforehand.
+        ~scheduler() noexcept;
+
+        /// @brief Submits a job.
+        /// @param j The job to run. It must stay alive until group reports it finished.
+        /// @param group The counter notified when the job finishes.
+        void submit(job& j, counter& group) noexcept;
+
+        /// @brief Submits a job without tracking when it finishes.
+        /// @param j The job to run. It must stay alive until it has run.
+        ///
+        /// Useful for jobs that signal their completion on their own, like resuming a
+        /// coroutine.
+        void submit(job& j) noexcept;
+
+        /// @brief Submits many jobs.
+        /// @param js The jobs to run. They must stay alive until group reports them finished.
+        /// @param group The counter notified when each job finishes.
+        void submit(utils::span<job> js, counter& group) noexcept;
+
+        /// @brief Runs jobs until a counter reaches zero.
+        /// @param group The counter to wait on.
+        void wait(const counter& group) noexcept;
+
+        /// @brief Tries to find a job and run it.
+        /// @return true if a job was run, false if no work was found.
+        bool run_one() noexcept;
+
+        /// @brief Returns the number of worker threads.
+        /// @return The number of worker threads.
+        inline usize worker_count() const noexcept { return workers.size(); }
+
+        /// @brief Returns the number of threads that run jobs, i.e. the workers and a waiting thread.
+        /// @return The number of threads that run jobs.
+        inline usize thread_count() const noexcept { return workers.size() + 1; }
+
+        /// @brief Calculates a grain size for splitting a range of work over all the threads.
+        /// @param count The size of the range.
+        /// @return The number of elements handled by a single job.
+        inline usize default_grain(usize count) const noexcept
+        {
+            usize chunks = thread_count() * chunks_per_thread;
+            return count / chunks != 0 ? count / chunks : 1;
+        }
+
+        /// @brief Runs a function over a range of indices in parallel.
+        /// @param count The size of the range [0, count).
+        /// @param f The function, called as f(begin, end) for disjoint subranges covering the range.
+        /// @param grain The size of every subrange, or 0 to choose it automatically.
+        ///
+        /// Returns once f has been called on the whole range. The calling thread runs jobs
+        /// while waiting.
+        template<typename function>
+        inline void parallel_for(usize count, function&& f, usize grain = 0) noexcept
+        {
+            if(count == 0)
+                return;
+
+            if(grain == 0)
+                grain = default_grain(count);
+
+            usize chunks = (count + grain - 1) / grain;
+            if(chunks == 1)
+            {
+                f(usize(0), count);
+                return;
+            }
+
+            utils::array<job> batch(chunks);
+            for(usize i = 0; i != chunks; i++)
+                batch.push_unchecked(&invoke_range<::std::remove_reference_t<function>>, const_cast<void*>(static_cast<const void*>(&f)),
+                                     i * grain, ::std::min(count, (i + 1) * grain));
+
+            counter group;
+            submit(batch.suffix(chunks - 1), group);
+            batch[0].run();
+            wait(group);
+        }
+
+        /// @brief Runs a function on every element of a span in parallel.
+        /// @param items The elements.
+        /// @param f The function, called as f(item) once for every element.
+        /// @param grain The number of elements handled by a single job, or 0 to choose it automatically.
+        template<typename type, typename function>
+        inline void parallel_for(utils::span<type> items, function&& f, usize grain = 0) noexcept
+        {
+            parallel_for(items.size(), [&items, &f](usize begin, usize end) {
+                for(usize i = begin; i != end; i++)
+                    f(items[i]);
+            }, grain);
+        }
+
+        /// @brief Returns the scheduler the calling thread is a worker of.
+        /// @return The scheduler of the calling worker thread, or nullptr if the thread isn't a worker.
+        static scheduler* current() noexcept;
+
+    private:
+        struct worker
+        {
+            inline worker() noexcept :
+                deque(deque_capacity), thread()
+            {
+            }
+
+            work_stealing_deque<job*> deque;
+            ::std::thread thread;
+        };
+
+        template<typename function>
+        static inline void invoke_range(job& j) noexcept
+        {
+            (*static_cast<function*>(j.data))(j.begin, j.end);
+        }
+
+        void work(usize index) noexcept;
+        void push(job* j) noexcept;
+        void wake(usize n) noexcept;
+        bool steal(job*& j) noexcept;
+
+    private:
+        utils::array<worker> workers;
+        utils::mpmc_queue<job*> injected;
+
+        alignas(utils::cache_line_size) ::std::atomic<u32> epoch;
+        ::std::atomic<u32> sleeping;
+        ::std::atomic<bool> stopping;
+    };
+};
@@ -0,0 +1,328 @@
+/**
+ * @file
+ * @brief Coroutine tasks that run on the job scheduler.
+ */
+#pragma once
+
+#include "scheduler.hpp"
+
+#include <coroutine>
+#include <exception>
+
+namespace jobs
+{
+    /// @brief Allocates memory for a coroutine frame.
+    /// @param n The size of the frame in bytes.
+    /// @return Pointer to the frame memory.
+    ///
+    /// Frames are served from per-thread free lists of a few size classes, falling back
+    /// to the global heap only for large frames or when the free lists are empty.
+    void* allocate_frame(usize n) noexcept;
+
+    /// @brief Deallocates memory previously returned by allocate_frame.
+    /// @param ptr Pointer to the frame memory.
+    /// @param n The size of the frame in bytes, as passed to allocate_frame.
+    void deallocate_frame(void* ptr, usize n) noexcept;
+
+    template<typename type>
+    class task;
+
+    namespace __detail
+    {
+        namespace __task
+        {
+            /// @brief Awaiter run when a task finishes, transferring control to whoever waits on it.
+            struct final_awaiter
+            {
+                inline bool await_ready() const noexcept { return false; }
+
+                template<typename promise>
+                inline ::std::coroutine_handle<> await_suspend(::std::coroutine_handle<promise> h) noexcept
+                {
+                    promise& p = h.promise();
+
+                    counter* group = p.group;
+                    ::std::coroutine_handle<> continuation = p.continuation;
+
+                    if(p.pending != nullptr && p.pending->fetch_sub(1, ::std::memory_order_acq_rel) != 1)
+                        continuation = nullptr;
+
+                    if(group != nullptr)
+                        group->done();
+
+                    return continuation ? continuation : ::std::noop_coroutine();
+                }
+
+                inline void await_resume() const noexcept {}
+            };
+
+            /// @brief Part of the promise that doesn't depend on the result type.
+            struct promise_base
+            {
+                inline ::std::suspend_always initial_suspend() const noexcept { return {}; }
+                inline final_awaiter final_suspend() const noexcept { return {}; }
+                inline void unhandled_exception() const noexcept { ::std::terminate(); }
+
+                static inline void* operator new(usize n) { return allocate_frame(n); }
+                static inline void operator delete(void* ptr, usize n) noexcept { deallocate_frame(ptr, n); }
+
+                /** The coroutine resumed when this one finishes. */
+                ::std::coroutine_handle<> continuation = nullptr;
+                /** Counter of tasks left in a when_all; only the last one resumes the continuation. */
+                ::std::atomic<usize>* pending = nullptr;
+                /** Counter notified when the task finishes, used by sync_wait. */
+                counter* group = nullptr;
+            };
+
+            template<typename type>
+            struct promise : public promise_base
+            {
+                inline promise() noexcept {}
+                inline ~promise() noexcept
+                {
+                    if(has_value)
+                        value.~type();
+                }
+
+                task<type> get_return_object() noexcept;
+
+                template<typename other>
+                inline void return_value(other&& v) noexcept
+                {
+                    new (&value) type(::std::forward<other>(v));
+                    has_value = true;
+                }
+
+                union { type value; };
+                bool has_value = false;
+            };
+
+            template<>
+            struct promise<void> : public promise_base
+            {
+                task<void> get_return_object() noexcept;
+
+                inline void return_void() const noexcept {}
+            };
+        };
+    };
+
+    /// @brief A lazily started coroutine that produces a value.
+    /// @tparam type The type of the value produced, or void.
+    ///
+    /// A task doesn't start running until it's awaited (or passed to sync_wait or
+    /// when_all). Awaiting a task transfers control to it directly and it transfers control
+    /// back when it finishes (symmetric transfer), so long chains of tasks don't grow the
+    /// stack. Frames are allocated with allocate_frame instead of the global heap.
+    ///
+    /// A task runs on whatever thread resumes it; use schedule to move it to a scheduler.
+    template<typename type = void>
+    class task
+    {
+    public:
+        /** The type of the value produced by the task. */
+        typedef type value_type;
+        /** The promise type of the coroutine. */
+        typedef __detail::__task::promise<value_type> promise_type;
+        /** The type of the task. */
+        typedef task<value_type> task_type;
+
+        /// @brief Constructs a task with no coroutine.
+        inline task() noexcept :
+            handle(nullptr)
+        {
+        }
+
+        /// @brief Constructs a task that owns a coroutine.
+        /// @param handle The handle of the coroutine.
+        inline explicit task(::std::coroutine_handle<promise_type> handle) noexcept :
+            handle(handle)
+        {
+        }
+
+        /// @brief Move constructor.
+        /// @param other The task moved.
+        inline task(task_type&& other) noexcept :
+            handle(other.handle)
+        {
+            other.handle = nullptr;
+        }
+
+        task(const task_type&) = delete;
+        task_type& operator=(const task_type&) = delete;
+
+        /// @brief Destroys the coroutine frame, if any.
+        inline ~task() noexcept
+        {
+            if(handle)
+                handle.destroy();
+        }
+
+        /// @brief Move assignment.
+        /// @param other The task moved.
+        inline task_type& operator=(task_type&& other) noexcept
+        {
+            if(handle)
+                handle.destroy();
+
+            handle = other.handle;
+            other.handle = nullptr;
+            return *this;
+        }
+
+        /// @brief Checks if the task has finished running.
+        /// @return true if the coroutine finished, false otherwise.
+        inline bool done() const noexcept { return handle && handle.done(); }
+
+        /// @brief Returns the value produced by a finished task.
+        /// @return A reference to the value produced.
+        inline ::std::add_lvalue_reference_t<value_type> result() noexcept requires (!::std::is_void_v<value_type>) { return handle.promise().value; }
+
+        /// @brief Returns the handle of the coroutine.
+        /// @return The handle of the coroutine owned by the task.
+        inline ::std::coroutine_handle<promise_type> coroutine() const noexcept { return handle; }
+
+        /// @brief Awaits the task, starting it and resuming the awaiting coroutine once it finishes.
+        inline auto operator co_await() const noexcept
+        {
+            struct awaiter
+            {
+                ::std::coroutine_handle<promise_type> handle;
+
+                inline bool await_ready() const noexcept { return false; }
+
+                inline ::std::coroutine_handle<> await_suspend(::std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                inline decltype(auto) await_resume() noexcept
+                {
+                    if constexpr(!::std::is_void_v<value_type>)
+                        return ::std::move(handle.promise().value);
+                }
+            };
+
+            return awaiter { handle };
+        }
+
+    private:
+        ::std::coroutine_handle<promise_type> handle;
+    };
+
+    template<typename type> inline task<type> __detail::__task::promise<type>::get_return_object() noexcept
+    {
+        return task<type>(::std::coroutine_handle<promise<type>>::from_promise(*this));
+    }
+
+    inline task<void> __detail::__task::promise<void>::get_return_object() noexcept
+    {
+        return task<void>(::std::coroutine_handle<promise<void>>::from_promise(*this));
+    }
+
+    /// @brief Awaitable that moves the awaiting coroutine onto a scheduler.
+    ///
+    /// The coroutine is resumed by a job on one of the scheduler's threads. The job lives
+    /// in the awaiter, i.e. in the suspended coroutine's frame, so nothing is allocated.
+    class schedule_awaiter
+    {
+    public:
+        /// @brief Constructs the awaiter.
+        /// @param s The scheduler that resumes the coroutine.
+        inline explicit schedule_awaiter(scheduler& s) noexcept :
+            target(s), resume_job()
+        {
+        }
+
+        inline bool await_ready() const noexcept { return false; }
+
+        inline void await_suspend(::std::coroutine_handle<> h) noexcept
+        {
+            resume_job = job(&resume, h.address());
+            target.submit(resume_job);
+        }
+
+        inline void await_resume() const noexcept {}
+
+    private:
+        static inline void resume(job& j) noexcept
+        {
+            ::std::coroutine_handle<>::from_address(j.data).resume();
+        }
+
+    private:
+        scheduler& target;
+        job resume_job;
+    };
+
+    /// @brief Moves the awaiting coroutine onto a scheduler.
+    /// @param s The scheduler that resumes the coroutine.
+    /// @return An awaitable; co_await it to continue on one of the scheduler's threads.
+    inline schedule_awaiter schedule(scheduler& s) noexcept { return schedule_awaiter(s); }
+
+    /// @brief Awaitable that starts many tasks and resumes once all of them finished.
+    /// @tparam type The type of the values produced by the tasks.
+    ///
+    /// The tasks are started one after the other on the awaiting thread, each running until
+    /// its first suspension, so tasks that begin with co_await schedule(s) run in parallel.
+    /// The last task to finish resumes the awaiting coroutine. Results stay in the tasks.
+    template<typename type>
+    class when_all_awaiter
+    {
+    public:
+        /// @brief Constructs the awaiter.
+        /// @param tasks The tasks to run. They must not have been started.
+        inline explicit when_all_awaiter(utils::array<task<type>>& tasks) noexcept :
+            tasks(tasks), pending(0)
+        {
+        }
+
+        inline bool await_ready() const noexcept { return tasks.empty(); }
+
+        inline bool await_suspend(::std::coroutine_handle<> h) noexcept
+        {
+            // One extra count keeps the tasks that finish early from resuming h before
+            // all of them have been started.
+            pending.store(tasks.size() + 1, ::std::memory_order_relaxed);
+
+            for(task<type>& t : tasks)
+            {
+                typename task<type>::promise_type& p = t.coroutine().promise();
+                p.continuation = h;
+                p.pending = &pending;
+                t.coroutine().resume();
+            }
+
+            return pending.fetch_sub(1, ::std::memory_order_acq_rel) != 1;
+        }
+
+        inline void await_resume() const noexcept {}
+
+    private:
+        utils::array<task<type>>& tasks;
+        ::std::atomic<usize> pending;
+    };
+
+    /// @brief Runs many tasks concurrently.
+    /// @param tasks The tasks to run, which must not have been started.
+    /// @return An awaitable; co_await it to resume once every task finished.
+    template<typename type>
+    inline when_all_awaiter<type> when_all(utils::array<task<type>>& tasks) noexcept { return when_all_awaiter<type>(tasks); }
+
+    /// @brief Runs a task from outside any coroutine and waits for it to finish.
+    /// @param s The scheduler to help while waiting.
+    /// @param t The task to run, which must not have been started.
+    ///
+    /// The task starts on the calling thread. While it is suspended, the calling thread
+    /// runs jobs of the scheduler instead of blocking.
+    template<typename type>
+    inline void sync_wait(scheduler& s, task<type>& t) noexcept
+    {
+        counter group;
+        group.add(1);
+        t.coroutine().promise().group = &group;
+        t.coroutine().resume();
+        s.wait(group);
+    }
+};
@@ -102,6 +102,39 @@ namespace utils
             return top;
         }
 
+        /// @brief Creates many elements in the arena.
+        /// @param n The number of elements to create.
+        /// @param _args The arguments to use to construct each element in-place.
+        /// @return A const span over the indices of the constructed elements.
+        ///
+        /// Reserves space once for all n elements, then constructs them in a single pass.
+        /// The returned span views the arena's internal storage, so it is only valid until
+        /// the next call that modifies the arena.
+        template<typename... args>
+        inline const_span<usize> create_many(usize n, const args&... _args) noexcept
+        {
+            if(stack.size() < n)
+                resize(capacity_growth(n - stack.size()));
+
+            return create_many_unchecked(n, _args...);
+        }
+
+        /// @brief Creates many elements without checking for available space.
+        /// @param n The number of elements to create.
+        /// @param _args The arguments to use to construct each element in-place.
+        /// @return A const span over the indices of the constructed elements.
+        ///
+        /// The returned span is only valid until the next call that modifies the arena.
+        template<typename... args>
+        inline const_span<usize> create_many_unchecked(usize n, const args&... _args) noexcept
+        {
+            stack.pop_many(n);
+
+            const_span<usize> indices(stack.data() + stack.size(), n);
+            buffer.insert_many_unchecked(indices, _args...);
+            return indices;
+        }
+
         /// @brief Destroys an element.
         /// @param i The index of the element to destroy.
         inline void destroy(usize i) noexcept
@@ -118,6 +151,33 @@ namespace utils
             stack.push_unchecked(i);
         }
 
+        /// @brief Destroys many elements.
+        /// @param indices The indices of the elements to destroy.
+        ///
+        /// Indices that don't hold an element, or repeat an earlier one, are skipped: the
+        /// occupancy is cleared as the indices are checked, so it also marks the ones already
+        /// destroyed. The free indices always have room for every element, so the valid ones
+        /// are pushed in place, without allocating.
+        inline void destroy_many(const const_span<usize>& indices) noexcept
+        {
+            for(usize i : indices)
+                if(buffer.has(i))
+                {
+                    buffer.erase_unchecked(i);
+                    stack.push_unchecked(i);
+                }
+        }
+
+        /// @brief Destroys many elements without checking if they exist.
+        /// @param indices The indices of the elements to destroy.
+        ///
+        /// The indices must be distinct, and each one must hold an element.
+        inline void destroy_many_unchecked(const const_span<usize>& indices) noexcept
+        {
+            buffer.erase_many_unchecked(indices);
+            stack.push_many_unchecked(indices);
+        }
+
         /// @brief Clears the arena, destroying all its elements in the process.
         inline void clear() noexcept
         {
@@ -160,6 +220,28 @@ namespace utils
         /// @return A const reference to the element at index i.
         inline const value_type& operator[](usize i) const noexcept { return buffer[i]; }
 
+        /// @brief Returns the storage of the arena.
+        /// @return A const reference to the sparse array holding the elements at their indices.
+        inline const sparse_array<value_type, allocator_type>& storage() const noexcept { return buffer; }
+        /// @brief Returns the free indices.
+        /// @return A const span over the indices create hands out, the last one first.
+        inline const_span<usize> free_indices() const noexcept { return stack; }
+
+        /// @brief Replaces the contents of the arena with raw copies of its storage.
+        /// @param elements The slots, including the empty ones, whose bytes are copied as is.
+        /// @param occupied For every slot, true if it holds an element.
+        /// @param free The free indices, in the order of free_indices.
+        ///
+        /// The free indices must be exactly the empty slots, so that the arena hands out the
+        /// same indices as the one the contents were taken from.
+        inline void assign(const const_span<value_type>& elements, const const_span<bool>& occupied, const const_span<usize>& free) noexcept requires trivially_copyable<value_type>
+        {
+            buffer.assign(elements, occupied);
+            stack.clear();
+            stack.reserve_exactly(elements.size());
+            stack.push_many_unchecked(free);
+        }
+
     private:
         void resize(usize n) noexcept
         {
@@ -700,7 +700,7 @@ namespace utils
             if(buff.begin() + n > finish)
             {
                 if(buff.begin() + n > buff.end())
-                    resize(capacity_growth(buff.size() - n));
+                    resize(capacity_growth(n - size()));
 
                 n -= (finish - buff.begin());
                 
@@ -805,6 +805,34 @@ namespace utils
                 allocator_type::construct_at(finish++, *(current++));
         }
 
+        /// @brief Appends elements without initializing them.
+        /// @param n The number of elements to append.
+        /// @return A span over the new elements.
+        ///
+        /// Only available for trivially copyable types. The new elements hold garbage until
+        /// they are written, so the caller can fill them in place instead of pushing one
+        /// at a time. Just like push, checks if the array has enough space and resizes it
+        /// if needed.
+        inline span_type push_uninitialized(usize n) noexcept requires trivially_copyable<value_type>
+        {
+            if(finish + n > buff.end())
+                resize(capacity_growth(n));
+
+            return push_uninitialized_unchecked(n);
+        }
+
+        /// @brief Appends elements without initializing them.
+        /// @param n The number of elements to append.
+        /// @return A span over the new elements.
+        ///
+        /// Just like push_unchecked, doesn't check the capacity of the array.
+        inline span_type push_uninitialized_unchecked(usize n) noexcept requires trivially_copyable<value_type>
+        {
+            span_type span(finish, finish + n);
+            finish += n;
+            return span;
+        }
+
         /// @brief Pops the top element of the array.
         inline void pop() noexcept
         {
@@ -1018,7 +1046,7 @@ namespace utils
         inline sparse_array(usize capacity) noexcept :
             buff(capacity), bitset(capacity)
         {
-            bitset.push_many_unchecked(capacity, 0);
+            bitset.push_many_unchecked(0, capacity);
         }
 
         /// @brief Move constructor.
@@ -1146,6 +1174,25 @@ namespace utils
             return buff[i];
         }
 
+        /// @brief Inserts an object at each of the given indices.
+        /// @param indices The indices where to insert the objects.
+        /// @param _args The arguments to use for constructing each object in-place.
+        ///
+        /// Assumes that every index is within the capacity of the array and that no
+        /// element exists at any of them. The occupancy bits are set in one pass, and
+        /// the objects are constructed in a second one.
+        template<typename... args>
+        inline void insert_many_unchecked(const const_span<usize>& indices, const args&... _args) noexcept
+        {
+            bool* bits = bitset.data();
+            for(usize i : indices)
+                bits[i] = 1;
+
+            value_type* base = buff.begin();
+            for(usize i : indices)
+                allocator_type::construct_at(base + i, _args...);
+        }
+
         /// @brief Erases an element at an index, calling its destructor if needed.
         /// @param i The index of the element to erase.
         ///
@@ -1170,6 +1217,33 @@ namespace utils
             bitset[i] = 0;
         }
 
+        /// @brief Erases the elements at the given indices, calling their destructors if needed.
+        /// @param indices The indices of the elements to erase.
+        ///
+        /// Like erase_unchecked, doesn't check if the elements exist.
+        inline void erase_many_unchecked(const const_span<usize>& indices) noexcept
+        {
+            value_type* base = buff.begin();
+            for(usize i : indices)
+                allocator_type::destruct_at(base + i);
+
+            bool* bits = bitset.data();
+            for(usize i : indices)
+                bits[i] = 0;
+        }
+
+        /// @brief Erases the elements at the given indices, calling their destructors if needed.
+        /// @param indices The indices of the elements to erase.
+        ///
+        /// Like erase_unchecked, doesn't check if the elements exist. Specialized to
+        /// only clear the occupancy bits for trivially destructible types.
+        inline void erase_many_unchecked(const const_span<usize>& indices) noexcept requires trivially_destructible<value_type>
+        {
+            bool* bits = bitset.data();
+            for(usize i : indices)
+                bits[i] = 0;
+        }
+
         /// @brief Get the element at an index, inserting a default object if it doesn't exist.
         /// @param i The index of the element to return.
         /// @param _args The arguments to use for constructing the default object in-place.
@@ -1232,6 +1306,32 @@ namespace utils
         /// @return The capacity of the array.
         inline usize capacity() const noexcept { return buff.size(); }
 
+        /// @brief Returns the storage of the array, occupied or not.
+        /// @return A const span over the capacity() slots; the contents of empty slots are unspecified.
+        inline const_span<value_type> slots() const noexcept { return const_span<value_type>(buff.begin(), buff.size()); }
+        /// @brief Returns the occupancy of the slots.
+        /// @return A const span with, for every slot, true if it holds an element.
+        inline const_span<bool> occupancy() const noexcept { return bitset; }
+
+        /// @brief Replaces the contents of the array with raw copies of slots.
+        /// @param elements The slots, including the empty ones, whose bytes are copied as is.
+        /// @param occupied For every slot, true if it holds an element.
+        ///
+        /// The capacity becomes exactly the number of slots, and the whole storage is copied
+        /// at once, which is why the elements must be trivially copyable.
+        inline void assign(const const_span<value_type>& elements, const const_span<bool>& occupied) noexcept requires trivially_copyable<value_type>
+        {
+            clear_buffer();
+            if(buff.size() != elements.size())
+                buff = buffer_type(elements.size());
+
+            bitset.clear();
+            bitset.reserve_exactly(occupied.size());
+            bitset.push_many_unchecked(occupied);
+            if(!elements.empty())
+                ::std::memcpy(buff.begin(), elements.data(), elements.size() * sizeof(value_type));
+        }
+
         /// @brief Returns the element at index i.
         /// @param i The index of the element to return.
         /// @return The element at index i.
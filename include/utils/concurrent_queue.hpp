@@ -0,0 +1,433 @@
+/**
+ * @file
+ * @brief Bounded lock-free queues for passing objects between threads.
+ */
+#pragma once
+
+#include "array.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace utils
+{
+    /// @brief Bounded multi-producer multi-consumer lock-free queue.
+    /// @tparam type The type of the elements of the queue.
+    /// @tparam allocator The allocator to use to allocate its data.
+    ///
+    /// A ring of slots, each with its own sequence number that tells producers and consumers
+    /// whether the slot is free or full for their position in the queue (D. Vyukov's bounded
+    /// MPMC queue). Producers only contend on the enqueue position and consumers only on the
+    /// dequeue position, which live on separate cache lines. The capacity is rounded up to a
+    /// power of two and never changes.
+    template<typename type, typename allocator = basic_allocator<type>>
+    class mpmc_queue
+    {
+    public:
+        /** The type of the elements of the queue. */
+        typedef type value_type;
+        /** The type of the allocator of the queue. */
+        typedef allocator allocator_type;
+
+        /** The type of the queue. */
+        typedef mpmc_queue<value_type, allocator_type> mpmc_queue_type;
+
+        /** The type of a span of elements. */
+        typedef span<value_type> span_type;
+        /** The type of a const span of elements. */
+        typedef const_span<value_type> const_span_type;
+
+        /// @brief Constructs an empty queue.
+        /// @param capacity The minimum capacity of the queue, rounded up to a power of two.
+        inline mpmc_queue(usize capacity) noexcept :
+            slots(round_capacity(capacity)), mask(slots.size() - 1),
+            enqueue_pos(0), dequeue_pos(0)
+        {
+            for(usize i = 0; i != slots.size(); i++)
+                new (&slots[i].sequence) ::std::atomic<usize>(i);
+        }
+
+        mpmc_queue(const mpmc_queue_type&) = delete;
+        mpmc_queue_type& operator=(const mpmc_queue_type&) = delete;
+
+        /// @brief Destructor.
+        ///
+        /// Destroys the elements left in the queue. No other thread may use the queue
+        /// at this point.
+        inline ~mpmc_queue() noexcept
+        {
+            usize head = dequeue_pos.load(::std::memory_order_relaxed);
+            usize tail = enqueue_pos.load(::std::memory_order_relaxed);
+            for(; head != tail; head++)
+                allocator_type::destruct_at(slots[head & mask].get());
+        }
+
+        /// @brief Tries to push an element at the back of the queue.
+        /// @param _args The arguments to use to construct the element in-place.
+        /// @return true if the element was pushed, false if the queue is full.
+        template<typename... args>
+        inline bool try_push(args&&... _args) noexcept
+        {
+            usize pos = enqueue_pos.load(::std::memory_order_relaxed);
+            slot_type* slot;
+            for(;;)
+            {
+                slot = &slots[pos & mask];
+                usize sequence = slot->sequence.load(::std::memory_order_acquire);
+                size diff = static_cast<size>(sequence) - static_cast<size>(pos);
+
+                if(diff == 0)
+                {
+                    if(enqueue_pos.compare_exchange_weak(pos, pos + 1, ::std::memory_order_relaxed))
+                        break;
+                }
+                else if(diff < 0)
+                    return false;
+                else pos = enqueue_pos.load(::std::memory_order_relaxed);
+            }
+
+            allocator_type::construct_at(slot->get(), ::std::forward<args>(_args)...);
+            slot->sequence.store(pos + 1, ::std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Tries to pop the element at the front of the queue.
+        /// @param out The object that receives the popped element.
+        /// @return true if an element was popped, false if the queue is empty.
+        inline bool try_pop(value_type& out) noexcept
+        {
+            usize pos = dequeue_pos.load(::std::memory_order_relaxed);
+            slot_type* slot;
+            for(;;)
+            {
+                slot = &slots[pos & mask];
+                usize sequence = slot->sequence.load(::std::memory_order_acquire);
+                size diff = static_cast<size>(sequence) - static_cast<size>(pos + 1);
+
+                if(diff == 0)
+                {
+                    if(dequeue_pos.compare_exchange_weak(pos, pos + 1, ::std::memory_order_relaxed))
+                        break;
+                }
+                else if(diff < 0)
+                    return false;
+                else pos = dequeue_pos.load(::std::memory_order_relaxed);
+            }
+
+            out = ::std::move(*slot->get());
+            allocator_type::destruct_at(slot->get());
+            slot->sequence.store(pos + mask + 1, ::std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Tries to push copies of the elements of a span at the back of the queue.
+        /// @param values The elements to push.
+        /// @return The number of elements pushed, from the front of the span.
+        ///
+        /// Claims a run of consecutive free slots with a single atomic operation, so a
+        /// batch costs about as much contention as a single push.
+        inline usize try_push_many(const const_span_type& values) noexcept
+        {
+            if(values.empty())
+                return 0;
+
+            usize pos = enqueue_pos.load(::std::memory_order_relaxed);
+            usize n;
+            for(;;)
+            {
+                n = 0;
+                usize limit = ::std::min(values.size(), slots.size());
+                while(n != limit && slots[(pos + n) & mask].sequence.load(::std::memory_order_acquire) == pos + n)
+                    n++;
+
+                if(n != 0)
+                {
+                    if(enqueue_pos.compare_exchange_weak(pos, pos + n, ::std::memory_order_relaxed))
+                        break;
+                }
+                else
+                {
+                    size diff = static_cast<size>(slots[pos & mask].sequence.load(::std::memory_order_acquire)) - static_cast<size>(pos);
+                    if(diff < 0)
+                        return 0;
+                    pos = enqueue_pos.load(::std::memory_order_relaxed);
+                }
+            }
+
+            for(usize i = 0; i != n; i++)
+            {
+                slot_type& slot = slots[(pos + i) & mask];
+                allocator_type::construct_at(slot.get(), values[i]);
+                slot.sequence.store(pos + i + 1, ::std::memory_order_release);
+            }
+            return n;
+        }
+
+        /// @brief Tries to pop elements from the front of the queue into a span.
+        /// @param out The span that receives the popped elements.
+        /// @return The number of elements popped, written at the front of the span.
+        inline usize try_pop_many(const span_type& out) noexcept
+        {
+            if(out.empty())
+                return 0;
+
+            usize pos = dequeue_pos.load(::std::memory_order_relaxed);
+            usize n;
+            for(;;)
+            {
+                n = 0;
+                usize limit = ::std::min(out.size(), slots.size());
+                while(n != limit && slots[(pos + n) & mask].sequence.load(::std::memory_order_acquire) == pos + n + 1)
+                    n++;
+
+                if(n != 0)
+                {
+                    if(dequeue_pos.compare_exchange_weak(pos, pos + n, ::std::memory_order_relaxed))
+                        break;
+                }
+                else
+                {
+                    size diff = static_cast<size>(slots[pos & mask].sequence.load(::std::memory_order_acquire)) - static_cast<size>(pos + 1);
+                    if(diff < 0)
+                        return 0;
+                    pos = dequeue_pos.load(::std::memory_order_relaxed);
+                }
+            }
+
+            for(usize i = 0; i != n; i++)
+            {
+                slot_type& slot = slots[(pos + i) & mask];
+                out[i] = ::std::move(*slot.get());
+                allocator_type::destruct_at(slot.get());
+                slot.sequence.store(pos + i + mask + 1, ::std::memory_order_release);
+            }
+            return n;
+        }
+
+        /// @brief Returns an estimate of the number of elements in the queue.
+        /// @return The number of elements in the queue at some recent point in time.
+        inline usize size_approx() const noexcept
+        {
+            usize tail = enqueue_pos.load(::std::memory_order_relaxed);
+            usize head = dequeue_pos.load(::std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        /// @brief Returns the capacity of the queue.
+        /// @return The maximum number of elements in the queue, a power of two.
+        inline usize capacity() const noexcept { return slots.size(); }
+
+    private:
+        struct slot_type
+        {
+            ::std::atomic<usize> sequence;
+            alignas(value_type) byte storage[sizeof(value_type)];
+
+            inline value_type* get() noexcept { return reinterpret_cast<value_type*>(storage); }
+        };
+
+        static inline usize round_capacity(usize n) noexcept
+        {
+            usize capacity = 2;
+            while(capacity < n)
+                capacity <<= 1;
+            return capacity;
+        }
+
+    private:
+        typedef typename allocator_type::template rebind<slot_type>::allocator_type slot_allocator_type;
+
+        buffer<slot_type, slot_allocator_type> slots;
+        usize mask;
+
+        alignas(cache_line_size) ::std::atomic<usize> enqueue_pos;
+        alignas(cache_line_size) ::std::atomic<usize> dequeue_pos;
+    };
+
+    /// @brief Bounded single-producer single-consumer lock-free queue.
+    /// @tparam type The type of the elements of the queue.
+    /// @tparam allocator The allocator to use to allocate its data.
+    ///
+    /// Only one thread may push and only one thread may pop at any time. Each side keeps a
+    /// private copy of the other side's position and only reloads it when the queue looks
+    /// full (or empty), so in the common case an operation touches no shared cache line
+    /// other than the slot itself. The capacity is rounded up to a power of two.
+    template<typename type, typename allocator = basic_allocator<type>>
+    class spsc_queue
+    {
+    public:
+        /** The type of the elements of the queue. */
+        typedef type value_type;
+        /** The type of the allocator of the queue. */
+        typedef allocator allocator_type;
+
+        /** The type of the queue. */
+        typedef spsc_queue<value_type, allocator_type> spsc_queue_type;
+
+        /** The type of a span of elements. */
+        typedef span<value_type> span_type;
+        /** The type of a const span of elements. */
+        typedef const_span<value_type> const_span_type;
+
+        /// @brief Constructs an empty queue.
+        /// @param capacity The minimum capacity of the queue, rounded up to a power of two.
+        inline spsc_queue(usize capacity) noexcept :
+            buff(round_capacity(capacity)), mask(buff.size() - 1),
+            tail(0), head_cache(0), head(0), tail_cache(0)
+        {
+        }
+
+        spsc_queue(const spsc_queue_type&) = delete;
+        spsc_queue_type& operator=(const spsc_queue_type&) = delete;
+
+        /// @brief Destructor.
+        ///
+        /// Destroys the elements left in the queue.
+        inline ~spsc_queue() noexcept
+        {
+            usize h = head.load(::std::memory_order_relaxed);
+            usize t = tail.load(::std::memory_order_relaxed);
+            for(; h != t; h++)
+                allocator_type::destruct_at(buff.begin() + (h & mask));
+        }
+
+        /// @brief Tries to push an element at the back of the queue. Producer only.
+        /// @param _args The arguments to use to construct the element in-place.
+        /// @return true if the element was pushed, false if the queue is full.
+        template<typename... args>
+        inline bool try_push(args&&... _args) noexcept
+        {
+            usize t = tail.load(::std::memory_order_relaxed);
+            if(t - head_cache == buff.size())
+            {
+                head_cache = head.load(::std::memory_order_acquire);
+                if(t - head_cache == buff.size())
+                    return false;
+            }
+
+            allocator_type::construct_at(buff.begin() + (t & mask), ::std::forward<args>(_args)...);
+            tail.store(t + 1, ::std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Tries to pop the element at the front of the queue. Consumer only.
+        /// @param out The object that receives the popped element.
+        /// @return true if an element was popped, false if the queue is empty.
+        inline bool try_pop(value_type& out) noexcept
+        {
+            usize h = head.load(::std::memory_order_relaxed);
+            if(h == tail_cache)
+            {
+                tail_cache = tail.load(::std::memory_order_acquire);
+                if(h == tail_cache)
+                    return false;
+            }
+
+            value_type* slot = buff.begin() + (h & mask);
+            out = ::std::move(*slot);
+            allocator_type::destruct_at(slot);
+            head.store(h + 1, ::std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Tries to push copies of the elements of a span at the back of the queue. Producer only.
+        /// @param values The elements to push.
+        /// @return The number of elements pushed, from the front of the span.
+        ///
+        /// The elements are published with a single store, after being copied in at most
+        /// two contiguous runs.
+        inline usize try_push_many(const const_span_type& values) noexcept
+        {
+            usize t = tail.load(::std::memory_order_relaxed);
+            if(buff.size() - (t - head_cache) < values.size())
+                head_cache = head.load(::std::memory_order_acquire);
+
+            usize n = ::std::min(values.size(), buff.size() - (t - head_cache));
+            usize start = t & mask;
+            usize first = ::std::min(n, buff.size() - start);
+
+            copy_in(buff.begin() + start, values.data(), first);
+            copy_in(buff.begin(), values.data() + first, n - first);
+
+            tail.store(t + n, ::std::memory_order_release);
+            return n;
+        }
+
+        /// @brief Tries to pop elements from the front of the queue into a span. Consumer only.
+        /// @param out The span that receives the popped elements.
+        /// @return The number of elements popped, written at the front of the span.
+        inline usize try_pop_many(const span_type& out) noexcept
+        {
+            usize h = head.load(::std::memory_order_relaxed);
+            if(tail_cache - h < out.size())
+                tail_cache = tail.load(::std::memory_order_acquire);
+
+            usize n = ::std::min(out.size(), tail_cache - h);
+            usize start = h & mask;
+            usize first = ::std::min(n, buff.size() - start);
+
+            move_out(out.data(), buff.begin() + start, first);
+            move_out(out.data() + first, buff.begin(), n - first);
+
+            head.store(h + n, ::std::memory_order_release);
+            return n;
+        }
+
+        /// @brief Returns an estimate of the number of elements in the queue.
+        /// @return The number of elements in the queue at some recent point in time.
+        inline usize size_approx() const noexcept
+        {
+            usize t = tail.load(::std::memory_order_relaxed);
+            usize h = head.load(::std::memory_order_relaxed);
+            return t > h ? t - h : 0;
+        }
+
+        /// @brief Returns the capacity of the queue.
+        /// @return The maximum number of elements in the queue, a power of two.
+        inline usize capacity() const noexcept { return buff.size(); }
+
+    private:
+        static inline usize round_capacity(usize n) noexcept
+        {
+            usize capacity = 2;
+            while(capacity < n)
+                capacity <<= 1;
+            return capacity;
+        }
+
+        static inline void copy_in(value_type* to, const value_type* from, usize n) noexcept
+        {
+            for(usize i = 0; i != n; i++)
+                allocator_type::construct_at(to + i, from[i]);
+        }
+
+        static inline void copy_in(value_type* to, const value_type* from, usize n) noexcept requires relocatable<value_type>
+        {
+            ::std::memcpy(to, from, n * sizeof(value_type));
+        }
+
+        static inline void move_out(value_type* to, value_type* from, usize n) noexcept
+        {
+            for(usize i = 0; i != n; i++)
+            {
+                to[i] = ::std::move(from[i]);
+                allocator_type::destruct_at(from + i);
+            }
+        }
+
+        static inline void move_out(value_type* to, value_type* from, usize n) noexcept requires trivially_copyable<value_type>
+        {
+            ::std::memcpy(to, from, n * sizeof(value_type));
+        }
+
+    private:
+        buffer<value_type, allocator_type> buff;
+        usize mask;
+
+        alignas(cache_line_size) ::std::atomic<usize> tail;
+        usize head_cache;
+
+        alignas(cache_line_size) ::std::atomic<usize> head;
+        usize tail_cache;
+    };
+};
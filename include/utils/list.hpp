@@ -0,0 +1,301 @@
+/**
+ * @file
+ * @brief Index-based doubly-linked lists.
+ */
+#pragma once
+
+#include "arena.hpp"
+
+namespace utils
+{
+    /// @brief An arena of doubly-linked list nodes.
+    /// @tparam type The type of the values stored in the nodes.
+    /// @tparam allocator The allocator to use internally.
+    ///
+    /// Nodes live in a basic_arena and link to each other with 32-bit indices, so creating
+    /// a node never allocates on its own and the whole arena can be moved around freely.
+    /// Any number of lists can share the same arena, which makes it possible to move nodes
+    /// and whole lists between them in O(1). A list itself is just a small handle
+    /// (list_type) that the user owns and passes to the arena's operations.
+    template<typename type, typename allocator = basic_allocator<type>>
+    class list_arena
+    {
+    public:
+        /** The type of the values in the lists. */
+        typedef type value_type;
+        /** The type of the allocator of the arena. */
+        typedef allocator allocator_type;
+
+        /** The type of the list arena. */
+        typedef list_arena<value_type, allocator_type> list_arena_type;
+
+        /** The type of the index of a node. */
+        typedef u32 index_type;
+
+        /** The index that marks the absence of a node. */
+        static constexpr index_type null = ~index_type(0);
+
+        /// @brief A list whose nodes live in a list arena.
+        struct list_type
+        {
+            /** The first node of the list. */
+            index_type head = null;
+            /** The last node of the list. */
+            index_type tail = null;
+            /** The number of nodes in the list. */
+            index_type length = 0;
+
+            /// @brief Checks if the list is empty.
+            /// @return true if the list has no nodes, false otherwise.
+            inline bool empty() const noexcept { return length == 0; }
+            /// @brief Returns the number of nodes in the list.
+            /// @return The number of nodes in the list.
+            inline usize size() const noexcept { return length; }
+        };
+
+        /// @brief Default constructor.
+        inline list_arena() noexcept :
+            nodes()
+        {
+        }
+
+        /// @brief Constructs a list arena with a given capacity.
+        /// @param capacity The number of nodes to reserve.
+        inline list_arena(usize capacity) noexcept :
+            nodes(capacity)
+        {
+        }
+
+        /// @brief Assures that the arena has space for at least a number of new nodes.
+        /// @param n The number of nodes to reserve.
+        inline void reserve(usize n) noexcept { nodes.reserve(n); }
+
+        /// @brief Creates a node at the back of a list.
+        /// @param l The list.
+        /// @param _args The arguments to use to construct the value in-place.
+        /// @return The index of the new node.
+        template<typename... args>
+        inline index_type push_back(list_type& l, args&&... _args) noexcept
+        {
+            index_type i = create(::std::forward<args>(_args)...);
+            link_back(l, i);
+            return i;
+        }
+
+        /// @brief Creates a node at the front of a list.
+        /// @param l The list.
+        /// @param _args The arguments to use to construct the value in-place.
+        /// @return The index of the new node.
+        template<typename... args>
+        inline index_type push_front(list_type& l, args&&... _args) noexcept
+        {
+            index_type i = create(::std::forward<args>(_args)...);
+            link_front(l, i);
+            return i;
+        }
+
+        /// @brief Creates a node before another node of a list.
+        /// @param l The list.
+        /// @param pos The node before which to insert, or null to insert at the back.
+        /// @param _args The arguments to use to construct the value in-place.
+        /// @return The index of the new node.
+        template<typename... args>
+        inline index_type insert(list_type& l, index_type pos, args&&... _args) noexcept
+        {
+            index_type i = create(::std::forward<args>(_args)...);
+            link_before(l, pos, i);
+            return i;
+        }
+
+        /// @brief Removes a node from a list and destroys it.
+        /// @param l The list that contains the node.
+        /// @param i The index of the node.
+        inline void erase(list_type& l, index_type i) noexcept
+        {
+            unlink(l, i);
+            nodes.destroy_unchecked(i);
+        }
+
+        /// @brief Destroys the first node of a list.
+        /// @param l The list, which must not be empty.
+        inline void pop_front(list_type& l) noexcept { erase(l, l.head); }
+        /// @brief Destroys the last node of a list.
+        /// @param l The list, which must not be empty.
+        inline void pop_back(list_type& l) noexcept { erase(l, l.tail); }
+
+        /// @brief Destroys all the nodes of a list.
+        /// @param l The list to clear.
+        inline void clear(list_type& l) noexcept
+        {
+            index_type i = l.head;
+            while(i != null)
+            {
+                index_type next = nodes[i].next;
+                nodes.destroy_unchecked(i);
+                i = next;
+            }
+
+            l = list_type();
+        }
+
+        /// @brief Moves a node of a list to its front.
+        /// @param l The list that contains the node.
+        /// @param i The index of the node.
+        inline void move_to_front(list_type& l, index_type i) noexcept
+        {
+            if(l.head == i)
+                return;
+
+            unlink(l, i);
+            link_front(l, i);
+        }
+
+        /// @brief Moves a node of a list to its back.
+        /// @param l The list that contains the node.
+        /// @param i The index of the node.
+        inline void move_to_back(list_type& l, index_type i) noexcept
+        {
+            if(l.tail == i)
+                return;
+
+            unlink(l, i);
+            link_back(l, i);
+        }
+
+        /// @brief Moves a single node from one list to another.
+        /// @param to The list that receives the node.
+        /// @param pos The node of to before which to insert, or null to insert at the back.
+        /// @param from The list that contains the node.
+        /// @param i The index of the node to move.
+        inline void splice(list_type& to, index_type pos, list_type& from, index_type i) noexcept
+        {
+            unlink(from, i);
+            link_before(to, pos, i);
+        }
+
+        /// @brief Moves all the nodes of a list into another one.
+        /// @param to The list that receives the nodes.
+        /// @param pos The node of to before which to insert, or null to insert at the back.
+        /// @param from The list whose nodes are moved. It is left empty.
+        inline void splice(list_type& to, index_type pos, list_type& from) noexcept
+        {
+            if(from.empty())
+                return;
+
+            index_type before = pos == null ? to.tail : nodes[pos].prev;
+
+            nodes[from.head].prev = before;
+            nodes[from.tail].next = pos;
+
+            if(before == null) to.head = from.head;
+            else nodes[before].next = from.head;
+
+            if(pos == null) to.tail = from.tail;
+            else nodes[pos].prev = from.tail;
+
+            to.length += from.length;
+            from = list_type();
+        }
+
+        /// @brief Detaches a node from a list without destroying it.
+        /// @param l The list that contains the node.
+        /// @param i The index of the node.
+        ///
+        /// The node must be linked into a list again, or erased, by the user.
+        inline void unlink(list_type& l, index_type i) noexcept
+        {
+            node_type& n = nodes[i];
+
+            if(n.prev == null) l.head = n.next;
+            else nodes[n.prev].next = n.next;
+
+            if(n.next == null) l.tail = n.prev;
+            else nodes[n.next].prev = n.prev;
+
+            n.prev = null;
+            n.next = null;
+            l.length--;
+        }
+
+        /// @brief Links a detached node at the front of a list.
+        /// @param l The list.
+        /// @param i The index of the node.
+        inline void link_front(list_type& l, index_type i) noexcept { link_before(l, l.head, i); }
+        /// @brief Links a detached node at the back of a list.
+        /// @param l The list.
+        /// @param i The index of the node.
+        inline void link_back(list_type& l, index_type i) noexcept { link_before(l, null, i); }
+
+        /// @brief Links a detached node before another node of a list.
+        /// @param l The list.
+        /// @param pos The node before which to link, or null to link at the back.
+        /// @param i The index of the node.
+        inline void link_before(list_type& l, index_type pos, index_type i) noexcept
+        {
+            node_type& n = nodes[i];
+            n.next = pos;
+            n.prev = pos == null ? l.tail : nodes[pos].prev;
+
+            if(n.prev == null) l.head = i;
+            else nodes[n.prev].next = i;
+
+            if(pos == null) l.tail = i;
+            else nodes[pos].prev = i;
+
+            l.length++;
+        }
+
+        /// @brief Returns the node following another one.
+        /// @param i The index of the node.
+        /// @return The index of the next node, or null if i is the last one.
+        inline index_type next(index_type i) const noexcept { return nodes[i].next; }
+        /// @brief Returns the node preceding another one.
+        /// @param i The index of the node.
+        /// @return The index of the previous node, or null if i is the first one.
+        inline index_type prev(index_type i) const noexcept { return nodes[i].prev; }
+
+        /// @brief Checks if the arena has a node at an index.
+        /// @param i The index to check.
+        /// @return true if there is a node at index i, false otherwise.
+        inline bool has(index_type i) const noexcept { return nodes.has(i); }
+
+        /// @brief Returns the number of nodes in the arena, over all the lists.
+        /// @return The number of nodes in the arena.
+        inline usize size() const noexcept { return nodes.size(); }
+
+        /// @brief Accesses the value of a node.
+        /// @param i The index of the node.
+        /// @return A reference to the value of the node.
+        inline value_type& operator[](index_type i) noexcept { return nodes[i].value; }
+        /// @brief Accesses the value of a node.
+        /// @param i The index of the node.
+        /// @return A const reference to the value of the node.
+        inline const value_type& operator[](index_type i) const noexcept { return nodes[i].value; }
+
+    private:
+        struct node_type
+        {
+            template<typename... args>
+            inline node_type(::std::in_place_t, args&&... _args) noexcept :
+                prev(null), next(null), value(::std::forward<args>(_args)...)
+            {
+            }
+
+            index_type prev;
+            index_type next;
+            value_type value;
+        };
+
+        template<typename... args>
+        inline index_type create(args&&... _args) noexcept
+        {
+            return static_cast<index_type>(nodes.create(::std::in_place, ::std::forward<args>(_args)...));
+        }
+
+    private:
+        typedef typename allocator_type::template rebind<node_type>::allocator_type node_allocator_type;
+        typedef basic_arena<node_type, node_allocator_type> arena_type;
+
+        arena_type nodes;
+    };
+};
@@ -0,0 +1,150 @@
+/**
+ * @file
+ * @brief Least recently used cache.
+ */
+#pragma once
+
+#include "list.hpp"
+
+namespace utils
+{
+    /// @brief A bounded cache that keeps its entries ordered by recency of use.
+    /// @tparam type The type of the cached values.
+    /// @tparam allocator The allocator to use internally.
+    ///
+    /// Entries are nodes of a single list in a list_arena, with the most recently used
+    /// one at the front. Entries are addressed by their index, so the user is expected
+    /// to keep its own lookup structure (for example a hash map) from keys to indices.
+    template<typename type, typename allocator = basic_allocator<type>>
+    class lru_cache
+    {
+    public:
+        /** The type of the cached values. */
+        typedef type value_type;
+        /** The type of the allocator of the cache. */
+        typedef allocator allocator_type;
+
+        /** The type of the cache. */
+        typedef lru_cache<value_type, allocator_type> lru_cache_type;
+        /** The type of the arena holding the entries. */
+        typedef list_arena<value_type, allocator_type> list_arena_type;
+        /** The type of the index of an entry. */
+        typedef typename list_arena_type::index_type index_type;
+
+        /** The index that marks the absence of an entry. */
+        static constexpr index_type null = list_arena_type::null;
+
+        /// @brief Constructs a cache that holds at most limit entries.
+        /// @param limit The maximum number of entries.
+        inline lru_cache(usize limit) noexcept :
+            entries(limit), order(), max(limit)
+        {
+        }
+
+        /// @brief Inserts a new entry as the most recently used one.
+        /// @param _args The arguments to use to construct the value in-place.
+        /// @return The index of the new entry.
+        ///
+        /// If the cache is full, the least recently used entry is destroyed first. Use
+        /// full and evict beforehand if the evicted value is needed.
+        template<typename... args>
+        inline index_type insert(args&&... _args) noexcept
+        {
+            if(full() && !order.empty())
+                entries.pop_back(order);
+
+            return entries.push_front(order, ::std::forward<args>(_args)...);
+        }
+
+        /// @brief Marks an entry as the most recently used one.
+        /// @param i The index of the entry.
+        inline void touch(index_type i) noexcept { entries.move_to_front(order, i); }
+
+        /// @brief Removes an entry from the cache.
+        /// @param i The index of the entry.
+        inline void erase(index_type i) noexcept { entries.erase(order, i); }
+
+        /// @brief Removes the least recently used entry.
+        /// @param on_evict Function called with a reference to the value before it's destroyed.
+        ///
+        /// The cache must not be empty.
+        template<typename function>
+        inline void evict(function&& on_evict) noexcept
+        {
+            on_evict(entries[order.tail]);
+            entries.pop_back(order);
+        }
+
+        /// @brief Removes the least recently used entry.
+        ///
+        /// The cache must not be empty.
+        inline void evict() noexcept { entries.pop_back(order); }
+
+        /// @brief Removes least recently used entries until the cache has at most n entries.
+        /// @param n The number of entries to keep.
+        /// @param on_evict Function called with a reference to each value before it's destroyed.
+        template<typename function>
+        inline void shrink(usize n, function&& on_evict) noexcept
+        {
+            while(order.size() > n)
+                evict(on_evict);
+        }
+
+        /// @brief Removes all the entries.
+        inline void clear() noexcept { entries.clear(order); }
+
+        /// @brief Changes the maximum number of entries.
+        /// @param limit The new maximum number of entries.
+        ///
+        /// Entries above the new limit are evicted, least recently used first.
+        inline void set_limit(usize limit) noexcept
+        {
+            max = limit;
+            while(order.size() > max)
+                evict();
+        }
+
+        /// @brief Returns the least recently used entry.
+        /// @return The index of the least recently used entry, or null if the cache is empty.
+        inline index_type least_recent() const noexcept { return order.tail; }
+        /// @brief Returns the most recently used entry.
+        /// @return The index of the most recently used entry, or null if the cache is empty.
+        inline index_type most_recent() const noexcept { return order.head; }
+
+        /// @brief Returns the next less recently used entry.
+        /// @param i The index of the entry.
+        /// @return The index of the entry used right before i, or null if i is the least recent.
+        inline index_type older(index_type i) const noexcept { return entries.next(i); }
+        /// @brief Returns the next more recently used entry.
+        /// @param i The index of the entry.
+        /// @return The index of the entry used right after i, or null if i is the most recent.
+        inline index_type newer(index_type i) const noexcept { return entries.prev(i); }
+
+        /// @brief Returns the number of entries in the cache.
+        /// @return The number of entries in the cache.
+        inline usize size() const noexcept { return order.size(); }
+        /// @brief Returns the maximum number of entries in the cache.
+        /// @return The maximum number of entries in the cache.
+        inline usize limit() const noexcept { return max; }
+        /// @brief Checks if the cache is empty.
+        /// @return true if the cache is empty, false otherwise.
+        inline bool empty() const noexcept { return order.empty(); }
+        /// @brief Checks if the cache is full.
+        /// @return true if inserting would evict an entry, false otherwise.
+        inline bool full() const noexcept { return order.size() >= max; }
+
+        /// @brief Accesses the value of an entry, without changing its recency.
+        /// @param i The index of the entry.
+        /// @return A reference to the value of the entry.
+        inline value_type& operator[](index_type i) noexcept { return entries[i]; }
+        /// @brief Accesses the value of an entry, without changing its recency.
+        /// @param i The index of the entry.
+        /// @return A const reference to the value of the entry.
+        inline const value_type& operator[](index_type i) const noexcept { return entries[i]; }
+
+    private:
+        list_arena_type entries;
+        typename list_arena_type::list_type order;
+        usize max;
+    };
+};
@@ -0,0 +1,482 @@
+/**
+ * @file
+ * @brief Ring buffer and double-ended queue structures.
+ */
+#pragma once
+
+#include "array.hpp"
+
+#include <algorithm>
+
+namespace utils
+{
+    namespace __detail
+    {
+        namespace __ring
+        {
+            /// @brief Common implementation of the ring structures.
+            /// @tparam type The type of the elements of the ring.
+            /// @tparam allocator The allocator to use to allocate its data.
+            ///
+            /// The elements are stored in a buffer whose size is always a power of two, so
+            /// that wrapping an index around is a single mask. None of the operations here
+            /// check the capacity of the ring, this is left to the derived structures.
+            template<typename type, typename allocator>
+            class ring
+            {
+            public:
+                /** The type of the elements of the ring. */
+                typedef type value_type;
+                /** The type of the allocator of the ring. */
+                typedef allocator allocator_type;
+
+                /** The type of the internal buffer used by the ring. */
+                typedef buffer<value_type, allocator_type> buffer_type;
+
+                /** The type of a span over a part of the ring. */
+                typedef span<value_type> span_type;
+                /** The type of a const span over a part of the ring. */
+                typedef const_span<value_type> const_span_type;
+
+                /// @brief Pushes an element at the back of the ring, without checking the capacity.
+                /// @param _args The arguments to pass to the constructor.
+                /// @return A reference to the element constructed.
+                template<typename... args>
+                inline value_type& push_back_unchecked(args&&... _args) noexcept
+                {
+                    value_type* slot = buff.begin() + ((head + count) & mask);
+                    allocator_type::construct_at(slot, ::std::forward<args>(_args)...);
+                    count++;
+                    return *slot;
+                }
+
+                /// @brief Pushes an element at the front of the ring, without checking the capacity.
+                /// @param _args The arguments to pass to the constructor.
+                /// @return A reference to the element constructed.
+                template<typename... args>
+                inline value_type& push_front_unchecked(args&&... _args) noexcept
+                {
+                    head = (head - 1) & mask;
+                    value_type* slot = buff.begin() + head;
+                    allocator_type::construct_at(slot, ::std::forward<args>(_args)...);
+                    count++;
+                    return *slot;
+                }
+
+                /// @brief Pushes copies of the elements of a span at the back of the ring, without checking the capacity.
+                /// @param span The span to push.
+                ///
+                /// The copy is done in at most two contiguous runs.
+                inline void push_back_many_unchecked(const const_span_type& span) noexcept
+                {
+                    usize start = (head + count) & mask;
+                    usize first = ::std::min(span.size(), buff.size() - start);
+
+                    copy_in(buff.begin() + start, span.data(), first);
+                    copy_in(buff.begin(), span.data() + first, span.size() - first);
+                    count += span.size();
+                }
+
+                /// @brief Pops the element at the front of the ring.
+                inline void pop_front() noexcept
+                {
+                    allocator_type::destruct_at(buff.begin() + head);
+                    head = (head + 1) & mask;
+                    count--;
+                }
+
+                /// @brief Pops the element at the back of the ring.
+                inline void pop_back() noexcept
+                {
+                    count--;
+                    allocator_type::destruct_at(buff.begin() + ((head + count) & mask));
+                }
+
+                /// @brief Pops a number of elements from the front of the ring.
+                /// @param n The number of elements to pop.
+                inline void pop_front_many(usize n) noexcept
+                {
+                    for(usize i = 0; i != n; i++)
+                        allocator_type::destruct_at(buff.begin() + ((head + i) & mask));
+
+                    head = (head + n) & mask;
+                    count -= n;
+                }
+
+                /// @brief Moves elements from the front of the ring into a span.
+                /// @param out The span that receives the elements.
+                /// @return The number of elements moved, i.e. the smaller of out's size and the ring's size.
+                ///
+                /// The elements moved are popped from the ring.
+                inline usize pop_front_many(const span_type& out) noexcept
+                {
+                    usize n = ::std::min(out.size(), count);
+                    usize first = ::std::min(n, buff.size() - head);
+
+                    move_out(out.data(), buff.begin() + head, first);
+                    move_out(out.data() + first, buff.begin(), n - first);
+
+                    head = (head + n) & mask;
+                    count -= n;
+                    return n;
+                }
+
+                /// @brief Clears the ring.
+                inline void clear() noexcept
+                {
+                    pop_front_many(count);
+                    head = 0;
+                }
+
+                /// @brief Returns the number of elements in the ring.
+                /// @return The number of elements in the ring.
+                inline usize size() const noexcept { return count; }
+                /// @brief Returns the number of elements the ring can hold.
+                /// @return The capacity of the ring, which is always a power of two.
+                inline usize capacity() const noexcept { return buff.size(); }
+                /// @brief Checks if the ring is empty.
+                /// @return true if the ring is empty, false otherwise.
+                inline bool empty() const noexcept { return count == 0; }
+                /// @brief Checks if the ring is full.
+                /// @return true if the ring has no more space, false otherwise.
+                inline bool full() const noexcept { return count == buff.size(); }
+
+                /// @brief Returns a reference to the element at the front of the ring.
+                /// @return A reference to the element at the front of the ring.
+                inline value_type& front() noexcept { return buff[head]; }
+                /// @brief Returns a reference to the element at the front of the ring.
+                /// @return A const reference to the element at the front of the ring.
+                inline const value_type& front() const noexcept { return buff[head]; }
+
+                /// @brief Returns a reference to the element at the back of the ring.
+                /// @return A reference to the element at the back of the ring.
+                inline value_type& back() noexcept { return buff[(head + count - 1) & mask]; }
+                /// @brief Returns a reference to the element at the back of the ring.
+                /// @return A const reference to the element at the back of the ring.
+                inline const value_type& back() const noexcept { return buff[(head + count - 1) & mask]; }
+
+                /// @brief Accesses an element of the ring.
+                /// @param i The index of the element, counting from the front.
+                /// @return A reference to the i-th element from the front.
+                inline value_type& operator[](usize i) noexcept { return buff[(head + i) & mask]; }
+                /// @brief Accesses an element of the ring.
+                /// @param i The index of the element, counting from the front.
+                /// @return A const reference to the i-th element from the front.
+                inline const value_type& operator[](usize i) const noexcept { return buff[(head + i) & mask]; }
+
+                /// @brief Returns the first contiguous run of elements, starting at the front.
+                /// @return A span over the elements from the front up to the end of the storage or the back.
+                inline span_type first_segment() noexcept { return span_type(buff.begin() + head, ::std::min(count, buff.size() - head)); }
+                /// @brief Returns the second contiguous run of elements, that wrapped around the storage.
+                /// @return A span over the wrapped elements, empty if the ring doesn't wrap.
+                inline span_type second_segment() noexcept { return span_type(buff.begin(), count - ::std::min(count, buff.size() - head)); }
+
+            protected:
+                inline ring() noexcept :
+                    buff(), head(0), count(0), mask(0)
+                {
+                }
+
+                inline ring(ring&& other) noexcept :
+                    buff(::std::move(other.buff)), head(other.head), count(other.count), mask(other.mask)
+                {
+                    other.head = 0;
+                    other.count = 0;
+                    other.mask = 0;
+                }
+
+                inline ring(const ring& other) noexcept :
+                    buff(), head(0), count(0), mask(0)
+                {
+                    relocate(other.buff.size());
+                    copy_from(other);
+                }
+
+                inline ~ring() noexcept
+                {
+                    pop_front_many(count);
+                }
+
+                inline ring& operator=(ring&& other) noexcept
+                {
+                    pop_front_many(count);
+
+                    buff = ::std::move(other.buff);
+                    head = other.head; other.head = 0;
+                    count = other.count; other.count = 0;
+                    mask = other.mask; other.mask = 0;
+
+                    return *this;
+                }
+
+                inline ring& operator=(const ring& other) noexcept
+                {
+                    clear();
+                    if(buff.size() < other.buff.size())
+                        relocate(other.buff.size());
+                    copy_from(other);
+
+                    return *this;
+                }
+
+                static inline usize round_capacity(usize n) noexcept
+                {
+                    usize capacity = 1;
+                    while(capacity < n)
+                        capacity <<= 1;
+                    return capacity;
+                }
+
+                /// Moves the elements into a new buffer of power of two size n, unwrapping
+                /// them so that the front ends up at index 0. Assumes n >= count.
+                void relocate(usize n) noexcept
+                {
+                    buffer_type new_buffer(n);
+
+                    usize first = ::std::min(count, buff.size() - head);
+                    relocate_out(new_buffer.begin(), buff.begin() + head, first);
+                    relocate_out(new_buffer.begin() + first, buff.begin(), count - first);
+
+                    buff = ::std::move(new_buffer);
+                    head = 0;
+                    mask = n - 1;
+                }
+
+            private:
+                inline void copy_from(const ring& other) noexcept
+                {
+                    for(usize i = 0; i != other.count; i++)
+                        push_back_unchecked(other[i]);
+                }
+
+                static inline void relocate_out(value_type* to, value_type* from, usize n) noexcept
+                {
+                    for(usize i = 0; i != n; i++)
+                    {
+                        allocator_type::construct_at(to + i, ::std::move(from[i]));
+                        allocator_type::destruct_at(from + i);
+                    }
+                }
+
+                static inline void relocate_out(value_type* to, value_type* from, usize n) noexcept requires relocatable<value_type>
+                {
+                    ::std::memcpy(to, from, n * sizeof(value_type));
+                }
+
+                static inline void copy_in(value_type* to, const value_type* from, usize n) noexcept
+                {
+                    for(usize i = 0; i != n; i++)
+                        allocator_type::construct_at(to + i, from[i]);
+                }
+
+                static inline void copy_in(value_type* to, const value_type* from, usize n) noexcept requires relocatable<value_type>
+                {
+                    ::std::memcpy(to, from, n * sizeof(value_type));
+                }
+
+                static inline void move_out(value_type* to, value_type* from, usize n) noexcept
+                {
+                    for(usize i = 0; i != n; i++)
+                    {
+                        to[i] = ::std::move(from[i]);
+                        allocator_type::destruct_at(from + i);
+                    }
+                }
+
+                static inline void move_out(value_type* to, value_type* from, usize n) noexcept requires trivially_copyable<value_type>
+                {
+                    ::std::memcpy(to, from, n * sizeof(value_type));
+                }
+
+            protected:
+                buffer_type buff;
+                usize head;
+                usize count;
+                usize mask;
+            };
+        };
+    };
+
+    /// @brief Fixed capacity ring buffer.
+    /// @tparam type The type of the elements of the ring buffer.
+    /// @tparam allocator The allocator to use to allocate its data.
+    ///
+    /// The capacity is rounded up to a power of two at construction and never changes
+    /// afterwards, so pushes fail instead of reallocating when the ring buffer is full.
+    template<typename type, typename allocator = basic_allocator<type>>
+    class ring_buffer : public __detail::__ring::ring<type, allocator>
+    {
+    public:
+        /** The type of the ring buffer. */
+        typedef ring_buffer<type, allocator> ring_buffer_type;
+        /** The type of the common ring implementation. */
+        typedef __detail::__ring::ring<type, allocator> ring_type;
+
+        typedef typename ring_type::value_type value_type;
+        typedef typename ring_type::const_span_type const_span_type;
+
+        /// @brief Constructs an empty ring buffer with no space.
+        inline ring_buffer() noexcept :
+            ring_type()
+        {
+        }
+
+        /// @brief Constructs an empty ring buffer.
+        /// @param capacity The minimum capacity, rounded up to a power of two.
+        inline ring_buffer(usize capacity) noexcept :
+            ring_type()
+        {
+            this->relocate(ring_type::round_capacity(capacity));
+        }
+
+        /// @brief Move constructor.
+        /// @param other The ring buffer moved.
+        inline ring_buffer(ring_buffer_type&& other) noexcept = default;
+        /// @brief Copy constructor.
+        /// @param other The ring buffer copied.
+        inline ring_buffer(const ring_buffer_type& other) noexcept = default;
+
+        /// @brief Move assignment.
+        /// @param other The ring buffer moved.
+        inline ring_buffer_type& operator=(ring_buffer_type&& other) noexcept = default;
+        /// @brief Copy assignment.
+        /// @param other The ring buffer copied.
+        inline ring_buffer_type& operator=(const ring_buffer_type& other) noexcept = default;
+
+        /// @brief Pushes an element at the back of the ring buffer.
+        /// @param _args The arguments to pass to the constructor.
+        /// @return true if the element was pushed, false if the ring buffer is full.
+        template<typename... args>
+        inline bool push_back(args&&... _args) noexcept
+        {
+            if(this->full())
+                return false;
+
+            this->push_back_unchecked(::std::forward<args>(_args)...);
+            return true;
+        }
+
+        /// @brief Pushes an element at the front of the ring buffer.
+        /// @param _args The arguments to pass to the constructor.
+        /// @return true if the element was pushed, false if the ring buffer is full.
+        template<typename... args>
+        inline bool push_front(args&&... _args) noexcept
+        {
+            if(this->full())
+                return false;
+
+            this->push_front_unchecked(::std::forward<args>(_args)...);
+            return true;
+        }
+
+        /// @brief Pushes copies of the elements of a span at the back of the ring buffer.
+        /// @param span The span to push.
+        /// @return The number of elements pushed, which is less than the size of the span if the ring buffer fills up.
+        inline usize push_back_many(const const_span_type& span) noexcept
+        {
+            usize n = ::std::min(span.size(), this->capacity() - this->size());
+            this->push_back_many_unchecked(span.prefix(n));
+            return n;
+        }
+    };
+
+    /// @brief Growable double-ended queue.
+    /// @tparam type The type of the elements of the deque.
+    /// @tparam allocator The allocator to use to allocate its data.
+    ///
+    /// A ring that doubles its storage when it fills up. Growth unwraps the ring into the
+    /// new storage in at most two runs, which are plain memcpys for relocatable types.
+    template<typename type, typename allocator = basic_allocator<type>>
+    class deque : public __detail::__ring::ring<type, allocator>
+    {
+    public:
+        /** The type of the deque. */
+        typedef deque<type, allocator> deque_type;
+        /** The type of the common ring implementation. */
+        typedef __detail::__ring::ring<type, allocator> ring_type;
+
+        typedef typename ring_type::value_type value_type;
+        typedef typename ring_type::const_span_type const_span_type;
+
+        /// @brief Constructs an empty deque.
+        inline deque() noexcept :
+            ring_type()
+        {
+        }
+
+        /// @brief Constructs an empty deque with some reserved space.
+        /// @param capacity The minimum capacity, rounded up to a power of two.
+        inline deque(usize capacity) noexcept :
+            ring_type()
+        {
+            this->relocate(ring_type::round_capacity(capacity));
+        }
+
+        /// @brief Move constructor.
+        /// @param other The deque moved.
+        inline deque(deque_type&& other) noexcept = default;
+        /// @brief Copy constructor.
+        /// @param other The deque copied.
+        inline deque(const deque_type& other) noexcept = default;
+
+        /// @brief Move assignment.
+        /// @param other The deque moved.
+        inline deque_type& operator=(deque_type&& other) noexcept = default;
+        /// @brief Copy assignment.
+        /// @param other The deque copied.
+        inline deque_type& operator=(const deque_type& other) noexcept = default;
+
+        /// @brief Assures that the deque has space for some number of elements.
+        /// @param capacity The number of elements to reserve.
+        inline void reserve(usize capacity) noexcept
+        {
+            if(this->capacity() < capacity)
+                this->relocate(ring_type::round_capacity(capacity));
+        }
+
+        /// @brief Pushes an element at the back of the deque.
+        /// @param _args The arguments to pass to the constructor.
+        /// @return A reference to the element constructed.
+        template<typename... args>
+        inline value_type& push_back(args&&... _args) noexcept
+        {
+            if(this->full())
+                this->relocate(capacity_growth(1));
+
+            return this->push_back_unchecked(::std::forward<args>(_args)...);
+        }
+
+        /// @brief Pushes an element at the front of the deque.
+        /// @param _args The arguments to pass to the constructor.
+        /// @return A reference to the element constructed.
+        template<typename... args>
+        inline value_type& push_front(args&&... _args) noexcept
+        {
+            if(this->full())
+                this->relocate(capacity_growth(1));
+
+            return this->push_front_unchecked(::std::forward<args>(_args)...);
+        }
+
+        /// @brief Pushes copies of the elements of a span at the back of the deque.
+        /// @param span The span to push.
+        inline void push_back_many(const const_span_type& span) noexcept
+        {
+            if(this->size() + span.size() > this->capacity())
+                this->relocate(capacity_growth(span.size()));
+
+            this->push_back_many_unchecked(span);
+        }
+
+        /// @brief Calculates the new capacity of the deque that accommodates an additional number of objects.
+        /// @param extra The additional number of objects that the new capacity must accommodate.
+        /// @return The new capacity, a power of two.
+        inline usize capacity_growth(usize extra) const noexcept
+        {
+            return ring_type::round_capacity(::std::max<usize>((this->size() + extra), this->capacity() * 2));
+        }
+    };
+
+    template<typename type, typename allocator> struct is_relocatable<ring_buffer<type, allocator>> : public ::std::true_type {};
+    template<typename type, typename allocator> struct is_relocatable<deque<type, allocator>> : public ::std::true_type {};
+};
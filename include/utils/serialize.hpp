@@ -0,0 +1,468 @@
+/**
+ * @file
+ * @brief Binary serialization of containers as raw blocks, read back without copies.
+ */
+#pragma once
+
+#include "arena.hpp"
+
+#include <cstring>
+
+namespace utils
+{
+    /** The alignment of the blocks and of the arrays inside them, in bytes. */
+    constexpr usize serial_alignment = cache_line_size;
+
+    namespace __detail
+    {
+        /// @brief Hashes the name of a type, as spelled by the compiler.
+        /// @tparam type The type.
+        /// @return The 32-bit FNV-1a hash of the signature of this function for the type.
+        ///
+        /// The signature comes from __FUNCSIG__ or __PRETTY_FUNCTION__, which spell out the
+        /// template argument, unlike std::source_location whose function name may not.
+        template<typename type>
+        inline constexpr u32 type_hash() noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            const char* signature = __FUNCSIG__;
+#else
+            const char* signature = __PRETTY_FUNCTION__;
+#endif
+            u32 h = 2166136261u;
+            for(const char* c = signature; *c != 0; c++)
+                h = (h ^ u8(*c)) * 16777619u;
+            return h;
+        }
+
+        static_assert(type_hash<u32>() != type_hash<u64>() && type_hash<u32>() != type_hash<f32>(), "type_hash must tell types apart");
+
+        /// @brief Rounds a size up to the alignment of blocks.
+        inline constexpr usize serial_align(usize n) noexcept { return (n + serial_alignment - 1) & ~(serial_alignment - 1); }
+    };
+
+    /// @brief Identifies the type and layout of the elements of a serialized container.
+    /// @tparam type The type of the elements.
+    ///
+    /// The default tag is a hash of the name of the type, which only stays the same with
+    /// the same compiler. Specialize it to pin the tag of a type stored across builds, and
+    /// bump the version whenever its layout changes.
+    template<typename type>
+    struct serial_traits
+    {
+        /** The tag of the type. */
+        static constexpr u32 tag = __detail::type_hash<type>();
+        /** The version of the layout of the type. */
+        static constexpr u16 version = 0;
+    };
+
+    /// @brief The kind of container a block holds.
+    enum class serial_kind : u8
+    {
+        /** Contiguous elements, from an array or a span. */
+        array,
+        /** The slots of a sparse_array, and their occupancy. */
+        sparse_array,
+        /** The slots of a basic_arena, their occupancy and the free indices. */
+        arena
+    };
+
+    /// @brief The header in front of every block.
+    ///
+    /// A block is the header, then every array of the container, each starting at a
+    /// multiple of serial_alignment from the start of the block: the elements, then the
+    /// occupancy as one byte per slot, then the free indices.
+    struct serial_header
+    {
+        /** serial_header::signature. */
+        u32 magic;
+        /** The tag of the type of the elements. */
+        u32 tag;
+        /** The version of the type of the elements. */
+        u16 version;
+        /** The serial_kind of the container. */
+        u8 kind;
+        u8 reserved;
+        /** The size of an element in bytes. */
+        u32 element_size;
+        /** The number of elements or slots. */
+        u64 count;
+        /** The number of free indices of an arena, 0 otherwise. */
+        u64 free;
+        /** The size of the whole block in bytes, a multiple of serial_alignment. */
+        u64 size;
+
+        /** The magic number of blocks, "USB1". */
+        static constexpr u32 signature = 0x31425355;
+    };
+
+    /// @brief A sparse_array read back, viewed in place.
+    /// @tparam type The type of the elements.
+    template<typename type>
+    struct sparse_view
+    {
+        /** The slots, occupied or not; empty ones are zeroed. */
+        const_span<type> slots;
+        /** For every slot, true if it holds an element. */
+        const_span<bool> occupied;
+
+        /// @brief Checks if a slot holds an element.
+        /// @param i The index of the slot.
+        /// @return true if there is an element at index i, false otherwise.
+        inline bool has(usize i) const noexcept { return i < occupied.size() && occupied[i]; }
+
+        /// @brief Access the element at an index.
+        /// @param i The index of the element.
+        /// @return A const reference to the element at index i.
+        inline const type& operator[](usize i) const noexcept { return slots[i]; }
+    };
+
+    /// @brief A basic_arena read back, viewed in place.
+    /// @tparam type The type of the elements.
+    template<typename type>
+    struct arena_view
+    {
+        /** The elements at their indices. */
+        sparse_view<type> elements;
+        /** The free indices, in the order of basic_arena::free_indices. */
+        const_span<usize> free;
+    };
+
+    /// @brief Appends containers of trivially copyable elements to a byte array, as raw blocks.
+    ///
+    /// Every container is written as one block: a serial_header, then its memory copied
+    /// with a single memcpy per array, so writing is bound by memory bandwidth rather than
+    /// by the number of elements. Blocks are aligned, so that a serial_reader can view them
+    /// in place, in a mapped file or a received buffer.
+    ///
+    /// Elements are written in the byte order and layout of the machine, so the blocks are
+    /// meant to be read back on the same platform, like snapshots. Only trivially copyable
+    /// elements can be written: relocatable ones, like arrays, may own memory elsewhere.
+    class serial_writer
+    {
+    public:
+        /// @brief Constructs a writer appending to an array.
+        /// @param out The array the blocks are appended to. Its data must be aligned to
+        /// serial_alignment, or start at a multiple of it in the final buffer, for the blocks
+        /// to be read in place; the writer pads it to a multiple of serial_alignment first.
+        inline serial_writer(array<u8>& out) noexcept :
+            data(out)
+        {
+            pad();
+        }
+
+        /// @brief Writes contiguous elements, like the contents of an array.
+        /// @tparam type The type of the elements.
+        /// @param elements The elements.
+        template<trivially_copyable type>
+        inline void write(const const_span<type>& elements) noexcept
+        {
+            u8* block = begin<type>(serial_kind::array, elements.size(), 0, array_bytes<type>(elements.size()));
+            copy(block, elements.data(), elements.size() * sizeof(type));
+        }
+
+        /// @brief Writes the elements of an array.
+        /// @tparam type The type of the elements.
+        /// @tparam allocator The allocator of the array.
+        /// @param a The array.
+        template<trivially_copyable type, typename allocator>
+        inline void write(const array<type, allocator>& a) noexcept { write(const_span<type>(a.data(), a.size())); }
+
+        /// @brief Writes the slots of a sparse array, and their occupancy.
+        /// @tparam type The type of the elements.
+        /// @tparam allocator The allocator of the sparse array.
+        /// @param a The sparse array.
+        template<trivially_copyable type, typename allocator>
+        inline void write(const sparse_array<type, allocator>& a) noexcept
+        {
+            usize n = a.capacity();
+            usize slots = array_bytes<type>(n);
+            u8* block = begin<type>(serial_kind::sparse_array, n, 0, slots + array_bytes<bool>(n));
+            copy_slots(block, a.slots().data(), a.occupancy());
+            copy(block + slots, a.occupancy().data(), n);
+        }
+
+        /// @brief Writes the storage of an arena, and its free indices.
+        /// @tparam type The type of the elements.
+        /// @tparam allocator The allocator of the arena.
+        /// @param a The arena.
+        template<trivially_copyable type, typename allocator>
+        inline void write(const basic_arena<type, allocator>& a) noexcept
+        {
+            const sparse_array<type, allocator>& storage = a.storage();
+            const_span<usize> free = a.free_indices();
+            usize n = storage.capacity();
+            usize slots = array_bytes<type>(n), bits = array_bytes<bool>(n);
+            u8* block = begin<type>(serial_kind::arena, n, free.size(), slots + bits + array_bytes<usize>(free.size()));
+            copy_slots(block, storage.slots().data(), storage.occupancy());
+            copy(block + slots, storage.occupancy().data(), n);
+            copy(block + slots + bits, free.data(), free.size() * sizeof(usize));
+        }
+
+    private:
+        template<typename type>
+        static inline constexpr usize array_bytes(usize n) noexcept { return __detail::serial_align(n * sizeof(type)); }
+
+        inline void pad() noexcept
+        {
+            usize n = __detail::serial_align(data.size()) - data.size();
+            if(n != 0)
+                data.push_many(0, n);
+        }
+
+        /// Appends a block and its header, returning where its arrays start.
+        template<typename type>
+        inline u8* begin(serial_kind kind, usize count, usize free, usize bytes) noexcept
+        {
+            constexpr usize header_bytes = __detail::serial_align(sizeof(serial_header));
+            static_assert(alignof(type) <= serial_alignment, "the elements must fit the alignment of blocks");
+
+            span<u8> block = data.push_uninitialized(header_bytes + bytes);
+            serial_header h { serial_header::signature, serial_traits<type>::tag, serial_traits<type>::version, static_cast<u8>(kind), 0, sizeof(type), count, free, header_bytes + bytes };
+            ::std::memset(block.data(), 0, header_bytes);
+            ::std::memcpy(block.data(), &h, sizeof(h));
+            return block.data() + header_bytes;
+        }
+
+        /// Copies an array, clearing the padding after it.
+        static inline void copy(u8* to, const void* from, usize n) noexcept
+        {
+            if(n != 0)
+                ::std::memcpy(to, from, n);
+            ::std::memset(to + n, 0, __detail::serial_align(n) - n);
+        }
+
+        /// Copies the slots of a sparse array, zeroing the empty ones, whose bytes are
+        /// unspecified, so no stale memory ends up in the blocks.
+        template<typename type>
+        static inline void copy_slots(u8* to, const type* from, const const_span<bool>& occupied) noexcept
+        {
+            copy(to, from, occupied.size() * sizeof(type));
+            for(usize i = 0; i != occupied.size(); i++)
+                if(!occupied[i])
+                    ::std::memset(to + i * sizeof(type), 0, sizeof(type));
+        }
+
+    private:
+        array<u8>& data;
+    };
+
+    /// @brief Reads blocks written by serial_writer, in order.
+    ///
+    /// Views point straight into the bytes read, with no copies, and stay valid as long as
+    /// they do. Every block is checked before it's read: its header must match the type
+    /// and kind asked for, its arrays must fit in the bytes, and its data must be aligned
+    /// for the type in memory. Arenas also get their free indices checked against their
+    /// occupancy, with a bitmap of one bit per slot. A block that fails the checks isn't
+    /// consumed, and peek lets the caller inspect it, for example to migrate an older
+    /// version.
+    class serial_reader
+    {
+    public:
+        /// @brief Constructs a reader over bytes.
+        /// @param bytes The bytes, as written by serial_writer, e.g. mapped from a file.
+        inline serial_reader(const const_span<u8>& bytes) noexcept :
+            data(bytes), offset(0)
+        {
+        }
+
+        /// @brief Checks if every block was read.
+        /// @return true if there are no bytes left, false otherwise.
+        inline bool done() const noexcept { return offset >= data.size(); }
+
+        /// @brief Returns the header of the next block.
+        /// @return A pointer to the header, or nullptr if no whole header is left or it's
+        /// misaligned.
+        inline const serial_header* peek() const noexcept
+        {
+            if(offset > data.size() || data.size() - offset < sizeof(serial_header) || !aligned<serial_header>(data.data() + offset))
+                return nullptr;
+            return reinterpret_cast<const serial_header*>(data.data() + offset);
+        }
+
+        /// @brief Skips the next block, whatever it holds.
+        /// @return true if a block was skipped, false if its header is invalid.
+        inline bool skip() noexcept
+        {
+            const serial_header* h = peek();
+            if(h == nullptr || h->magic != serial_header::signature || h->size > data.size() - offset || h->size % serial_alignment != 0 || h->size == 0)
+                return false;
+            offset += h->size;
+            return true;
+        }
+
+        /// @brief Views a block of contiguous elements.
+        /// @tparam type The type of the elements.
+        /// @param out The span set to view the elements.
+        /// @return true if the block was read, false otherwise.
+        template<trivially_copyable type>
+        inline bool read(const_span<type>& out) noexcept
+        {
+            const u8* block = open<type>(serial_kind::array);
+            if(block == nullptr)
+                return false;
+
+            out = const_span<type>(reinterpret_cast<const type*>(block), peek()->count);
+            consume();
+            return true;
+        }
+
+        /// @brief Views a block of the slots of a sparse array.
+        /// @tparam type The type of the elements.
+        /// @param out The view set to the slots and their occupancy.
+        /// @return true if the block was read, false otherwise.
+        template<trivially_copyable type>
+        inline bool read(sparse_view<type>& out) noexcept
+        {
+            const u8* block = open<type>(serial_kind::sparse_array);
+            if(block == nullptr || !slots(block, peek()->count, out))
+                return false;
+
+            consume();
+            return true;
+        }
+
+        /// @brief Views a block of the storage of an arena.
+        /// @tparam type The type of the elements.
+        /// @param out The view set to the slots, their occupancy and the free indices.
+        /// @return true if the block was read, false otherwise.
+        template<trivially_copyable type>
+        inline bool read(arena_view<type>& out) noexcept
+        {
+            const u8* block = open<type>(serial_kind::arena);
+            if(block == nullptr)
+                return false;
+
+            usize n = peek()->count;
+            if(!slots(block, n, out.elements))
+                return false;
+
+            // The free indices must be the empty slots, each once, or the arena would hand
+            // out an index twice.
+            const_span<usize> free(reinterpret_cast<const usize*>(block + array_bytes<type>(n) + array_bytes<bool>(n)), peek()->free);
+            array<u64> seen;
+            seen.push_many(0, (n + 63) / 64);
+            usize empty = 0;
+            for(bool b : out.elements.occupied)
+                empty += !b;
+            if(empty != free.size())
+                return false;
+            for(usize i : free)
+            {
+                if(i >= n || out.elements.occupied[i] || (seen[i / 64] >> (i % 64) & 1) != 0)
+                    return false;
+                seen[i / 64] |= u64(1) << (i % 64);
+            }
+
+            out.free = free;
+            consume();
+            return true;
+        }
+
+        /// @brief Copies a block of contiguous elements into an array.
+        /// @tparam type The type of the elements.
+        /// @tparam allocator The allocator of the array.
+        /// @param out The array, whose contents are replaced.
+        /// @return true if the block was read, false otherwise.
+        template<trivially_copyable type, typename allocator>
+        inline bool read(array<type, allocator>& out) noexcept
+        {
+            const_span<type> view;
+            if(!read(view))
+                return false;
+
+            out = view;
+            return true;
+        }
+
+        /// @brief Copies a block of the slots of a sparse array into a sparse array.
+        /// @tparam type The type of the elements.
+        /// @tparam allocator The allocator of the sparse array.
+        /// @param out The sparse array, whose contents are replaced.
+        /// @return true if the block was read, false otherwise.
+        template<trivially_copyable type, typename allocator>
+        inline bool read(sparse_array<type, allocator>& out) noexcept
+        {
+            sparse_view<type> view;
+            if(!read(view))
+                return false;
+
+            out.assign(view.slots, view.occupied);
+            return true;
+        }
+
+        /// @brief Copies a block of the storage of an arena into an arena.
+        /// @tparam type The type of the elements.
+        /// @tparam allocator The allocator of the arena.
+        /// @param out The arena, whose contents are replaced.
+        /// @return true if the block was read, false otherwise.
+        template<trivially_copyable type, typename allocator>
+        inline bool read(basic_arena<type, allocator>& out) noexcept
+        {
+            arena_view<type> view;
+            if(!read(view))
+                return false;
+
+            out.assign(view.elements.slots, view.elements.occupied, view.free);
+            return true;
+        }
+
+    private:
+        template<typename type>
+        static inline constexpr usize array_bytes(usize n) noexcept { return __detail::serial_align(n * sizeof(type)); }
+
+        template<typename type>
+        static inline bool aligned(const void* p) noexcept { return reinterpret_cast<::std::uintptr_t>(p) % alignof(type) == 0; }
+
+        /// Checks the header of the next block, returning where its arrays start.
+        template<typename type>
+        inline const u8* open(serial_kind kind) const noexcept
+        {
+            constexpr usize header_bytes = __detail::serial_align(sizeof(serial_header));
+
+            const serial_header* h = peek();
+            if(h == nullptr || h->magic != serial_header::signature || h->tag != serial_traits<type>::tag || h->version != serial_traits<type>::version)
+                return nullptr;
+            if(h->kind != static_cast<u8>(kind) || h->element_size != sizeof(type) || h->size > data.size() - offset)
+                return nullptr;
+
+            // The counts are checked against the size of the block before any array is sized by them.
+            constexpr u64 limit = u64(1) << 48;
+            if(h->count >= limit / sizeof(type) || h->free >= limit / sizeof(usize))
+                return nullptr;
+
+            usize bytes = header_bytes + array_bytes<type>(h->count);
+            if(kind != serial_kind::array)
+                bytes += array_bytes<bool>(h->count);
+            if(kind == serial_kind::arena)
+                bytes += array_bytes<usize>(h->free);
+            else if(h->free != 0)
+                return nullptr;
+            if(bytes != h->size)
+                return nullptr;
+
+            const u8* block = data.data() + offset + header_bytes;
+            return aligned<type>(block) && (kind != serial_kind::arena || aligned<usize>(block)) ? block : nullptr;
+        }
+
+        /// Views the slots of a block and their occupancy, whose bytes must all be booleans.
+        template<typename type>
+        inline bool slots(const u8* block, usize n, sparse_view<type>& out) const noexcept
+        {
+            const u8* bits = block + array_bytes<type>(n);
+            for(usize i = 0; i != n; i++)
+                if(bits[i] > 1)
+                    return false;
+
+            out.slots = const_span<type>(reinterpret_cast<const type*>(block), n);
+            out.occupied = const_span<bool>(reinterpret_cast<const bool*>(bits), n);
+            return true;
+        }
+
+        inline void consume() noexcept { offset += peek()->size; }
+
+    private:
+        const_span<u8> data;
+        usize offset;
+    };
+};
@@ -0,0 +1,363 @@
+/**
+ * @file
+ * @brief Struct-of-arrays container.
+ */
+#pragma once
+
+#include "array.hpp"
+
+#include <tuple>
+
+namespace utils
+{
+    /// @brief Variable length array that stores each field of its elements in a separate column.
+    /// @tparam types The types of the columns.
+    ///
+    /// All the columns live in a single allocation, each one starting at an address aligned
+    /// to column_alignment bytes, so that a span over any column can be handed directly to
+    /// vectorized loops. Rows are pushed, popped and erased over all the columns at once.
+    template<typename... types>
+    class soa_array
+    {
+    public:
+        /** The type of the struct-of-arrays. */
+        typedef soa_array<types...> soa_array_type;
+
+        /** The allocator used for the underlying memory. */
+        typedef basic_allocator<byte> allocator_type;
+        /** The type of the internal buffer that holds all the columns. */
+        typedef buffer<byte, allocator_type> buffer_type;
+
+        /// @brief The type of a column.
+        /// @tparam i The index of the column.
+        template<usize i>
+        using column_type = ::std::tuple_element_t<i, ::std::tuple<types...>>;
+
+        /** The number of columns. */
+        static constexpr usize column_count = sizeof...(types);
+        /** The alignment, in bytes, of the beginning of every column. */
+        static constexpr usize column_alignment = 64;
+
+        static_assert(column_count != 0, "soa_array needs at least one column");
+
+        /// @brief Default constructor.
+        ///
+        /// Empty array, with no elements allocated.
+        inline soa_array() noexcept :
+            buff(), columns(), count(0), cap(0)
+        {
+        }
+
+        /// @brief Constructs an array with the given capacity, but with size 0.
+        /// @param capacity The capacity of the array.
+        inline soa_array(usize capacity) noexcept :
+            buff(), columns(), count(0), cap(0)
+        {
+            resize(capacity);
+        }
+
+        /// @brief Move constructor.
+        /// @param other The array moved.
+        inline soa_array(soa_array_type&& other) noexcept :
+            buff(::std::move(other.buff)), columns(other.columns), count(other.count), cap(other.cap)
+        {
+            other.columns = column_pointers();
+            other.count = 0;
+            other.cap = 0;
+        }
+
+        /// @brief Copy constructor.
+        /// @param other The array copied.
+        ///
+        /// Note: columns of relocatable types are copied with a single memcpy.
+        inline soa_array(const soa_array_type& other) noexcept :
+            buff(), columns(), count(0), cap(0)
+        {
+            resize(other.count);
+            copy_from(other);
+        }
+
+        /// @brief Destructor.
+        ///
+        /// Calls the destructors of all the elements and then deallocates the space.
+        inline ~soa_array() noexcept
+        {
+            clear();
+        }
+
+        /// @brief Move assignment.
+        /// @param other The array to move.
+        inline soa_array_type& operator=(soa_array_type&& other) noexcept
+        {
+            clear();
+
+            buff = ::std::move(other.buff);
+            columns = other.columns; other.columns = column_pointers();
+            count = other.count; other.count = 0;
+            cap = other.cap; other.cap = 0;
+
+            return *this;
+        }
+
+        /// @brief Copy assignment.
+        /// @param other The array to copy.
+        inline soa_array_type& operator=(const soa_array_type& other) noexcept
+        {
+            clear();
+            reserve(other.count);
+            copy_from(other);
+
+            return *this;
+        }
+
+        /// @brief Assures that the array has enough space for some number of rows.
+        /// @param capacity The number of rows to reserve.
+        inline void reserve(usize capacity) noexcept
+        {
+            if(cap < capacity)
+                resize(capacity);
+        }
+
+        /// @brief Shrinks the array's capacity to exactly its size.
+        inline void shrink_to_fit() noexcept
+        {
+            resize(count);
+        }
+
+        /// @brief Pushes a row, constructing each column's element in-place.
+        /// @param _args One argument per column, forwarded to that column's constructor.
+        ///
+        /// If the array doesn't have enough space for the new row, reallocates the memory
+        /// in such a way that a series of N pushes will result in O(N) time complexity.
+        template<typename... args> requires (sizeof...(args) == column_count)
+        inline void push(args&&... _args) noexcept
+        {
+            if(count == cap)
+                resize(capacity_growth(1));
+
+            push_unchecked(::std::forward<args>(_args)...);
+        }
+
+        /// @brief Pushes a row without checking the capacity of the array.
+        /// @param _args One argument per column, forwarded to that column's constructor.
+        template<typename... args> requires (sizeof...(args) == column_count)
+        inline void push_unchecked(args&&... _args) noexcept
+        {
+            push_row(::std::index_sequence_for<types...>(), ::std::forward<args>(_args)...);
+        }
+
+        /// @brief Pushes default constructed rows.
+        /// @param n The number of rows to push.
+        /// @return The index of the first row pushed.
+        ///
+        /// Useful for filling the columns afterwards through their spans.
+        inline usize push_many(usize n) noexcept
+        {
+            if(count + n > cap)
+                resize(capacity_growth(n));
+
+            usize first = count;
+            for_each_column([first, n]<typename column>(column* data) {
+                for(usize i = first; i != first + n; i++)
+                    basic_allocator<column>::construct_at(data + i);
+            });
+            count += n;
+
+            return first;
+        }
+
+        /// @brief Pops the last row of the array.
+        inline void pop() noexcept
+        {
+            --count;
+            for_each_column([this]<typename column>(column* data) {
+                basic_allocator<column>::destruct_at(data + count);
+            });
+        }
+
+        /// @brief Pops the last rows of the array.
+        /// @param n The number of rows to pop.
+        inline void pop_many(usize n) noexcept
+        {
+            usize new_count = count - n;
+            for_each_column([this, new_count]<typename column>(column* data) {
+                for(usize i = count; i != new_count; i--)
+                    basic_allocator<column>::destruct_at(data + i - 1);
+            });
+            count = new_count;
+        }
+
+        /// @brief Erases a row, without keeping the same ordering.
+        /// @param i The index of the row to erase.
+        ///
+        /// Moves the last row into the position of the erased one in every column.
+        inline void erase_unordered(usize i) noexcept
+        {
+            --count;
+            for_each_column([this, i]<typename column>(column* data) {
+                if(i != count)
+                    data[i] = ::std::move(data[count]);
+                basic_allocator<column>::destruct_at(data + count);
+            });
+        }
+
+        /// @brief Clears the array.
+        inline void clear() noexcept
+        {
+            pop_many(count);
+        }
+
+        /// @brief Calculates the new capacity of the array that accommodates an additional number of rows.
+        /// @param extra The additional number of rows that the new capacity must accommodate.
+        /// @return The new capacity.
+        inline usize capacity_growth(usize extra) const noexcept
+        {
+            if(row_size * count <= (16 << 10))
+                return (count + extra) * 2;
+            else return (count + extra) * 3 / 2;
+        }
+
+        /// @brief Returns a span over a whole column.
+        /// @tparam i The index of the column.
+        /// @return A span over the elements of column i.
+        template<usize i>
+        inline span<column_type<i>> column() noexcept { return span<column_type<i>>(::std::get<i>(columns), count); }
+        /// @brief Returns a const span over a whole column.
+        /// @tparam i The index of the column.
+        /// @return A const span over the elements of column i.
+        template<usize i>
+        inline const_span<column_type<i>> column() const noexcept { return const_span<column_type<i>>(::std::get<i>(columns), count); }
+
+        /// @brief Accesses an element of a column.
+        /// @tparam c The index of the column.
+        /// @param i The index of the row.
+        /// @return A reference to the element of column c in row i.
+        template<usize c>
+        inline column_type<c>& get(usize i) noexcept { return ::std::get<c>(columns)[i]; }
+        /// @brief Accesses an element of a column.
+        /// @tparam c The index of the column.
+        /// @param i The index of the row.
+        /// @return A const reference to the element of column c in row i.
+        template<usize c>
+        inline const column_type<c>& get(usize i) const noexcept { return ::std::get<c>(columns)[i]; }
+
+        /// @brief Calculates the number of rows in the array.
+        /// @return The number of rows.
+        inline usize size() const noexcept { return count; }
+        /// @brief Calculates the capacity of the array.
+        /// @return The number of rows the array can hold before reallocating.
+        inline usize capacity() const noexcept { return cap; }
+        /// @brief Checks if the array is empty.
+        /// @return true if the array is empty, false otherwise.
+        inline bool empty() const noexcept { return count == 0; }
+
+    private:
+        typedef ::std::tuple<types*...> column_pointers;
+
+        static constexpr usize row_size = (sizeof(types) + ...);
+
+        template<typename function>
+        inline void for_each_column(function&& f) noexcept
+        {
+            ::std::apply([&f](auto*... data) { (f(data), ...); }, columns);
+        }
+
+        template<usize... i, typename... args>
+        inline void push_row(::std::index_sequence<i...>, args&&... _args) noexcept
+        {
+            (basic_allocator<column_type<i>>::construct_at(::std::get<i>(columns) + count, ::std::forward<args>(_args)), ...);
+            count++;
+        }
+
+        static inline usize align_up(usize n) noexcept
+        {
+            return (n + column_alignment - 1) & ~(column_alignment - 1);
+        }
+
+        /// Places the columns for a capacity of n rows over the given buffer.
+        template<usize... i>
+        static inline column_pointers layout(buffer_type& memory, usize n, ::std::index_sequence<i...>) noexcept
+        {
+            usize offset = align_up(reinterpret_cast<usize>(memory.data())) - reinterpret_cast<usize>(memory.data());
+            column_pointers pointers;
+            ((::std::get<i>(pointers) = reinterpret_cast<column_type<i>*>(memory.data() + offset),
+              offset = align_up(offset + n * sizeof(column_type<i>))), ...);
+            return pointers;
+        }
+
+        static inline usize layout_size(usize n) noexcept
+        {
+            usize bytes = column_alignment;
+            ((bytes = align_up(bytes + n * sizeof(types))), ...);
+            return bytes;
+        }
+
+        template<typename column>
+        static inline void relocate(column* to, column* from, usize n) noexcept
+        {
+            for(usize i = 0; i != n; i++)
+            {
+                basic_allocator<column>::construct_at(to + i, ::std::move(from[i]));
+                basic_allocator<column>::destruct_at(from + i);
+            }
+        }
+
+        template<typename column> requires relocatable<column>
+        static inline void relocate(column* to, column* from, usize n) noexcept
+        {
+            ::std::memcpy(to, from, n * sizeof(column));
+        }
+
+        template<typename column>
+        static inline void copy(column* to, const column* from, usize n) noexcept
+        {
+            for(usize i = 0; i != n; i++)
+                basic_allocator<column>::construct_at(to + i, from[i]);
+        }
+
+        template<typename column> requires relocatable<column>
+        static inline void copy(column* to, const column* from, usize n) noexcept
+        {
+            ::std::memcpy(to, from, n * sizeof(column));
+        }
+
+        template<usize... i>
+        inline void copy_columns(const soa_array_type& other, ::std::index_sequence<i...>) noexcept
+        {
+            (copy(::std::get<i>(columns), ::std::get<i>(other.columns), other.count), ...);
+        }
+
+        inline void copy_from(const soa_array_type& other) noexcept
+        {
+            copy_columns(other, ::std::index_sequence_for<types...>());
+            count = other.count;
+        }
+
+        template<usize... i>
+        inline void relocate_columns(const column_pointers& to, ::std::index_sequence<i...>) noexcept
+        {
+            (relocate(::std::get<i>(to), ::std::get<i>(columns), count), ...);
+        }
+
+        /// Assumes that n is at least the current size.
+        void resize(usize n) noexcept
+        {
+            buffer_type new_buffer(layout_size(n));
+            column_pointers new_columns = layout(new_buffer, n, ::std::index_sequence_for<types...>());
+
+            relocate_columns(new_columns, ::std::index_sequence_for<types...>());
+
+            buff = ::std::move(new_buffer);
+            columns = new_columns;
+            cap = n;
+        }
+
+    private:
+        buffer_type buff;
+        column_pointers columns;
+        usize count;
+        usize cap;
+    };
+
+    template<typename... types> struct is_relocatable<soa_array<types...>> : public ::std::true_type {};
+};
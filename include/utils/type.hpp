@@ -10,6 +10,10 @@
 #include <cstdint>
 #include <utility>
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
 /** Byte type. */
 typedef ::std::uint8_t byte;
 
@@ -43,6 +47,23 @@ typedef ::std::ptrdiff_t size;
 
 namespace utils
 {
+    /// @brief Size in bytes of a cache line.
+    ///
+    /// Data written concurrently by different threads is aligned to this size to avoid
+    /// false sharing.
+    constexpr usize cache_line_size = 64;
+
+    /// @brief Hints that the cache line holding an address is about to be read.
+    /// @param ptr The address; it doesn't need to be valid, as nothing is loaded from it.
+    inline void prefetch([[maybe_unused]] const void* ptr) noexcept
+    {
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(ptr);
+#endif
+    }
+
     /// @brief Concept that classifies a fundamental type.
     /// @tparam type The type checked.
     template<typename type>
@@ -0,0 +1,202 @@
+/**
+ * @file
+ * @brief Palette-compressed storage for the voxels of a chunk.
+ */
+#pragma once
+
+#include <utils/array.hpp>
+
+namespace voxel
+{
+    /** The type of the id of a block. */
+    typedef u16 block;
+
+    /** The block of empty space; every other block is opaque. */
+    constexpr block air = 0;
+
+    /** The number of voxels along every edge of a chunk. */
+    constexpr usize chunk_size = 32;
+    /** The base 2 logarithm of chunk_size. */
+    constexpr usize chunk_shift = 5;
+    /** The number of voxels in a chunk. */
+    constexpr usize chunk_volume = chunk_size * chunk_size * chunk_size;
+
+    /// @brief Calculates the index of a voxel inside a chunk.
+    /// @param x The x coordinate of the voxel, in [0, chunk_size).
+    /// @param y The y coordinate of the voxel, in [0, chunk_size).
+    /// @param z The z coordinate of the voxel, in [0, chunk_size).
+    /// @return The index of the voxel; x varies fastest, then y, then z.
+    inline constexpr usize voxel_index(usize x, usize y, usize z) noexcept { return x | (y << chunk_shift) | (z << (2 * chunk_shift)); }
+
+    /// @brief The position of a voxel inside a chunk.
+    struct local_coord
+    {
+        u8 x;
+        u8 y;
+        u8 z;
+
+        /// @brief Calculates the index of the voxel.
+        /// @return The index of the voxel inside its chunk.
+        inline constexpr usize index() const noexcept { return voxel_index(x, y, z); }
+    };
+
+    /// @brief The blocks of a chunk, compressed with a palette.
+    ///
+    /// Every voxel stores an index into a palette of the distinct blocks of the chunk,
+    /// bit-packed at 1, 2, 4 or 8 bits per voxel so that an index never straddles two
+    /// 64-bit words. A chunk made of a single block stores no indices at all, and a chunk
+    /// with more than 256 distinct blocks stores the 16-bit block ids directly.
+    ///
+    /// The width grows when a block is added to a full palette. It shrinks once the blocks
+    /// left would fill at most half the palette of a smaller width, or down to no indices
+    /// when a single block is left, so a voxel flipping back and forth doesn't repack the
+    /// chunk every time. Direct chunks don't count their blocks and only narrow on
+    /// shrink_to_fit.
+    class chunk
+    {
+    public:
+        /** The number of bits per voxel of a chunk storing block ids directly. */
+        static constexpr u8 direct_bits = 16;
+        /** The largest palette before a chunk switches to storing block ids directly. */
+        static constexpr usize max_palette_size = 256;
+
+        /// @brief Constructs a chunk filled with a single block.
+        /// @param value The block.
+        chunk(block value = 0) noexcept;
+
+        /// @brief Reads a voxel.
+        /// @param i The index of the voxel.
+        /// @return The block of the voxel.
+        inline block get(usize i) const noexcept
+        {
+            if(bits == 0)
+                return entries[0];
+
+            usize index = read(i);
+            return bits == direct_bits ? static_cast<block>(index) : entries[index];
+        }
+
+        /// @brief Reads a voxel.
+        /// @param c The position of the voxel.
+        /// @return The block of the voxel.
+        inline block get(local_coord c) const noexcept { return get(c.index()); }
+
+        /// @brief Writes a voxel.
+        /// @param i The index of the voxel.
+        /// @param b The new block of the voxel.
+        void set(usize i, block b) noexcept;
+
+        /// @brief Writes a voxel.
+        /// @param c The position of the voxel.
+        /// @param b The new block of the voxel.
+        inline void set(local_coord c, block b) noexcept { set(c.index(), b); }
+
+        /// @brief Reads many voxels.
+        /// @param coords The positions of the voxels.
+        /// @param out The span that receives the blocks, as large as coords.
+        void get_many(const utils::const_span<local_coord>& coords, const utils::span<block>& out) const noexcept;
+
+        /// @brief Writes many voxels.
+        /// @param coords The positions of the voxels.
+        /// @param blocks The new blocks of the voxels, as large as coords.
+        ///
+        /// The palette is widened at most once and narrowed at most once for the whole batch.
+        void set_many(const utils::const_span<local_coord>& coords, const utils::const_span<block>& blocks) noexcept;
+
+        /// @brief Writes the same block to many voxels.
+        /// @param coords The positions of the voxels.
+        /// @param b The new block of the voxels.
+        void set_many(const utils::const_span<local_coord>& coords, block b) noexcept;
+
+        /// @brief Fills the chunk with a single block.
+        /// @param b The block.
+        void fill(block b) noexcept;
+
+        /// @brief Replaces the contents of the chunk with uncompressed blocks.
+        /// @param blocks The blocks of all the voxels, chunk_volume of them in voxel_index order.
+        ///
+        /// The chunk ends up with the smallest width that fits its distinct blocks.
+        void encode(const utils::const_span<block>& blocks) noexcept;
+
+        /// @brief Uncompresses the blocks of the chunk.
+        /// @param out The span that receives the blocks of all the voxels, chunk_volume of them in voxel_index order.
+        void decode(const utils::span<block>& out) const noexcept;
+
+        /// @brief Replaces the contents of the chunk with packed indices written in place.
+        /// @param palette The palette of the indices: a single block for a width of 0, none for
+        /// direct_bits, and at most 2^width blocks otherwise.
+        /// @param width The number of bits per voxel: 0, 1, 2, 4, 8 or direct_bits.
+        /// @return A span over the uninitialized words of the indices, laid out like words(),
+        /// which must be filled before calling recount.
+        ///
+        /// Lets a loader unpack stored indices straight into the chunk instead of decoding
+        /// them into blocks first.
+        utils::span<u64> assign_packed(const utils::const_span<block>& palette, u8 width) noexcept;
+
+        /// @brief Counts the uses of the palette entries after assign_packed.
+        /// @return true if every index is inside the palette, false otherwise, in which case
+        /// the chunk is filled with air.
+        bool recount() noexcept;
+
+        /// @brief Repacks the chunk with the smallest width that fits its distinct blocks.
+        void shrink_to_fit() noexcept;
+
+        /// @brief Checks if the chunk is made of a single block.
+        /// @return true if every voxel has the same block, false otherwise.
+        inline bool uniform() const noexcept { return bits == 0; }
+
+        /// @brief Returns the number of bits used by every voxel.
+        /// @return 0 for a uniform chunk, 1, 2, 4, 8, or direct_bits.
+        inline u8 bits_per_voxel() const noexcept { return bits; }
+
+        /// @brief Returns the number of distinct blocks in the palette.
+        /// @return The number of palette entries used by at least one voxel, or 0 for a direct chunk.
+        inline usize palette_size() const noexcept { return live; }
+
+        /// @brief Returns the palette.
+        /// @return A const span over the palette entries; unused entries are kept until the chunk is repacked.
+        inline utils::const_span<block> palette() const noexcept { return entries; }
+
+        /// @brief Returns the packed indices.
+        /// @return A const span over the words holding the voxel indices.
+        inline utils::const_span<u64> words() const noexcept { return utils::const_span<u64>(data.data(), data.size()); }
+
+        /// @brief Returns the memory used by the chunk.
+        /// @return The number of bytes allocated for the palette and the indices.
+        inline usize memory_usage() const noexcept
+        {
+            return entries.capacity() * sizeof(block) + counts.capacity() * sizeof(u16) + data.size() * sizeof(u64);
+        }
+
+    private:
+        inline usize read(usize i) const noexcept
+        {
+            usize bit = i * bits;
+            return (data[bit >> 6] >> (bit & 63)) & ((u64(1) << bits) - 1);
+        }
+
+        inline void write(usize i, usize index) noexcept
+        {
+            usize bit = i * bits;
+            u64 mask = ((u64(1) << bits) - 1) << (bit & 63);
+            u64& word = data[bit >> 6];
+            word = (word & ~mask) | (u64(index) << (bit & 63));
+        }
+
+        usize find_or_add(block b) noexcept;
+        void replace(usize i, block b) noexcept;
+        void reserve(const utils::const_span<block>& blocks) noexcept;
+        void widen(u8 width) noexcept;
+        void narrow() noexcept;
+        void repack(u8 width, const utils::const_span<usize>& remap) noexcept;
+
+        static u8 width_for(usize n) noexcept;
+
+    private:
+        utils::array<block> entries;
+        utils::array<u16> counts;
+        utils::buffer<u64> data;
+        u16 live;
+        u8 bits;
+    };
+};
@@ -0,0 +1,154 @@
+/**
+ * @file
+ * @brief A cache of chunks held to a fixed number of bytes.
+ */
+#pragma once
+
+#include "region.hpp"
+
+#include <utils/list.hpp>
+
+namespace voxel
+{
+    /// @brief Keeps chunks in memory within a hard byte budget.
+    ///
+    /// Chunks live in two tiers: a hot one, decompressed and ready to use, and a cold one,
+    /// compressed with compress_chunk, several times smaller. Both are lists ordered by
+    /// recency in a single utils::list_arena, whose nodes sit in a basic_arena and link to
+    /// each other by index, and a chunk_map finds the node of a chunk.
+    ///
+    /// When the hot tier grows past its share of the budget, its least recently used chunks
+    /// are compressed into the cold tier. When both tiers together grow past the budget,
+    /// the least recently used cold chunks leave memory: the ones edited since they were
+    /// read are handed to the spill function to be written to disk, the others dropped.
+    /// Getting a cold chunk decompresses it back into the hot tier.
+    ///
+    /// The bytes counted are the ones allocated by the chunks and the payloads, and a fixed
+    /// overhead per chunk; the spare capacity of the arena and the map isn't. The most
+    /// recently used hot chunk always stays, even if it alone is over the budget.
+    class chunk_cache
+    {
+    public:
+        /** The type of the function chunks edited since they were read are written with. */
+        typedef void (*spill_callback)(const chunk_coord& c, utils::array<u8>&& payload, void* user);
+
+        /// @brief Constructs an empty cache.
+        /// @param budget The largest number of bytes held by the cache.
+        /// @param hot_budget The largest number of bytes held by decompressed chunks, at most budget.
+        /// @param spill The function edited chunks are handed to when they leave memory,
+        /// with a payload to move into region_io::write for example.
+        /// @param user User data passed to spill.
+        chunk_cache(usize budget, usize hot_budget, spill_callback spill, void* user = nullptr) noexcept;
+
+        chunk_cache(const chunk_cache&) = delete;
+        chunk_cache& operator=(const chunk_cache&) = delete;
+
+        /// @brief Returns a chunk, making it the most recently used one.
+        /// @param c The coordinates of the chunk.
+        /// @return A pointer to the chunk, decompressed if it was cold, or nullptr if the
+        /// chunk isn't cached or its payload is corrupt. It stays valid until the next call
+        /// that adds or gets a chunk.
+        ///
+        /// A corrupt payload read from disk is dropped, so the chunk can be read again; one
+        /// edited since stays cold and is written as it is.
+        chunk* get(const chunk_coord& c) noexcept;
+
+        /// @brief Checks if a chunk is cached, without changing its recency.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk is in either tier, false otherwise.
+        inline bool contains(const chunk_coord& c) const noexcept { return nodes.contains(c); }
+
+        /// @brief Checks if a chunk is in the hot tier.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk is cached decompressed, false otherwise.
+        bool hot(const chunk_coord& c) const noexcept;
+
+        /// @brief Adds a decompressed chunk, or replaces it, as the most recently used one.
+        /// @param c The coordinates of the chunk.
+        /// @param value The chunk, moved into the cache.
+        /// @param dirty true if the chunk differs from the one on disk, e.g. was generated.
+        /// @return A reference to the chunk in the cache, valid as the pointers of get.
+        chunk& insert(const chunk_coord& c, chunk&& value, bool dirty) noexcept;
+
+        /// @brief Adds a compressed chunk, or replaces it, as the most recently used cold one.
+        /// @param c The coordinates of the chunk.
+        /// @param payload The payload, as read from a region file, moved into the cache.
+        ///
+        /// Chunks read ahead of their use can be kept compressed until they're needed.
+        void insert(const chunk_coord& c, utils::array<u8>&& payload) noexcept;
+
+        /// @brief Reports that a chunk was edited, so it's written when it leaves memory.
+        /// @param c The coordinates of the chunk.
+        ///
+        /// A chunk grows as it's edited, so the budget is enforced again.
+        void changed(const chunk_coord& c) noexcept;
+
+        /// @brief Drops a chunk without writing it.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk was dropped, false if it wasn't cached.
+        bool erase(const chunk_coord& c) noexcept;
+
+        /// @brief Writes every edited chunk with the spill function, keeping them cached.
+        /// @return The number of chunks written.
+        usize flush() noexcept;
+
+        /// @brief Changes the budgets, moving chunks out of memory as needed.
+        /// @param budget The largest number of bytes held by the cache.
+        /// @param hot_budget The largest number of bytes held by decompressed chunks, at most budget.
+        void set_budget(usize budget, usize hot_budget) noexcept;
+
+        /// @brief Returns the number of bytes held by the cache.
+        /// @return The number of bytes held by both tiers.
+        inline usize memory() const noexcept { return hot_bytes + cold_bytes; }
+
+        /// @brief Returns the number of bytes held by the hot tier.
+        /// @return The number of bytes held by decompressed chunks.
+        inline usize hot_memory() const noexcept { return hot_bytes; }
+
+        /// @brief Returns the number of chunks in the hot tier.
+        /// @return The number of decompressed chunks.
+        inline usize hot_size() const noexcept { return hot_list.size(); }
+
+        /// @brief Returns the number of chunks in the cold tier.
+        /// @return The number of compressed chunks.
+        inline usize cold_size() const noexcept { return cold_list.size(); }
+
+        /// @brief Returns the number of cached chunks.
+        /// @return The number of chunks in both tiers.
+        inline usize size() const noexcept { return hot_list.size() + cold_list.size(); }
+
+    private:
+        /// @brief A cached chunk, in either tier.
+        struct entry
+        {
+            chunk_coord coord;
+            chunk data;
+            utils::array<u8> payload;
+            usize bytes;
+            bool hot;
+            bool dirty;
+        };
+
+        typedef utils::list_arena<entry> list_arena_type;
+        typedef list_arena_type::index_type index_type;
+
+        static usize measure(const entry& e) noexcept;
+        void resize(entry& e) noexcept;
+        bool promote(index_type i) noexcept;
+        void demote(index_type i) noexcept;
+        void evict(index_type i) noexcept;
+        void enforce() noexcept;
+
+    private:
+        list_arena_type entries;
+        list_arena_type::list_type hot_list;
+        list_arena_type::list_type cold_list;
+        chunk_map<index_type> nodes;
+        spill_callback spill;
+        void* user;
+        usize total_budget;
+        usize hot_budget;
+        usize hot_bytes;
+        usize cold_bytes;
+    };
+};
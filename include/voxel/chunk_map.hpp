@@ -0,0 +1,395 @@
+/**
+ * @file
+ * @brief Hash map from chunk coordinates to chunk data.
+ */
+#pragma once
+
+#include "chunk.hpp"
+
+#include <utils/arena.hpp>
+
+#include <atomic>
+
+namespace voxel
+{
+    /// @brief The coordinates of a chunk in the world, in units of chunks.
+    struct chunk_coord
+    {
+        i32 x;
+        i32 y;
+        i32 z;
+
+        /// @brief Finds the chunk that contains a voxel.
+        /// @param vx The x coordinate of the voxel in the world.
+        /// @param vy The y coordinate of the voxel in the world.
+        /// @param vz The z coordinate of the voxel in the world.
+        /// @return The coordinates of the chunk containing the voxel.
+        static inline constexpr chunk_coord containing(i32 vx, i32 vy, i32 vz) noexcept
+        {
+            return chunk_coord { vx >> chunk_shift, vy >> chunk_shift, vz >> chunk_shift };
+        }
+
+        inline constexpr bool operator==(const chunk_coord&) const noexcept = default;
+    };
+
+    /// @brief A map from chunk coordinates to per-chunk values.
+    /// @tparam type The type of the values, by default chunk storage.
+    ///
+    /// Values live in a basic_arena, so the index of a value never changes while it is in
+    /// the map. The map itself is a flat open-addressing table with linear probing, holding
+    /// the Morton code of the coordinates of every chunk and the arena index of its value;
+    /// erasing shifts the following entries back instead of leaving tombstones.
+    ///
+    /// Coordinates must be in [-2^20, 2^20) along every axis, so that the Morton code of
+    /// any chunk fits in 63 bits.
+    ///
+    /// Lookups can run concurrently with each other, but not with insertions or erasures.
+    template<typename type = chunk>
+    class chunk_map
+    {
+    public:
+        /** The type of the values. */
+        typedef type value_type;
+        /** The type of the index of a value. */
+        typedef u32 index_type;
+
+        /** The type of the map. */
+        typedef chunk_map<value_type> chunk_map_type;
+
+        /** The index returned for missing chunks. */
+        static constexpr index_type none = ~index_type(0);
+        /** The number of chunks around and including a chunk. */
+        static constexpr usize neighborhood_size = 27;
+
+        /// @brief Constructs an empty map.
+        /// @param capacity The number of chunks to reserve space for.
+        inline chunk_map(usize capacity = 0) noexcept :
+            values(), slots(), mask(0), count(0), stamp(next_stamp())
+        {
+            reserve(capacity);
+        }
+
+        chunk_map(const chunk_map_type&) = delete;
+        chunk_map_type& operator=(const chunk_map_type&) = delete;
+
+        /// @brief Reserves space for some number of chunks.
+        /// @param n The number of chunks.
+        inline void reserve(usize n) noexcept
+        {
+            usize capacity = 16;
+            while(capacity < 2 * n)
+                capacity <<= 1;
+
+            if(capacity > slots.size())
+                rehash(capacity);
+        }
+
+        /// @brief Finds the value of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return The index of the value of the chunk, or none if the chunk isn't in the map.
+        ///
+        /// The last chunk found by every thread is cached, so repeated lookups of the same
+        /// chunk skip the table.
+        inline index_type find(const chunk_coord& c) const noexcept
+        {
+            u64 key = encode(c);
+            if(last_hit.stamp == stamp && last_hit.key == key)
+                return last_hit.index;
+
+            index_type index = probe(key, home(key));
+            if(index != none)
+                last_hit = { stamp, key, index };
+            return index;
+        }
+
+        /// @brief Finds the values of many chunks.
+        /// @param coords The coordinates of the chunks.
+        /// @param out The span that receives the indices of the values, or none for missing chunks.
+        ///
+        /// The slots of the whole batch are prefetched before any of them is probed.
+        inline void find_many(const utils::const_span<chunk_coord>& coords, const utils::span<index_type>& out) const noexcept
+        {
+            constexpr usize batch = 32;
+
+            u64 keys[batch];
+            usize homes[batch];
+            for(usize first = 0; first < coords.size(); first += batch)
+            {
+                usize n = ::std::min(batch, coords.size() - first);
+                for(usize i = 0; i != n; i++)
+                {
+                    keys[i] = encode(coords[first + i]);
+                    homes[i] = home(keys[i]);
+                    utils::prefetch(slots.data() + homes[i]);
+                }
+
+                for(usize i = 0; i != n; i++)
+                    out[first + i] = probe(keys[i], homes[i]);
+            }
+        }
+
+        /// @brief Finds the values of a chunk and its 26 neighbors.
+        /// @param c The coordinates of the chunk in the middle.
+        /// @param out The span that receives the 27 indices, or none for missing chunks. The
+        /// chunk at offset (dx, dy, dz) goes to (dx + 1) + 3 * (dy + 1) + 9 * (dz + 1).
+        inline void neighbors(const chunk_coord& c, const utils::span<index_type>& out) const noexcept
+        {
+            chunk_coord coords[neighborhood_size];
+            for(i32 dz = -1, i = 0; dz <= 1; dz++)
+                for(i32 dy = -1; dy <= 1; dy++)
+                    for(i32 dx = -1; dx <= 1; dx++, i++)
+                        coords[i] = chunk_coord { c.x + dx, c.y + dy, c.z + dz };
+
+            find_many(utils::const_span<chunk_coord>(coords, neighborhood_size), out);
+        }
+
+        /// @brief Finds the values of a chunk and its 26 neighbors.
+        /// @param c The coordinates of the chunk in the middle.
+        /// @param out The span that receives 27 pointers to the values, or nullptr for
+        /// missing chunks, in the same order as the indices.
+        inline void neighbors(const chunk_coord& c, const utils::span<value_type*>& out) noexcept
+        {
+            index_type indices[neighborhood_size];
+            neighbors(c, utils::span<index_type>(indices, neighborhood_size));
+            for(usize i = 0; i != neighborhood_size; i++)
+                out[i] = indices[i] == none ? nullptr : &values[indices[i]];
+        }
+
+        /// @brief Checks if a chunk is in the map.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk is in the map, false otherwise.
+        inline bool contains(const chunk_coord& c) const noexcept { return find(c) != none; }
+
+        /// @brief Returns the value of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return A pointer to the value of the chunk, or nullptr if it isn't in the map.
+        inline value_type* get(const chunk_coord& c) noexcept
+        {
+            index_type index = find(c);
+            return index == none ? nullptr : &values[index];
+        }
+
+        /// @brief Returns the value of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return A const pointer to the value of the chunk, or nullptr if it isn't in the map.
+        inline const value_type* get(const chunk_coord& c) const noexcept
+        {
+            index_type index = find(c);
+            return index == none ? nullptr : &values[index];
+        }
+
+        /// @brief Inserts a chunk, unless it already is in the map.
+        /// @param c The coordinates of the chunk.
+        /// @param _args The arguments to construct the value with, if the chunk is missing.
+        /// @return The index of the value of the chunk.
+        template<typename... args>
+        inline index_type insert(const chunk_coord& c, args&&... _args) noexcept
+        {
+            u64 key = encode(c);
+            index_type index = probe(key, home(key));
+            if(index != none)
+                return index;
+
+            if(2 * (count + 1) > slots.size())
+                rehash(slots.size() < 16 ? 16 : 2 * slots.size());
+
+            index = static_cast<index_type>(values.create(::std::forward<args>(_args)...));
+
+            usize i = home(key);
+            while(slots[i].key != empty_key)
+                i = (i + 1) & mask;
+
+            slots[i] = slot { key, index };
+            count++;
+            return index;
+        }
+
+        /// @brief Erases a chunk, destroying its value.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk was erased, false if it wasn't in the map.
+        inline bool erase(const chunk_coord& c) noexcept
+        {
+            if(count == 0)
+                return false;
+
+            u64 key = encode(c);
+            usize i = home(key);
+            while(slots[i].key != key)
+            {
+                if(slots[i].key == empty_key)
+                    return false;
+                i = (i + 1) & mask;
+            }
+
+            values.destroy(slots[i].value);
+
+            // Shift back the following entries that can move closer to their home slot.
+            for(usize j = (i + 1) & mask; slots[j].key != empty_key; j = (j + 1) & mask)
+            {
+                usize h = home(slots[j].key);
+                if(((j - h) & mask) >= ((j - i) & mask))
+                {
+                    slots[i] = slots[j];
+                    i = j;
+                }
+            }
+
+            slots[i].key = empty_key;
+            count--;
+            stamp = next_stamp();
+            return true;
+        }
+
+        /// @brief Erases all the chunks.
+        inline void clear() noexcept
+        {
+            for(slot& s : slots)
+                s.key = empty_key;
+
+            values.clear();
+            count = 0;
+            stamp = next_stamp();
+        }
+
+        /// @brief Calls a function on every chunk.
+        /// @param f The function, called as f(coord, index) for every chunk in the map.
+        template<typename function>
+        inline void for_each(function&& f) const noexcept
+        {
+            for(const slot& s : slots)
+                if(s.key != empty_key)
+                    f(decode(s.key), s.value);
+        }
+
+        /// @brief Returns the number of chunks in the map.
+        /// @return The number of chunks in the map.
+        inline usize size() const noexcept { return count; }
+
+        /// @brief Checks if the map is empty.
+        /// @return true if the map holds no chunks, false otherwise.
+        inline bool empty() const noexcept { return count == 0; }
+
+        /// @brief Access the value at an index.
+        /// @param i The index of the value.
+        /// @return A reference to the value at index i.
+        inline value_type& operator[](index_type i) noexcept { return values[i]; }
+        /// @brief Access the value at an index.
+        /// @param i The index of the value.
+        /// @return A const reference to the value at index i.
+        inline const value_type& operator[](index_type i) const noexcept { return values[i]; }
+
+        /// @brief Calculates the Morton code of the coordinates of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return The 63-bit key of the chunk, interleaving the bits of x, y and z.
+        static inline u64 encode(const chunk_coord& c) noexcept
+        {
+            return spread(u32(c.x + coord_bias)) | (spread(u32(c.y + coord_bias)) << 1) | (spread(u32(c.z + coord_bias)) << 2);
+        }
+
+        /// @brief Recovers the coordinates of a chunk from its Morton code.
+        /// @param key The key of the chunk.
+        /// @return The coordinates of the chunk.
+        static inline chunk_coord decode(u64 key) noexcept
+        {
+            return chunk_coord { i32(compact(key)) - coord_bias, i32(compact(key >> 1)) - coord_bias, i32(compact(key >> 2)) - coord_bias };
+        }
+
+    private:
+        struct slot
+        {
+            u64 key;
+            index_type value;
+        };
+
+        struct cache
+        {
+            u64 stamp;
+            u64 key;
+            index_type index;
+        };
+
+        static constexpr i32 coord_bias = i32(1) << 20;
+        static constexpr u64 empty_key = ~u64(0);
+
+        static inline u64 spread(u64 v) noexcept
+        {
+            v &= 0x1fffff;
+            v = (v | (v << 32)) & 0x1f00000000ffff;
+            v = (v | (v << 16)) & 0x1f0000ff0000ff;
+            v = (v | (v << 8)) & 0x100f00f00f00f00f;
+            v = (v | (v << 4)) & 0x10c30c30c30c30c3;
+            v = (v | (v << 2)) & 0x1249249249249249;
+            return v;
+        }
+
+        static inline u64 compact(u64 v) noexcept
+        {
+            v &= 0x1249249249249249;
+            v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3;
+            v = (v ^ (v >> 4)) & 0x100f00f00f00f00f;
+            v = (v ^ (v >> 8)) & 0x1f0000ff0000ff;
+            v = (v ^ (v >> 16)) & 0x1f00000000ffff;
+            v = (v ^ (v >> 32)) & 0x1fffff;
+            return v;
+        }
+
+        static inline u64 next_stamp() noexcept
+        {
+            static ::std::atomic<u64> stamps = 1;
+            return stamps.fetch_add(1, ::std::memory_order_relaxed);
+        }
+
+        inline usize home(u64 key) const noexcept
+        {
+            // Neighboring chunks have close Morton codes, so they are scattered with a
+            // Fibonacci multiplication before being masked.
+            return static_cast<usize>((key * 0x9e3779b97f4a7c15) >> 32) & mask;
+        }
+
+        inline index_type probe(u64 key, usize i) const noexcept
+        {
+            if(count == 0)
+                return none;
+
+            while(true)
+            {
+                const slot& s = slots[i];
+                if(s.key == key)
+                    return s.value;
+                if(s.key == empty_key)
+                    return none;
+                i = (i + 1) & mask;
+            }
+        }
+
+        inline void rehash(usize capacity) noexcept
+        {
+            utils::buffer<slot> old = ::std::move(slots);
+
+            slots = utils::buffer<slot>(capacity);
+            mask = capacity - 1;
+            for(slot& s : slots)
+                s.key = empty_key;
+
+            for(const slot& s : old)
+            {
+                if(s.key == empty_key)
+                    continue;
+
+                usize i = home(s.key);
+                while(slots[i].key != empty_key)
+                    i = (i + 1) & mask;
+                slots[i] = s;
+            }
+        }
+
+    private:
+        utils::basic_arena<value_type> values;
+        utils::buffer<slot> slots;
+        usize mask;
+        usize count;
+        u64 stamp;
+
+        static inline thread_local cache last_hit = { 0, 0, none };
+    };
+};
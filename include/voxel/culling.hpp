@@ -0,0 +1,129 @@
+/**
+ * @file
+ * @brief Frustum and occlusion culling of chunks on the CPU.
+ */
+#pragma once
+
+#include <utils/array.hpp>
+#include <utils/buffer.hpp>
+#include <utils/type.hpp>
+
+namespace voxel
+{
+    /// @brief The bounding box of a chunk, in world units.
+    struct chunk_bounds
+    {
+        f32 min_x;
+        f32 min_y;
+        f32 min_z;
+        f32 max_x;
+        f32 max_y;
+        f32 max_z;
+        /** true if the whole box is opaque, so that it hides what lies behind it. */
+        bool occluder;
+    };
+
+    /// @brief The 6 planes bounding the view of a camera.
+    ///
+    /// Every plane is stored as (a, b, c, d), with a * x + b * y + c * z + d >= 0 on the
+    /// inner side.
+    struct frustum
+    {
+        /** The left, right, bottom, top, near and far planes. */
+        f32 planes[6][4];
+
+        /// @brief Extracts the planes of a view-projection matrix.
+        /// @param view_projection The 16 coefficients of the matrix, row by row. It maps a point
+        /// (x, y, z, 1) to clip coordinates, whose visible range is -w <= x, y, z <= w.
+        /// @return The frustum of the matrix.
+        static frustum from_matrix(const f32* view_projection) noexcept;
+    };
+
+    /// @brief Finds the boxes that intersect a frustum.
+    /// @param f The frustum.
+    /// @param boxes The boxes.
+    /// @param visible The array the indices of the boxes inside the frustum are appended to,
+    /// in increasing order.
+    ///
+    /// The boxes are tested 8 at a time, transposed into one array of 8 lanes per
+    /// coordinate. For every plane, the corner of each box furthest along the normal of the
+    /// plane is picked for all the lanes at once, since it only depends on the signs of the
+    /// plane, so every lane runs the same operations; on x86 they run as two SSE2 vectors of
+    /// 4 lanes. The test is conservative: boxes near the corners of the frustum can pass it
+    /// while being just outside.
+    void frustum_cull(const frustum& f, const utils::const_span<chunk_bounds>& boxes, utils::array<u32>& visible) noexcept;
+
+    /// @brief Culls the boxes outside the view or hidden behind occluders.
+    ///
+    /// The boxes inside the frustum are sorted from front to back and tested against a small
+    /// depth buffer rasterized in software. A box is hidden if every pixel its projection
+    /// covers holds an occluder nearer than the nearest point of the box. Visible occluders
+    /// are then rasterized into the buffer, so only the boxes in front of a box hide it.
+    ///
+    /// The depth buffer samples occluders at pixel centers, so it's accurate to a pixel:
+    /// a box visible through a gap narrower than a pixel can be culled. Boxes that cross the
+    /// near plane are always visible and never occlude.
+    ///
+    /// A culler keeps its depth buffer and scratch memory between calls, and runs without
+    /// any GPU, so it also works headless.
+    class culler
+    {
+    public:
+        /// @brief Constructs a culler.
+        /// @param width The width of the depth buffer, in pixels.
+        /// @param height The height of the depth buffer, in pixels.
+        culler(u32 width = 256, u32 height = 128) noexcept;
+
+        /// @brief Finds the visible boxes.
+        /// @param view_projection The 16 coefficients of the view-projection matrix, row by row,
+        /// as in frustum::from_matrix.
+        /// @param boxes The boxes.
+        /// @param visible The array the indices of the visible boxes are appended to, from the
+        /// nearest to the furthest.
+        void cull(const f32* view_projection, const utils::const_span<chunk_bounds>& boxes, utils::array<u32>& visible) noexcept;
+
+        /// @brief Returns the depth buffer of the last call to cull.
+        /// @return A const span over the depths of the pixels, row by row from the bottom, in
+        /// normalized device coordinates, with 1 where no occluder was drawn.
+        inline utils::const_span<f32> depth() const noexcept { return utils::const_span<f32>(depths.data(), depths.size()); }
+
+        /// @brief Returns the width of the depth buffer.
+        /// @return The width of the depth buffer, in pixels.
+        inline u32 width() const noexcept { return w; }
+
+        /// @brief Returns the height of the depth buffer.
+        /// @return The height of the depth buffer, in pixels.
+        inline u32 height() const noexcept { return h; }
+
+    private:
+        /// @brief A corner of a box projected on the screen.
+        struct vertex
+        {
+            f32 x;
+            f32 y;
+            f32 z;
+        };
+
+        /// @brief A rectangle of pixels, bounds included.
+        struct rectangle
+        {
+            i32 x0;
+            i32 y0;
+            i32 x1;
+            i32 y1;
+        };
+
+        bool project(const f32* m, const chunk_bounds& b, vertex* corners) const noexcept;
+        rectangle cover(const vertex* corners, f32& min_z) const noexcept;
+        bool hidden(const vertex* corners) const noexcept;
+        void draw(const vertex* corners) noexcept;
+        void draw_triangle(const vertex& a, const vertex& b, const vertex& c) noexcept;
+
+    private:
+        u32 w;
+        u32 h;
+        utils::buffer<f32> depths;
+        utils::array<u32> candidates;
+        utils::array<u64> order;
+    };
+};
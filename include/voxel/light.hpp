@@ -0,0 +1,176 @@
+/**
+ * @file
+ * @brief Incremental block and sky light propagation.
+ */
+#pragma once
+
+#include "chunk_map.hpp"
+
+#include <utils/ring.hpp>
+
+namespace voxel
+{
+    /** The brightest light level. */
+    constexpr u8 max_light = 15;
+
+    /// @brief The kinds of light.
+    enum class light_channel : u8
+    {
+        /** Light emitted by blocks, such as torches. */
+        block = 0,
+        /** Light coming from the sky, which travels straight down without fading. */
+        sky = 1
+    };
+
+    /// @brief The light levels of the voxels of a chunk, packed as two nibbles per byte.
+    ///
+    /// The block light of every voxel comes first, then the sky light, each taking half a
+    /// byte per voxel in voxel_index order.
+    class light_chunk
+    {
+    public:
+        /** The number of bytes of a channel. */
+        static constexpr usize channel_size = chunk_volume / 2;
+
+        /// @brief Constructs a chunk with no light at all.
+        light_chunk() noexcept;
+
+        /// @brief Reads the light of a voxel.
+        /// @param c The channel.
+        /// @param i The index of the voxel.
+        /// @return The light level, in [0, max_light].
+        inline u8 get(light_channel c, usize i) const noexcept
+        {
+            return (nibbles[static_cast<usize>(c) * channel_size + (i >> 1)] >> ((i & 1) << 2)) & 0xf;
+        }
+
+        /// @brief Writes the light of a voxel.
+        /// @param c The channel.
+        /// @param i The index of the voxel.
+        /// @param level The light level, in [0, max_light].
+        inline void set(light_channel c, usize i, u8 level) noexcept
+        {
+            u8& byte = nibbles[static_cast<usize>(c) * channel_size + (i >> 1)];
+            u32 shift = (i & 1) << 2;
+            byte = static_cast<u8>((byte & ~(0xf << shift)) | (level << shift));
+        }
+
+        /// @brief Returns the packed light levels.
+        /// @return A const span over the 2 * channel_size bytes of the chunk.
+        inline utils::const_span<u8> data() const noexcept { return utils::const_span<u8>(nibbles.data(), nibbles.size()); }
+
+    private:
+        utils::buffer<u8> nibbles;
+    };
+
+    /// @brief Spreads block and sky light through the chunks of a map as they're edited.
+    ///
+    /// Light spreads breadth-first, fading by one level per voxel, except sky light at full
+    /// level which travels straight down without fading. Air and the blocks made
+    /// transparent with set_transparent let light through; every other block stops it.
+    ///
+    /// Every channel has an add queue of voxels whose light must spread to their neighbors
+    /// and a remove queue of voxels whose light was taken away, with the level they had.
+    /// Removing light clears the voxels that were lit through the removed one and queues
+    /// the brighter voxels on the edge of that region to spread again, so an edit only
+    /// touches the voxels whose light depends on it. Queue entries pack the slot of a chunk
+    /// and the index of a voxel into 32 bits, and the slots of the 6 face neighbors of
+    /// every chunk are cached so crossing a border costs no lookup.
+    ///
+    /// Up to max_chunks chunks can be lit at once.
+    class light_engine
+    {
+    public:
+        /** The number of chunks that can be lit at once, so that queue entries fit in 32 bits. */
+        static constexpr u32 max_chunks = u32(1) << 17;
+
+        /// @brief Constructs an engine for the chunks of a map.
+        /// @param chunks The chunks, which must outlive the engine.
+        light_engine(chunk_map<chunk>& chunks) noexcept;
+
+        /// @brief Sets the light a block emits.
+        /// @param b The block.
+        /// @param level The light level, in [0, max_light].
+        void set_emission(block b, u8 level) noexcept;
+
+        /// @brief Sets whether a block lets light through.
+        /// @param b The block.
+        /// @param transparent true if light goes through the block, false if it stops it.
+        void set_transparent(block b, bool transparent) noexcept;
+
+        /// @brief Starts lighting a chunk that was added to the map.
+        /// @param c The coordinates of the chunk.
+        ///
+        /// Queues the emitting blocks of the chunk and the lit voxels of its neighbors
+        /// along its borders. A chunk without a lit chunk above it is lit by the sky. The
+        /// chunk is left unlit if max_chunks chunks already are.
+        void chunk_added(const chunk_coord& c) noexcept;
+
+        /// @brief Stops lighting a chunk, before it's erased from the map.
+        /// @param c The coordinates of the chunk.
+        ///
+        /// The queued light is spread first. The light that reached the neighbors through
+        /// the chunk stays until they're edited.
+        void chunk_removed(const chunk_coord& c) noexcept;
+
+        /// @brief Queues the light changes caused by editing a voxel.
+        /// @param c The coordinates of the chunk of the voxel.
+        /// @param v The position of the voxel inside its chunk, whose block was already changed.
+        void block_changed(const chunk_coord& c, local_coord v) noexcept;
+
+        /// @brief Spreads the queued light changes.
+        /// @return The number of voxels visited.
+        usize update() noexcept;
+
+        /// @brief Reads the light of a voxel.
+        /// @param c The coordinates of the chunk of the voxel.
+        /// @param v The position of the voxel inside its chunk.
+        /// @param channel The channel.
+        /// @return The light level, or 0 if the chunk isn't lit.
+        u8 get(const chunk_coord& c, local_coord v, light_channel channel) const noexcept;
+
+        /// @brief Returns the light of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return A const pointer to the light of the chunk, or nullptr if it isn't lit.
+        const light_chunk* find(const chunk_coord& c) const noexcept;
+
+    private:
+        /// @brief A lit chunk along with the slots of its neighbors.
+        struct node
+        {
+            light_chunk light;
+            u32 chunk;
+            u32 neighbors[6];
+        };
+
+        /// @brief The queues of a channel.
+        struct queues
+        {
+            utils::deque<u32> add;
+            utils::deque<u32> remove;
+            utils::deque<u8> removed_levels;
+        };
+
+        static constexpr u32 index_bits = 15;
+        static_assert((u64(max_chunks) << index_bits) == (u64(1) << 32) && (u32(1) << index_bits) == chunk_volume, "light_engine packs a slot and a voxel index into 32 bits");
+
+        static inline u32 pack(u32 slot, u32 index) noexcept { return (slot << index_bits) | index; }
+
+        inline bool transparent(block b) const noexcept { return (table[b] & transparent_flag) != 0; }
+        inline u8 emission(block b) const noexcept { return table[b] & 0xf; }
+
+        bool step(u32 slot, u32 index, u32 direction, u32& next_slot, u32& next_index) const noexcept;
+        block block_at(u32 slot, u32 index) const noexcept;
+        void push_border(u32 slot, u32 direction) noexcept;
+        usize spread(light_channel channel) noexcept;
+        usize unspread(light_channel channel) noexcept;
+
+        static constexpr u8 transparent_flag = 0x10;
+
+    private:
+        chunk_map<chunk>& chunks;
+        chunk_map<node> nodes;
+        utils::buffer<u8> table;
+        queues channels[2];
+    };
+};
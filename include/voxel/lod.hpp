@@ -0,0 +1,97 @@
+/**
+ * @file
+ * @brief Downsampled levels of detail of a chunk.
+ */
+#pragma once
+
+#include "chunk.hpp"
+
+namespace voxel
+{
+    /// @brief How a voxel of a coarser level is picked from the 8 voxels it covers.
+    enum class lod_filter : u8
+    {
+        /** The most common block, opaque blocks winning ties against air. */
+        majority,
+        /** The most common opaque block if any, so thin floors and walls never vanish. */
+        surface
+    };
+
+    /// @brief The mip chain of a chunk: the chunk downsampled 2x, 4x, 8x, and so on down
+    /// to a single voxel.
+    ///
+    /// Level l has chunk_size >> l voxels along every edge, indexed x fastest, then y, then
+    /// z, and every voxel of it is picked from the 2 x 2 x 2 voxels it covers in level l - 1,
+    /// level 0 being the chunk itself.
+    ///
+    /// Edits are reported with changed, which marks the voxel of level 1 covering the
+    /// edited one. update picks the marked voxels again, and marks the voxel of the next
+    /// level covering a voxel only when its block actually changed, so an edit stops
+    /// climbing the chain at the first level it doesn't affect.
+    class chunk_lod
+    {
+    public:
+        /** The number of levels, from 1 to level_count included, down to a single voxel. */
+        static constexpr u32 level_count = chunk_shift;
+
+        /// @brief Constructs the levels of a chunk of air.
+        /// @param filter How the voxels of the levels are picked.
+        chunk_lod(lod_filter filter = lod_filter::majority) noexcept;
+
+        /// @brief Returns the number of voxels along every edge of a level.
+        /// @param l The level, in [1, level_count].
+        /// @return The edge of the level.
+        static inline constexpr u32 size(u32 l) noexcept { return static_cast<u32>(chunk_size) >> l; }
+
+        /// @brief Builds all the levels from scratch.
+        /// @param c The chunk.
+        void build(const chunk& c) noexcept;
+
+        /// @brief Marks the voxels depending on an edited voxel as dirty.
+        /// @param v The position of the voxel in the chunk.
+        void changed(local_coord v) noexcept;
+
+        /// @brief Checks if any voxel is dirty.
+        /// @return true if the next update has work to do, false otherwise.
+        inline bool dirty() const noexcept { return !pending.empty(); }
+
+        /// @brief Picks the dirty voxels again, climbing the levels while they change.
+        /// @param c The chunk, with the edits reported since the last update.
+        /// @return The number of voxels picked again, across all the levels.
+        usize update(const chunk& c) noexcept;
+
+        /// @brief Returns the voxels of a level.
+        /// @param l The level, in [1, level_count].
+        /// @return A const span over the size(l)^3 blocks of the level.
+        inline utils::const_span<block> level(u32 l) const noexcept { return levels[l - 1]; }
+
+        /// @brief Reads a voxel of a level.
+        /// @param l The level, in [1, level_count].
+        /// @param x The x coordinate of the voxel, in [0, size(l)).
+        /// @param y The y coordinate of the voxel, in [0, size(l)).
+        /// @param z The z coordinate of the voxel, in [0, size(l)).
+        /// @return The block of the voxel.
+        inline block get(u32 l, u32 x, u32 y, u32 z) const noexcept { return levels[l - 1][index(l, x, y, z)]; }
+
+        /// @brief Returns how the voxels of the levels are picked.
+        /// @return The filter.
+        inline lod_filter filter() const noexcept { return mode; }
+
+    private:
+        static inline constexpr u32 index(u32 l, u32 x, u32 y, u32 z) noexcept
+        {
+            u32 shift = chunk_shift - l;
+            return x | (y << shift) | (z << (2 * shift));
+        }
+
+        block pick(const block* samples) const noexcept;
+        bool mark(u32 i) noexcept;
+
+    private:
+        utils::array<block> levels[level_count];
+        utils::array<u16> pending;
+        utils::array<u16> next;
+        u64 marks[(chunk_volume >> 3) / 64];
+        lod_filter mode;
+    };
+};
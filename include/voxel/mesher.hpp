@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief Binary greedy meshing of chunks into quads.
+ */
+#pragma once
+
+#include "chunk.hpp"
+
+namespace voxel
+{
+    /// @brief The direction a face points to.
+    ///
+    /// Faces are numbered 2 * axis + negative, with the axes x, y, z numbered 0, 1, 2.
+    enum class face : u8
+    {
+        pos_x = 0, neg_x = 1,
+        pos_y = 2, neg_y = 3,
+        pos_z = 4, neg_z = 5
+    };
+
+    /** The number of face directions. */
+    constexpr usize face_count = 6;
+
+    /// @brief A rectangle of faces of the same block, packed in 64 bits.
+    ///
+    /// A quad lies on the side given by its face of the voxels it covers. With a the axis
+    /// of the face, u = (a + 1) % 3 and v = (a + 2) % 3, it covers width voxels along u and
+    /// height voxels along v starting at (x, y, z). The renderer expands every quad into
+    /// its 4 corners, so this is the whole vertex data of a chunk.
+    ///
+    /// Bits 0-17 hold x, y, z, bits 18-27 width - 1 and height - 1, bits 28-30 the face and
+    /// bits 32-47 the block.
+    struct quad
+    {
+        u64 data;
+
+        /// @brief Packs a quad.
+        /// @param x The x coordinate of the first voxel covered.
+        /// @param y The y coordinate of the first voxel covered.
+        /// @param z The z coordinate of the first voxel covered.
+        /// @param width The number of voxels covered along u, in [1, chunk_size].
+        /// @param height The number of voxels covered along v, in [1, chunk_size].
+        /// @param f The face.
+        /// @param b The block.
+        /// @return The packed quad.
+        static inline constexpr quad make(u32 x, u32 y, u32 z, u32 width, u32 height, face f, block b) noexcept
+        {
+            return quad { u64(x) | (u64(y) << 6) | (u64(z) << 12) | (u64(width - 1) << 18) | (u64(height - 1) << 23) |
+                          (u64(f) << 28) | (u64(b) << 32) };
+        }
+
+        inline constexpr u32 x() const noexcept { return u32(data) & 63; }
+        inline constexpr u32 y() const noexcept { return u32(data >> 6) & 63; }
+        inline constexpr u32 z() const noexcept { return u32(data >> 12) & 63; }
+        inline constexpr u32 width() const noexcept { return (u32(data >> 18) & 31) + 1; }
+        inline constexpr u32 height() const noexcept { return (u32(data >> 23) & 31) + 1; }
+        inline constexpr face direction() const noexcept { return static_cast<face>((data >> 28) & 7); }
+        inline constexpr block type() const noexcept { return static_cast<block>(data >> 32); }
+    };
+
+    /// @brief Turns chunks into quads with binary greedy meshing.
+    ///
+    /// The occupancy of the chunk is kept as one 32-bit mask per column along every axis,
+    /// the columns along one axis being the rows of the slices across another. The visible
+    /// faces of a slice are the voxels of its rows that are opaque where the rows of the next
+    /// slice, or the touching layer of the neighbor, are not, which gives a 32x32 bit plane
+    /// of faces per slice in 32 operations. The plane is merged greedily one run of bits
+    /// at a time. Runs only grow over faces of the same block, a check skipped entirely
+    /// for chunks with a single opaque block.
+    ///
+    /// A mesher keeps its scratch memory between calls, so reusing one per thread avoids
+    /// any allocation while meshing. Blocks other than air are opaque.
+    class mesher
+    {
+    public:
+        /** The number of groups of quads of a chunk, one per face and slice. */
+        static constexpr usize group_count = face_count * chunk_size;
+
+        /// @brief Constructs a mesher.
+        mesher() noexcept;
+
+        /// @brief Loads a chunk and the layers of its face neighbors that touch it.
+        /// @param neighborhood 27 pointers to the chunk and its neighbors, in the order
+        /// of chunk_map::neighbors; the chunk in the middle must not be nullptr, missing
+        /// neighbors are treated as air.
+        void load(const utils::const_span<const chunk*>& neighborhood) noexcept;
+
+        /// @brief Meshes the loaded chunk.
+        /// @param out The array the quads are appended to.
+        /// @param ends If not empty, receives for each of the group_count groups the size
+        /// of out after its quads were appended. Groups are ordered by face, then slice.
+        void mesh(utils::array<quad>& out, const utils::span<u32>& ends = utils::span<u32>()) noexcept;
+
+        /// @brief Meshes a single slice of the loaded chunk.
+        /// @param f The face of the quads.
+        /// @param slice The coordinate of the slice along the axis of the face.
+        /// @param out The array the quads are appended to.
+        void mesh_slice(face f, u32 slice, utils::array<quad>& out) noexcept;
+
+        /// @brief Loads a chunk and meshes it.
+        /// @param neighborhood The chunk and its neighbors, as passed to load.
+        /// @param out The array the quads are appended to.
+        inline void mesh(const utils::const_span<const chunk*>& neighborhood, utils::array<quad>& out) noexcept
+        {
+            load(neighborhood);
+            mesh(out);
+        }
+
+    private:
+        void merge(face f, u32 slice, u32* rows, utils::array<quad>& out) const noexcept;
+        void plane(face f, u32 slice, u32* rows) const noexcept;
+
+    private:
+        utils::buffer<block> blocks;
+        utils::buffer<u32> columns;
+        u32 borders[face_count][chunk_size];
+        block solid;
+    };
+};
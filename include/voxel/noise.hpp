@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @brief Batch noise generation over grids of points.
+ */
+#pragma once
+
+#include "chunk.hpp"
+
+namespace voxel
+{
+    /// @brief The kinds of noise.
+    enum class noise : u8
+    {
+        /** Simplex gradient noise, in [-1, 1]. */
+        simplex = 0,
+        /** Value noise with quintic interpolation between random lattice values, in [-1, 1]. */
+        value = 1,
+        /** Cellular noise, the distance to the closest random feature point mapped to [-1, 1]. */
+        cellular = 2
+    };
+
+    /// @brief The instruction sets noise can be generated with.
+    enum class simd_level : u8
+    {
+        scalar = 0,
+        sse = 1,
+        avx2 = 2,
+        /** The best level supported by the processor. */
+        best = 3
+    };
+
+    /// @brief A regular grid of points to sample noise at.
+    ///
+    /// Point (i, j, k) is at (x + i * step, y + j * step, z + k * step) and goes to index
+    /// i + width * (j + height * k) of the output, so a grid with chunk_size points along
+    /// every axis matches voxel_index. 2D noise ignores z and depth.
+    struct noise_grid
+    {
+        f32 x = 0.0f;
+        f32 y = 0.0f;
+        f32 z = 0.0f;
+        f32 step = 1.0f;
+        u32 width = 0;
+        u32 height = 0;
+        u32 depth = 1;
+
+        /// @brief Returns the number of points of a 2D grid.
+        /// @return width * height.
+        inline usize area() const noexcept { return static_cast<usize>(width) * height; }
+
+        /// @brief Returns the number of points of a 3D grid.
+        /// @return width * height * depth.
+        inline usize volume() const noexcept { return area() * depth; }
+    };
+
+    /// @brief The parameters of a sum of octaves of noise.
+    struct fractal
+    {
+        /** The number of octaves. */
+        u32 octaves = 4;
+        /** The factor the frequency is multiplied by from one octave to the next. */
+        f32 lacunarity = 2.0f;
+        /** The factor the amplitude is multiplied by from one octave to the next. */
+        f32 gain = 0.5f;
+    };
+
+    /// @brief Returns the instruction set noise is generated with by default.
+    /// @return The best level both supported by the processor and compiled in.
+    simd_level noise_simd_level() noexcept;
+
+    /// @brief Samples 2D noise over a grid.
+    /// @param type The kind of noise.
+    /// @param seed The seed of the noise.
+    /// @param frequency The factor the coordinates of the points are multiplied by.
+    /// @param grid The grid of points.
+    /// @param out The span that receives the noise, grid.area() values.
+    /// @param level The instruction set to use; levels the processor doesn't support are
+    /// lowered to the best one it does.
+    ///
+    /// Every level gives bitwise-identical results: all of them run the same sequence of
+    /// correctly rounded operations, without fused multiply-adds.
+    void noise_2d(noise type, u32 seed, f32 frequency, const noise_grid& grid, const utils::span<f32>& out,
+                  simd_level level = simd_level::best) noexcept;
+
+    /// @brief Samples 3D noise over a grid.
+    /// @param type The kind of noise.
+    /// @param seed The seed of the noise.
+    /// @param frequency The factor the coordinates of the points are multiplied by.
+    /// @param grid The grid of points.
+    /// @param out The span that receives the noise, grid.volume() values.
+    /// @param level The instruction set to use, as for noise_2d.
+    void noise_3d(noise type, u32 seed, f32 frequency, const noise_grid& grid, const utils::span<f32>& out,
+                  simd_level level = simd_level::best) noexcept;
+
+    /// @brief Samples fractal Brownian motion, a sum of octaves of 2D noise, over a grid.
+    /// @param type The kind of noise of every octave.
+    /// @param seed The seed of the first octave; octave i uses seed + i.
+    /// @param frequency The frequency of the first octave.
+    /// @param f The parameters of the octaves.
+    /// @param grid The grid of points.
+    /// @param out The span that receives the noise, grid.area() values in [-1, 1].
+    /// @param level The instruction set to use, as for noise_2d.
+    void fbm_2d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                simd_level level = simd_level::best) noexcept;
+
+    /// @brief Samples fractal Brownian motion, a sum of octaves of 3D noise, over a grid.
+    /// @param type The kind of noise of every octave.
+    /// @param seed The seed of the first octave; octave i uses seed + i.
+    /// @param frequency The frequency of the first octave.
+    /// @param f The parameters of the octaves.
+    /// @param grid The grid of points.
+    /// @param out The span that receives the noise, grid.volume() values in [-1, 1].
+    /// @param level The instruction set to use, as for noise_2d.
+    void fbm_3d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                simd_level level = simd_level::best) noexcept;
+
+    /// @brief Samples ridged noise, a sum of octaves of 1 - |noise|, over a 2D grid.
+    /// @param type The kind of noise of every octave.
+    /// @param seed The seed of the first octave; octave i uses seed + i.
+    /// @param frequency The frequency of the first octave.
+    /// @param f The parameters of the octaves.
+    /// @param grid The grid of points.
+    /// @param out The span that receives the noise, grid.area() values in [-1, 1].
+    /// @param level The instruction set to use, as for noise_2d.
+    void ridged_2d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                   simd_level level = simd_level::best) noexcept;
+
+    /// @brief Samples ridged noise, a sum of octaves of 1 - |noise|, over a 3D grid.
+    /// @param type The kind of noise of every octave.
+    /// @param seed The seed of the first octave; octave i uses seed + i.
+    /// @param frequency The frequency of the first octave.
+    /// @param f The parameters of the octaves.
+    /// @param grid The grid of points.
+    /// @param out The span that receives the noise, grid.volume() values in [-1, 1].
+    /// @param level The instruction set to use, as for noise_2d.
+    void ridged_3d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                   simd_level level = simd_level::best) noexcept;
+};
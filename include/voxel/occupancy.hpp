@@ -0,0 +1,113 @@
+/**
+ * @file
+ * @brief Bitmasks of the opaque voxels of chunks.
+ */
+#pragma once
+
+#include "chunk_map.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace voxel
+{
+    /// @brief Builds the mask of the opaque blocks of a row of chunk_size blocks.
+    /// @param row The blocks of the row.
+    /// @return A mask with bit x set if row[x] isn't air.
+    inline u32 row_occupancy(const block* row) noexcept
+    {
+        static_assert(air == 0, "row_occupancy assumes air is the only zero block");
+
+        u32 m = 0;
+        if constexpr(::std::endian::native == ::std::endian::little)
+        {
+            // 4 blocks at a time: the top bit of every 16-bit lane is set if the lane
+            // isn't zero, and a multiplication gathers the 4 top bits together.
+            constexpr u64 low = 0x7fff7fff7fff7fff;
+            for(u32 x = 0; x != chunk_size; x += 4)
+            {
+                u64 w;
+                ::std::memcpy(&w, row + x, sizeof(w));
+                u64 nonzero = (((w & low) + low) | w) & ~low;
+                m |= static_cast<u32>((((nonzero >> 15) * 0x0000200040008001) >> 45) & 0xf) << x;
+            }
+        }
+        else
+            for(u32 x = 0; x != chunk_size; x++)
+                m |= u32(row[x] != air) << x;
+        return m;
+    }
+
+    /// @brief The opaque voxels of a chunk, one bit per voxel.
+    ///
+    /// Every row of voxels along x is a 32-bit mask, indexed by z then y. On top of the
+    /// rows, one bit per brick of 8x8x8 voxels tells if the brick holds any opaque voxel,
+    /// so traversals can skip empty bricks, and empty chunks, without reading their rows.
+    class chunk_occupancy
+    {
+    public:
+        /** The number of voxels along every edge of a brick. */
+        static constexpr u32 brick_size = 8;
+        /** The base 2 logarithm of brick_size. */
+        static constexpr u32 brick_shift = 3;
+        /** The number of bricks along every edge of a chunk. */
+        static constexpr u32 bricks_per_edge = chunk_size / brick_size;
+
+        /// @brief Constructs the occupancy of an empty chunk.
+        chunk_occupancy() noexcept;
+
+        /// @brief Constructs the occupancy of a chunk.
+        /// @param c The chunk.
+        explicit chunk_occupancy(const chunk& c) noexcept;
+
+        /// @brief Recomputes the occupancy from a chunk.
+        /// @param c The chunk.
+        void build(const chunk& c) noexcept;
+
+        /// @brief Checks if a voxel is opaque.
+        /// @param x The x coordinate of the voxel.
+        /// @param y The y coordinate of the voxel.
+        /// @param z The z coordinate of the voxel.
+        /// @return true if the voxel is opaque, false otherwise.
+        inline bool get(u32 x, u32 y, u32 z) const noexcept { return (rows[z * chunk_size + y] >> x) & 1; }
+
+        /// @brief Updates a single voxel.
+        /// @param c The position of the voxel.
+        /// @param opaque true if the voxel is opaque now, false otherwise.
+        void set(local_coord c, bool opaque) noexcept;
+
+        /// @brief Returns the mask of a row of voxels along x.
+        /// @param y The y coordinate of the row.
+        /// @param z The z coordinate of the row.
+        /// @return The mask of the row, with bit x set if voxel (x, y, z) is opaque.
+        inline u32 row(u32 y, u32 z) const noexcept { return rows[z * chunk_size + y]; }
+
+        /// @brief Checks if a brick holds any opaque voxel.
+        /// @param bx The x coordinate of the brick, in [0, bricks_per_edge).
+        /// @param by The y coordinate of the brick, in [0, bricks_per_edge).
+        /// @param bz The z coordinate of the brick, in [0, bricks_per_edge).
+        /// @return true if the brick isn't empty, false otherwise.
+        inline bool brick(u32 bx, u32 by, u32 bz) const noexcept { return (bricks >> brick_index(bx, by, bz)) & 1; }
+
+        /// @brief Checks if the chunk has no opaque voxel at all.
+        /// @return true if every voxel is air, false otherwise.
+        inline bool empty() const noexcept { return bricks == 0; }
+
+        /// @brief Checks if every voxel of the chunk is opaque.
+        /// @return true if no voxel is air, false otherwise.
+        inline bool full() const noexcept { return solid == chunk_volume; }
+
+    private:
+        static inline constexpr u32 brick_index(u32 bx, u32 by, u32 bz) noexcept
+        {
+            return bx | (by << 2) | (bz << 4);
+        }
+
+        void update_brick(u32 bx, u32 by, u32 bz) noexcept;
+
+    private:
+        u32 rows[chunk_size * chunk_size];
+        u64 bricks;
+        u32 solid;
+    };
+};
@@ -0,0 +1,160 @@
+/**
+ * @file
+ * @brief Sparse voxel octree for large, mostly uniform regions.
+ */
+#pragma once
+
+#include "chunk.hpp"
+
+#include <utils/arena.hpp>
+
+namespace voxel
+{
+    /// @brief A sparse voxel octree over a cube of 2^depth voxels per edge.
+    ///
+    /// Every node is a u32 entry that either holds the block of a uniform cube or the
+    /// index of a group of 8 child entries. Groups live in a basic_arena, so they are
+    /// addressed by index and can be relocated freely. A group whose 8 children are the
+    /// same block is collapsed back into a single entry after every edit, so the number of
+    /// groups follows the surface between different blocks rather than the volume.
+    class sparse_octree
+    {
+    public:
+        /** The largest depth of an octree, so that coordinates past its edge still fit in a u32. */
+        static constexpr u8 max_depth = 30;
+
+        /// @brief An axis-aligned box of voxels, with exclusive maximum coordinates.
+        struct box
+        {
+            u32 min_x;
+            u32 min_y;
+            u32 min_z;
+            u32 max_x;
+            u32 max_y;
+            u32 max_z;
+        };
+
+        /// @brief Constructs an octree filled with a single block.
+        /// @param depth The depth of the octree; its edge is 2^depth voxels long. Depths past
+        /// max_depth are clamped to it.
+        /// @param value The block filling the octree.
+        sparse_octree(u8 depth, block value = 0) noexcept;
+
+        /// @brief Reads a voxel.
+        /// @param x The x coordinate of the voxel.
+        /// @param y The y coordinate of the voxel.
+        /// @param z The z coordinate of the voxel.
+        /// @return The block of the voxel.
+        block get(u32 x, u32 y, u32 z) const noexcept;
+
+        /// @brief Writes a voxel, collapsing the groups that become uniform.
+        /// @param x The x coordinate of the voxel.
+        /// @param y The y coordinate of the voxel.
+        /// @param z The z coordinate of the voxel.
+        /// @param b The new block of the voxel.
+        void set(u32 x, u32 y, u32 z, block b) noexcept;
+
+        /// @brief Replaces a chunk-sized cube of the octree with the blocks of a chunk.
+        /// @param c The chunk.
+        /// @param x The x coordinate of the first voxel of the cube, a multiple of chunk_size.
+        /// @param y The y coordinate of the first voxel of the cube, a multiple of chunk_size.
+        /// @param z The z coordinate of the first voxel of the cube, a multiple of chunk_size.
+        ///
+        /// The subtree is built bottom-up, so uniform cubes never allocate groups. The depth
+        /// of the octree must be at least chunk_shift.
+        void build(const chunk& c, u32 x = 0, u32 y = 0, u32 z = 0) noexcept;
+
+        /// @brief Fills the whole octree with a single block.
+        /// @param b The block.
+        void fill(block b) noexcept;
+
+        /// @brief Visits the uniform cubes that overlap a box.
+        /// @param b The box.
+        /// @param f The function, called as f(x, y, z, size, block) for every cube, where
+        /// (x, y, z) is the first voxel of the cube and size its edge. Returning false stops
+        /// the query.
+        /// @return false if f stopped the query, true otherwise.
+        ///
+        /// Cubes are visited whole, not clipped to the box.
+        template<typename function>
+        inline bool query(const box& b, function&& f) const noexcept
+        {
+            return visit(root, 0, 0, 0, edge(), b, f);
+        }
+
+        /// @brief Turns the octree into a flat breadth-first list of entries.
+        /// @param out The array the entries are appended to.
+        ///
+        /// The first entry is the root and every group follows as 8 consecutive entries,
+        /// in breadth-first order. Entries that point to groups hold the breadth-first
+        /// number of the group instead of its index in the arena.
+        void serialize(utils::array<u32>& out) const noexcept;
+
+        /// @brief Replaces the octree with one read from a breadth-first list of entries.
+        /// @param entries The entries, as written by serialize.
+        /// @return true if the entries were loaded, false if they are malformed or have
+        /// groups deeper than the depth of the octree.
+        bool deserialize(const utils::const_span<u32>& entries) noexcept;
+
+        /// @brief Returns the depth of the octree.
+        /// @return The depth of the octree.
+        inline u8 depth() const noexcept { return levels; }
+
+        /// @brief Returns the length of the edge of the octree.
+        /// @return The number of voxels along every edge of the octree.
+        inline u32 edge() const noexcept { return u32(1) << levels; }
+
+        /// @brief Returns the number of groups of children.
+        /// @return The number of groups allocated in the arena.
+        inline usize group_count() const noexcept { return nodes.size(); }
+
+        /// @brief Returns the memory used by the octree.
+        /// @return The number of bytes allocated for the groups.
+        inline usize memory_usage() const noexcept { return (nodes.size() + nodes.capacity()) * sizeof(group); }
+
+    private:
+        struct group
+        {
+            u32 children[8];
+        };
+
+        static constexpr u32 leaf_flag = u32(1) << 31;
+        static constexpr u32 none = ~u32(0);
+
+        static inline bool is_leaf(u32 e) noexcept { return (e & leaf_flag) != 0; }
+        static inline u32 leaf(block b) noexcept { return leaf_flag | b; }
+        static inline block leaf_block(u32 e) noexcept { return static_cast<block>(e); }
+        static inline u32 child_slot(u32 x, u32 y, u32 z, u32 shift) noexcept
+        {
+            return ((x >> shift) & 1) | (((y >> shift) & 1) << 1) | (((z >> shift) & 1) << 2);
+        }
+
+        inline u32& entry(u32 g, u32 slot) noexcept { return g == none ? root : nodes[g].children[slot]; }
+
+        template<typename function>
+        inline bool visit(u32 e, u32 x, u32 y, u32 z, u32 size, const box& b, function& f) const noexcept
+        {
+            if(x >= b.max_x || y >= b.max_y || z >= b.max_z || x + size <= b.min_x || y + size <= b.min_y || z + size <= b.min_z)
+                return true;
+
+            if(is_leaf(e))
+                return f(x, y, z, size, leaf_block(e));
+
+            u32 half = size >> 1;
+            const group& g = nodes[e];
+            for(u32 i = 0; i != 8; i++)
+                if(!visit(g.children[i], x + (i & 1) * half, y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half, b, f))
+                    return false;
+            return true;
+        }
+
+        void assign(u32 x, u32 y, u32 z, u32 level, u32 e) noexcept;
+        void destroy(u32 e) noexcept;
+        u32 build(const block* blocks, u32 x, u32 y, u32 z, u32 size) noexcept;
+
+    private:
+        utils::basic_arena<group> nodes;
+        u32 root;
+        u8 levels;
+    };
+};
@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @brief Swept box collisions of entities against the opaque voxels of the world.
+ */
+#pragma once
+
+#include "mesher.hpp"
+#include "occupancy.hpp"
+
+#include <jobs/scheduler.hpp>
+
+namespace voxel
+{
+    /// @brief The state of a batch of entities, as one span per field.
+    ///
+    /// Every entity is an axis-aligned box, given by its center and its half size along
+    /// every axis, in voxel units. All the spans must have the same size, which is the
+    /// number of entities; they can be the columns of a utils::soa_array.
+    struct entity_spans
+    {
+        /** The x coordinates of the centers of the boxes. */
+        utils::span<f32> x;
+        /** The y coordinates of the centers of the boxes. */
+        utils::span<f32> y;
+        /** The z coordinates of the centers of the boxes. */
+        utils::span<f32> z;
+        /** The velocities along x, in voxels per unit of time. */
+        utils::span<f32> velocity_x;
+        /** The velocities along y, in voxels per unit of time. */
+        utils::span<f32> velocity_y;
+        /** The velocities along z, in voxels per unit of time. */
+        utils::span<f32> velocity_z;
+        /** The half sizes of the boxes along x. */
+        utils::const_span<f32> half_x;
+        /** The half sizes of the boxes along y. */
+        utils::const_span<f32> half_y;
+        /** The half sizes of the boxes along z. */
+        utils::const_span<f32> half_z;
+        /** The faces of the boxes blocked by a voxel during the last move, with bit f set
+         *  if face f was blocked; an entity standing on the ground has bit neg_y set. */
+        utils::span<u8> contacts;
+
+        /// @brief Returns the number of entities.
+        /// @return The size of the spans.
+        inline usize size() const noexcept { return x.size(); }
+    };
+
+    /** The distance kept between the boxes and the voxels they're blocked by, so that rounding
+     *  can't make a box resting against a voxel overlap it. It stays larger than the rounding
+     *  of positions up to 8192 voxels away from the origin. */
+    constexpr f32 contact_skin = 1.0f / 1024;
+
+    /// @brief Checks if a box of voxels holds any opaque voxel.
+    /// @param world The occupancy of the loaded chunks.
+    /// @param x0 The lowest x coordinate of the box.
+    /// @param y0 The lowest y coordinate of the box.
+    /// @param z0 The lowest z coordinate of the box.
+    /// @param x1 The highest x coordinate of the box, included.
+    /// @param y1 The highest y coordinate of the box, included.
+    /// @param z1 The highest z coordinate of the box, included.
+    /// @return true if a voxel of the box is opaque or lies in a chunk that isn't loaded.
+    bool overlaps(const chunk_map<chunk_occupancy>& world, i32 x0, i32 y0, i32 z0, i32 x1, i32 y1, i32 z1) noexcept;
+
+    /// @brief Moves a range of entities along their velocities, stopping them at opaque voxels.
+    /// @param world The occupancy of the loaded chunks. Chunks that aren't loaded are solid,
+    /// so entities never move into them.
+    /// @param entities The entities.
+    /// @param dt The time step.
+    /// @param begin The index of the first entity moved.
+    /// @param end The index past the last entity moved.
+    ///
+    /// Every entity moves along y, then x, then z. Each move sweeps the face of the box
+    /// that leads the move across the layers of voxels in its way, one bitmask row of the
+    /// occupancy per row of voxels, and stops in front of the first layer holding an opaque
+    /// voxel, so fast entities can't go through thin walls. A blocked move zeroes the
+    /// velocity along its axis and sets the blocked face in the contacts.
+    void move_entities(const chunk_map<chunk_occupancy>& world, const entity_spans& entities, f32 dt, usize begin, usize end) noexcept;
+
+    /// @brief Moves all the entities along their velocities, stopping them at opaque voxels.
+    /// @param world The occupancy of the loaded chunks, which must not change until it returns.
+    /// @param entities The entities.
+    /// @param dt The time step.
+    /// @param s The scheduler the entities are split over, in ranges of grain entities.
+    /// @param grain The number of entities moved by a single job, or 0 to choose it automatically.
+    ///
+    /// Entities don't collide with each other, so every range moves independently.
+    void move_entities(const chunk_map<chunk_occupancy>& world, const entity_spans& entities, f32 dt, jobs::scheduler& s, usize grain = 0) noexcept;
+};
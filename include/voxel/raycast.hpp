@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Batched raycasting against the opaque voxels of the world.
+ */
+#pragma once
+
+#include "mesher.hpp"
+#include "occupancy.hpp"
+
+namespace voxel
+{
+    /// @brief A ray through the world, in voxel units.
+    ///
+    /// The points of the ray are origin + t * direction for t in [0, length]. The direction
+    /// doesn't need to be normalized; with a normalized one, t is a distance in voxels.
+    struct ray
+    {
+        f32 origin_x;
+        f32 origin_y;
+        f32 origin_z;
+        f32 direction_x;
+        f32 direction_y;
+        f32 direction_z;
+        f32 length;
+    };
+
+    /// @brief The first opaque voxel hit by a ray.
+    struct ray_hit
+    {
+        /** The index of the ray in the batch. */
+        u32 ray;
+        /** The x coordinate of the voxel in the world. */
+        i32 x;
+        /** The y coordinate of the voxel in the world. */
+        i32 y;
+        /** The z coordinate of the voxel in the world. */
+        i32 z;
+        /** The t of the point where the ray enters the voxel. */
+        f32 t;
+        /** The face of the voxel the ray enters through. A ray starting inside an opaque
+         *  voxel hits it at t = 0, through the face opposite to its main direction. */
+        face side;
+    };
+
+    /// @brief Casts a batch of rays against the opaque voxels of the world.
+    /// @param world The occupancy of the loaded chunks; missing chunks are empty.
+    /// @param rays The rays, whose lengths must be finite.
+    /// @param hits The array the hits are appended to, one per ray that hits a voxel, in
+    /// the order of the rays.
+    ///
+    /// Rays are sorted by the chunk they start in, so rays that run through the same
+    /// chunks run close together in time, and walked by a 3D DDA in packets of 8
+    /// interleaved rays. Each step of the packet advances every ray by one cell, so the
+    /// lookups of the 8 rays overlap instead of waiting on each other; a ray that finishes
+    /// is replaced by the next one right away. Empty chunks and empty 8x8x8 bricks are
+    /// crossed in a single step.
+    void raycast(const chunk_map<chunk_occupancy>& world, const utils::const_span<ray>& rays, utils::array<ray_hit>& hits) noexcept;
+};
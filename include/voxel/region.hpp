@@ -0,0 +1,283 @@
+/**
+ * @file
+ * @brief Region files storing the compressed chunks of a cube of the world.
+ */
+#pragma once
+
+#include "chunk_map.hpp"
+
+namespace voxel
+{
+    /** The base 2 logarithm of the number of chunks along every edge of a region. */
+    constexpr u32 region_shift = 4;
+    /** The number of chunks along every edge of a region. */
+    constexpr u32 region_size = u32(1) << region_shift;
+    /** The number of chunks in a region. */
+    constexpr u32 region_volume = region_size * region_size * region_size;
+    /** The size of the sectors region files are allocated by, in bytes. */
+    constexpr u32 sector_size = 4096;
+    /** The offset of the table of a region file, in bytes, past its header. */
+    constexpr u32 region_table_offset = 16;
+
+    /** The native handle of an open file: a file descriptor, or a HANDLE on Windows. */
+    typedef ::std::intptr_t file_handle;
+    /** The handle of no file, matching both -1 and INVALID_HANDLE_VALUE. */
+    constexpr file_handle invalid_file = -1;
+
+    /// @brief The coordinates of a region in the world, in units of regions.
+    struct region_coord
+    {
+        i32 x;
+        i32 y;
+        i32 z;
+
+        /// @brief Finds the region that contains a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return The coordinates of the region containing the chunk.
+        static inline constexpr region_coord containing(const chunk_coord& c) noexcept
+        {
+            return region_coord { c.x >> region_shift, c.y >> region_shift, c.z >> region_shift };
+        }
+
+        inline constexpr bool operator==(const region_coord&) const noexcept = default;
+    };
+
+    /// @brief Calculates the index of a chunk inside its region.
+    /// @param c The coordinates of the chunk.
+    /// @return The index of the chunk in the table of its region, in [0, region_volume).
+    inline constexpr u32 region_index(const chunk_coord& c) noexcept
+    {
+        constexpr u32 mask = region_size - 1;
+        return (u32(c.x) & mask) | ((u32(c.y) & mask) << region_shift) | ((u32(c.z) & mask) << (2 * region_shift));
+    }
+
+    /** The largest payload of a chunk: its header, a full palette, and incompressible
+     *  indices with an extra byte per 255 literals. */
+    constexpr usize max_payload_size = 4 + chunk::max_palette_size * sizeof(block) + chunk_volume * sizeof(block) + chunk_volume * sizeof(block) / 255 + 16;
+
+    /// @brief Compresses a chunk into the payload stored in region files.
+    /// @param c The chunk.
+    /// @param out The array the payload is appended to.
+    ///
+    /// The payload is the width of the chunk, its palette, and its packed indices
+    /// compressed with a byte-oriented LZ77 coder. Matches may overlap their own output, so
+    /// runs of a single index, like the air above the ground, are run-length coded for free.
+    void compress_chunk(const chunk& c, utils::array<u8>& out) noexcept;
+
+    /// @brief Decompresses a payload written by compress_chunk.
+    /// @param payload The payload.
+    /// @param c The chunk the payload is decompressed into. The packed indices are
+    /// decompressed straight into its storage.
+    /// @return true if the payload was valid, false otherwise, in which case the chunk is
+    /// filled with air.
+    bool decompress_chunk(const utils::const_span<u8>& payload, chunk& c) noexcept;
+
+    /// @brief An entry of the table of a region file.
+    struct region_entry
+    {
+        /** The first sector of the payload of the chunk. */
+        u32 sector;
+        /** The length of the payload of the chunk in bytes, 0 if the chunk isn't stored. */
+        u32 length;
+
+        /// @brief Returns the offset of the entry of a chunk in a region file.
+        /// @param i The index of the chunk in the region.
+        /// @return The offset of the entry, in bytes.
+        static inline constexpr u64 offset(u32 i) noexcept { return region_table_offset + u64(i) * sizeof(region_entry); }
+
+        /// @brief Encodes the entry as it's stored in the file.
+        /// @param out The sizeof(region_entry) bytes the entry is written to.
+        void encode(u8* out) const noexcept;
+    };
+
+    /// @brief A region file open for reading and writing.
+    ///
+    /// A region file starts with a header and a table of region_volume entries, followed by
+    /// the payloads of the chunks, each in a run of whole sectors. A bitmap of the sectors
+    /// in use is rebuilt from the table on open; new payloads take the first run of free
+    /// sectors large enough, or grow the file.
+    ///
+    /// A payload is always written to new sectors before its entry is updated, and the old
+    /// sectors are freed only then, so a crash while saving leaves the previous payload of
+    /// the chunk readable.
+    ///
+    /// Files are accessed through POSIX file descriptors, or Win32 handles on Windows.
+    class region_file
+    {
+    public:
+        /// @brief Constructs a closed region file.
+        region_file() noexcept;
+
+        region_file(const region_file&) = delete;
+        region_file& operator=(const region_file&) = delete;
+
+        /// @brief Closes the file.
+        ~region_file() noexcept;
+
+        /// @brief Opens a region file.
+        /// @param path The path of the file.
+        /// @param create true to create an empty region if the file is missing.
+        /// @return true if the file was opened, false if it couldn't be or isn't a region file.
+        bool open(const char* path, bool create = true) noexcept;
+
+        /// @brief Closes the file, if it's open.
+        void close() noexcept;
+
+        /// @brief Checks if the file is open.
+        /// @return true if the file is open, false otherwise.
+        inline bool is_open() const noexcept { return file != invalid_file; }
+
+        /// @brief Returns the native handle of the file.
+        /// @return The file descriptor or HANDLE, or invalid_file if the file is closed.
+        inline file_handle handle() const noexcept { return file; }
+
+        /// @brief Returns the entry of a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @return The entry of the chunk.
+        inline const region_entry& entry(u32 i) const noexcept { return table[i]; }
+
+        /// @brief Checks if a chunk is stored.
+        /// @param i The index of the chunk in the region.
+        /// @return true if the chunk is stored, false otherwise.
+        inline bool contains(u32 i) const noexcept { return table[i].length != 0; }
+
+        /// @brief Returns the length of the file in sectors.
+        /// @return The number of sectors, in use or not, up to the last one in use.
+        inline u32 sectors() const noexcept { return count; }
+
+        /// @brief Reads a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @param c The chunk the payload is decompressed into.
+        /// @return true if the chunk was read, false if it isn't stored or couldn't be read.
+        bool load(u32 i, chunk& c) noexcept;
+
+        /// @brief Writes a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @param c The chunk.
+        /// @return true if the chunk was written, false otherwise.
+        bool save(u32 i, const chunk& c) noexcept;
+
+        /// @brief Writes the payload of a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @param payload The payload, as written by compress_chunk.
+        /// @return true if the payload was written, false otherwise.
+        bool write(u32 i, const utils::const_span<u8>& payload) noexcept;
+
+        /// @brief Erases a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @return true if the table was updated, false otherwise.
+        inline bool erase(u32 i) noexcept { return commit(i, 0, 0); }
+
+        /// @brief Reserves free sectors for a payload.
+        /// @param length The length of the payload in bytes.
+        /// @return The first sector reserved.
+        ///
+        /// For writers that write payloads themselves: the sectors must be passed to commit
+        /// or update once the payload is written, or to release if it couldn't be.
+        u32 allocate(u32 length) noexcept;
+
+        /// @brief Points the entry of a chunk to a written payload, freeing its old sectors.
+        /// @param i The index of the chunk in the region.
+        /// @param sector The first sector of the payload, from allocate.
+        /// @param length The length of the payload in bytes, 0 to erase the chunk.
+        /// @return true if the table was updated, false otherwise.
+        bool commit(u32 i, u32 sector, u32 length) noexcept;
+
+        /// @brief Records an entry written to the file by another writer, freeing the old
+        /// sectors of the chunk.
+        /// @param i The index of the chunk in the region.
+        /// @param sector The first sector of the payload, from allocate.
+        /// @param length The length of the payload in bytes, 0 if the chunk was erased.
+        void update(u32 i, u32 sector, u32 length) noexcept;
+
+        /// @brief Frees sectors from allocate whose payload was never committed.
+        /// @param sector The first sector.
+        /// @param length The length of the payload the sectors were allocated for.
+        void release(u32 sector, u32 length) noexcept;
+
+        /// @brief Flushes the writes to the disk.
+        /// @return true if the file was flushed, false otherwise.
+        bool sync() noexcept;
+
+        /// @brief Reads bytes of the file, without moving any file position.
+        /// @param p The memory the bytes are read to.
+        /// @param n The number of bytes.
+        /// @param offset The offset of the first byte in the file.
+        /// @return true if every byte was read, false otherwise.
+        ///
+        /// Reads and writes at offsets can run on several threads at once.
+        bool read_at(u8* p, usize n, u64 offset) const noexcept;
+
+        /// @brief Writes bytes to the file, without moving any file position.
+        /// @param p The bytes.
+        /// @param n The number of bytes.
+        /// @param offset The offset of the first byte in the file.
+        /// @return true if every byte was written, false otherwise.
+        bool write_at(const u8* p, usize n, u64 offset) noexcept;
+
+    private:
+        void mark(u32 first, u32 n, bool used) noexcept;
+
+    private:
+        utils::buffer<region_entry> table;
+        utils::array<u64> used;
+        utils::array<u8> scratch;
+        u32 count;
+        file_handle file;
+    };
+
+    /// @brief A region file mapped in memory for reading.
+    ///
+    /// Chunks are decompressed straight from the mapping into their storage, with no read
+    /// calls and no copies of the payloads. The mapping is a snapshot: chunks written after
+    /// open may not be seen until the file is opened again.
+    class region_reader
+    {
+    public:
+        /// @brief Constructs a closed reader.
+        region_reader() noexcept;
+
+        region_reader(const region_reader&) = delete;
+        region_reader& operator=(const region_reader&) = delete;
+
+        /// @brief Unmaps the file.
+        ~region_reader() noexcept;
+
+        /// @brief Maps a region file.
+        /// @param path The path of the file.
+        /// @return true if the file was mapped, false if it couldn't be or isn't a region file.
+        bool open(const char* path) noexcept;
+
+        /// @brief Unmaps the file, if it's mapped.
+        void close() noexcept;
+
+        /// @brief Checks if a file is mapped.
+        /// @return true if a file is mapped, false otherwise.
+        inline bool is_open() const noexcept { return base != nullptr; }
+
+        /// @brief Returns the payload of a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @return A const span over the payload in the mapping, empty if the chunk isn't
+        /// stored or lies past the end of the file.
+        utils::const_span<u8> payload(u32 i) const noexcept;
+
+        /// @brief Checks if a chunk is stored.
+        /// @param i The index of the chunk in the region.
+        /// @return true if the chunk is stored, false otherwise.
+        inline bool contains(u32 i) const noexcept { return !payload(i).empty(); }
+
+        /// @brief Reads a chunk.
+        /// @param i The index of the chunk in the region.
+        /// @param c The chunk the payload is decompressed into.
+        /// @return true if the chunk was read, false if it isn't stored or is corrupt.
+        inline bool load(u32 i, chunk& c) const noexcept
+        {
+            utils::const_span<u8> p = payload(i);
+            return !p.empty() && decompress_chunk(p, c);
+        }
+
+    private:
+        const u8* base;
+        usize size;
+    };
+};
@@ -0,0 +1,193 @@
+/**
+ * @file
+ * @brief Asynchronous reads and writes of the chunks of region files.
+ */
+#pragma once
+
+#include "region.hpp"
+
+#include <utils/concurrent_queue.hpp>
+#include <utils/ring.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace voxel
+{
+    /// @brief A finished read or write of a chunk.
+    struct io_completion
+    {
+        /** The region file of the chunk. */
+        region_file* region;
+        /** The index of the chunk in the region. */
+        u32 index;
+        /** true if the operation succeeded, false otherwise. */
+        bool ok;
+        /** The payload read, valid until the callback returns; empty for writes. */
+        utils::const_span<u8> payload;
+        /** The user data passed with the operation. */
+        void* user;
+    };
+
+    /** The type of the function called when an operation finishes. */
+    typedef void (*io_callback)(const io_completion& done);
+
+    /// @brief Reads and writes the payloads of chunks in region files without blocking.
+    ///
+    /// Operations are queued by read and write, and submitted in batches by poll, as many as
+    /// there are free buffers in a pool of utils::buffers sized for the largest payload.
+    /// On Linux the buffers are registered with an io_uring, so a whole batch is submitted
+    /// with a single system call and the kernel doesn't map the buffers again for every
+    /// operation. A write is linked to the write of its table entry, so the entry is only
+    /// written once the payload is. Where io_uring isn't available, or isn't allowed, a
+    /// small pool of threads runs the same operations with region_file::read_at and
+    /// write_at, on any platform.
+    ///
+    /// Callbacks run inside poll or wait, on the thread that calls them, which is also the
+    /// only thread that may touch the region files while operations on them are pending.
+    /// They may queue new operations, but not call poll or wait themselves. A read callback
+    /// gets the payload straight in its buffer, to decompress it or hand it to a job. A
+    /// write only updates the table of its region file in memory when it finishes, freeing
+    /// the old sectors of the chunk then.
+    ///
+    /// Operations on the same chunk must not overlap.
+    class region_io
+    {
+    public:
+        /// @brief The way the operations are run.
+        enum class backend : u8
+        {
+            /** Submitted to an io_uring. */
+            io_uring,
+            /** Run by a pool of threads with blocking calls. */
+            threads
+        };
+
+        /** The size of every buffer of the pool, in bytes: the largest payload and a table entry. */
+        static constexpr usize buffer_size = (max_payload_size + sizeof(region_entry) + sector_size - 1) / sector_size * sector_size;
+
+        /// @brief Starts the backend.
+        /// @param depth The number of buffers, so the most operations in flight at once.
+        /// @param threads The number of threads of the fallback backend.
+        /// @param prefer_io_uring false to always use the fallback backend.
+        region_io(u32 depth = 64, u32 threads = 4, bool prefer_io_uring = true) noexcept;
+
+        region_io(const region_io&) = delete;
+        region_io& operator=(const region_io&) = delete;
+
+        /// @brief Waits for every operation, then stops the backend.
+        ~region_io() noexcept;
+
+        /// @brief Returns the way the operations are run.
+        /// @return The backend.
+        inline backend kind() const noexcept { return mode; }
+
+        /// @brief Queues the read of a chunk.
+        /// @param r The region file, which must stay open until the read finishes.
+        /// @param i The index of the chunk in the region.
+        /// @param f The function called with the payload once it's read.
+        /// @param user User data passed to f.
+        /// @return true if the read was queued, false if the chunk isn't stored.
+        bool read(region_file& r, u32 i, io_callback f, void* user = nullptr) noexcept;
+
+        /// @brief Queues the write of a chunk.
+        /// @param r The region file, which must stay open until the write finishes.
+        /// @param i The index of the chunk in the region.
+        /// @param payload The payload, as written by compress_chunk, moved into the queue.
+        /// An empty payload erases the chunk.
+        /// @param f The function called once the payload and the entry are written, or nullptr.
+        /// @param user User data passed to f.
+        ///
+        /// Chunks are usually compressed on jobs, and their payloads handed over here.
+        void write(region_file& r, u32 i, utils::array<u8>&& payload, io_callback f = nullptr, void* user = nullptr) noexcept;
+
+        /// @brief Submits the queued operations that fit in free buffers, and finishes the
+        /// completed ones, without blocking.
+        /// @return The number of operations finished.
+        usize poll() noexcept;
+
+        /// @brief Runs poll until every operation has finished, blocking between calls.
+        void wait() noexcept;
+
+        /// @brief Returns the number of operations queued or in flight.
+        /// @return The number of operations that haven't finished.
+        inline usize pending() const noexcept { return queue.size() + in_flight; }
+
+    private:
+        /// @brief An operation waiting for a buffer.
+        struct request
+        {
+            region_file* region;
+            utils::array<u8> payload;
+            io_callback callback;
+            void* user;
+            u32 index;
+            bool write;
+        };
+
+        /// @brief An operation holding a buffer, whose index it shares.
+        struct operation
+        {
+            region_file* region;
+            io_callback callback;
+            void* user;
+            u32 index;
+            u32 sector;
+            u32 length;
+            /** The number of completions still expected. */
+            u32 waiting;
+            /** The first error, or 0. */
+            i32 error;
+            bool write;
+        };
+
+        /// @brief The rings shared with the kernel.
+        struct ring
+        {
+            int fd;
+            void* sq_ring;
+            usize sq_size;
+            void* cq_ring;
+            usize cq_size;
+            void* entries;
+            usize entries_size;
+            u32* sq_head;
+            u32* sq_tail;
+            u32* sq_mask;
+            u32* sq_array;
+            u32* cq_head;
+            u32* cq_tail;
+            u32* cq_mask;
+            void* cqes;
+            u32 sq_entries;
+        };
+
+        bool start_ring() noexcept;
+        void stop_ring() noexcept;
+        void start_threads(u32 threads) noexcept;
+        void stop_threads() noexcept;
+
+        void start(u32 slot) noexcept;
+        usize submit() noexcept;
+        usize reap(bool block) noexcept;
+        void finish(u32 slot) noexcept;
+        void work() noexcept;
+
+    private:
+        utils::array<utils::buffer<u8>> buffers;
+        utils::array<operation> operations;
+        utils::array<u32> free;
+        utils::deque<request> queue;
+        usize in_flight;
+        ring uring;
+        backend mode;
+
+        // The fallback backend: slots to run, and slots done.
+        utils::array<::std::thread> workers;
+        utils::mpmc_queue<u32> runnable;
+        utils::mpmc_queue<u32> done;
+        ::std::atomic<u32> epoch;
+        ::std::atomic<u32> finished;
+        ::std::atomic<bool> stopping;
+    };
+};
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief Incremental remeshing of edited chunks.
+ */
+#pragma once
+
+#include "chunk_map.hpp"
+#include "mesher.hpp"
+
+#include <utils/ring.hpp>
+
+namespace voxel
+{
+    /// @brief The quads of a chunk, grouped by face and slice so they can be patched.
+    ///
+    /// The quads of every one of the mesher::group_count groups are stored contiguously, in
+    /// the order mesher::mesh writes them. An edit only changes the faces of the slices
+    /// through the voxel and next to it, so only those groups are marked dirty; update
+    /// meshes them again and splices them into the array in place, shifting the quads of
+    /// the following groups.
+    ///
+    /// A new chunk_mesh has every group dirty.
+    class chunk_mesh
+    {
+    public:
+        /// @brief Constructs a mesh that has never been built.
+        chunk_mesh() noexcept;
+
+        /// @brief Returns all the quads of the chunk.
+        /// @return A const span over the quads, valid until the next update.
+        inline utils::const_span<quad> quads() const noexcept { return data; }
+
+        /// @brief Returns the quads of a single group.
+        /// @param f The face of the quads.
+        /// @param slice The coordinate of the slice along the axis of the face.
+        /// @return A const span over the quads of the group, valid until the next update.
+        inline utils::const_span<quad> group(face f, u32 slice) const noexcept
+        {
+            usize g = static_cast<usize>(f) * chunk_size + slice;
+            u32 first = g == 0 ? 0 : ends[g - 1];
+            return data.subarray(first, ends[g] - first);
+        }
+
+        /// @brief Marks the groups whose faces depend on a voxel as dirty.
+        /// @param c The position of the voxel.
+        void mark(local_coord c) noexcept;
+
+        /// @brief Marks a single group as dirty.
+        /// @param f The face of the group.
+        /// @param slice The coordinate of the slice along the axis of the face.
+        inline void mark(face f, u32 slice) noexcept { slices[static_cast<usize>(f)] |= u32(1) << slice; }
+
+        /// @brief Marks every group as dirty, so the next update meshes the whole chunk.
+        void mark_all() noexcept;
+
+        /// @brief Checks if any group is dirty.
+        /// @return true if the next update has work to do, false otherwise.
+        bool dirty() const noexcept;
+
+        /// @brief Meshes the dirty groups again.
+        /// @param m A mesher with the chunk and its neighbors loaded.
+        ///
+        /// Meshes the whole chunk at once when too many groups are dirty for patching them
+        /// one by one to pay off.
+        void update(mesher& m) noexcept;
+
+    private:
+        void splice(usize g, usize first) noexcept;
+
+    private:
+        utils::array<quad> data;
+        u32 ends[mesher::group_count];
+        u32 slices[face_count];
+    };
+
+    /// @brief Keeps the meshes of the chunks of a map up to date as they're edited.
+    ///
+    /// Edits are reported with changed, which marks the groups of the edited chunk dirty,
+    /// along with the border groups of a neighbor when the voxel touches it, and queues
+    /// the chunks that weren't dirty yet. update then meshes a bounded number of queued
+    /// chunks, so a frame with many edits spreads the remeshing over several frames.
+    class remesher
+    {
+    public:
+        /// @brief Constructs a remesher for the chunks of a map.
+        /// @param chunks The chunks, which must outlive the remesher.
+        remesher(chunk_map<chunk>& chunks) noexcept;
+
+        /// @brief Reports that a voxel was edited.
+        /// @param c The coordinates of the chunk of the voxel.
+        /// @param v The position of the voxel inside its chunk.
+        void changed(const chunk_coord& c, local_coord v) noexcept;
+
+        /// @brief Reports that a whole chunk was replaced, e.g. loaded or generated.
+        /// @param c The coordinates of the chunk.
+        void changed(const chunk_coord& c) noexcept;
+
+        /// @brief Meshes the queued chunks.
+        /// @param budget The largest number of chunks to mesh.
+        /// @return The number of chunks meshed.
+        ///
+        /// Chunks that were erased from the map in the meantime drop their mesh instead.
+        usize update(usize budget = ~usize(0)) noexcept;
+
+        /// @brief Returns the mesh of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return A const pointer to the mesh, or nullptr if the chunk was never reported.
+        inline const chunk_mesh* find(const chunk_coord& c) const noexcept { return meshes.get(c); }
+
+        /// @brief Drops the mesh of a chunk.
+        /// @param c The coordinates of the chunk.
+        inline void erase(const chunk_coord& c) noexcept { meshes.erase(c); }
+
+        /// @brief Returns the number of chunks waiting to be meshed.
+        /// @return The number of queued chunks.
+        inline usize pending() const noexcept { return queue.size(); }
+
+    private:
+        chunk_mesh* touch(const chunk_coord& c) noexcept;
+
+    private:
+        chunk_map<chunk>& chunks;
+        chunk_map<chunk_mesh> meshes;
+        utils::deque<chunk_coord> queue;
+        mesher m;
+    };
+};
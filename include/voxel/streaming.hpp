@@ -0,0 +1,182 @@
+/**
+ * @file
+ * @brief Streaming of the chunks around observers, nearest and most visible first.
+ */
+#pragma once
+
+#include "chunk_map.hpp"
+
+namespace voxel
+{
+    /// @brief A point chunks are streamed around, like a player or a camera.
+    struct observer
+    {
+        /** The position of the observer in the world, in voxels. */
+        f32 x;
+        f32 y;
+        f32 z;
+        /** The direction the observer looks at; it doesn't have to be normalized. */
+        f32 dir_x;
+        f32 dir_y;
+        f32 dir_z;
+        /** The radius of the sphere of chunks kept around the observer, in chunks. */
+        u32 radius;
+    };
+
+    /// @brief The steps a chunk goes through before it's ready.
+    enum class stream_task : u8
+    {
+        /** Read from disk. */
+        load,
+        /** Generated, since it wasn't stored. */
+        generate,
+        /** Meshed, once its blocks are known. */
+        mesh
+    };
+
+    /** The number of kinds of tasks. */
+    constexpr usize stream_task_count = 3;
+
+    /// @brief The largest number of tasks of every kind handed out per frame.
+    struct stream_budget
+    {
+        u32 loads;
+        u32 generations;
+        u32 meshes;
+    };
+
+    /// @brief Decides which chunks to load, generate, mesh and unload around observers.
+    ///
+    /// Every chunk within the radius of an observer is requested, and goes through a load,
+    /// a generation if it wasn't stored, and a mesh. The tasks waiting to run are kept in
+    /// one binary heap per kind, keyed by their priority: the distance to the nearest
+    /// observer, stretched up to twice for chunks behind it, so the chunks in view and
+    /// around the observer come first. Priorities are computed again every frame, as
+    /// observers move and turn, and the heaps rebuilt in linear time.
+    ///
+    /// schedule hands out the most urgent tasks of a kind, at most the budget of that kind
+    /// per frame, so an observer moving fast spreads its load over several frames instead of
+    /// stalling one. The caller runs them, and reports them done with loaded, generated and
+    /// meshed.
+    ///
+    /// Chunks further than one chunk past the radius of every observer are dropped: waiting
+    /// tasks are cancelled, ready chunks and the ones waiting to be meshed reported to
+    /// unload, and running tasks cancelled so that reporting them done tells the caller to
+    /// throw the result away. The extra chunk
+    /// keeps observers going back and forth over a border from streaming the same chunks
+    /// again and again.
+    class streamer
+    {
+    public:
+        /// @brief Constructs a streamer with no observers.
+        /// @param budget The number of tasks of every kind handed out per frame.
+        streamer(const stream_budget& budget) noexcept;
+
+        /// @brief Starts a frame: requests the chunks around the observers, drops the ones
+        /// out of range, and orders the waiting tasks.
+        /// @param observers The observers.
+        /// @param unloads The array the coordinates of the chunks to unload are appended to:
+        /// ready ones, and ones whose blocks were loaded or generated but not meshed yet.
+        ///
+        /// The chunks in range are only scanned again when an observer enters another chunk,
+        /// or the observers change.
+        void update(const utils::const_span<observer>& observers, utils::array<chunk_coord>& unloads) noexcept;
+
+        /// @brief Hands out the most urgent waiting tasks of a kind.
+        /// @param t The kind of tasks.
+        /// @param out The array the coordinates of their chunks are appended to, most urgent first.
+        /// @return The number of tasks handed out, limited by what's left of the budget of the frame.
+        usize schedule(stream_task t, utils::array<chunk_coord>& out) noexcept;
+
+        /// @brief Reports that a chunk was read.
+        /// @param c The coordinates of the chunk.
+        /// @param found true if the chunk was stored, false if it must be generated.
+        /// @return true if the chunk is still wanted, false if it was cancelled and must be dropped.
+        bool loaded(const chunk_coord& c, bool found) noexcept;
+
+        /// @brief Reports that a chunk was generated.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk is still wanted, false if it was cancelled and must be dropped.
+        bool generated(const chunk_coord& c) noexcept;
+
+        /// @brief Reports that a chunk was meshed, making it ready.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk is still wanted, false if it was cancelled and must be dropped.
+        bool meshed(const chunk_coord& c) noexcept;
+
+        /// @brief Checks if a chunk is ready.
+        /// @param c The coordinates of the chunk.
+        /// @return true if the chunk was meshed and is still in range, false otherwise.
+        bool ready(const chunk_coord& c) const noexcept;
+
+        /// @brief Returns the number of waiting tasks of a kind.
+        /// @param t The kind of tasks.
+        /// @return The number of tasks in the heap of that kind.
+        inline usize pending(stream_task t) const noexcept { return heaps[static_cast<usize>(t)].size(); }
+
+        /// @brief Returns the number of tasks handed out and not reported done yet.
+        /// @return The number of running tasks, cancelled ones included.
+        inline usize running() const noexcept { return active; }
+
+        /// @brief Returns the number of chunks tracked, from requested to ready.
+        /// @return The number of chunks tracked.
+        inline usize size() const noexcept { return entries.size(); }
+
+    private:
+        /// @brief The state of a chunk.
+        enum class phase : u8
+        {
+            /** In the heap of its task. */
+            waiting,
+            /** Handed out. */
+            running,
+            /** Handed out, then dropped. */
+            cancelled,
+            /** Meshed. */
+            ready
+        };
+
+        /// @brief A chunk tracked by the streamer.
+        struct entry
+        {
+            chunk_coord coord;
+            stream_task task;
+            phase state;
+        };
+
+        /// @brief A waiting task, smaller priorities first.
+        struct node
+        {
+            f32 priority;
+            u32 index;
+        };
+
+        /// @brief The chunk of an observer, and its radius.
+        struct center
+        {
+            chunk_coord coord;
+            u32 radius;
+        };
+
+        typedef chunk_map<entry>::index_type index_type;
+
+        entry* complete(const chunk_coord& c, stream_task t) noexcept;
+        void enqueue(index_type i, stream_task t, f32 priority) noexcept;
+        bool in_range(const chunk_coord& c) const noexcept;
+        f32 priority(const chunk_coord& c) const noexcept;
+        void rescan(utils::array<chunk_coord>& unloads) noexcept;
+
+        static void sift_up(utils::array<node>& heap, usize i) noexcept;
+        static void sift_down(utils::array<node>& heap, usize i) noexcept;
+
+    private:
+        chunk_map<entry> entries;
+        utils::array<node> heaps[stream_task_count];
+        utils::array<center> centers;
+        utils::array<observer> views;
+        utils::array<chunk_coord> scratch;
+        stream_budget budget;
+        u32 left[stream_task_count];
+        usize active;
+    };
+};
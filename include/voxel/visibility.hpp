@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @brief Connectivity of the faces of chunks through their transparent voxels.
+ */
+#pragma once
+
+#include "mesher.hpp"
+#include "occupancy.hpp"
+
+#include <utils/ring.hpp>
+
+namespace voxel
+{
+    /** The mask of the connections of a chunk where every pair of faces is connected. */
+    constexpr u16 all_connected = 0x7fff;
+
+    /// @brief Returns the bit of a pair of distinct faces in a mask of connections.
+    /// @param a A face.
+    /// @param b Another face.
+    /// @return The index of the pair among the 15 pairs of faces, in [0, 15).
+    inline constexpr u32 face_pair(face a, face b) noexcept
+    {
+        u32 i = static_cast<u32>(a < b ? a : b), j = static_cast<u32>(a < b ? b : a);
+        return i * 5 - i * (i - 1) / 2 + j - i - 1;
+    }
+
+    /// @brief Finds which faces of a chunk see each other through its transparent voxels.
+    /// @param o The occupancy of the chunk.
+    /// @return A mask with bit face_pair(a, b) set if faces a and b are connected through a
+    /// path of transparent voxels.
+    ///
+    /// Every region of transparent voxels touching a face is flood filled from it, a row of
+    /// 32 voxels at a time. The queue is a ring buffer of rows and the voxels reached are a
+    /// packed bitset of the same layout as the occupancy, so a row spreads to each of its 4
+    /// neighbor rows with a few bit operations, and along itself with a bitwise fill.
+    u16 face_connections(const chunk_occupancy& o) noexcept;
+
+    /// @brief The connections of the faces of the chunks of a map, kept up to date as they're edited.
+    ///
+    /// A traversal from the chunk of the camera goes into a neighbor through a face only if
+    /// the face it entered the current chunk by sees that face, and never goes back along a
+    /// direction it went forward along before. Chunks behind solid rock are never reached,
+    /// while caves and tunnels are followed.
+    class visibility_graph
+    {
+    public:
+        /// @brief Constructs a graph for the chunks of a map.
+        /// @param occupancy The occupancy of the chunks, which must outlive the graph.
+        visibility_graph(const chunk_map<chunk_occupancy>& occupancy) noexcept;
+
+        /// @brief Adds a chunk that was added to the map.
+        /// @param c The coordinates of the chunk.
+        void chunk_added(const chunk_coord& c) noexcept;
+
+        /// @brief Removes a chunk, before it's erased from the map.
+        /// @param c The coordinates of the chunk.
+        void chunk_removed(const chunk_coord& c) noexcept;
+
+        /// @brief Queues the update of a chunk after a voxel of it was edited.
+        /// @param c The coordinates of the chunk.
+        /// @param v The position of the voxel inside the chunk, whose occupancy was already updated.
+        ///
+        /// Edits that can't change the connections are skipped: filling a voxel of a chunk
+        /// whose faces are all separated already, or clearing one in a chunk whose faces are
+        /// all connected already.
+        void block_changed(const chunk_coord& c, local_coord v) noexcept;
+
+        /// @brief Recomputes the connections of the edited chunks.
+        /// @return The number of chunks recomputed.
+        usize update() noexcept;
+
+        /// @brief Returns the connections of a chunk.
+        /// @param c The coordinates of the chunk.
+        /// @return The mask of the connections of the chunk, or all_connected if it isn't in the graph.
+        u16 connections(const chunk_coord& c) const noexcept;
+
+        /// @brief Finds the chunks that can be seen from a chunk.
+        /// @param start The chunk of the camera.
+        /// @param visible The array the chunks reached are appended to, starting with the
+        /// chunk of the camera, in breadth-first order.
+        /// @param accept A function called as accept(c) on a chunk before going into it, to
+        /// stop the traversal at chunks outside the view.
+        ///
+        /// Only chunks in the graph are visited.
+        template<typename predicate>
+        void traverse(const chunk_coord& start, utils::array<chunk_coord>& visible, predicate&& accept) noexcept
+        {
+            if(nodes.find(start) == none)
+                return;
+
+            reached.clear();
+            queue.clear();
+            reached.insert(start);
+            visible.push(start);
+            queue.push_back(step { start, no_face, 0 });
+            while(!queue.empty())
+            {
+                step s = queue.front();
+                queue.pop_front();
+                u16 mask = s.entered == no_face ? all_connected : nodes[nodes.find(s.c)].connections;
+                for(u32 f = 0; f != face_count; f++)
+                {
+                    // Never back along a direction taken before, and only out by a face seen
+                    // from the one the chunk was entered by.
+                    if((s.directions >> (f ^ 1)) & 1)
+                        continue;
+                    if(s.entered != no_face && !((mask >> face_pair(face(s.entered), face(f))) & 1))
+                        continue;
+
+                    chunk_coord n = neighbor(s.c, f);
+                    if(nodes.find(n) == none || reached.find(n) != none || !accept(n))
+                        continue;
+
+                    reached.insert(n);
+                    visible.push(n);
+                    queue.push_back(step { n, static_cast<u8>(f ^ 1), static_cast<u8>(s.directions | (1 << f)) });
+                }
+            }
+        }
+
+        /// @brief Finds the chunks that can be seen from a chunk.
+        /// @param start The chunk of the camera.
+        /// @param visible The array the chunks reached are appended to.
+        inline void traverse(const chunk_coord& start, utils::array<chunk_coord>& visible) noexcept
+        {
+            traverse(start, visible, [](const chunk_coord&) { return true; });
+        }
+
+    private:
+        /// @brief The connections of a chunk.
+        struct node
+        {
+            u16 connections;
+            bool dirty;
+        };
+
+        /// @brief A chunk reached by a traversal, with the face it was entered by and the
+        /// directions taken to reach it.
+        struct step
+        {
+            chunk_coord c;
+            u8 entered;
+            u8 directions;
+        };
+
+        static constexpr u32 none = chunk_map<node>::none;
+        static constexpr u8 no_face = face_count;
+
+        static chunk_coord neighbor(const chunk_coord& c, u32 f) noexcept;
+
+    private:
+        const chunk_map<chunk_occupancy>& occupancy;
+        chunk_map<node> nodes;
+        utils::array<chunk_coord> dirty;
+        chunk_map<u8> reached;
+        utils::deque<step> queue;
+    };
+};
@@ -0,0 +1,89 @@
+#include <jobs/graph.hpp>
+
+namespace jobs
+{
+    task_graph::node::node(const job& work) noexcept :
+        work(work), task(), successors(), dependencies(0), remaining(0)
+    {
+    }
+
+    task_graph::node::node(node&& other) noexcept :
+        work(other.work), task(other.task), successors(::std::move(other.successors)),
+        dependencies(other.dependencies), remaining(other.remaining.load(::std::memory_order_relaxed))
+    {
+    }
+
+    task_graph::node& task_graph::node::operator=(node&& other) noexcept
+    {
+        work = other.work;
+        task = other.task;
+        successors = ::std::move(other.successors);
+        dependencies = other.dependencies;
+        remaining.store(other.remaining.load(::std::memory_order_relaxed), ::std::memory_order_relaxed);
+
+        return *this;
+    }
+
+    task_graph::task_graph() noexcept :
+        nodes(), running(nullptr)
+    {
+    }
+
+    task_graph::node_index task_graph::add(job::function_type function, void* data, usize begin, usize end) noexcept
+    {
+        return static_cast<node_index>(nodes.create(job(function, data, begin, end)));
+    }
+
+    void task_graph::precede(node_index before, node_index after) noexcept
+    {
+        nodes[before].successors.push(after);
+        nodes[after].dependencies++;
+    }
+
+    void task_graph::clear() noexcept
+    {
+        nodes.clear();
+    }
+
+    void task_graph::submit(scheduler& s, counter& group) noexcept
+    {
+        running = &s;
+
+        // Nodes are never destroyed one by one, so their indices are exactly [0, size()).
+        usize n = nodes.size();
+        for(usize i = 0; i != n; i++)
+        {
+            node& current = nodes[i];
+            current.task = job(&execute, this, i);
+            current.remaining.store(current.dependencies, ::std::memory_order_relaxed);
+        }
+
+        for(usize i = 0; i != n; i++)
+            if(nodes[i].dependencies == 0)
+                s.submit(nodes[i].task, group);
+    }
+
+    void task_graph::run(scheduler& s) noexcept
+    {
+        counter group;
+        submit(s, group);
+        s.wait(group);
+    }
+
+    void task_graph::execute(job& j) noexcept
+    {
+        task_graph& graph = *static_cast<task_graph*>(j.data);
+        node& current = graph.nodes[j.begin];
+
+        current.work.run();
+
+        // The successors are submitted before this job reports itself finished, so the
+        // group can't reach zero while there is still work left in the graph.
+        for(node_index next : current.successors)
+        {
+            node& successor = graph.nodes[next];
+            if(successor.remaining.fetch_sub(1, ::std::memory_order_acq_rel) == 1)
+                graph.running->submit(successor.task, *j.group);
+        }
+    }
+};
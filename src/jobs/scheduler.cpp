@@ -0,0 +1,181 @@
+#include <jobs/scheduler.hpp>
+
+namespace jobs
+{
+    namespace
+    {
+        thread_local scheduler* current_scheduler = nullptr;
+        thread_local usize current_worker = 0;
+        thread_local u64 steal_state = 0x9E3779B97F4A7C15ull;
+
+        /// Number of failed searches for work before a worker goes to sleep.
+        constexpr usize idle_spins = 64;
+
+        inline usize worker_threads(usize count) noexcept
+        {
+            if(count != 0)
+                return count;
+
+            usize hardware = ::std::thread::hardware_concurrency();
+            return hardware > 1 ? hardware - 1 : 1;
+        }
+
+        inline u64 next_random() noexcept
+        {
+            steal_state ^= steal_state << 13;
+            steal_state ^= steal_state >> 7;
+            steal_state ^= steal_state << 17;
+            return steal_state;
+        }
+    };
+
+    scheduler::scheduler(usize count) noexcept :
+        workers(worker_threads(count)), injected(injection_capacity), epoch(0), sleeping(0), stopping(false)
+    {
+        for(usize i = 0; i != workers.capacity(); i++)
+            workers.push_unchecked();
+
+        for(usize i = 0; i != workers.size(); i++)
+            workers[i].thread = ::std::thread(&scheduler::work, this, i);
+    }
+
+    scheduler::~scheduler() noexcept
+    {
+        stopping.store(true, ::std::memory_order_seq_cst);
+        epoch.fetch_add(1, ::std::memory_order_seq_cst);
+        epoch.notify_all();
+
+        for(worker& w : workers)
+            w.thread.join();
+    }
+
+    void scheduler::submit(job& j, counter& group) noexcept
+    {
+        group.add(1);
+        j.group = &group;
+        push(&j);
+        wake(1);
+    }
+
+    void scheduler::submit(job& j) noexcept
+    {
+        j.group = nullptr;
+        push(&j);
+        wake(1);
+    }
+
+    void scheduler::submit(utils::span<job> js, counter& group) noexcept
+    {
+        if(js.empty())
+            return;
+
+        group.add(js.size());
+        for(job& j : js)
+        {
+            j.group = &group;
+            push(&j);
+        }
+        wake(js.size());
+    }
+
+    void scheduler::wait(const counter& group) noexcept
+    {
+        while(!group.finished())
+            if(!run_one())
+                ::std::this_thread::yield();
+    }
+
+    bool scheduler::run_one() noexcept
+    {
+        job* j;
+        if(current_scheduler == this && workers[current_worker].deque.pop(j))
+        {
+            j->run();
+            return true;
+        }
+
+        if(injected.try_pop(j) || steal(j))
+        {
+            j->run();
+            return true;
+        }
+
+        return false;
+    }
+
+    scheduler* scheduler::current() noexcept
+    {
+        return current_scheduler;
+    }
+
+    void scheduler::work(usize index) noexcept
+    {
+        current_scheduler = this;
+        current_worker = index;
+        steal_state += index * 0x2545F4914F6CDD1Dull;
+
+        usize failures = 0;
+        while(!stopping.load(::std::memory_order_relaxed))
+        {
+            if(run_one())
+            {
+                failures = 0;
+                continue;
+            }
+
+            if(++failures < idle_spins)
+            {
+                ::std::this_thread::yield();
+                continue;
+            }
+
+            sleeping.fetch_add(1, ::std::memory_order_seq_cst);
+            u32 e = epoch.load(::std::memory_order_seq_cst);
+            if(!stopping.load(::std::memory_order_seq_cst) && !run_one())
+                epoch.wait(e, ::std::memory_order_seq_cst);
+            sleeping.fetch_sub(1, ::std::memory_order_seq_cst);
+            failures = 0;
+        }
+
+        current_scheduler = nullptr;
+    }
+
+    void scheduler::push(job* j) noexcept
+    {
+        bool pushed = current_scheduler == this
+            ? workers[current_worker].deque.push(j)
+            : injected.try_push(j);
+
+        // Overflowing work runs right away on the submitting thread.
+        if(!pushed)
+            j->run();
+    }
+
+    void scheduler::wake(usize n) noexcept
+    {
+        epoch.fetch_add(1, ::std::memory_order_seq_cst);
+        if(sleeping.load(::std::memory_order_seq_cst) == 0)
+            return;
+
+        if(n == 1)
+            epoch.notify_one();
+        else epoch.notify_all();
+    }
+
+    bool scheduler::steal(job*& j) noexcept
+    {
+        usize n = workers.size();
+        usize start = static_cast<usize>(next_random() % n);
+        for(usize i = 0; i != n; i++)
+        {
+            usize victim = start + i < n ? start + i : start + i - n;
+            if(current_scheduler == this && victim == current_worker)
+                continue;
+
+            if(workers[victim].deque.steal(j))
+                return true;
+        }
+
+        return false;
+    }
+};
@@ -0,0 +1,64 @@
+#include <jobs/task.hpp>
+
+namespace jobs
+{
+    namespace
+    {
+        /// Frames are rounded up to a multiple of this size.
+        constexpr usize frame_granularity = 64;
+        /// Number of size classes; larger frames always go to the global heap.
+        constexpr usize frame_classes = 32;
+        /// Maximum number of free frames kept per size class and thread.
+        constexpr usize frames_per_class = 256;
+
+        struct frame_pool
+        {
+            inline ~frame_pool() noexcept
+            {
+                for(utils::array<void*>& frames : free)
+                    for(void* frame : frames)
+                        ::std::free(frame);
+            }
+
+            utils::array<void*> free[frame_classes];
+        };
+
+        thread_local frame_pool pool;
+    };
+
+    void* allocate_frame(usize n) noexcept
+    {
+        usize c = (n + frame_granularity - 1) / frame_granularity - 1;
+        if(c >= frame_classes)
+            return ::std::malloc(n);
+
+        utils::array<void*>& frames = pool.free[c];
+        if(frames.empty())
+            return ::std::malloc((c + 1) * frame_granularity);
+
+        void* frame = frames.back();
+        frames.pop();
+        return frame;
+    }
+
+    void deallocate_frame(void* ptr, usize n) noexcept
+    {
+        usize c = (n + frame_granularity - 1) / frame_granularity - 1;
+        if(c >= frame_classes)
+        {
+            ::std::free(ptr);
+            return;
+        }
+
+        // Frames may be freed on another thread than the one that allocated them; they
+        // simply migrate to the free lists of the freeing thread.
+        utils::array<void*>& frames = pool.free[c];
+        if(frames.size() == frames_per_class)
+        {
+            ::std::free(ptr);
+            return;
+        }
+
+        frames.push(ptr);
+    }
+};
@@ -0,0 +1,418 @@
+#include <voxel/chunk.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace voxel
+{
+    namespace
+    {
+        /// Packs chunk_volume values of a given width into words, lowest bits first.
+        template<typename function>
+        inline void pack(u64* words, u8 width, function&& value) noexcept
+        {
+            usize per_word = 64 / width;
+            for(usize w = 0, i = 0; w != chunk_volume * width / 64; w++)
+            {
+                u64 word = 0;
+                for(usize k = 0; k != per_word; k++, i++)
+                    word |= u64(value(i)) << (k * width);
+                words[w] = word;
+            }
+        }
+
+        /// Unpacks the indices of a given width through the palette, a byte at a time.
+        template<u8 width>
+        inline void unpack(const u64* words, const utils::const_span<block>& palette, block* out) noexcept
+        {
+            constexpr usize per_byte = 8 / width;
+            constexpr u32 mask = (1 << width) - 1;
+
+            // Every byte of packed indices turns into per_byte blocks, looked up at once.
+            block table[256][per_byte];
+            for(u32 b = 0; b != 256; b++)
+                for(u32 k = 0; k != per_byte; k++)
+                {
+                    u32 index = (b >> (k * width)) & mask;
+                    table[b][k] = index < palette.size() ? palette[index] : air;
+                }
+
+            for(usize w = 0; w != chunk_volume * width / 64; w++)
+            {
+                u64 word = words[w];
+                for(usize k = 0; k != 8; k++, word >>= 8, out += per_byte)
+                    ::std::memcpy(out, table[word & 0xff], sizeof(table[0]));
+            }
+        }
+    };
+
+    chunk::chunk(block value) noexcept :
+        entries({ value }), counts({ static_cast<u16>(chunk_volume) }), data(), live(1), bits(0)
+    {
+    }
+
+    void chunk::set(usize i, block b) noexcept
+    {
+        replace(i, b);
+        narrow();
+    }
+
+    void chunk::get_many(const utils::const_span<local_coord>& coords, const utils::span<block>& out) const noexcept
+    {
+        if(bits == 0)
+        {
+            for(usize i = 0; i != coords.size(); i++)
+                out[i] = entries[0];
+            return;
+        }
+
+        for(usize i = 0; i != coords.size(); i++)
+            out[i] = get(coords[i].index());
+    }
+
+    void chunk::set_many(const utils::const_span<local_coord>& coords, const utils::const_span<block>& blocks) noexcept
+    {
+        reserve(blocks);
+        for(usize i = 0; i != coords.size(); i++)
+            replace(coords[i].index(), blocks[i]);
+        narrow();
+    }
+
+    void chunk::set_many(const utils::const_span<local_coord>& coords, block b) noexcept
+    {
+        reserve(utils::const_span<block>(&b, 1));
+        for(const local_coord& c : coords)
+            replace(c.index(), b);
+        narrow();
+    }
+
+    void chunk::fill(block b) noexcept
+    {
+        entries = { b };
+        counts = { static_cast<u16>(chunk_volume) };
+        data = utils::buffer<u64>();
+        live = 1;
+        bits = 0;
+    }
+
+    void chunk::encode(const utils::const_span<block>& blocks) noexcept
+    {
+        entries.clear();
+        counts.clear();
+
+        utils::buffer<u8> indices(chunk_volume);
+        usize last = 0;
+        for(usize i = 0; i != chunk_volume; i++)
+        {
+            block b = blocks[i];
+            if(entries.empty() || entries[last] != b)
+            {
+                last = 0;
+                while(last != entries.size() && entries[last] != b)
+                    last++;
+
+                if(last == entries.size())
+                {
+                    if(entries.size() == max_palette_size)
+                    {
+                        entries.clear();
+                        counts.clear();
+                        data.resize(chunk_volume * direct_bits / 64);
+                        pack(data.data(), direct_bits, [&blocks](usize i) { return blocks[i]; });
+                        live = 0;
+                        bits = direct_bits;
+                        return;
+                    }
+
+                    entries.push(b);
+                    counts.push(0);
+                }
+            }
+
+            counts[last]++;
+            indices[i] = static_cast<u8>(last);
+        }
+
+        live = static_cast<u16>(entries.size());
+        bits = width_for(live);
+        if(bits == 0)
+        {
+            data = utils::buffer<u64>();
+            return;
+        }
+
+        data.resize(chunk_volume * bits / 64);
+        pack(data.data(), bits, [&indices](usize i) { return indices[i]; });
+    }
+
+    void chunk::decode(const utils::span<block>& out) const noexcept
+    {
+        switch(bits)
+        {
+        case 0:
+            for(usize i = 0; i != chunk_volume; i++)
+                out[i] = entries[0];
+            break;
+        case 1:
+            unpack<1>(data.data(), entries, out.data());
+            break;
+        case 2:
+            unpack<2>(data.data(), entries, out.data());
+            break;
+        case 4:
+            unpack<4>(data.data(), entries, out.data());
+            break;
+        case 8:
+            unpack<8>(data.data(), entries, out.data());
+            break;
+        default:
+            if constexpr(::std::endian::native == ::std::endian::little)
+                ::std::memcpy(out.data(), data.data(), chunk_volume * sizeof(block));
+            else
+                for(usize i = 0; i != chunk_volume; i++)
+                    out[i] = static_cast<block>(read(i));
+            break;
+        }
+    }
+
+    utils::span<u64> chunk::assign_packed(const utils::const_span<block>& palette, u8 width) noexcept
+    {
+        entries = palette;
+        counts.clear();
+        counts.push_many(0, entries.size());
+        data = width == 0 ? utils::buffer<u64>() : utils::buffer<u64>(chunk_volume * width / 64);
+        live = 0;
+        bits = width;
+        return utils::span<u64>(data.data(), data.size());
+    }
+
+    bool chunk::recount() noexcept
+    {
+        if(bits == direct_bits)
+            return true;
+
+        if(bits == 0)
+        {
+            counts[0] = static_cast<u16>(chunk_volume);
+            live = 1;
+            return true;
+        }
+
+        // The bytes of the indices are counted first, in 4 histograms so that runs of the
+        // same byte don't wait on each other, then split into the indices they hold.
+        // Indices past the palette are counted too, and checked once at the end.
+        u32 bytes[4][256] = {};
+        const u8* p = reinterpret_cast<const u8*>(data.data());
+        for(usize i = 0; i != data.size() * sizeof(u64); i += 4)
+        {
+            bytes[0][p[i]]++;
+            bytes[1][p[i + 1]]++;
+            bytes[2][p[i + 2]]++;
+            bytes[3][p[i + 3]]++;
+        }
+
+        u32 uses[max_palette_size] = {};
+        u32 mask = (u32(1) << bits) - 1;
+        for(u32 b = 0; b != 256; b++)
+        {
+            u32 n = bytes[0][b] + bytes[1][b] + bytes[2][b] + bytes[3][b];
+            if(n != 0)
+                for(u32 k = 0; k != 8; k += bits)
+                    uses[(b >> k) & mask] += n;
+        }
+
+        usize size = entries.size();
+        for(usize i = size; i != (usize(1) << bits); i++)
+            if(uses[i] != 0)
+            {
+                fill(air);
+                return false;
+            }
+
+        live = 0;
+        for(usize i = 0; i != size; i++)
+        {
+            counts[i] = static_cast<u16>(uses[i]);
+            live += uses[i] != 0;
+        }
+        narrow();
+        return true;
+    }
+
+    void chunk::shrink_to_fit() noexcept
+    {
+        utils::buffer<block> blocks(chunk_volume);
+        decode(utils::span<block>(blocks.data(), chunk_volume));
+        encode(utils::const_span<block>(blocks.data(), chunk_volume));
+
+        entries.shrink_to_fit();
+        counts.shrink_to_fit();
+    }
+
+    usize chunk::find_or_add(block b) noexcept
+    {
+        usize free = entries.size();
+        for(usize i = 0; i != entries.size(); i++)
+        {
+            if(entries[i] == b)
+            {
+                if(counts[i] == 0)
+                    live++;
+                return i;
+            }
+
+            if(counts[i] == 0 && free == entries.size())
+                free = i;
+        }
+
+        live++;
+        if(free != entries.size())
+        {
+            entries[free] = b;
+            return free;
+        }
+
+        if(entries.size() == (usize(1) << bits))
+        {
+            widen(width_for(entries.size() + 1));
+            if(bits == direct_bits)
+                return b;
+        }
+
+        entries.push(b);
+        counts.push(0);
+        return entries.size() - 1;
+    }
+
+    void chunk::replace(usize i, block b) noexcept
+    {
+        if(bits == direct_bits)
+        {
+            write(i, b);
+            return;
+        }
+
+        usize old = bits == 0 ? 0 : read(i);
+        if(entries[old] == b)
+            return;
+
+        usize index = find_or_add(b);
+        if(bits == direct_bits)
+        {
+            write(i, b);
+            return;
+        }
+
+        counts[index]++;
+        write(i, index);
+        if(--counts[old] == 0)
+            live--;
+    }
+
+    void chunk::reserve(const utils::const_span<block>& blocks) noexcept
+    {
+        if(bits == direct_bits)
+            return;
+
+        utils::array<block> missing;
+        for(block b : blocks)
+        {
+            bool found = false;
+            for(usize i = 0; i != entries.size() && !found; i++)
+                found = entries[i] == b;
+            for(usize i = 0; i != missing.size() && !found; i++)
+                found = missing[i] == b;
+
+            if(!found)
+            {
+                missing.push(b);
+                if(missing.size() > max_palette_size)
+                    break;
+            }
+        }
+
+        usize free = 0;
+        for(u16 c : counts)
+            free += c == 0;
+
+        usize slots = entries.size() + (missing.size() > free ? missing.size() - free : 0);
+        u8 width = width_for(slots);
+        if(width > bits)
+            widen(width);
+    }
+
+    void chunk::widen(u8 width) noexcept
+    {
+        utils::array<usize> remap(entries.size());
+        for(usize i = 0; i != entries.size(); i++)
+            remap.push_unchecked(width == direct_bits ? entries[i] : i);
+
+        repack(width, remap);
+
+        if(width == direct_bits)
+        {
+            entries.clear();
+            counts.clear();
+            live = 0;
+        }
+    }
+
+    void chunk::narrow() noexcept
+    {
+        if(bits == 0 || bits == direct_bits || (live != 1 && width_for(2 * usize(live)) >= bits))
+            return;
+
+        utils::array<usize> remap(entries.size());
+        usize n = 0;
+        for(usize i = 0; i != entries.size(); i++)
+        {
+            remap.push_unchecked(n);
+            if(counts[i] != 0)
+            {
+                entries[n] = entries[i];
+                counts[n] = counts[i];
+                n++;
+            }
+        }
+
+        entries.pop_many(entries.size() - n);
+        counts.pop_many(counts.size() - n);
+
+        u8 width = width_for(n);
+        if(width == 0)
+        {
+            data = utils::buffer<u64>();
+            bits = 0;
+            return;
+        }
+
+        repack(width, remap);
+    }
+
+    void chunk::repack(u8 width, const utils::const_span<usize>& remap) noexcept
+    {
+        utils::buffer<u64> packed(chunk_volume * width / 64);
+        if(bits == 0)
+            pack(packed.data(), width, [&remap](usize) { return remap[0]; });
+        else
+            pack(packed.data(), width, [this, &remap](usize i) { return remap[read(i)]; });
+
+        data = ::std::move(packed);
+        bits = width;
+    }
+
+    u8 chunk::width_for(usize n) noexcept
+    {
+        if(n <= 1)
+            return 0;
+        if(n <= 2)
+            return 1;
+        if(n <= 4)
+            return 2;
+        if(n <= 16)
+            return 4;
+        if(n <= max_palette_size)
+            return 8;
+        return direct_bits;
+    }
+};
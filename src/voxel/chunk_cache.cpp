@@ -0,0 +1,229 @@
+#include <voxel/chunk_cache.hpp>
+
+namespace voxel
+{
+    chunk_cache::chunk_cache(usize budget, usize hot, spill_callback f, void* u) noexcept :
+        entries(), hot_list(), cold_list(), nodes(), spill(f), user(u), total_budget(budget), hot_budget(hot < budget ? hot : budget), hot_bytes(0), cold_bytes(0)
+    {
+    }
+
+    chunk* chunk_cache::get(const chunk_coord& c) noexcept
+    {
+        const index_type* node = nodes.get(c);
+        if(node == nullptr)
+            return nullptr;
+
+        index_type i = *node;
+        if(entries[i].hot)
+            entries.move_to_front(hot_list, i);
+        else
+        {
+            if(!promote(i))
+                return nullptr;
+            enforce();
+        }
+        return &entries[i].data;
+    }
+
+    bool chunk_cache::hot(const chunk_coord& c) const noexcept
+    {
+        const index_type* node = nodes.get(c);
+        return node != nullptr && entries[*node].hot;
+    }
+
+    chunk& chunk_cache::insert(const chunk_coord& c, chunk&& value, bool dirty) noexcept
+    {
+        const index_type* node = nodes.get(c);
+        index_type i;
+        if(node == nullptr)
+        {
+            i = entries.push_front(hot_list, c, ::std::move(value), utils::array<u8>(), usize(0), true, dirty);
+            nodes[nodes.insert(c)] = i;
+        }
+        else
+        {
+            i = *node;
+            entry& e = entries[i];
+            if(!e.hot)
+            {
+                cold_bytes -= e.bytes;
+                e.bytes = 0;
+                e.payload = utils::array<u8>();
+                e.hot = true;
+                entries.splice(hot_list, hot_list.head, cold_list, i);
+            }
+            else
+                entries.move_to_front(hot_list, i);
+            e.data = ::std::move(value);
+            e.dirty |= dirty;
+        }
+
+        resize(entries[i]);
+        enforce();
+        return entries[i].data;
+    }
+
+    void chunk_cache::insert(const chunk_coord& c, utils::array<u8>&& payload) noexcept
+    {
+        const index_type* node = nodes.get(c);
+        index_type i;
+        if(node == nullptr)
+        {
+            i = entries.push_front(cold_list, c, chunk(), ::std::move(payload), usize(0), false, false);
+            nodes[nodes.insert(c)] = i;
+        }
+        else
+        {
+            // The payload comes from disk, so whatever is cached is at least as recent.
+            i = *node;
+            entry& e = entries[i];
+            if(e.hot)
+                entries.move_to_front(hot_list, i);
+            else
+                entries.move_to_front(cold_list, i);
+            return;
+        }
+
+        entries[i].payload.shrink_to_fit();
+        resize(entries[i]);
+        enforce();
+    }
+
+    void chunk_cache::changed(const chunk_coord& c) noexcept
+    {
+        const index_type* node = nodes.get(c);
+        if(node == nullptr)
+            return;
+
+        entry& e = entries[*node];
+        e.dirty = true;
+        resize(e);
+        enforce();
+    }
+
+    bool chunk_cache::erase(const chunk_coord& c) noexcept
+    {
+        const index_type* node = nodes.get(c);
+        if(node == nullptr)
+            return false;
+
+        index_type i = *node;
+        entry& e = entries[i];
+        (e.hot ? hot_bytes : cold_bytes) -= e.bytes;
+        entries.erase(e.hot ? hot_list : cold_list, i);
+        nodes.erase(c);
+        return true;
+    }
+
+    usize chunk_cache::flush() noexcept
+    {
+        usize written = 0;
+        for(list_arena_type::list_type* l : { &hot_list, &cold_list })
+            for(index_type i = l->head; i != list_arena_type::null; i = entries.next(i))
+            {
+                entry& e = entries[i];
+                if(!e.dirty)
+                    continue;
+
+                utils::array<u8> payload;
+                if(e.hot)
+                    compress_chunk(e.data, payload);
+                else
+                    payload = e.payload;
+                spill(e.coord, ::std::move(payload), user);
+                e.dirty = false;
+                written++;
+            }
+        return written;
+    }
+
+    void chunk_cache::set_budget(usize budget, usize hot) noexcept
+    {
+        total_budget = budget;
+        hot_budget = hot < budget ? hot : budget;
+        enforce();
+    }
+
+    usize chunk_cache::measure(const entry& e) noexcept
+    {
+        return sizeof(entry) + (e.hot ? e.data.memory_usage() : e.payload.capacity());
+    }
+
+    void chunk_cache::resize(entry& e) noexcept
+    {
+        usize bytes = measure(e);
+        usize& tier = e.hot ? hot_bytes : cold_bytes;
+        tier = tier - e.bytes + bytes;
+        e.bytes = bytes;
+    }
+
+    bool chunk_cache::promote(index_type i) noexcept
+    {
+        // A payload that doesn't decompress must never replace the chunk on disk, which may
+        // still be intact: a clean one is dropped so the chunk can be read again, and an
+        // edited one stays cold as it is.
+        entry& e = entries[i];
+        if(!decompress_chunk(e.payload, e.data))
+        {
+            e.data = chunk();
+            if(!e.dirty)
+            {
+                cold_bytes -= e.bytes;
+                chunk_coord c = e.coord;
+                entries.erase(cold_list, i);
+                nodes.erase(c);
+            }
+            return false;
+        }
+
+        cold_bytes -= e.bytes;
+        e.bytes = 0;
+        e.payload = utils::array<u8>();
+        e.hot = true;
+        resize(e);
+        entries.splice(hot_list, hot_list.head, cold_list, i);
+        return true;
+    }
+
+    void chunk_cache::demote(index_type i) noexcept
+    {
+        entry& e = entries[i];
+        hot_bytes -= e.bytes;
+        e.bytes = 0;
+
+        compress_chunk(e.data, e.payload);
+        e.payload.shrink_to_fit();
+        e.data = chunk();
+        e.hot = false;
+        resize(e);
+        entries.splice(cold_list, cold_list.head, hot_list, i);
+    }
+
+    void chunk_cache::evict(index_type i) noexcept
+    {
+        entry& e = entries[i];
+        cold_bytes -= e.bytes;
+        chunk_coord c = e.coord;
+        if(e.dirty)
+            spill(c, ::std::move(e.payload), user);
+        entries.erase(cold_list, i);
+        nodes.erase(c);
+    }
+
+    void chunk_cache::enforce() noexcept
+    {
+        // The most recently used chunk is never moved, since its caller is about to use it.
+        while(hot_bytes > hot_budget && hot_list.size() > 1)
+            demote(hot_list.tail);
+
+        while(hot_bytes + cold_bytes > total_budget)
+        {
+            if(!cold_list.empty())
+                evict(cold_list.tail);
+            else if(hot_list.size() > 1)
+                demote(hot_list.tail);
+            else
+                break;
+        }
+    }
+};
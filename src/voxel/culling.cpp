@@ -0,0 +1,264 @@
+#include <voxel/culling.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define VOXEL_CULLING_SSE2 1
+#endif
+
+namespace voxel
+{
+    namespace
+    {
+        constexpr u32 lanes = 8;
+
+        /// The corners of the faces of a box, counterclockwise seen from outside the box,
+        /// with bit 0, 1 and 2 of a corner selecting the maximum along x, y and z.
+        constexpr u8 faces[6][4] = {
+            { 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+            { 0, 1, 5, 4 }, { 2, 6, 7, 3 },
+            { 0, 2, 3, 1 }, { 4, 5, 7, 6 }
+        };
+
+        inline f32 edge(f32 ax, f32 ay, f32 bx, f32 by, f32 px, f32 py) noexcept
+        {
+            return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+        }
+    };
+
+    frustum frustum::from_matrix(const f32* m) noexcept
+    {
+        frustum f;
+        for(u32 i = 0; i != 3; i++)
+            for(u32 j = 0; j != 4; j++)
+            {
+                f.planes[2 * i][j] = m[12 + j] + m[4 * i + j];
+                f.planes[2 * i + 1][j] = m[12 + j] - m[4 * i + j];
+            }
+        return f;
+    }
+
+    void frustum_cull(const frustum& f, const utils::const_span<chunk_bounds>& boxes, utils::array<u32>& visible) noexcept
+    {
+        usize n = boxes.size();
+        for(usize first = 0; first < n; first += lanes)
+        {
+            // The last block is padded with copies of its first box.
+            usize count = ::std::min<usize>(lanes, n - first);
+            f32 low[3][lanes], high[3][lanes];
+            for(u32 l = 0; l != lanes; l++)
+            {
+                const chunk_bounds& b = boxes[first + (l < count ? l : 0)];
+                low[0][l] = b.min_x;
+                low[1][l] = b.min_y;
+                low[2][l] = b.min_z;
+                high[0][l] = b.max_x;
+                high[1][l] = b.max_y;
+                high[2][l] = b.max_z;
+            }
+
+            u32 inside = 0;
+#ifdef VOXEL_CULLING_SSE2
+            // Two halves of 4 lanes. SSE2 is part of every x86-64 CPU, so no dispatch is needed.
+            __m128 masks[2] = { _mm_castsi128_ps(_mm_set1_epi32(-1)), _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+            for(const f32* p : f.planes)
+            {
+                const f32* x = p[0] > 0 ? high[0] : low[0];
+                const f32* y = p[1] > 0 ? high[1] : low[1];
+                const f32* z = p[2] > 0 ? high[2] : low[2];
+                __m128 a = _mm_set1_ps(p[0]), b = _mm_set1_ps(p[1]), c = _mm_set1_ps(p[2]), d = _mm_set1_ps(p[3]);
+                for(u32 half = 0; half != 2; half++)
+                {
+                    u32 o = 4 * half;
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(x + o)), _mm_mul_ps(b, _mm_loadu_ps(y + o))),
+                                                            _mm_mul_ps(c, _mm_loadu_ps(z + o))), d);
+                    masks[half] = _mm_and_ps(masks[half], _mm_cmpge_ps(distance, _mm_setzero_ps()));
+                }
+            }
+            inside = static_cast<u32>(_mm_movemask_ps(masks[0]) | (_mm_movemask_ps(masks[1]) << 4));
+#else
+            inside = (u32(1) << lanes) - 1;
+            for(const f32* p : f.planes)
+            {
+                const f32* x = p[0] > 0 ? high[0] : low[0];
+                const f32* y = p[1] > 0 ? high[1] : low[1];
+                const f32* z = p[2] > 0 ? high[2] : low[2];
+                for(u32 l = 0; l != lanes; l++)
+                    if(!(p[0] * x[l] + p[1] * y[l] + p[2] * z[l] + p[3] >= 0))
+                        inside &= ~(u32(1) << l);
+            }
+#endif
+
+            for(u32 l = 0; l != count; l++)
+                if((inside >> l) & 1)
+                    visible.push(static_cast<u32>(first + l));
+        }
+    }
+
+    culler::culler(u32 width, u32 height) noexcept :
+        w(width), h(height), depths(usize(width) * height), candidates(), order()
+    {
+        ::std::fill(depths.data(), depths.data() + depths.size(), 1.0f);
+    }
+
+    void culler::cull(const f32* view_projection, const utils::const_span<chunk_bounds>& boxes, utils::array<u32>& visible) noexcept
+    {
+        const f32* m = view_projection;
+        candidates.clear();
+        frustum_cull(frustum::from_matrix(m), boxes, candidates);
+
+        // Front to back, by the depth of the center of every box. The bits of a positive
+        // float sort like the float itself.
+        order.clear();
+        for(u32 i : candidates)
+        {
+            const chunk_bounds& b = boxes[i];
+            f32 depth = m[12] * (b.min_x + b.max_x) * 0.5f + m[13] * (b.min_y + b.max_y) * 0.5f +
+                        m[14] * (b.min_z + b.max_z) * 0.5f + m[15];
+            order.push((u64(::std::bit_cast<u32>(::std::max(depth, 0.0f))) << 32) | i);
+        }
+        ::std::sort(order.data(), order.data() + order.size());
+
+        ::std::fill(depths.data(), depths.data() + depths.size(), 1.0f);
+        vertex corners[8];
+        for(u64 key : order)
+        {
+            u32 i = static_cast<u32>(key);
+            if(!project(m, boxes[i], corners))
+            {
+                visible.push(i);
+                continue;
+            }
+
+            if(hidden(corners))
+                continue;
+
+            visible.push(i);
+            if(boxes[i].occluder)
+                draw(corners);
+        }
+    }
+
+    bool culler::project(const f32* m, const chunk_bounds& b, vertex* corners) const noexcept
+    {
+        for(u32 i = 0; i != 8; i++)
+        {
+            f32 p[3] = { i & 1 ? b.max_x : b.min_x, i & 2 ? b.max_y : b.min_y, i & 4 ? b.max_z : b.min_z };
+            f32 clip[4];
+            for(u32 r = 0; r != 4; r++)
+                clip[r] = m[4 * r] * p[0] + m[4 * r + 1] * p[1] + m[4 * r + 2] * p[2] + m[4 * r + 3];
+
+            // Behind the near plane.
+            if(clip[3] <= 0 || clip[2] < -clip[3])
+                return false;
+
+            f32 inv = 1 / clip[3];
+            corners[i] = vertex { (clip[0] * inv * 0.5f + 0.5f) * static_cast<f32>(w),
+                                  (clip[1] * inv * 0.5f + 0.5f) * static_cast<f32>(h), clip[2] * inv };
+        }
+        return true;
+    }
+
+    culler::rectangle culler::cover(const vertex* corners, f32& min_z) const noexcept
+    {
+        f32 min_x = corners[0].x, max_x = corners[0].x;
+        f32 min_y = corners[0].y, max_y = corners[0].y;
+        min_z = corners[0].z;
+        for(u32 i = 1; i != 8; i++)
+        {
+            min_x = ::std::min(min_x, corners[i].x);
+            max_x = ::std::max(max_x, corners[i].x);
+            min_y = ::std::min(min_y, corners[i].y);
+            max_y = ::std::max(max_y, corners[i].y);
+            min_z = ::std::min(min_z, corners[i].z);
+        }
+
+        // Clamped before the conversions, since boxes near the camera can project very far
+        // off the screen.
+        f32 fw = static_cast<f32>(w), fh = static_cast<f32>(h);
+        return rectangle { static_cast<i32>(::std::floor(::std::clamp(min_x, 0.0f, fw))),
+                           static_cast<i32>(::std::floor(::std::clamp(min_y, 0.0f, fh))),
+                           static_cast<i32>(::std::floor(::std::clamp(max_x, -1.0f, fw - 1))),
+                           static_cast<i32>(::std::floor(::std::clamp(max_y, -1.0f, fh - 1))) };
+    }
+
+    bool culler::hidden(const vertex* corners) const noexcept
+    {
+        f32 min_z;
+        rectangle r = cover(corners, min_z);
+        for(i32 y = r.y0; y <= r.y1; y++)
+        {
+            const f32* row = depths.data() + usize(y) * w;
+            for(i32 x = r.x0; x <= r.x1; x++)
+                if(row[x] >= min_z)
+                    return false;
+        }
+        return true;
+    }
+
+    void culler::draw(const vertex* corners) noexcept
+    {
+        for(const u8* f : faces)
+        {
+            draw_triangle(corners[f[0]], corners[f[1]], corners[f[2]]);
+            draw_triangle(corners[f[0]], corners[f[2]], corners[f[3]]);
+        }
+    }
+
+    void culler::draw_triangle(const vertex& a, const vertex& b, const vertex& c) noexcept
+    {
+        // Faces turned away from the camera are hidden by the ones turned towards it, and
+        // they're the ones that turn clockwise on the screen.
+        f32 area = edge(a.x, a.y, b.x, b.y, c.x, c.y);
+        if(area <= 0)
+            return;
+
+        // The pixels whose centers are inside the bounding rectangle of the triangle.
+        f32 fw = static_cast<f32>(w), fh = static_cast<f32>(h);
+        i32 x0 = static_cast<i32>(::std::ceil(::std::clamp(::std::min({ a.x, b.x, c.x }) - 0.5f, 0.0f, fw)));
+        i32 x1 = static_cast<i32>(::std::floor(::std::clamp(::std::max({ a.x, b.x, c.x }) - 0.5f, -1.0f, fw - 1)));
+        i32 y0 = static_cast<i32>(::std::ceil(::std::clamp(::std::min({ a.y, b.y, c.y }) - 0.5f, 0.0f, fh)));
+        i32 y1 = static_cast<i32>(::std::floor(::std::clamp(::std::max({ a.y, b.y, c.y }) - 0.5f, -1.0f, fh - 1)));
+        if(x0 > x1 || y0 > y1)
+            return;
+
+        // The edge functions are affine in the pixel coordinates, so the pixels of a row
+        // inside the triangle are found from their values at the start of the row, and
+        // scaled by the inverse of the area they give the depth. The span found is widened
+        // by a pixel on both sides against rounding, and every pixel still checked.
+        f32 inv = 1 / area;
+        f32 px = static_cast<f32>(x0) + 0.5f;
+        const f32 steps[3] = { b.y - c.y, c.y - a.y, a.y - b.y };
+        for(i32 y = y0; y <= y1; y++)
+        {
+            f32 py = static_cast<f32>(y) + 0.5f;
+            f32 e[3] = { edge(b.x, b.y, c.x, c.y, px, py), edge(c.x, c.y, a.x, a.y, px, py), edge(a.x, a.y, b.x, b.y, px, py) };
+            f32 first = 0, last = static_cast<f32>(x1 - x0);
+            for(u32 i = 0; i != 3; i++)
+                if(steps[i] > 0)
+                    first = ::std::max(first, -e[i] / steps[i] - 1);
+                else if(steps[i] < 0)
+                    last = ::std::min(last, e[i] / -steps[i] + 1);
+                else if(e[i] < 0)
+                    last = -1;
+            if(first > last)
+                continue;
+
+            i32 begin = x0 + static_cast<i32>(first), end = x0 + static_cast<i32>(last);
+            f32 k = static_cast<f32>(begin - x0);
+            f32 e0 = e[0] + steps[0] * k, e1 = e[1] + steps[1] * k, e2 = e[2] + steps[2] * k;
+            f32* row = depths.data() + usize(y) * w;
+            for(i32 x = begin; x <= end; x++, e0 += steps[0], e1 += steps[1], e2 += steps[2])
+            {
+                if(e0 < 0 || e1 < 0 || e2 < 0)
+                    continue;
+
+                f32 z = (e0 * a.z + e1 * b.z + e2 * c.z) * inv;
+                row[x] = ::std::min(row[x], z);
+            }
+        }
+    }
+};
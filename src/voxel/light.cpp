@@ -0,0 +1,364 @@
+#include <voxel/light.hpp>
+
+#include <cstring>
+
+namespace voxel
+{
+    namespace
+    {
+        /// The offsets of the face neighbors, in the order +x, -x, +y, -y, +z, -z, so that
+        /// the opposite of direction d is d ^ 1.
+        constexpr i32 offsets[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+        constexpr u32 up = 2;
+        constexpr u32 down = 3;
+        constexpr u32 none = chunk_map<chunk>::none;
+
+        /// The index of the voxel at (u, v) on the layer of a chunk facing a direction.
+        inline u32 border_index(u32 direction, u32 u, u32 v) noexcept
+        {
+            u32 axis = direction >> 1;
+            u32 s = direction & 1 ? 0 : chunk_size - 1;
+            u32 coords[3];
+            coords[axis] = s;
+            coords[(axis + 1) % 3] = u;
+            coords[(axis + 2) % 3] = v;
+            return static_cast<u32>(voxel_index(coords[0], coords[1], coords[2]));
+        }
+    };
+
+    light_chunk::light_chunk() noexcept :
+        nibbles(2 * channel_size)
+    {
+        ::std::memset(nibbles.data(), 0, nibbles.size());
+    }
+
+    light_engine::light_engine(chunk_map<chunk>& chunks) noexcept :
+        chunks(chunks), nodes(), table(usize(1) << (8 * sizeof(block))), channels()
+    {
+        ::std::memset(table.data(), 0, table.size());
+        table[air] = transparent_flag;
+    }
+
+    void light_engine::set_emission(block b, u8 level) noexcept
+    {
+        table[b] = static_cast<u8>((table[b] & ~0xf) | level);
+    }
+
+    void light_engine::set_transparent(block b, bool transparent) noexcept
+    {
+        table[b] = static_cast<u8>(transparent ? table[b] | transparent_flag : table[b] & ~transparent_flag);
+    }
+
+    void light_engine::chunk_added(const chunk_coord& c) noexcept
+    {
+        u32 ci = chunks.find(c);
+        if(ci == none || nodes.contains(c))
+            return;
+
+        // A slot past max_chunks would be cut off when packed into a queue entry.
+        u32 slot = nodes.insert(c);
+        if(slot >= max_chunks)
+        {
+            nodes.erase(c);
+            return;
+        }
+
+        nodes[slot].chunk = ci;
+        for(u32 d = 0; d != 6; d++)
+        {
+            u32 neighbor = nodes.find(chunk_coord { c.x + offsets[d][0], c.y + offsets[d][1], c.z + offsets[d][2] });
+            nodes[slot].neighbors[d] = neighbor;
+            if(neighbor != none)
+                nodes[neighbor].neighbors[d ^ 1] = slot;
+        }
+
+        node& n = nodes[slot];
+        queues& block_queues = channels[static_cast<usize>(light_channel::block)];
+        queues& sky_queues = channels[static_cast<usize>(light_channel::sky)];
+
+        // Emitting blocks light themselves; skip the scan when none is in the palette.
+        const chunk& blocks = chunks[ci];
+        bool emits = false;
+        for(block b : blocks.palette())
+            emits = emits || emission(b) != 0;
+        if(emits)
+            for(u32 i = 0; i != chunk_volume; i++)
+                if(u8 e = emission(blocks.get(i)))
+                {
+                    n.light.set(light_channel::block, i, e);
+                    block_queues.add.push_back(pack(slot, i));
+                }
+
+        if(n.neighbors[up] == none)
+        {
+            for(u32 u = 0; u != chunk_size; u++)
+                for(u32 v = 0; v != chunk_size; v++)
+                {
+                    u32 i = border_index(up, u, v);
+                    if(transparent(blocks.get(i)))
+                    {
+                        n.light.set(light_channel::sky, i, max_light);
+                        sky_queues.add.push_back(pack(slot, i));
+                    }
+                }
+        }
+
+        // The chunk below was open to the sky; its light now comes through this chunk.
+        u32 below = n.neighbors[down];
+        if(below != none)
+            for(u32 u = 0; u != chunk_size; u++)
+                for(u32 v = 0; v != chunk_size; v++)
+                {
+                    u32 i = border_index(up, u, v);
+                    if(nodes[below].light.get(light_channel::sky, i) == max_light)
+                    {
+                        nodes[below].light.set(light_channel::sky, i, 0);
+                        sky_queues.remove.push_back(pack(below, i));
+                        sky_queues.removed_levels.push_back(max_light);
+                    }
+                }
+
+        for(u32 d = 0; d != 6; d++)
+            if(n.neighbors[d] != none)
+                push_border(n.neighbors[d], d ^ 1);
+    }
+
+    void light_engine::chunk_removed(const chunk_coord& c) noexcept
+    {
+        u32 slot = nodes.find(c);
+        if(slot == none)
+            return;
+
+        // Queue entries hold slots, which the map reuses, so they must not outlive the chunk.
+        update();
+
+        for(u32 d = 0; d != 6; d++)
+            if(u32 neighbor = nodes[slot].neighbors[d]; neighbor != none)
+                nodes[neighbor].neighbors[d ^ 1] = none;
+
+        // The chunk below is open to the sky again.
+        u32 below = nodes[slot].neighbors[down];
+        if(below != none)
+            for(u32 u = 0; u != chunk_size; u++)
+                for(u32 v = 0; v != chunk_size; v++)
+                {
+                    u32 i = border_index(up, u, v);
+                    if(transparent(block_at(below, i)))
+                    {
+                        nodes[below].light.set(light_channel::sky, i, max_light);
+                        channels[static_cast<usize>(light_channel::sky)].add.push_back(pack(below, i));
+                    }
+                }
+
+        nodes.erase(c);
+    }
+
+    void light_engine::block_changed(const chunk_coord& c, local_coord v) noexcept
+    {
+        u32 slot = nodes.find(c);
+        if(slot == none)
+            return;
+
+        u32 index = static_cast<u32>(v.index());
+        block b = block_at(slot, index);
+        node& n = nodes[slot];
+
+        for(u32 ch = 0; ch != 2; ch++)
+        {
+            light_channel channel = static_cast<light_channel>(ch);
+            queues& q = channels[ch];
+
+            u8 level = n.light.get(channel, index);
+            if(level != 0)
+            {
+                n.light.set(channel, index, 0);
+                q.remove.push_back(pack(slot, index));
+                q.removed_levels.push_back(level);
+            }
+
+            // A voxel that lets light through is lit again by its neighbors.
+            if(transparent(b))
+                for(u32 d = 0; d != 6; d++)
+                {
+                    u32 next_slot, next_index;
+                    if(step(slot, index, d, next_slot, next_index) && nodes[next_slot].light.get(channel, next_index) != 0)
+                        q.add.push_back(pack(next_slot, next_index));
+                }
+        }
+
+        if(u8 e = emission(b))
+        {
+            n.light.set(light_channel::block, index, e);
+            channels[static_cast<usize>(light_channel::block)].add.push_back(pack(slot, index));
+        }
+
+        if(transparent(b) && v.y == chunk_size - 1 && n.neighbors[up] == none)
+        {
+            n.light.set(light_channel::sky, index, max_light);
+            channels[static_cast<usize>(light_channel::sky)].add.push_back(pack(slot, index));
+        }
+    }
+
+    usize light_engine::update() noexcept
+    {
+        usize visited = 0;
+        for(light_channel channel : { light_channel::block, light_channel::sky })
+        {
+            visited += unspread(channel);
+            visited += spread(channel);
+        }
+        return visited;
+    }
+
+    u8 light_engine::get(const chunk_coord& c, local_coord v, light_channel channel) const noexcept
+    {
+        const light_chunk* light = find(c);
+        return light == nullptr ? 0 : light->get(channel, v.index());
+    }
+
+    const light_chunk* light_engine::find(const chunk_coord& c) const noexcept
+    {
+        u32 slot = nodes.find(c);
+        return slot == none ? nullptr : &nodes[slot].light;
+    }
+
+    bool light_engine::step(u32 slot, u32 index, u32 direction, u32& next_slot, u32& next_index) const noexcept
+    {
+        u32 shift = (direction >> 1) * chunk_shift;
+        u32 coord = (index >> shift) & (chunk_size - 1);
+
+        if(direction & 1)
+        {
+            if(coord != 0)
+            {
+                next_slot = slot;
+                next_index = index - (u32(1) << shift);
+                return true;
+            }
+
+            next_slot = nodes[slot].neighbors[direction];
+            next_index = index | (u32(chunk_size - 1) << shift);
+        }
+        else
+        {
+            if(coord != chunk_size - 1)
+            {
+                next_slot = slot;
+                next_index = index + (u32(1) << shift);
+                return true;
+            }
+
+            next_slot = nodes[slot].neighbors[direction];
+            next_index = index & ~(u32(chunk_size - 1) << shift);
+        }
+
+        return next_slot != none;
+    }
+
+    block light_engine::block_at(u32 slot, u32 index) const noexcept
+    {
+        return chunks[nodes[slot].chunk].get(index);
+    }
+
+    void light_engine::push_border(u32 slot, u32 direction) noexcept
+    {
+        const light_chunk& light = nodes[slot].light;
+        for(u32 u = 0; u != chunk_size; u++)
+            for(u32 v = 0; v != chunk_size; v++)
+            {
+                u32 i = border_index(direction, u, v);
+                for(u32 ch = 0; ch != 2; ch++)
+                    if(light.get(static_cast<light_channel>(ch), i) != 0)
+                        channels[ch].add.push_back(pack(slot, i));
+            }
+    }
+
+    usize light_engine::spread(light_channel channel) noexcept
+    {
+        queues& q = channels[static_cast<usize>(channel)];
+        bool sky = channel == light_channel::sky;
+
+        usize visited = 0;
+        while(!q.add.empty())
+        {
+            u32 e = q.add.front();
+            q.add.pop_front();
+            visited++;
+
+            u32 slot = e >> index_bits;
+            u32 index = e & ((u32(1) << index_bits) - 1);
+            u8 level = nodes[slot].light.get(channel, index);
+            if(level <= 1)
+                continue;
+
+            for(u32 d = 0; d != 6; d++)
+            {
+                u32 next_slot, next_index;
+                if(!step(slot, index, d, next_slot, next_index))
+                    continue;
+
+                u8 next = sky && d == down && level == max_light ? max_light : level - 1;
+                light_chunk& light = nodes[next_slot].light;
+                if(light.get(channel, next_index) >= next || !transparent(block_at(next_slot, next_index)))
+                    continue;
+
+                light.set(channel, next_index, next);
+                q.add.push_back(pack(next_slot, next_index));
+            }
+        }
+
+        return visited;
+    }
+
+    usize light_engine::unspread(light_channel channel) noexcept
+    {
+        queues& q = channels[static_cast<usize>(channel)];
+        bool sky = channel == light_channel::sky;
+
+        usize visited = 0;
+        while(!q.remove.empty())
+        {
+            u32 e = q.remove.front();
+            u8 level = q.removed_levels.front();
+            q.remove.pop_front();
+            q.removed_levels.pop_front();
+            visited++;
+
+            u32 slot = e >> index_bits;
+            u32 index = e & ((u32(1) << index_bits) - 1);
+
+            for(u32 d = 0; d != 6; d++)
+            {
+                u32 next_slot, next_index;
+                if(!step(slot, index, d, next_slot, next_index))
+                    continue;
+
+                light_chunk& light = nodes[next_slot].light;
+                u8 current = light.get(channel, next_index);
+                if(current == 0)
+                    continue;
+
+                // Dimmer neighbors, and sky light at full level below, were lit through the
+                // removed voxel; brighter ones have another source and spread back in.
+                if(current < level || (sky && d == down && level == max_light && current == max_light))
+                {
+                    light.set(channel, next_index, 0);
+                    q.remove.push_back(pack(next_slot, next_index));
+                    q.removed_levels.push_back(current);
+
+                    if(!sky)
+                        if(u8 emitted = emission(block_at(next_slot, next_index)))
+                        {
+                            light.set(channel, next_index, emitted);
+                            q.add.push_back(pack(next_slot, next_index));
+                        }
+                }
+                else
+                    q.add.push_back(pack(next_slot, next_index));
+            }
+        }
+
+        return visited;
+    }
+};
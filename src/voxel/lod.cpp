@@ -0,0 +1,135 @@
+#include <voxel/lod.hpp>
+
+#include <cstring>
+#include <utility>
+
+namespace voxel
+{
+    chunk_lod::chunk_lod(lod_filter filter) noexcept :
+        pending(), next(), mode(filter)
+    {
+        for(u32 l = 1; l <= level_count; l++)
+        {
+            usize s = size(l);
+            levels[l - 1].assign(s * s * s, air);
+        }
+        ::std::memset(marks, 0, sizeof(marks));
+    }
+
+    void chunk_lod::build(const chunk& c) noexcept
+    {
+        pending.clear();
+        ::std::memset(marks, 0, sizeof(marks));
+
+        // Every filter picks the block of 8 equal samples.
+        if(c.uniform())
+        {
+            block b = c.get(0);
+            for(utils::array<block>& level : levels)
+                for(block& v : level)
+                    v = b;
+            return;
+        }
+
+        thread_local utils::buffer<block> voxels(chunk_volume);
+        c.decode(utils::span<block>(voxels.data(), chunk_volume));
+
+        const block* source = voxels.data();
+        for(u32 l = 1; l <= level_count; l++)
+        {
+            u32 s = size(l), shift = chunk_shift - l + 1;
+            block* out = levels[l - 1].data();
+            for(u32 z = 0; z != s; z++)
+                for(u32 y = 0; y != s; y++)
+                    for(u32 x = 0; x != s; x++)
+                    {
+                        block samples[8];
+                        for(u32 k = 0; k != 8; k++)
+                            samples[k] = source[(2 * x + (k & 1)) | ((2 * y + ((k >> 1) & 1)) << shift) | ((2 * z + (k >> 2)) << (2 * shift))];
+                        out[index(l, x, y, z)] = pick(samples);
+                    }
+            source = out;
+        }
+    }
+
+    void chunk_lod::changed(local_coord v) noexcept
+    {
+        u32 i = index(1, v.x >> 1, v.y >> 1, v.z >> 1);
+        if(mark(i))
+            pending.push(static_cast<u16>(i));
+    }
+
+    usize chunk_lod::update(const chunk& c) noexcept
+    {
+        usize count = 0;
+        for(u32 l = 1; l <= level_count && !pending.empty(); l++)
+        {
+            // The marks are cleared first, so that the same bits can mark the next level.
+            for(u16 i : pending)
+                marks[i >> 6] &= ~(u64(1) << (i & 63));
+
+            u32 shift = chunk_shift - l;
+            next.clear();
+            for(u16 i : pending)
+            {
+                u32 x = i & ((1 << shift) - 1), y = (i >> shift) & ((1 << shift) - 1), z = i >> (2 * shift);
+                block samples[8];
+                if(l == 1)
+                    for(u32 k = 0; k != 8; k++)
+                        samples[k] = c.get(voxel_index(2 * x + (k & 1), 2 * y + ((k >> 1) & 1), 2 * z + (k >> 2)));
+                else
+                    for(u32 k = 0; k != 8; k++)
+                        samples[k] = get(l - 1, 2 * x + (k & 1), 2 * y + ((k >> 1) & 1), 2 * z + (k >> 2));
+
+                block b = pick(samples);
+                count++;
+                if(b == levels[l - 1][i])
+                    continue;
+
+                levels[l - 1][i] = b;
+                if(l != level_count)
+                {
+                    u32 parent = index(l + 1, x >> 1, y >> 1, z >> 1);
+                    if(mark(parent))
+                        next.push(static_cast<u16>(parent));
+                }
+            }
+            ::std::swap(pending, next);
+        }
+        pending.clear();
+        return count;
+    }
+
+    block chunk_lod::pick(const block* samples) const noexcept
+    {
+        // With 8 samples, counting the matches of every one is cheaper than sorting them.
+        block best = air;
+        u32 most = 0;
+        for(u32 i = 0; i != 8; i++)
+        {
+            block b = samples[i];
+            if(b == air && mode == lod_filter::surface)
+                continue;
+
+            u32 n = 0;
+            for(u32 j = 0; j != 8; j++)
+                n += samples[j] == b;
+            if(n > most || (n == most && best == air))
+            {
+                best = b;
+                most = n;
+            }
+        }
+        return best;
+    }
+
+    bool chunk_lod::mark(u32 i) noexcept
+    {
+        u64 bit = u64(1) << (i & 63);
+        if(marks[i >> 6] & bit)
+            return false;
+
+        marks[i >> 6] |= bit;
+        return true;
+    }
+};
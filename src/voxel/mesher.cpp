@@ -0,0 +1,240 @@
+#include <voxel/mesher.hpp>
+#include <voxel/occupancy.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace voxel
+{
+    namespace
+    {
+        constexpr usize plane_area = chunk_size * chunk_size;
+
+        /// Transposes two 32x32 bit matrices at once, one in the low and one in the high
+        /// half of every row, where bit j of row i is the element (i, j).
+        inline void transpose(u64* rows) noexcept
+        {
+            u64 m = 0x0000ffff0000ffff;
+            for(u32 j = 16; j != 0; j >>= 1, m ^= m << j)
+                for(u32 k = 0; k < 32; k = (k + j + 1) & ~j)
+                {
+                    u64 t = ((rows[k] >> j) ^ rows[k + j]) & m;
+                    rows[k] ^= t << j;
+                    rows[k + j] ^= t;
+                }
+        }
+
+        /// The distances between voxel indices along an axis (s) and the two others (u, v).
+        struct strides
+        {
+            usize s;
+            usize u;
+            usize v;
+        };
+
+        constexpr strides axis_strides[3] = {
+            { voxel_index(1, 0, 0), voxel_index(0, 1, 0), voxel_index(0, 0, 1) },
+            { voxel_index(0, 1, 0), voxel_index(0, 0, 1), voxel_index(1, 0, 0) },
+            { voxel_index(0, 0, 1), voxel_index(1, 0, 0), voxel_index(0, 1, 0) }
+        };
+
+        /// The index of the voxel at coordinate s along an axis and (u, v) on the other two.
+        inline usize slice_index(u32 axis, u32 s, u32 u, u32 v) noexcept
+        {
+            const strides& st = axis_strides[axis];
+            return s * st.s + u * st.u + v * st.v;
+        }
+
+        /// Builds the masks of the opaque voxels of a layer of a neighbor, one row per u.
+        inline void load_border(u32* rows, const chunk* neighbor, u32 axis, u32 s) noexcept
+        {
+            if(neighbor == nullptr || neighbor->uniform())
+            {
+                u32 fill = neighbor != nullptr && neighbor->get(0) != air ? ~u32(0) : 0;
+                for(u32 u = 0; u != chunk_size; u++)
+                    rows[u] = fill;
+                return;
+            }
+
+            for(u32 u = 0; u != chunk_size; u++)
+                rows[u] = 0;
+
+            for(u32 u = 0; u != chunk_size; u++)
+                for(u32 v = 0; v != chunk_size; v++)
+                    if(neighbor->get(slice_index(axis, s, u, v)) != air)
+                        rows[u] |= u32(1) << v;
+        }
+    };
+
+    mesher::mesher() noexcept :
+        blocks(chunk_volume), columns(3 * plane_area), solid(air)
+    {
+    }
+
+    void mesher::load(const utils::const_span<const chunk*>& neighborhood) noexcept
+    {
+        const chunk& c = *neighborhood[13];
+        c.decode(utils::span<block>(blocks.data(), chunk_volume));
+
+        // Faces only need their blocks compared when the chunk may hold several opaque ones.
+        solid = air;
+        for(block b : c.palette())
+        {
+            if(b == air || b == solid)
+                continue;
+            if(solid != air || c.bits_per_voxel() == chunk::direct_bits)
+            {
+                solid = air;
+                break;
+            }
+            solid = b;
+        }
+
+        // Rows along x, indexed by z then y. Every other axis is a transpose away.
+        u32* x_columns = columns.data();
+        u32* y_columns = x_columns + plane_area;
+        u32* z_columns = y_columns + plane_area;
+
+        u32 rows[plane_area];
+        for(u32 i = 0; i != plane_area; i++)
+            rows[i] = row_occupancy(blocks.data() + i * chunk_size);
+
+        for(u32 y = 0; y != chunk_size; y++)
+            for(u32 z = 0; z != chunk_size; z++)
+                x_columns[y * chunk_size + z] = rows[z * chunk_size + y];
+
+        // The rows of a z layer, with bits along x, transpose into the y columns of that
+        // layer; the rows of a y layer transpose into its z columns.
+        u64 t[chunk_size];
+        for(u32 z = 0; z != chunk_size; z += 2)
+        {
+            for(u32 y = 0; y != chunk_size; y++)
+                t[y] = u64(rows[z * chunk_size + y]) | (u64(rows[(z + 1) * chunk_size + y]) << 32);
+            transpose(t);
+            for(u32 x = 0; x != chunk_size; x++)
+            {
+                y_columns[z * chunk_size + x] = static_cast<u32>(t[x]);
+                y_columns[(z + 1) * chunk_size + x] = static_cast<u32>(t[x] >> 32);
+            }
+        }
+
+        for(u32 y = 0; y != chunk_size; y += 2)
+        {
+            for(u32 z = 0; z != chunk_size; z++)
+                t[z] = u64(rows[z * chunk_size + y]) | (u64(rows[z * chunk_size + y + 1]) << 32);
+            transpose(t);
+            for(u32 x = 0; x != chunk_size; x++)
+            {
+                z_columns[x * chunk_size + y] = static_cast<u32>(t[x]);
+                z_columns[x * chunk_size + y + 1] = static_cast<u32>(t[x] >> 32);
+            }
+        }
+
+        load_border(borders[u32(face::pos_x)], neighborhood[14], 0, 0);
+        load_border(borders[u32(face::neg_x)], neighborhood[12], 0, chunk_size - 1);
+        load_border(borders[u32(face::pos_y)], neighborhood[16], 1, 0);
+        load_border(borders[u32(face::neg_y)], neighborhood[10], 1, chunk_size - 1);
+        load_border(borders[u32(face::pos_z)], neighborhood[22], 2, 0);
+        load_border(borders[u32(face::neg_z)], neighborhood[4], 2, chunk_size - 1);
+    }
+
+    void mesher::mesh(utils::array<quad>& out, const utils::span<u32>& ends) noexcept
+    {
+        u32 rows[chunk_size];
+        for(u32 f = 0; f != face_count; f++)
+            for(u32 s = 0; s != chunk_size; s++)
+            {
+                plane(static_cast<face>(f), s, rows);
+                merge(static_cast<face>(f), s, rows, out);
+                if(!ends.empty())
+                    ends[f * chunk_size + s] = static_cast<u32>(out.size());
+            }
+    }
+
+    void mesher::mesh_slice(face f, u32 slice, utils::array<quad>& out) noexcept
+    {
+        u32 rows[chunk_size];
+        plane(f, slice, rows);
+        merge(f, slice, rows, out);
+    }
+
+    void mesher::merge(face f, u32 slice, u32* rows, utils::array<quad>& out) const noexcept
+    {
+        usize bound = 0;
+        for(u32 u = 0; u != chunk_size; u++)
+            bound += static_cast<usize>(::std::popcount(rows[u]));
+        if(bound == 0)
+            return;
+
+        const strides& st = axis_strides[static_cast<u32>(f) >> 1];
+        const block* base = blocks.data() + slice * st.s;
+
+        quad* quads = out.push_uninitialized(bound).data();
+        usize n = 0;
+
+        for(u32 u = 0; u != chunk_size; u++)
+        {
+            while(rows[u] != 0)
+            {
+                u32 v = static_cast<u32>(::std::countr_zero(rows[u]));
+                const block* first = base + u * st.u + v * st.v;
+
+                block type = solid;
+                u32 height;
+                if(type != air)
+                    height = static_cast<u32>(::std::countr_one(u64(rows[u]) >> v));
+                else
+                {
+                    type = *first;
+                    height = 1;
+                    while(v + height != chunk_size && ((rows[u] >> (v + height)) & 1) && first[height * st.v] == type)
+                        height++;
+                }
+
+                u32 run = static_cast<u32>(((u64(1) << height) - 1) << v);
+
+                u32 width = 1;
+                for(; u + width != chunk_size && (rows[u + width] & run) == run; width++)
+                {
+                    if(solid == air)
+                    {
+                        const block* next = first + width * st.u;
+                        u32 k = 0;
+                        while(k != height && next[k * st.v] == type)
+                            k++;
+                        if(k != height)
+                            break;
+                    }
+
+                    rows[u + width] &= ~run;
+                }
+                rows[u] &= ~run;
+
+                usize i = static_cast<usize>(first - blocks.data());
+                quads[n++] = quad::make(u32(i) & (chunk_size - 1), u32(i >> chunk_shift) & (chunk_size - 1), u32(i >> (2 * chunk_shift)),
+                                        width, height, f, type);
+            }
+        }
+
+        out.pop_many(bound - n);
+    }
+
+    void mesher::plane(face f, u32 slice, u32* rows) const noexcept
+    {
+        // The columns along v of every axis are indexed by the coordinate along the next
+        // axis, then the one after it: for v = (axis + 2) % 3 that's the slice, then u.
+        u32 i = static_cast<u32>(f);
+        u32 axis = i >> 1;
+        const u32* v_columns = columns.data() + ((axis + 2) % 3) * plane_area;
+        const u32* current = v_columns + slice * chunk_size;
+
+        const u32* next;
+        if(i & 1)
+            next = slice == 0 ? borders[i] : current - chunk_size;
+        else
+            next = slice == chunk_size - 1 ? borders[i] : current + chunk_size;
+
+        for(u32 u = 0; u != chunk_size; u++)
+            rows[u] = current[u] & ~next[u];
+    }
+};
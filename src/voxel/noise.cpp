@@ -0,0 +1,126 @@
+#include "noise_kernels.hpp"
+
+namespace voxel
+{
+    namespace __detail
+    {
+        namespace __noise
+        {
+            void run_scalar(const layer& l) noexcept
+            {
+                run<scalar_ops>(l);
+            }
+        };
+    };
+
+    namespace
+    {
+        using namespace __detail::__noise;
+
+        simd_level supported() noexcept
+        {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            if(avx2_compiled && __builtin_cpu_supports("avx2"))
+                return simd_level::avx2;
+            if(sse_compiled && __builtin_cpu_supports("sse4.1"))
+                return simd_level::sse;
+#endif
+            return simd_level::scalar;
+        }
+
+        void run(const layer& l, simd_level level) noexcept
+        {
+            simd_level best = noise_simd_level();
+            if(level > best)
+                level = best;
+
+            switch(level)
+            {
+            case simd_level::avx2:
+                run_avx2(l);
+                break;
+            case simd_level::sse:
+                run_sse(l);
+                break;
+            default:
+                run_scalar(l);
+                break;
+            }
+        }
+
+        void octaves(noise type, u8 dimensions, combine op, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid,
+                     const utils::span<f32>& out, simd_level level) noexcept
+        {
+            f32* values = out.data();
+            for(usize i = 0; i != out.size(); i++)
+                values[i] = 0.0f;
+
+            // Every octave adds its noise to the output in place, so no scratch memory is needed.
+            f32 amplitude = 1.0f;
+            f32 total = 0.0f;
+            for(u32 i = 0; i != f.octaves; i++)
+            {
+                run(layer { type, dimensions, op, seed + i, frequency, amplitude, &grid, values }, level);
+                total += amplitude;
+                amplitude *= f.gain;
+                frequency *= f.lacunarity;
+            }
+
+            if(total == 0.0f)
+                return;
+
+            if(op == combine::ridged)
+            {
+                f32 scale = 2.0f / total;
+                for(usize i = 0; i != out.size(); i++)
+                    values[i] = values[i] * scale - 1.0f;
+            }
+            else
+            {
+                f32 scale = 1.0f / total;
+                for(usize i = 0; i != out.size(); i++)
+                    values[i] *= scale;
+            }
+        }
+    };
+
+    simd_level noise_simd_level() noexcept
+    {
+        static const simd_level level = supported();
+        return level;
+    }
+
+    void noise_2d(noise type, u32 seed, f32 frequency, const noise_grid& grid, const utils::span<f32>& out, simd_level level) noexcept
+    {
+        run(layer { type, 2, combine::assign, seed, frequency, 1.0f, &grid, out.data() }, level);
+    }
+
+    void noise_3d(noise type, u32 seed, f32 frequency, const noise_grid& grid, const utils::span<f32>& out, simd_level level) noexcept
+    {
+        run(layer { type, 3, combine::assign, seed, frequency, 1.0f, &grid, out.data() }, level);
+    }
+
+    void fbm_2d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                simd_level level) noexcept
+    {
+        octaves(type, 2, combine::add, seed, frequency, f, grid, out, level);
+    }
+
+    void fbm_3d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                simd_level level) noexcept
+    {
+        octaves(type, 3, combine::add, seed, frequency, f, grid, out, level);
+    }
+
+    void ridged_2d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                   simd_level level) noexcept
+    {
+        octaves(type, 2, combine::ridged, seed, frequency, f, grid, out, level);
+    }
+
+    void ridged_3d(noise type, u32 seed, f32 frequency, const fractal& f, const noise_grid& grid, const utils::span<f32>& out,
+                   simd_level level) noexcept
+    {
+        octaves(type, 3, combine::ridged, seed, frequency, f, grid, out, level);
+    }
+};
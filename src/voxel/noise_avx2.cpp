@@ -0,0 +1,79 @@
+#include "noise_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace voxel
+{
+    namespace __detail
+    {
+        namespace __noise
+        {
+#if defined(__AVX2__)
+            namespace
+            {
+                struct avx2_ops
+                {
+                    static constexpr usize width = 8;
+
+                    typedef __m256 f;
+                    typedef __m256i i;
+                    typedef __m256 m;
+
+                    static inline f load(const f32* p) noexcept { return _mm256_loadu_ps(p); }
+                    static inline void store(f32* p, f v) noexcept { _mm256_storeu_ps(p, v); }
+                    static inline f set(f32 v) noexcept { return _mm256_set1_ps(v); }
+                    static inline i seti(u32 v) noexcept { return _mm256_set1_epi32(static_cast<i32>(v)); }
+                    static inline f iota(u32 first) noexcept
+                    {
+                        return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(static_cast<i32>(first)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+                    }
+
+                    static inline f add(f a, f b) noexcept { return _mm256_add_ps(a, b); }
+                    static inline f sub(f a, f b) noexcept { return _mm256_sub_ps(a, b); }
+                    static inline f mul(f a, f b) noexcept { return _mm256_mul_ps(a, b); }
+                    static inline f min(f a, f b) noexcept { return _mm256_min_ps(a, b); }
+                    static inline f max(f a, f b) noexcept { return _mm256_max_ps(a, b); }
+                    static inline f abs(f a) noexcept { return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))); }
+                    static inline f sqrt(f a) noexcept { return _mm256_sqrt_ps(a); }
+                    static inline f floor(f a) noexcept { return _mm256_floor_ps(a); }
+                    static inline f flip(f a, i sign) noexcept { return _mm256_xor_ps(a, _mm256_castsi256_ps(sign)); }
+
+                    static inline i to_int(f a) noexcept { return _mm256_cvttps_epi32(a); }
+                    static inline f to_float(i a) noexcept { return _mm256_cvtepi32_ps(a); }
+
+                    static inline i iadd(i a, i b) noexcept { return _mm256_add_epi32(a, b); }
+                    static inline i imul(i a, i b) noexcept { return _mm256_mullo_epi32(a, b); }
+                    static inline i ixor(i a, i b) noexcept { return _mm256_xor_si256(a, b); }
+                    static inline i iand(i a, i b) noexcept { return _mm256_and_si256(a, b); }
+                    template<int n> static inline i shr(i a) noexcept { return _mm256_srli_epi32(a, n); }
+                    template<int n> static inline i shl(i a) noexcept { return _mm256_slli_epi32(a, n); }
+
+                    static inline m lt(f a, f b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+                    static inline m ge(f a, f b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+                    static inline m ieq(i a, i b) noexcept { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+                    static inline m mand(m a, m b) noexcept { return _mm256_and_ps(a, b); }
+                    static inline m mor(m a, m b) noexcept { return _mm256_or_ps(a, b); }
+                    static inline m mnot(m a) noexcept { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+                    static inline f select(m c, f a, f b) noexcept { return _mm256_blendv_ps(b, a, c); }
+                };
+            };
+
+            const bool avx2_compiled = true;
+
+            void run_avx2(const layer& l) noexcept
+            {
+                run<avx2_ops>(l);
+            }
+#else
+            const bool avx2_compiled = false;
+
+            void run_avx2(const layer& l) noexcept
+            {
+                run_scalar(l);
+            }
+#endif
+        };
+    };
+};
@@ -0,0 +1,480 @@
+/**
+ * @file
+ * @brief Noise kernels shared by the scalar, SSE and AVX2 translation units.
+ *
+ * The kernels are written once against a small set of vector operations and live in an
+ * anonymous namespace, so every translation unit that includes this header compiles its
+ * own copy with its own instruction set. Every operation is correctly rounded and the
+ * sources are compiled without floating point contraction, so all the copies compute
+ * bitwise-identical results.
+ */
+#pragma once
+
+#include <voxel/noise.hpp>
+
+#include <bit>
+#include <cmath>
+
+namespace voxel
+{
+    namespace __detail
+    {
+        namespace __noise
+        {
+            /// @brief How the noise of a layer is written to the output.
+            enum class combine : u8
+            {
+                /** out = n */
+                assign = 0,
+                /** out = out + amplitude * n */
+                add = 1,
+                /** out = out + amplitude * (1 - |n|) */
+                ridged = 2
+            };
+
+            /// @brief One pass of noise over a grid.
+            struct layer
+            {
+                noise type;
+                u8 dimensions;
+                combine op;
+                u32 seed;
+                f32 frequency;
+                f32 amplitude;
+                const noise_grid* grid;
+                f32* out;
+            };
+
+            void run_scalar(const layer& l) noexcept;
+            void run_sse(const layer& l) noexcept;
+            void run_avx2(const layer& l) noexcept;
+
+            /** Whether run_sse was compiled with SSE 4.1, rather than forwarding to run_scalar. */
+            extern const bool sse_compiled;
+            /** Whether run_avx2 was compiled with AVX2, rather than forwarding to run_scalar. */
+            extern const bool avx2_compiled;
+
+            namespace
+            {
+                constexpr u32 prime_x = 501125321;
+                constexpr u32 prime_y = 1136930381;
+                constexpr u32 prime_z = 1720413743;
+                constexpr u32 hash_multiplier = 0x27d4eb2d;
+
+                constexpr f32 skew_2d = 0.36602540378f;
+                constexpr f32 unskew_2d = 0.21132486540f;
+                constexpr f32 skew_3d = 1.0f / 3.0f;
+                constexpr f32 unskew_3d = 1.0f / 6.0f;
+                constexpr f32 simplex_2d_scale = 90.0f;
+                constexpr f32 simplex_3d_scale = 32.69428f;
+
+                /// One lane at a time, with the same semantics as the SIMD instructions.
+                struct scalar_ops
+                {
+                    static constexpr usize width = 1;
+
+                    typedef f32 f;
+                    typedef u32 i;
+                    typedef bool m;
+
+                    static inline f load(const f32* p) noexcept { return *p; }
+                    static inline void store(f32* p, f v) noexcept { *p = v; }
+                    static inline f set(f32 v) noexcept { return v; }
+                    static inline i seti(u32 v) noexcept { return v; }
+                    static inline f iota(u32 first) noexcept { return static_cast<f32>(static_cast<i32>(first)); }
+
+                    static inline f add(f a, f b) noexcept { return a + b; }
+                    static inline f sub(f a, f b) noexcept { return a - b; }
+                    static inline f mul(f a, f b) noexcept { return a * b; }
+                    static inline f min(f a, f b) noexcept { return a < b ? a : b; }
+                    static inline f max(f a, f b) noexcept { return a > b ? a : b; }
+                    static inline f abs(f a) noexcept { return ::std::bit_cast<f32>(::std::bit_cast<u32>(a) & 0x7fffffff); }
+                    static inline f sqrt(f a) noexcept { return ::std::sqrt(a); }
+                    static inline f floor(f a) noexcept { return ::std::floor(a); }
+                    static inline f flip(f a, i sign) noexcept { return ::std::bit_cast<f32>(::std::bit_cast<u32>(a) ^ sign); }
+
+                    static inline i to_int(f a) noexcept { return static_cast<u32>(static_cast<i32>(a)); }
+                    static inline f to_float(i a) noexcept { return static_cast<f32>(static_cast<i32>(a)); }
+
+                    static inline i iadd(i a, i b) noexcept { return a + b; }
+                    static inline i imul(i a, i b) noexcept { return a * b; }
+                    static inline i ixor(i a, i b) noexcept { return a ^ b; }
+                    static inline i iand(i a, i b) noexcept { return a & b; }
+                    template<int n> static inline i shr(i a) noexcept { return a >> n; }
+                    template<int n> static inline i shl(i a) noexcept { return a << n; }
+
+                    static inline m lt(f a, f b) noexcept { return a < b; }
+                    static inline m ge(f a, f b) noexcept { return a >= b; }
+                    static inline m ieq(i a, i b) noexcept { return a == b; }
+                    static inline m mand(m a, m b) noexcept { return a && b; }
+                    static inline m mor(m a, m b) noexcept { return a || b; }
+                    static inline m mnot(m a) noexcept { return !a; }
+                    static inline f select(m c, f a, f b) noexcept { return c ? a : b; }
+                };
+
+                template<typename ops>
+                struct kernels
+                {
+                    typedef typename ops::f f;
+                    typedef typename ops::i i;
+                    typedef typename ops::m m;
+
+                    static inline i hash(i seed, i x, i y) noexcept
+                    {
+                        i h = ops::ixor(seed, ops::ixor(ops::imul(x, ops::seti(prime_x)), ops::imul(y, ops::seti(prime_y))));
+                        h = ops::imul(h, ops::seti(hash_multiplier));
+                        return ops::ixor(h, ops::template shr<15>(h));
+                    }
+
+                    static inline i hash(i seed, i x, i y, i z) noexcept
+                    {
+                        i h = ops::ixor(seed, ops::ixor(ops::imul(x, ops::seti(prime_x)), ops::imul(y, ops::seti(prime_y))));
+                        h = ops::ixor(h, ops::imul(z, ops::seti(prime_z)));
+                        h = ops::imul(h, ops::seti(hash_multiplier));
+                        return ops::ixor(h, ops::template shr<15>(h));
+                    }
+
+                    /// Turns a hash into a value in [-1, 1).
+                    static inline f lattice(i h) noexcept { return ops::mul(ops::to_float(h), ops::set(1.0f / 2147483648.0f)); }
+
+                    /// Turns 10 bits of a hash into an offset in [0, 1).
+                    template<int shift>
+                    static inline f jitter(i h) noexcept
+                    {
+                        return ops::mul(ops::to_float(ops::iand(ops::template shr<shift>(h), ops::seti(1023))), ops::set(1.0f / 1024.0f));
+                    }
+
+                    static inline f fade(f t) noexcept
+                    {
+                        f a = ops::sub(ops::mul(t, ops::set(6.0f)), ops::set(15.0f));
+                        a = ops::add(ops::mul(a, t), ops::set(10.0f));
+                        return ops::mul(ops::mul(ops::mul(t, t), t), a);
+                    }
+
+                    /// Clamps to [-1, 1] the few values the scale of simplex noise pushes past it.
+                    static inline f clamp(f v) noexcept { return ops::max(ops::min(v, ops::set(1.0f)), ops::set(-1.0f)); }
+
+                    static inline f lerp(f a, f b, f t) noexcept { return ops::add(a, ops::mul(t, ops::sub(b, a))); }
+
+                    /// One of the 8 gradients (+-1, +-1/2) and (+-1/2, +-1), dotted with (x, y).
+                    static inline f gradient(i h, f x, f y) noexcept
+                    {
+                        m swap = ops::ieq(ops::iand(h, ops::seti(4)), ops::seti(0));
+                        f a = ops::select(swap, x, y);
+                        f b = ops::mul(ops::select(swap, y, x), ops::set(0.5f));
+                        return ops::add(ops::flip(a, ops::template shl<31>(h)), ops::flip(b, ops::template shl<30>(ops::iand(h, ops::seti(2)))));
+                    }
+
+                    /// One of the 12 gradients toward the edges of a cube, dotted with (x, y, z).
+                    static inline f gradient(i h, f x, f y, f z) noexcept
+                    {
+                        m low = ops::ieq(ops::iand(h, ops::seti(8)), ops::seti(0));
+                        m lowest = ops::ieq(ops::iand(h, ops::seti(12)), ops::seti(0));
+                        m edge = ops::ieq(ops::iand(h, ops::seti(13)), ops::seti(12));
+                        f u = ops::select(low, x, y);
+                        f v = ops::select(lowest, y, ops::select(edge, x, z));
+                        return ops::add(ops::flip(u, ops::template shl<31>(h)), ops::flip(v, ops::template shl<30>(ops::iand(h, ops::seti(2)))));
+                    }
+
+                    static inline f corner(i h, f x, f y) noexcept
+                    {
+                        f t = ops::sub(ops::sub(ops::set(0.5f), ops::mul(x, x)), ops::mul(y, y));
+                        t = ops::max(t, ops::set(0.0f));
+                        t = ops::mul(t, t);
+                        return ops::mul(ops::mul(t, t), gradient(h, x, y));
+                    }
+
+                    static inline f corner(i h, f x, f y, f z) noexcept
+                    {
+                        f t = ops::sub(ops::sub(ops::sub(ops::set(0.6f), ops::mul(x, x)), ops::mul(y, y)), ops::mul(z, z));
+                        t = ops::max(t, ops::set(0.0f));
+                        t = ops::mul(t, t);
+                        return ops::mul(ops::mul(t, t), gradient(h, x, y, z));
+                    }
+
+                    static inline f simplex(i seed, f x, f y) noexcept
+                    {
+                        f one = ops::set(1.0f);
+                        f g = ops::set(unskew_2d);
+
+                        f s = ops::mul(ops::add(x, y), ops::set(skew_2d));
+                        f fi = ops::floor(ops::add(x, s));
+                        f fj = ops::floor(ops::add(y, s));
+                        f t = ops::mul(ops::add(fi, fj), g);
+                        f x0 = ops::sub(x, ops::sub(fi, t));
+                        f y0 = ops::sub(y, ops::sub(fj, t));
+
+                        m lower = ops::lt(y0, x0);
+                        f i1 = ops::select(lower, one, ops::set(0.0f));
+                        f j1 = ops::sub(one, i1);
+
+                        f x1 = ops::add(ops::sub(x0, i1), g);
+                        f y1 = ops::add(ops::sub(y0, j1), g);
+                        f x2 = ops::add(ops::sub(x0, one), ops::set(2.0f * unskew_2d));
+                        f y2 = ops::add(ops::sub(y0, one), ops::set(2.0f * unskew_2d));
+
+                        i ci = ops::to_int(fi);
+                        i cj = ops::to_int(fj);
+                        i di = ops::to_int(i1);
+                        i dj = ops::to_int(j1);
+                        i o = ops::seti(1);
+
+                        f n = corner(hash(seed, ci, cj), x0, y0);
+                        n = ops::add(n, corner(hash(seed, ops::iadd(ci, di), ops::iadd(cj, dj)), x1, y1));
+                        n = ops::add(n, corner(hash(seed, ops::iadd(ci, o), ops::iadd(cj, o)), x2, y2));
+                        return clamp(ops::mul(n, ops::set(simplex_2d_scale)));
+                    }
+
+                    static inline f simplex(i seed, f x, f y, f z) noexcept
+                    {
+                        f one = ops::set(1.0f);
+                        f zero = ops::set(0.0f);
+                        f g = ops::set(unskew_3d);
+
+                        f s = ops::mul(ops::add(ops::add(x, y), z), ops::set(skew_3d));
+                        f fi = ops::floor(ops::add(x, s));
+                        f fj = ops::floor(ops::add(y, s));
+                        f fk = ops::floor(ops::add(z, s));
+                        f t = ops::mul(ops::add(ops::add(fi, fj), fk), g);
+                        f x0 = ops::sub(x, ops::sub(fi, t));
+                        f y0 = ops::sub(y, ops::sub(fj, t));
+                        f z0 = ops::sub(z, ops::sub(fk, t));
+
+                        // The order of the offsets gives the two middle corners of the simplex.
+                        m xy = ops::ge(x0, y0);
+                        m yz = ops::ge(y0, z0);
+                        m xz = ops::ge(x0, z0);
+                        f i1 = ops::select(ops::mand(xy, xz), one, zero);
+                        f j1 = ops::select(ops::mand(ops::mnot(xy), yz), one, zero);
+                        f k1 = ops::select(ops::mand(ops::mnot(yz), ops::mnot(xz)), one, zero);
+                        f i2 = ops::select(ops::mor(xy, xz), one, zero);
+                        f j2 = ops::select(ops::mor(ops::mnot(xy), yz), one, zero);
+                        f k2 = ops::select(ops::mnot(ops::mand(yz, xz)), one, zero);
+
+                        f x1 = ops::add(ops::sub(x0, i1), g);
+                        f y1 = ops::add(ops::sub(y0, j1), g);
+                        f z1 = ops::add(ops::sub(z0, k1), g);
+                        f x2 = ops::add(ops::sub(x0, i2), ops::set(2.0f * unskew_3d));
+                        f y2 = ops::add(ops::sub(y0, j2), ops::set(2.0f * unskew_3d));
+                        f z2 = ops::add(ops::sub(z0, k2), ops::set(2.0f * unskew_3d));
+                        f x3 = ops::add(ops::sub(x0, one), ops::set(3.0f * unskew_3d));
+                        f y3 = ops::add(ops::sub(y0, one), ops::set(3.0f * unskew_3d));
+                        f z3 = ops::add(ops::sub(z0, one), ops::set(3.0f * unskew_3d));
+
+                        i ci = ops::to_int(fi);
+                        i cj = ops::to_int(fj);
+                        i ck = ops::to_int(fk);
+                        i o = ops::seti(1);
+
+                        f n = corner(hash(seed, ci, cj, ck), x0, y0, z0);
+                        n = ops::add(n, corner(hash(seed, ops::iadd(ci, ops::to_int(i1)), ops::iadd(cj, ops::to_int(j1)), ops::iadd(ck, ops::to_int(k1))), x1, y1, z1));
+                        n = ops::add(n, corner(hash(seed, ops::iadd(ci, ops::to_int(i2)), ops::iadd(cj, ops::to_int(j2)), ops::iadd(ck, ops::to_int(k2))), x2, y2, z2));
+                        n = ops::add(n, corner(hash(seed, ops::iadd(ci, o), ops::iadd(cj, o), ops::iadd(ck, o)), x3, y3, z3));
+                        return clamp(ops::mul(n, ops::set(simplex_3d_scale)));
+                    }
+
+                    static inline f value(i seed, f x, f y) noexcept
+                    {
+                        f fi = ops::floor(x);
+                        f fj = ops::floor(y);
+                        f u = fade(ops::sub(x, fi));
+                        f v = fade(ops::sub(y, fj));
+
+                        i ci = ops::to_int(fi);
+                        i cj = ops::to_int(fj);
+                        i ni = ops::iadd(ci, ops::seti(1));
+                        i nj = ops::iadd(cj, ops::seti(1));
+
+                        f a = lerp(lattice(hash(seed, ci, cj)), lattice(hash(seed, ni, cj)), u);
+                        f b = lerp(lattice(hash(seed, ci, nj)), lattice(hash(seed, ni, nj)), u);
+                        return lerp(a, b, v);
+                    }
+
+                    static inline f value(i seed, f x, f y, f z) noexcept
+                    {
+                        f fi = ops::floor(x);
+                        f fj = ops::floor(y);
+                        f fk = ops::floor(z);
+                        f u = fade(ops::sub(x, fi));
+                        f v = fade(ops::sub(y, fj));
+                        f w = fade(ops::sub(z, fk));
+
+                        i ci = ops::to_int(fi);
+                        i cj = ops::to_int(fj);
+                        i ck = ops::to_int(fk);
+                        i ni = ops::iadd(ci, ops::seti(1));
+                        i nj = ops::iadd(cj, ops::seti(1));
+                        i nk = ops::iadd(ck, ops::seti(1));
+
+                        f a = lerp(lattice(hash(seed, ci, cj, ck)), lattice(hash(seed, ni, cj, ck)), u);
+                        f b = lerp(lattice(hash(seed, ci, nj, ck)), lattice(hash(seed, ni, nj, ck)), u);
+                        f c = lerp(lattice(hash(seed, ci, cj, nk)), lattice(hash(seed, ni, cj, nk)), u);
+                        f d = lerp(lattice(hash(seed, ci, nj, nk)), lattice(hash(seed, ni, nj, nk)), u);
+                        return lerp(lerp(a, b, v), lerp(c, d, v), w);
+                    }
+
+                    /// Maps the distance to the closest feature point to [-1, 1].
+                    static inline f distance(f squared) noexcept
+                    {
+                        f d = ops::min(ops::sqrt(squared), ops::set(1.0f));
+                        return ops::sub(ops::mul(d, ops::set(2.0f)), ops::set(1.0f));
+                    }
+
+                    static inline f cellular(i seed, f x, f y) noexcept
+                    {
+                        f fi = ops::floor(x);
+                        f fj = ops::floor(y);
+                        f lx = ops::sub(x, fi);
+                        f ly = ops::sub(y, fj);
+                        i ci = ops::to_int(fi);
+                        i cj = ops::to_int(fj);
+
+                        f best = ops::set(8.0f);
+                        for(i32 dy = -1; dy <= 1; dy++)
+                            for(i32 dx = -1; dx <= 1; dx++)
+                            {
+                                i h = hash(seed, ops::iadd(ci, ops::seti(u32(dx))), ops::iadd(cj, ops::seti(u32(dy))));
+                                f px = ops::sub(ops::add(ops::set(f32(dx)), jitter<0>(h)), lx);
+                                f py = ops::sub(ops::add(ops::set(f32(dy)), jitter<10>(h)), ly);
+                                best = ops::min(best, ops::add(ops::mul(px, px), ops::mul(py, py)));
+                            }
+
+                        return distance(best);
+                    }
+
+                    static inline f cellular(i seed, f x, f y, f z) noexcept
+                    {
+                        f fi = ops::floor(x);
+                        f fj = ops::floor(y);
+                        f fk = ops::floor(z);
+                        f lx = ops::sub(x, fi);
+                        f ly = ops::sub(y, fj);
+                        f lz = ops::sub(z, fk);
+                        i ci = ops::to_int(fi);
+                        i cj = ops::to_int(fj);
+                        i ck = ops::to_int(fk);
+
+                        f best = ops::set(8.0f);
+                        for(i32 dz = -1; dz <= 1; dz++)
+                            for(i32 dy = -1; dy <= 1; dy++)
+                                for(i32 dx = -1; dx <= 1; dx++)
+                                {
+                                    i h = hash(seed, ops::iadd(ci, ops::seti(u32(dx))), ops::iadd(cj, ops::seti(u32(dy))), ops::iadd(ck, ops::seti(u32(dz))));
+                                    f px = ops::sub(ops::add(ops::set(f32(dx)), jitter<0>(h)), lx);
+                                    f py = ops::sub(ops::add(ops::set(f32(dy)), jitter<10>(h)), ly);
+                                    f pz = ops::sub(ops::add(ops::set(f32(dz)), jitter<20>(h)), lz);
+                                    best = ops::min(best, ops::add(ops::add(ops::mul(px, px), ops::mul(py, py)), ops::mul(pz, pz)));
+                                }
+
+                        return distance(best);
+                    }
+
+                    template<noise type, u8 dimensions>
+                    static inline f sample(i seed, f x, f y, f z) noexcept
+                    {
+                        if constexpr(dimensions == 2)
+                        {
+                            if constexpr(type == noise::simplex)
+                                return simplex(seed, x, y);
+                            else if constexpr(type == noise::value)
+                                return value(seed, x, y);
+                            else
+                                return cellular(seed, x, y);
+                        }
+                        else
+                        {
+                            if constexpr(type == noise::simplex)
+                                return simplex(seed, x, y, z);
+                            else if constexpr(type == noise::value)
+                                return value(seed, x, y, z);
+                            else
+                                return cellular(seed, x, y, z);
+                        }
+                    }
+
+                    static inline void write(const layer& l, f32* out, f n) noexcept
+                    {
+                        switch(l.op)
+                        {
+                        case combine::assign:
+                            ops::store(out, n);
+                            break;
+                        case combine::add:
+                            ops::store(out, ops::add(ops::load(out), ops::mul(ops::set(l.amplitude), n)));
+                            break;
+                        case combine::ridged:
+                            ops::store(out, ops::add(ops::load(out), ops::mul(ops::set(l.amplitude), ops::sub(ops::set(1.0f), ops::abs(n)))));
+                            break;
+                        }
+                    }
+                };
+
+                /// Samples a layer over its grid, with the vector operations for whole groups
+                /// of points and the scalar ones for the points left at the end of every row.
+                template<typename ops, noise type, u8 dimensions>
+                void run_grid(const layer& l) noexcept
+                {
+                    typedef kernels<ops> vector;
+                    typedef kernels<scalar_ops> scalar;
+
+                    const noise_grid& g = *l.grid;
+                    u32 depth = dimensions == 2 ? 1 : g.depth;
+                    f32* out = l.out;
+
+                    typename ops::i seed = ops::seti(l.seed);
+                    typename ops::f x0 = ops::set(g.x);
+                    typename ops::f step = ops::set(g.step);
+                    typename ops::f frequency = ops::set(l.frequency);
+
+                    for(u32 k = 0; k != depth; k++)
+                    {
+                        f32 z = (g.z + static_cast<f32>(static_cast<i32>(k)) * g.step) * l.frequency;
+                        for(u32 j = 0; j != g.height; j++, out += g.width)
+                        {
+                            f32 y = (g.y + static_cast<f32>(static_cast<i32>(j)) * g.step) * l.frequency;
+
+                            u32 i = 0;
+                            for(; i + ops::width <= g.width; i += ops::width)
+                            {
+                                typename ops::f x = ops::mul(ops::add(x0, ops::mul(ops::iota(i), step)), frequency);
+                                vector::write(l, out + i, vector::template sample<type, dimensions>(seed, x, ops::set(y), ops::set(z)));
+                            }
+
+                            for(; i != g.width; i++)
+                            {
+                                f32 x = (g.x + scalar_ops::iota(i) * g.step) * l.frequency;
+                                scalar::write(l, out + i, scalar::template sample<type, dimensions>(l.seed, x, y, z));
+                            }
+                        }
+                    }
+                }
+
+                template<typename ops, u8 dimensions>
+                inline void run_dimensions(const layer& l) noexcept
+                {
+                    switch(l.type)
+                    {
+                    case noise::simplex:
+                        run_grid<ops, noise::simplex, dimensions>(l);
+                        break;
+                    case noise::value:
+                        run_grid<ops, noise::value, dimensions>(l);
+                        break;
+                    case noise::cellular:
+                        run_grid<ops, noise::cellular, dimensions>(l);
+                        break;
+                    }
+                }
+
+                template<typename ops>
+                inline void run(const layer& l) noexcept
+                {
+                    if(l.dimensions == 2)
+                        run_dimensions<ops, 2>(l);
+                    else
+                        run_dimensions<ops, 3>(l);
+                }
+            };
+        };
+    };
+};
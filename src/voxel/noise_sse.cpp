@@ -0,0 +1,79 @@
+#include "noise_kernels.hpp"
+
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace voxel
+{
+    namespace __detail
+    {
+        namespace __noise
+        {
+#if defined(__SSE4_1__)
+            namespace
+            {
+                struct sse_ops
+                {
+                    static constexpr usize width = 4;
+
+                    typedef __m128 f;
+                    typedef __m128i i;
+                    typedef __m128 m;
+
+                    static inline f load(const f32* p) noexcept { return _mm_loadu_ps(p); }
+                    static inline void store(f32* p, f v) noexcept { _mm_storeu_ps(p, v); }
+                    static inline f set(f32 v) noexcept { return _mm_set1_ps(v); }
+                    static inline i seti(u32 v) noexcept { return _mm_set1_epi32(static_cast<i32>(v)); }
+                    static inline f iota(u32 first) noexcept
+                    {
+                        return _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(static_cast<i32>(first)), _mm_setr_epi32(0, 1, 2, 3)));
+                    }
+
+                    static inline f add(f a, f b) noexcept { return _mm_add_ps(a, b); }
+                    static inline f sub(f a, f b) noexcept { return _mm_sub_ps(a, b); }
+                    static inline f mul(f a, f b) noexcept { return _mm_mul_ps(a, b); }
+                    static inline f min(f a, f b) noexcept { return _mm_min_ps(a, b); }
+                    static inline f max(f a, f b) noexcept { return _mm_max_ps(a, b); }
+                    static inline f abs(f a) noexcept { return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); }
+                    static inline f sqrt(f a) noexcept { return _mm_sqrt_ps(a); }
+                    static inline f floor(f a) noexcept { return _mm_floor_ps(a); }
+                    static inline f flip(f a, i sign) noexcept { return _mm_xor_ps(a, _mm_castsi128_ps(sign)); }
+
+                    static inline i to_int(f a) noexcept { return _mm_cvttps_epi32(a); }
+                    static inline f to_float(i a) noexcept { return _mm_cvtepi32_ps(a); }
+
+                    static inline i iadd(i a, i b) noexcept { return _mm_add_epi32(a, b); }
+                    static inline i imul(i a, i b) noexcept { return _mm_mullo_epi32(a, b); }
+                    static inline i ixor(i a, i b) noexcept { return _mm_xor_si128(a, b); }
+                    static inline i iand(i a, i b) noexcept { return _mm_and_si128(a, b); }
+                    template<int n> static inline i shr(i a) noexcept { return _mm_srli_epi32(a, n); }
+                    template<int n> static inline i shl(i a) noexcept { return _mm_slli_epi32(a, n); }
+
+                    static inline m lt(f a, f b) noexcept { return _mm_cmplt_ps(a, b); }
+                    static inline m ge(f a, f b) noexcept { return _mm_cmpge_ps(a, b); }
+                    static inline m ieq(i a, i b) noexcept { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+                    static inline m mand(m a, m b) noexcept { return _mm_and_ps(a, b); }
+                    static inline m mor(m a, m b) noexcept { return _mm_or_ps(a, b); }
+                    static inline m mnot(m a) noexcept { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+                    static inline f select(m c, f a, f b) noexcept { return _mm_blendv_ps(b, a, c); }
+                };
+            };
+
+            const bool sse_compiled = true;
+
+            void run_sse(const layer& l) noexcept
+            {
+                run<sse_ops>(l);
+            }
+#else
+            const bool sse_compiled = false;
+
+            void run_sse(const layer& l) noexcept
+            {
+                run_scalar(l);
+            }
+#endif
+        };
+    };
+};
@@ -0,0 +1,68 @@
+#include <voxel/occupancy.hpp>
+
+namespace voxel
+{
+    chunk_occupancy::chunk_occupancy() noexcept :
+        bricks(0), solid(0)
+    {
+        ::std::memset(rows, 0, sizeof(rows));
+    }
+
+    chunk_occupancy::chunk_occupancy(const chunk& c) noexcept
+    {
+        build(c);
+    }
+
+    void chunk_occupancy::build(const chunk& c) noexcept
+    {
+        if(c.uniform())
+        {
+            bool opaque = c.get(0) != air;
+            ::std::memset(rows, opaque ? 0xff : 0, sizeof(rows));
+            bricks = opaque ? ~u64(0) : 0;
+            solid = opaque ? chunk_volume : 0;
+            return;
+        }
+
+        // Every thread decodes into its own scratch buffer, too large for the stack.
+        thread_local utils::buffer<block> blocks(chunk_volume);
+        c.decode(utils::span<block>(blocks.data(), chunk_volume));
+
+        solid = 0;
+        for(u32 i = 0; i != chunk_size * chunk_size; i++)
+        {
+            rows[i] = row_occupancy(blocks.data() + i * chunk_size);
+            solid += static_cast<u32>(::std::popcount(rows[i]));
+        }
+
+        bricks = 0;
+        for(u32 bz = 0; bz != bricks_per_edge; bz++)
+            for(u32 by = 0; by != bricks_per_edge; by++)
+                for(u32 bx = 0; bx != bricks_per_edge; bx++)
+                    update_brick(bx, by, bz);
+    }
+
+    void chunk_occupancy::set(local_coord c, bool opaque) noexcept
+    {
+        u32& r = rows[c.z * chunk_size + c.y];
+        u32 bit = u32(1) << c.x;
+        if(((r & bit) != 0) == opaque)
+            return;
+
+        r ^= bit;
+        solid += opaque ? 1 : -1;
+        update_brick(c.x >> brick_shift, c.y >> brick_shift, c.z >> brick_shift);
+    }
+
+    void chunk_occupancy::update_brick(u32 bx, u32 by, u32 bz) noexcept
+    {
+        u32 mask = ((u32(1) << brick_size) - 1) << (bx * brick_size);
+        u32 any = 0;
+        for(u32 z = bz * brick_size; z != (bz + 1) * brick_size; z++)
+            for(u32 y = by * brick_size; y != (by + 1) * brick_size; y++)
+                any |= rows[z * chunk_size + y] & mask;
+
+        u64 bit = u64(1) << brick_index(bx, by, bz);
+        bricks = any != 0 ? bricks | bit : bricks & ~bit;
+    }
+};
@@ -0,0 +1,218 @@
+#include <voxel/octree.hpp>
+
+namespace voxel
+{
+    sparse_octree::sparse_octree(u8 depth, block value) noexcept :
+        nodes(), root(leaf(value)), levels(depth < max_depth ? depth : max_depth)
+    {
+    }
+
+    block sparse_octree::get(u32 x, u32 y, u32 z) const noexcept
+    {
+        u32 e = root;
+        for(u32 shift = levels; !is_leaf(e); )
+        {
+            shift--;
+            e = nodes[e].children[child_slot(x, y, z, shift)];
+        }
+
+        return leaf_block(e);
+    }
+
+    void sparse_octree::set(u32 x, u32 y, u32 z, block b) noexcept
+    {
+        assign(x, y, z, 0, leaf(b));
+    }
+
+    void sparse_octree::build(const chunk& c, u32 x, u32 y, u32 z) noexcept
+    {
+        if(c.uniform())
+        {
+            assign(x, y, z, chunk_shift, leaf(c.get(0)));
+            return;
+        }
+
+        utils::buffer<block> blocks(chunk_volume);
+        c.decode(utils::span<block>(blocks.data(), chunk_volume));
+        assign(x, y, z, chunk_shift, build(blocks.data(), 0, 0, 0, chunk_size));
+    }
+
+    void sparse_octree::fill(block b) noexcept
+    {
+        nodes.clear();
+        root = leaf(b);
+    }
+
+    void sparse_octree::serialize(utils::array<u32>& out) const noexcept
+    {
+        if(is_leaf(root))
+        {
+            out.push(root);
+            return;
+        }
+
+        utils::array<u32> order(nodes.size());
+        order.push_unchecked(root);
+        out.reserve(out.size() + 1 + 8 * nodes.size());
+        out.push_unchecked(0);
+
+        for(usize i = 0; i != order.size(); i++)
+        {
+            const group& g = nodes[order[i]];
+            for(u32 child : g.children)
+            {
+                if(is_leaf(child))
+                    out.push_unchecked(child);
+                else
+                {
+                    out.push_unchecked(static_cast<u32>(order.size()));
+                    order.push_unchecked(child);
+                }
+            }
+        }
+    }
+
+    bool sparse_octree::deserialize(const utils::const_span<u32>& entries) noexcept
+    {
+        if(entries.empty() || (entries.size() - 1) % 8 != 0)
+            return false;
+
+        usize count = (entries.size() - 1) / 8;
+        if(is_leaf(entries[0]) ? count != 0 : entries[0] != 0 || count == 0)
+            return false;
+
+        // Breadth-first numbers are handed out in the order the entries appear, and a group
+        // is always referenced from a group before it, so a single pass rejects cycles. The
+        // depth of each group is tracked along, since get and assign walk at most levels groups.
+        utils::array<u8> depths(count);
+        if(count != 0)
+        {
+            if(levels == 0)
+                return false;
+            depths.push_unchecked(1);
+        }
+
+        usize next = 1;
+        for(usize i = 1; i != entries.size(); i++)
+        {
+            if(is_leaf(entries[i]))
+                continue;
+
+            usize parent = (i - 1) / 8;
+            if(entries[i] != next || entries[i] <= parent || next == count || depths[parent] == levels)
+                return false;
+            depths.push_unchecked(static_cast<u8>(depths[parent] + 1));
+            next++;
+        }
+
+        if(count != 0 && next != count)
+            return false;
+
+        nodes.clear();
+        if(count == 0)
+        {
+            root = entries[0];
+            return true;
+        }
+
+        utils::array<u32> indices(count);
+        for(usize i : nodes.create_many(count))
+            indices.push_unchecked(static_cast<u32>(i));
+
+        root = indices[0];
+        for(usize i = 0; i != count; i++)
+        {
+            group& g = nodes[indices[i]];
+            for(u32 c = 0; c != 8; c++)
+            {
+                u32 e = entries[1 + 8 * i + c];
+                g.children[c] = is_leaf(e) ? e : indices[e];
+            }
+        }
+
+        return true;
+    }
+
+    void sparse_octree::assign(u32 x, u32 y, u32 z, u32 level, u32 e) noexcept
+    {
+        u32 groups[max_depth];
+        u32 slots[max_depth];
+        usize n = 0;
+
+        u32 g = none;
+        u32 slot = 0;
+        for(u32 shift = levels; shift != level; )
+        {
+            shift--;
+
+            u32 current = entry(g, slot);
+            if(is_leaf(current))
+            {
+                if(current == e)
+                    return;
+
+                group children;
+                for(u32& child : children.children)
+                    child = current;
+
+                current = static_cast<u32>(nodes.create(children));
+                entry(g, slot) = current;
+            }
+
+            groups[n] = g;
+            slots[n] = slot;
+            n++;
+
+            g = current;
+            slot = child_slot(x, y, z, shift);
+        }
+
+        destroy(entry(g, slot));
+        entry(g, slot) = e;
+
+        // Collapse the groups on the path that became uniform, bottom-up.
+        while(n != 0 && is_leaf(e))
+        {
+            const group& children = nodes[g];
+            for(u32 child : children.children)
+                if(child != e)
+                    return;
+
+            nodes.destroy(g);
+            n--;
+            g = groups[n];
+            slot = slots[n];
+            entry(g, slot) = e;
+        }
+    }
+
+    void sparse_octree::destroy(u32 e) noexcept
+    {
+        if(is_leaf(e))
+            return;
+
+        for(u32 child : nodes[e].children)
+            destroy(child);
+        nodes.destroy(e);
+    }
+
+    u32 sparse_octree::build(const block* blocks, u32 x, u32 y, u32 z, u32 size) noexcept
+    {
+        if(size == 1)
+            return leaf(blocks[voxel_index(x, y, z)]);
+
+        u32 half = size >> 1;
+        group children;
+        bool uniform = true;
+        for(u32 i = 0; i != 8; i++)
+        {
+            children.children[i] = build(blocks, x + (i & 1) * half, y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half);
+            uniform = uniform && is_leaf(children.children[i]) && children.children[i] == children.children[0];
+        }
+
+        if(uniform)
+            return children.children[0];
+
+        return static_cast<u32>(nodes.create(children));
+    }
+};
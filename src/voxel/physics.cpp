@@ -0,0 +1,136 @@
+#include <voxel/physics.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace voxel
+{
+    namespace
+    {
+        constexpr u32 none = chunk_map<chunk_occupancy>::none;
+
+        /// The order of the moves: y first, so that entities land before sliding along the ground.
+        constexpr u32 axes[3] = { 1, 0, 2 };
+
+        inline i32 floor_int(f32 v) noexcept { return static_cast<i32>(::std::floor(v)); }
+        inline i32 ceil_int(f32 v) noexcept { return static_cast<i32>(::std::ceil(v)); }
+
+        /// Sweeps a box along an axis and returns how far it can go, at most d.
+        f32 sweep(const chunk_map<chunk_occupancy>& world, const f32* low, const f32* high, u32 a, f32 d, bool& blocked) noexcept
+        {
+            // The voxels the box overlaps along the other axes, ignoring the ones it only touches.
+            i32 from[3], to[3];
+            for(u32 b = 0; b != 3; b++)
+            {
+                from[b] = floor_int(low[b] + contact_skin);
+                to[b] = ::std::max(from[b], ceil_int(high[b] - contact_skin) - 1);
+            }
+
+            i32 first, last, step;
+            if(d > 0)
+            {
+                first = ceil_int(high[a] - contact_skin);
+                last = ceil_int(high[a] + d) - 1;
+                step = 1;
+            }
+            else
+            {
+                first = floor_int(low[a] + contact_skin) - 1;
+                last = floor_int(low[a] + d);
+                step = -1;
+            }
+
+            for(i32 k = first; step > 0 ? k <= last : k >= last; k += step)
+            {
+                from[a] = to[a] = k;
+                if(!overlaps(world, from[0], from[1], from[2], to[0], to[1], to[2]))
+                    continue;
+
+                blocked = true;
+                if(d > 0)
+                    return ::std::max(0.0f, static_cast<f32>(k) - contact_skin - high[a]);
+                return ::std::min(0.0f, static_cast<f32>(k + 1) + contact_skin - low[a]);
+            }
+            return d;
+        }
+    };
+
+    bool overlaps(const chunk_map<chunk_occupancy>& world, i32 x0, i32 y0, i32 z0, i32 x1, i32 y1, i32 z1) noexcept
+    {
+        chunk_coord c0 = chunk_coord::containing(x0, y0, z0);
+        chunk_coord c1 = chunk_coord::containing(x1, y1, z1);
+        for(i32 cz = c0.z; cz <= c1.z; cz++)
+            for(i32 cy = c0.y; cy <= c1.y; cy++)
+                for(i32 cx = c0.x; cx <= c1.x; cx++)
+                {
+                    u32 i = world.find(chunk_coord { cx, cy, cz });
+                    if(i == none)
+                        return true;
+
+                    const chunk_occupancy& o = world[i];
+                    if(o.empty())
+                        continue;
+                    if(o.full())
+                        return true;
+
+                    // The part of the box inside the chunk, in local coordinates.
+                    i32 base[3] = { cx * i32(chunk_size), cy * i32(chunk_size), cz * i32(chunk_size) };
+                    u32 lx0 = static_cast<u32>(::std::max(x0, base[0]) - base[0]);
+                    u32 lx1 = static_cast<u32>(::std::min(x1, base[0] + i32(chunk_size) - 1) - base[0]);
+                    u32 ly0 = static_cast<u32>(::std::max(y0, base[1]) - base[1]);
+                    u32 ly1 = static_cast<u32>(::std::min(y1, base[1] + i32(chunk_size) - 1) - base[1]);
+                    u32 lz0 = static_cast<u32>(::std::max(z0, base[2]) - base[2]);
+                    u32 lz1 = static_cast<u32>(::std::min(z1, base[2] + i32(chunk_size) - 1) - base[2]);
+
+                    u32 mask = (~u32(0) >> (chunk_size - 1 - (lx1 - lx0))) << lx0;
+                    for(u32 z = lz0; z <= lz1; z++)
+                        for(u32 y = ly0; y <= ly1; y++)
+                            if((o.row(y, z) & mask) != 0)
+                                return true;
+                }
+        return false;
+    }
+
+    void move_entities(const chunk_map<chunk_occupancy>& world, const entity_spans& entities, f32 dt, usize begin, usize end) noexcept
+    {
+        f32* position[3] = { entities.x.data(), entities.y.data(), entities.z.data() };
+        f32* velocity[3] = { entities.velocity_x.data(), entities.velocity_y.data(), entities.velocity_z.data() };
+        const f32* half[3] = { entities.half_x.data(), entities.half_y.data(), entities.half_z.data() };
+        u8* contacts = entities.contacts.data();
+
+        for(usize i = begin; i != end; i++)
+        {
+            u8 blocked_faces = 0;
+            for(u32 a : axes)
+            {
+                f32 d = velocity[a][i] * dt;
+                if(d == 0)
+                    continue;
+
+                f32 low[3], high[3];
+                for(u32 b = 0; b != 3; b++)
+                {
+                    low[b] = position[b][i] - half[b][i];
+                    high[b] = position[b][i] + half[b][i];
+                }
+
+                bool blocked = false;
+                position[a][i] += sweep(world, low, high, a, d, blocked);
+                if(blocked)
+                {
+                    velocity[a][i] = 0;
+                    face f = static_cast<face>(2 * a + (d > 0 ? 0 : 1));
+                    blocked_faces |= static_cast<u8>(1 << static_cast<u32>(f));
+                }
+            }
+            contacts[i] = blocked_faces;
+        }
+    }
+
+    void move_entities(const chunk_map<chunk_occupancy>& world, const entity_spans& entities, f32 dt, jobs::scheduler& s, usize grain) noexcept
+    {
+        s.parallel_for(entities.size(), [&](usize begin, usize end) {
+            move_entities(world, entities, dt, begin, end);
+        }, grain);
+    }
+};
@@ -0,0 +1,248 @@
+#include <voxel/raycast.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace voxel
+{
+    namespace
+    {
+        constexpr u32 packet_size = 8;
+        constexpr u32 none = chunk_map<chunk_occupancy>::none;
+        constexpr f32 infinity = ::std::numeric_limits<f32>::infinity();
+
+        /// A ray along with the chunk it starts in, to sort the batch by.
+        struct binned_ray
+        {
+            u64 key;
+            u32 ray;
+        };
+
+        enum class status : u8
+        {
+            running,
+            hit,
+            missed
+        };
+
+        /// The state of a ray being walked through the grid.
+        ///
+        /// tmax[a] is the t at which the ray leaves the current voxel along axis a. It's
+        /// recomputed from the voxel coordinates at every step instead of accumulated, so
+        /// crossing a whole brick or chunk in one step lands on the same voxels and the same
+        /// t as crossing it voxel by voxel.
+        struct lane
+        {
+            f32 origin[3];
+            f32 inv[3];
+            f32 tmax[3];
+            f32 t;
+            f32 length;
+            i32 v[3];
+            i32 step[3];
+            u32 ray;
+            u32 axis;
+            chunk_coord chunk;
+            const chunk_occupancy* occupancy;
+        };
+
+        /// The t at which a ray leaves voxel v along an axis.
+        inline f32 boundary(const lane& l, u32 a, i32 v) noexcept
+        {
+            if(l.step[a] == 0)
+                return infinity;
+            return (static_cast<f32>(l.step[a] > 0 ? v + 1 : v) - l.origin[a]) * l.inv[a];
+        }
+
+        /// The axis along which the ray leaves the current voxel first, the lowest on ties.
+        inline u32 next_axis(const f32* tmax) noexcept
+        {
+            if(tmax[0] <= tmax[1])
+                return tmax[0] <= tmax[2] ? 0 : 2;
+            return tmax[1] <= tmax[2] ? 1 : 2;
+        }
+
+        inline void locate(lane& l, const chunk_map<chunk_occupancy>& world) noexcept
+        {
+            chunk_coord c = chunk_coord::containing(l.v[0], l.v[1], l.v[2]);
+            if(c == l.chunk)
+                return;
+
+            l.chunk = c;
+            u32 i = world.find(c);
+            l.occupancy = i == none ? nullptr : &world[i];
+        }
+
+        void start(lane& l, const ray& r, u32 index, const chunk_map<chunk_occupancy>& world) noexcept
+        {
+            const f32 origin[3] = { r.origin_x, r.origin_y, r.origin_z };
+            const f32 direction[3] = { r.direction_x, r.direction_y, r.direction_z };
+
+            l.axis = 0;
+            for(u32 a = 0; a != 3; a++)
+            {
+                l.origin[a] = origin[a];
+                l.v[a] = static_cast<i32>(::std::floor(origin[a]));
+                l.step[a] = direction[a] > 0 ? 1 : direction[a] < 0 ? -1 : 0;
+                l.inv[a] = l.step[a] != 0 ? 1 / direction[a] : 0;
+                l.tmax[a] = boundary(l, a, l.v[a]);
+                if(::std::abs(direction[a]) > ::std::abs(direction[l.axis]))
+                    l.axis = a;
+            }
+
+            l.t = 0;
+            l.length = r.length;
+            l.ray = index;
+            l.chunk = chunk_coord::containing(l.v[0], l.v[1], l.v[2]);
+            u32 i = world.find(l.chunk);
+            l.occupancy = i == none ? nullptr : &world[i];
+        }
+
+        /// Crosses the empty cell of size voxels the ray is in, whose corner is aligned
+        /// on size, landing on the first voxel past it.
+        void skip(lane& l, i32 size) noexcept
+        {
+            i32 low[3];
+            f32 exits[3];
+            for(u32 a = 0; a != 3; a++)
+            {
+                low[a] = l.v[a] & ~(size - 1);
+                exits[a] = boundary(l, a, l.step[a] > 0 ? low[a] + size - 1 : low[a]);
+            }
+
+            u32 e = next_axis(exits);
+            l.t = exits[e];
+            l.axis = e;
+            if(l.t == infinity)
+                return;
+
+            for(u32 a = 0; a != 3; a++)
+            {
+                if(a == e || l.step[a] == 0)
+                    continue;
+
+                // The voxel the ray is in at t, corrected so that the boundaries it crossed
+                // and the ties with the exit axis match a voxel by voxel walk.
+                i32 high = low[a] + size - 1;
+                i32 v = static_cast<i32>(::std::floor(l.origin[a] + l.t / l.inv[a]));
+                v = ::std::clamp(v, low[a], high);
+                i32 s = l.step[a];
+                auto crossed = [&](i32 w) noexcept
+                {
+                    f32 b = boundary(l, a, w);
+                    return b < l.t || (b == l.t && a < e);
+                };
+                while(v - s >= low[a] && v - s <= high && !crossed(v - s))
+                    v -= s;
+                while(v + s >= low[a] && v + s <= high && crossed(v))
+                    v += s;
+                l.v[a] = v;
+                l.tmax[a] = boundary(l, a, v);
+            }
+
+            l.v[e] = l.step[e] > 0 ? low[e] + size : low[e] - 1;
+            l.tmax[e] = boundary(l, e, l.v[e]);
+        }
+
+        /// Checks the voxel the ray is in, then moves it past the voxel, or past the whole
+        /// brick or chunk if it's empty.
+        status advance(lane& l, const chunk_map<chunk_occupancy>& world) noexcept
+        {
+            locate(l, world);
+
+            i32 size = chunk_size;
+            if(l.occupancy != nullptr && !l.occupancy->empty())
+            {
+                u32 x = static_cast<u32>(l.v[0]) & (chunk_size - 1);
+                u32 y = static_cast<u32>(l.v[1]) & (chunk_size - 1);
+                u32 z = static_cast<u32>(l.v[2]) & (chunk_size - 1);
+                constexpr u32 shift = chunk_occupancy::brick_shift;
+                if(!l.occupancy->brick(x >> shift, y >> shift, z >> shift))
+                    size = chunk_occupancy::brick_size;
+                else if(l.occupancy->get(x, y, z))
+                    return status::hit;
+                else
+                    size = 1;
+            }
+
+            if(size == 1)
+            {
+                u32 a = next_axis(l.tmax);
+                l.t = l.tmax[a];
+                l.axis = a;
+                l.v[a] += l.step[a];
+                l.tmax[a] = boundary(l, a, l.v[a]);
+            }
+            else
+                skip(l, size);
+
+            return l.t > l.length ? status::missed : status::running;
+        }
+    };
+
+    void raycast(const chunk_map<chunk_occupancy>& world, const utils::const_span<ray>& rays, utils::array<ray_hit>& hits) noexcept
+    {
+        usize n = rays.size();
+        if(n == 0)
+            return;
+
+        utils::array<binned_ray> order;
+        order.reserve(n);
+        for(usize i = 0; i != n; i++)
+        {
+            const ray& r = rays[i];
+            chunk_coord c = chunk_coord::containing(static_cast<i32>(::std::floor(r.origin_x)),
+                static_cast<i32>(::std::floor(r.origin_y)), static_cast<i32>(::std::floor(r.origin_z)));
+            order.push_unchecked(binned_ray { chunk_map<chunk_occupancy>::encode(c), static_cast<u32>(i) });
+        }
+        ::std::sort(order.data(), order.data() + n, [](const binned_ray& a, const binned_ray& b) noexcept
+        {
+            return a.key < b.key || (a.key == b.key && a.ray < b.ray);
+        });
+
+        usize first = hits.size();
+        lane lanes[packet_size];
+        u32 live = 0;
+        usize next = 0;
+        while(live != packet_size && next != n)
+        {
+            start(lanes[live++], rays[order[next].ray], order[next].ray, world);
+            next++;
+        }
+
+        // Every pass advances all the live rays by one step. A finished ray hands its lane
+        // to the next ray of the batch, or to the last live ray once the batch runs out.
+        while(live != 0)
+            for(u32 i = 0; i < live;)
+            {
+                lane& l = lanes[i];
+                status s = advance(l, world);
+                if(s == status::running)
+                {
+                    i++;
+                    continue;
+                }
+
+                if(s == status::hit)
+                {
+                    face side = static_cast<face>(2 * l.axis + (l.step[l.axis] > 0 ? 1 : 0));
+                    hits.push(ray_hit { l.ray, l.v[0], l.v[1], l.v[2], l.t, side });
+                }
+
+                if(next != n)
+                {
+                    start(l, rays[order[next].ray], order[next].ray, world);
+                    next++;
+                    i++;
+                }
+                else
+                    l = lanes[--live];
+            }
+
+        ::std::sort(hits.data() + first, hits.data() + hits.size(), [](const ray_hit& a, const ray_hit& b) noexcept
+        {
+            return a.ray < b.ray;
+        });
+    }
+};
@@ -0,0 +1,659 @@
+#include <voxel/region.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace voxel
+{
+    namespace
+    {
+        constexpr u32 magic = 0x47525856;   // "VXRG"
+        constexpr u32 version = 1;
+        constexpr usize header_size = region_table_offset;
+        constexpr usize table_size = region_volume * sizeof(region_entry);
+        constexpr u32 header_sectors = static_cast<u32>((header_size + table_size + sector_size - 1) / sector_size);
+
+        constexpr usize min_match = 4;
+        constexpr u32 hash_bits = 13;
+
+        /// Compilers turn the loop into a single byte swap instruction.
+        template<typename type>
+        inline constexpr type swap_bytes(type v) noexcept
+        {
+            type r = 0;
+            for(usize i = 0; i != sizeof(type); i++)
+            {
+                r = static_cast<type>((r << 8) | (v & 0xff));
+                v = static_cast<type>(v >> 8);
+            }
+            return r;
+        }
+
+        /// Values are stored little-endian.
+        template<typename type>
+        inline type read_le(const u8* p) noexcept
+        {
+            type v;
+            ::std::memcpy(&v, p, sizeof(type));
+            if constexpr(::std::endian::native == ::std::endian::big)
+                v = swap_bytes(v);
+            return v;
+        }
+
+        template<typename type>
+        inline void write_le(u8* p, type v) noexcept
+        {
+            if constexpr(::std::endian::native == ::std::endian::big)
+                v = swap_bytes(v);
+            ::std::memcpy(p, &v, sizeof(type));
+        }
+
+        inline void put_length(utils::array<u8>& out, usize n) noexcept
+        {
+            for(; n >= 255; n -= 255)
+                out.push(255);
+            out.push(static_cast<u8>(n));
+        }
+
+        /// Codes the bytes as a series of literal runs each followed by a match, like LZ4: a
+        /// token holds both lengths in a nibble each, extended by bytes of 255 past 15, then
+        /// come the literals and the 16-bit distance of the match. The last run has no match.
+        void lz_compress(const u8* in, usize n, utils::array<u8>& out) noexcept
+        {
+            thread_local u32 recent[usize(1) << hash_bits];
+            ::std::memset(recent, 0xff, sizeof(recent));
+
+            usize anchor = 0, i = 0;
+            auto emit = [&](usize literals, usize distance, usize length) {
+                usize extra = length != 0 ? length - min_match : 0;
+                out.push(static_cast<u8>((::std::min<usize>(literals, 15) << 4) | ::std::min<usize>(extra, 15)));
+                if(literals >= 15)
+                    put_length(out, literals - 15);
+                out.push_many(utils::const_span<u8>(in + anchor, literals));
+                if(length == 0)
+                    return;
+
+                u8 d[2];
+                write_le(d, static_cast<u16>(distance));
+                out.push(d[0]);
+                out.push(d[1]);
+                if(extra >= 15)
+                    put_length(out, extra - 15);
+            };
+
+            while(i + min_match <= n)
+            {
+                u32 v = read_le<u32>(in + i);
+                u32 h = (v * 2654435761u) >> (32 - hash_bits);
+                u32 candidate = recent[h];
+                recent[h] = static_cast<u32>(i);
+                if(candidate == ~u32(0) || i - candidate > 0xffff || read_le<u32>(in + candidate) != v)
+                {
+                    i++;
+                    continue;
+                }
+
+                usize length = min_match;
+                while(i + length != n && in[candidate + length] == in[i + length])
+                    length++;
+
+                emit(i - anchor, i - candidate, length);
+                i += length;
+                anchor = i;
+            }
+            emit(n - anchor, 0, 0);
+        }
+
+        inline bool get_length(const u8*& in, const u8* end, usize& n) noexcept
+        {
+            u8 b;
+            do
+            {
+                if(in == end)
+                    return false;
+                b = *(in++);
+                n += b;
+            }
+            while(b == 255);
+            return true;
+        }
+
+        /// Decodes exactly size bytes, checking every length and distance against the bounds.
+        bool lz_decompress(const u8* in, usize n, u8* out, usize size) noexcept
+        {
+            const u8* end = in + n;
+            u8* o = out;
+            u8* last = out + size;
+            while(in != end)
+            {
+                u32 token = *(in++);
+                usize literals = token >> 4;
+                if(literals == 15 && !get_length(in, end, literals))
+                    return false;
+                if(literals > usize(end - in) || literals > usize(last - o))
+                    return false;
+
+                ::std::memcpy(o, in, literals);
+                o += literals;
+                in += literals;
+                if(in == end)
+                    break;
+
+                if(end - in < 2)
+                    return false;
+                usize distance = read_le<u16>(in);
+                in += 2;
+                usize length = token & 15;
+                if(length == 15 && !get_length(in, end, length))
+                    return false;
+                length += min_match;
+                if(distance == 0 || distance > usize(o - out) || length > usize(last - o))
+                    return false;
+
+                // A match overlapping its output repeats the distance bytes before it, so it
+                // is copied in pieces that each double the repeated part.
+                const u8* m = o - distance;
+                while(length != 0)
+                {
+                    usize k = ::std::min<usize>(length, usize(o - m));
+                    ::std::memcpy(o, m, k);
+                    o += k;
+                    length -= k;
+                }
+            }
+            return o == last;
+        }
+
+        // The platform layer: positional reads and writes that don't move any shared file
+        // position, so they can run from several threads at once, and read-only mappings.
+#if defined(_WIN32)
+        inline HANDLE native(file_handle f) noexcept { return reinterpret_cast<HANDLE>(f); }
+
+        file_handle open_file(const char* path, bool writable, bool create) noexcept
+        {
+            HANDLE h = ::CreateFileA(path, GENERIC_READ | (writable ? GENERIC_WRITE : 0), FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                     nullptr, create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            return reinterpret_cast<file_handle>(h);
+        }
+
+        inline void close_file(file_handle f) noexcept { ::CloseHandle(native(f)); }
+
+        inline bool file_size(file_handle f, u64& size) noexcept
+        {
+            LARGE_INTEGER n;
+            if(!::GetFileSizeEx(native(f), &n))
+                return false;
+            size = static_cast<u64>(n.QuadPart);
+            return true;
+        }
+
+        inline bool sync_file(file_handle f) noexcept { return ::FlushFileBuffers(native(f)) != 0; }
+
+        bool read_all(file_handle f, u8* p, usize n, u64 offset) noexcept
+        {
+            while(n != 0)
+            {
+                OVERLAPPED o {};
+                o.Offset = static_cast<DWORD>(offset);
+                o.OffsetHigh = static_cast<DWORD>(offset >> 32);
+                DWORD r = 0;
+                if(!::ReadFile(native(f), p, static_cast<DWORD>(::std::min<usize>(n, usize(1) << 30)), &r, &o) || r == 0)
+                    return false;
+                p += r;
+                n -= r;
+                offset += r;
+            }
+            return true;
+        }
+
+        bool write_all(file_handle f, const u8* p, usize n, u64 offset) noexcept
+        {
+            while(n != 0)
+            {
+                OVERLAPPED o {};
+                o.Offset = static_cast<DWORD>(offset);
+                o.OffsetHigh = static_cast<DWORD>(offset >> 32);
+                DWORD r = 0;
+                if(!::WriteFile(native(f), p, static_cast<DWORD>(::std::min<usize>(n, usize(1) << 30)), &r, &o) || r == 0)
+                    return false;
+                p += r;
+                n -= r;
+                offset += r;
+            }
+            return true;
+        }
+
+        const u8* map_file(file_handle f, usize size) noexcept
+        {
+            HANDLE m = ::CreateFileMappingA(native(f), nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(m == nullptr)
+                return nullptr;
+            void* p = ::MapViewOfFile(m, FILE_MAP_READ, 0, 0, size);
+            ::CloseHandle(m);
+            return static_cast<const u8*>(p);
+        }
+
+        inline void unmap_file(const u8* p, usize) noexcept { ::UnmapViewOfFile(p); }
+#else
+        file_handle open_file(const char* path, bool writable, bool create) noexcept
+        {
+            return ::open(path, (writable ? O_RDWR : O_RDONLY) | (create ? O_CREAT : 0), 0644);
+        }
+
+        inline void close_file(file_handle f) noexcept { ::close(static_cast<int>(f)); }
+
+        inline bool file_size(file_handle f, u64& size) noexcept
+        {
+            struct stat info;
+            if(::fstat(static_cast<int>(f), &info) != 0)
+                return false;
+            size = static_cast<u64>(info.st_size);
+            return true;
+        }
+
+        inline bool sync_file(file_handle f) noexcept { return ::fsync(static_cast<int>(f)) == 0; }
+
+        bool read_all(file_handle f, u8* p, usize n, u64 offset) noexcept
+        {
+            while(n != 0)
+            {
+                ssize_t r = ::pread(static_cast<int>(f), p, n, static_cast<off_t>(offset));
+                if(r <= 0)
+                    return false;
+                p += r;
+                n -= static_cast<usize>(r);
+                offset += static_cast<u64>(r);
+            }
+            return true;
+        }
+
+        bool write_all(file_handle f, const u8* p, usize n, u64 offset) noexcept
+        {
+            while(n != 0)
+            {
+                ssize_t r = ::pwrite(static_cast<int>(f), p, n, static_cast<off_t>(offset));
+                if(r <= 0)
+                    return false;
+                p += r;
+                n -= static_cast<usize>(r);
+                offset += static_cast<u64>(r);
+            }
+            return true;
+        }
+
+        const u8* map_file(file_handle f, usize size) noexcept
+        {
+            void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, static_cast<int>(f), 0);
+            return p != MAP_FAILED ? static_cast<const u8*>(p) : nullptr;
+        }
+
+        inline void unmap_file(const u8* p, usize size) noexcept { ::munmap(const_cast<u8*>(p), size); }
+#endif
+
+        inline bool valid_header(const u8* p) noexcept
+        {
+            return read_le<u32>(p) == magic && read_le<u32>(p + 4) == version && read_le<u32>(p + 8) == region_shift;
+        }
+
+        inline u32 sectors_for(u32 length) noexcept { return static_cast<u32>((u64(length) + sector_size - 1) / sector_size); }
+    };
+
+    void region_entry::encode(u8* out) const noexcept
+    {
+        write_le(out, length != 0 ? sector : 0);
+        write_le(out + 4, length);
+    }
+
+    void compress_chunk(const chunk& c, utils::array<u8>& out) noexcept
+    {
+        u8 width = c.bits_per_voxel();
+        utils::const_span<block> palette = c.palette();
+        usize entries = width == chunk::direct_bits ? 0 : width == 0 ? 1 : palette.size();
+
+        u8* header = out.push_uninitialized(4 + entries * sizeof(block)).data();
+        header[0] = width;
+        header[1] = 0;
+        write_le(header + 2, static_cast<u16>(entries));
+        for(usize i = 0; i != entries; i++)
+            write_le(header + 4 + i * sizeof(block), palette[i]);
+
+        utils::const_span<u64> words = c.words();
+        if(width == 0)
+            return;
+
+        if constexpr(::std::endian::native == ::std::endian::little)
+            lz_compress(reinterpret_cast<const u8*>(words.data()), words.size() * sizeof(u64), out);
+        else
+        {
+            utils::buffer<u64> swapped(words.size());
+            for(usize i = 0; i != words.size(); i++)
+                swapped[i] = swap_bytes(words[i]);
+            lz_compress(reinterpret_cast<const u8*>(swapped.data()), words.size() * sizeof(u64), out);
+        }
+    }
+
+    bool decompress_chunk(const utils::const_span<u8>& payload, chunk& c) noexcept
+    {
+        if(payload.size() < 4)
+        {
+            c.fill(air);
+            return false;
+        }
+
+        const u8* p = payload.data();
+        u8 width = p[0];
+        usize entries = read_le<u16>(p + 2);
+        bool valid = width == 0 ? entries == 1 :
+                     width == chunk::direct_bits ? entries == 0 :
+                     (width == 1 || width == 2 || width == 4 || width == 8) && entries != 0 && entries <= (usize(1) << width);
+        if(!valid || payload.size() < 4 + entries * sizeof(block))
+        {
+            c.fill(air);
+            return false;
+        }
+
+        block palette[chunk::max_palette_size];
+        for(usize i = 0; i != entries; i++)
+            palette[i] = read_le<block>(p + 4 + i * sizeof(block));
+
+        const u8* packed = p + 4 + entries * sizeof(block);
+        usize n = payload.size() - (4 + entries * sizeof(block));
+        utils::span<u64> words = c.assign_packed(utils::const_span<block>(palette, entries), width);
+        if(width == 0)
+            return c.recount();
+
+        if(!lz_decompress(packed, n, reinterpret_cast<u8*>(words.data()), words.size() * sizeof(u64)))
+        {
+            c.fill(air);
+            return false;
+        }
+
+        if constexpr(::std::endian::native == ::std::endian::big)
+            for(u64& w : words)
+                w = swap_bytes(w);
+        return c.recount();
+    }
+
+    region_file::region_file() noexcept :
+        table(region_volume), used(), scratch(), count(0), file(invalid_file)
+    {
+        ::std::memset(table.data(), 0, table_size);
+    }
+
+    region_file::~region_file() noexcept
+    {
+        close();
+    }
+
+    bool region_file::open(const char* path, bool create) noexcept
+    {
+        close();
+        file = open_file(path, true, create);
+        if(file == invalid_file)
+            return false;
+
+        u64 length;
+        if(!file_size(file, length))
+        {
+            close();
+            return false;
+        }
+
+        utils::buffer<u8> header(header_sectors * usize(sector_size));
+        ::std::memset(header.data(), 0, header.size());
+        if(length == 0)
+        {
+            // A new region: the header and an empty table.
+            write_le(header.data(), magic);
+            write_le(header.data() + 4, version);
+            write_le(header.data() + 8, region_shift);
+            if(!write_all(file, header.data(), header.size(), 0))
+            {
+                close();
+                return false;
+            }
+        }
+        else if(length < header_size + table_size ||
+                !read_all(file, header.data(), header_size + table_size, 0) || !valid_header(header.data()))
+        {
+            close();
+            return false;
+        }
+
+        used.clear();
+        count = 0;
+        mark(0, header_sectors, true);
+        for(u32 i = 0; i != region_volume; i++)
+        {
+            const u8* e = header.data() + header_size + i * sizeof(region_entry);
+            region_entry& t = table[i];
+            t = region_entry { read_le<u32>(e), read_le<u32>(e + 4) };
+            if(t.length != 0)
+            {
+                // Entries pointing into the header or past the end of the file, or longer
+                // than any payload, are corrupt, and dropped.
+                if(t.sector < header_sectors || t.length > max_payload_size || u64(t.sector) * sector_size + t.length > length)
+                    t = region_entry { 0, 0 };
+                else
+                    mark(t.sector, sectors_for(t.length), true);
+            }
+        }
+        return true;
+    }
+
+    void region_file::close() noexcept
+    {
+        if(file != invalid_file)
+            close_file(file);
+        file = invalid_file;
+        ::std::memset(table.data(), 0, table_size);
+        used.clear();
+        count = 0;
+    }
+
+    bool region_file::load(u32 i, chunk& c) noexcept
+    {
+        region_entry e = table[i];
+        if(file == invalid_file || e.length == 0 || e.length > max_payload_size)
+            return false;
+
+        scratch.clear();
+        u8* p = scratch.push_uninitialized(e.length).data();
+        if(!read_all(file, p, e.length, u64(e.sector) * sector_size))
+            return false;
+        return decompress_chunk(utils::const_span<u8>(p, e.length), c);
+    }
+
+    bool region_file::save(u32 i, const chunk& c) noexcept
+    {
+        scratch.clear();
+        compress_chunk(c, scratch);
+        return write(i, scratch);
+    }
+
+    bool region_file::write(u32 i, const utils::const_span<u8>& payload) noexcept
+    {
+        if(file == invalid_file)
+            return false;
+        if(payload.empty())
+            return erase(i);
+
+        u32 length = static_cast<u32>(payload.size());
+        u32 sector = allocate(length);
+        if(!write_all(file, payload.data(), length, u64(sector) * sector_size))
+        {
+            release(sector, length);
+            return false;
+        }
+        return commit(i, sector, length);
+    }
+
+    u32 region_file::allocate(u32 length) noexcept
+    {
+        // First fit, a word of the bitmap at a time past the full ones.
+        u64 n = sectors_for(length);
+        u64 run = 0;
+        for(u64 s = header_sectors; s < count; s++)
+        {
+            if((s & 63) == 0 && used[s >> 6] == ~u64(0))
+            {
+                run = 0;
+                s += 63;
+                continue;
+            }
+
+            run = (used[s >> 6] >> (s & 63)) & 1 ? 0 : run + 1;
+            if(run == n)
+            {
+                u32 first = static_cast<u32>(s + 1 - n);
+                mark(first, static_cast<u32>(n), true);
+                return first;
+            }
+        }
+
+        u32 first = static_cast<u32>(count - run);
+        mark(first, static_cast<u32>(n), true);
+        return first;
+    }
+
+    bool region_file::commit(u32 i, u32 sector, u32 length) noexcept
+    {
+        if(file == invalid_file)
+            return false;
+
+        u8 e[sizeof(region_entry)];
+        region_entry { sector, length }.encode(e);
+        if(!write_all(file, e, sizeof(e), region_entry::offset(i)))
+            return false;
+
+        update(i, sector, length);
+        return true;
+    }
+
+    void region_file::update(u32 i, u32 sector, u32 length) noexcept
+    {
+        region_entry old = table[i];
+        table[i] = region_entry { length != 0 ? sector : 0, length };
+        if(old.length != 0)
+            mark(old.sector, sectors_for(old.length), false);
+    }
+
+    void region_file::release(u32 sector, u32 length) noexcept
+    {
+        mark(sector, sectors_for(length), false);
+    }
+
+    bool region_file::sync() noexcept
+    {
+        return file != invalid_file && sync_file(file);
+    }
+
+    bool region_file::read_at(u8* p, usize n, u64 offset) const noexcept
+    {
+        return file != invalid_file && read_all(file, p, n, offset);
+    }
+
+    bool region_file::write_at(const u8* p, usize n, u64 offset) noexcept
+    {
+        return file != invalid_file && write_all(file, p, n, offset);
+    }
+
+    void region_file::mark(u32 first, u32 n, bool in_use) noexcept
+    {
+        u64 end = u64(first) + n;
+        if(end > count)
+        {
+            count = static_cast<u32>(end);
+            while(used.size() * 64 < end)
+                used.push(0);
+        }
+
+        for(u64 s = first; s != end; s++)
+            if(in_use)
+                used[s >> 6] |= u64(1) << (s & 63);
+            else
+                used[s >> 6] &= ~(u64(1) << (s & 63));
+
+        // The free sectors at the end of the file don't count.
+        if(!in_use)
+            while(count > header_sectors && !((used[(count - 1) >> 6] >> ((count - 1) & 63)) & 1))
+                count--;
+    }
+
+    region_reader::region_reader() noexcept :
+        base(nullptr), size(0)
+    {
+    }
+
+    region_reader::~region_reader() noexcept
+    {
+        close();
+    }
+
+    bool region_reader::open(const char* path) noexcept
+    {
+        close();
+        file_handle f = open_file(path, false, false);
+        if(f == invalid_file)
+            return false;
+
+        u64 length;
+        if(!file_size(f, length) || length < header_size + table_size)
+        {
+            close_file(f);
+            return false;
+        }
+
+        // The mapping outlives the file handle.
+        const u8* p = map_file(f, static_cast<usize>(length));
+        close_file(f);
+        if(p == nullptr)
+            return false;
+
+        base = p;
+        size = static_cast<usize>(length);
+        if(!valid_header(base))
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void region_reader::close() noexcept
+    {
+        if(base != nullptr)
+            unmap_file(base, size);
+        base = nullptr;
+        size = 0;
+    }
+
+    utils::const_span<u8> region_reader::payload(u32 i) const noexcept
+    {
+        if(base == nullptr)
+            return utils::const_span<u8>();
+
+        const u8* e = base + region_entry::offset(i);
+        u64 offset = u64(read_le<u32>(e)) * sector_size;
+        u32 length = read_le<u32>(e + 4);
+        if(length == 0 || offset < u64(header_sectors) * sector_size || offset + length > size)
+            return utils::const_span<u8>();
+        return utils::const_span<u8>(base + offset, length);
+    }
+};
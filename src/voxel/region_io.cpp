@@ -0,0 +1,399 @@
+#include <voxel/region_io.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define VOXEL_REGION_IO_URING 1
+#endif
+
+namespace voxel
+{
+    namespace
+    {
+        /// The completions of the write of a payload and of its entry are told apart by the
+        /// lowest bit of their user data.
+        constexpr u64 entry_bit = 1;
+
+        template<typename type>
+        inline ::std::atomic_ref<type> shared(type* p) noexcept
+        {
+            return ::std::atomic_ref<type>(*p);
+        }
+    };
+
+    region_io::region_io(u32 depth, u32 threads, bool prefer_io_uring) noexcept :
+        buffers(depth), operations(depth), free(depth), queue(), in_flight(0), uring(), mode(backend::threads),
+        workers(), runnable(depth), done(depth), epoch(0), finished(0), stopping(false)
+    {
+        for(u32 i = 0; i != depth; i++)
+        {
+            buffers.push(buffer_size);
+            operations.push();
+            free.push(depth - 1 - i);
+        }
+
+        uring.fd = -1;
+        if(prefer_io_uring && start_ring())
+            mode = backend::io_uring;
+        else
+            start_threads(threads == 0 ? 1 : threads);
+    }
+
+    region_io::~region_io() noexcept
+    {
+        wait();
+        stop_ring();
+        stop_threads();
+    }
+
+    bool region_io::read(region_file& r, u32 i, io_callback f, void* user) noexcept
+    {
+        if(!r.is_open() || !r.contains(i))
+            return false;
+
+        queue.push_back(request { &r, utils::array<u8>(), f, user, i, false });
+        return true;
+    }
+
+    void region_io::write(region_file& r, u32 i, utils::array<u8>&& payload, io_callback f, void* user) noexcept
+    {
+        queue.push_back(request { &r, ::std::move(payload), f, user, i, true });
+    }
+
+    usize region_io::poll() noexcept
+    {
+        usize n = reap(false);
+        return n + submit();
+    }
+
+    void region_io::wait() noexcept
+    {
+        while(pending() != 0)
+        {
+            submit();
+            if(in_flight != 0)
+                reap(true);
+        }
+    }
+
+    usize region_io::submit() noexcept
+    {
+        // Operations that can't be started finish right away, once the batch is submitted.
+        u32 failed[64];
+        usize failures = 0, started = 0;
+        while(!queue.empty() && !free.empty() && failures != 64)
+        {
+            u32 slot = free.back();
+            free.pop();
+            request& r = queue.front();
+            operation& op = operations[slot];
+            op = operation { r.region, r.callback, r.user, r.index, 0, 0, 0, 0, r.write };
+
+            // Reads look their chunk up now, to see the writes finished since they were queued.
+            bool valid = r.region->is_open();
+            if(r.write)
+            {
+                valid = valid && r.payload.size() <= max_payload_size;
+                if(valid)
+                {
+                    op.length = static_cast<u32>(r.payload.size());
+                    op.sector = op.length != 0 ? r.region->allocate(op.length) : 0;
+                    u8* p = buffers[slot].data();
+                    ::std::memcpy(p, r.payload.data(), op.length);
+                    region_entry { op.sector, op.length }.encode(p + buffer_size - sizeof(region_entry));
+                }
+            }
+            else
+            {
+                region_entry e = r.region->entry(r.index);
+                valid = valid && e.length != 0 && e.length <= max_payload_size;
+                op.sector = e.sector;
+                op.length = e.length;
+            }
+            queue.pop_front();
+            in_flight++;
+
+            if(!valid)
+            {
+                op.error = -EINVAL;
+                op.length = op.write ? 0 : op.length;
+                failed[failures++] = slot;
+                continue;
+            }
+
+            start(slot);
+            started++;
+        }
+
+#ifdef VOXEL_REGION_IO_URING
+        if(mode == backend::io_uring && started != 0)
+        {
+            u32 count = shared(uring.sq_tail).load(::std::memory_order_relaxed) - shared(uring.sq_head).load(::std::memory_order_acquire);
+            while(count != 0)
+            {
+                long r = ::syscall(__NR_io_uring_enter, uring.fd, count, 0, 0, nullptr, 0);
+                if(r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                    break;
+                if(r > 0)
+                    count -= static_cast<u32>(r);
+            }
+        }
+#endif
+
+        for(usize i = 0; i != failures; i++)
+            finish(failed[i]);
+        return failures;
+    }
+
+    void region_io::start(u32 slot) noexcept
+    {
+        operation& op = operations[slot];
+        op.waiting = op.write ? (op.length != 0 ? 2 : 1) : 1;
+
+#ifdef VOXEL_REGION_IO_URING
+        if(mode == backend::io_uring)
+        {
+            u8* p = buffers[slot].data();
+            int fd = static_cast<int>(op.region->handle());
+            u32 tail = shared(uring.sq_tail).load(::std::memory_order_relaxed);
+            io_uring_sqe* sqes = static_cast<io_uring_sqe*>(uring.entries);
+            auto push = [&](u8 opcode, u8* address, u32 length, u64 offset, u64 data, u8 flags) {
+                u32 i = tail & *uring.sq_mask;
+                io_uring_sqe& sqe = sqes[i];
+                ::std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = opcode;
+                sqe.flags = flags;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<u64>(address);
+                sqe.len = length;
+                sqe.off = offset;
+                sqe.buf_index = static_cast<u16>(slot);
+                sqe.user_data = data;
+                uring.sq_array[i] = i;
+                tail++;
+            };
+
+            u64 data = u64(slot) << 1;
+            if(!op.write)
+                push(IORING_OP_READ_FIXED, p, op.length, u64(op.sector) * sector_size, data, 0);
+            else
+            {
+                // The entry is written only if the payload was, fully.
+                if(op.length != 0)
+                    push(IORING_OP_WRITE_FIXED, p, op.length, u64(op.sector) * sector_size, data, IOSQE_IO_LINK);
+                push(IORING_OP_WRITE_FIXED, p + buffer_size - sizeof(region_entry), sizeof(region_entry),
+                     region_entry::offset(op.index), data | entry_bit, 0);
+            }
+            shared(uring.sq_tail).store(tail, ::std::memory_order_release);
+            return;
+        }
+#endif
+
+        runnable.try_push(slot);
+        epoch.fetch_add(1, ::std::memory_order_release);
+        epoch.notify_one();
+    }
+
+    usize region_io::reap(bool block) noexcept
+    {
+        usize count = 0;
+#ifdef VOXEL_REGION_IO_URING
+        if(mode == backend::io_uring)
+        {
+            u32 head = shared(uring.cq_head).load(::std::memory_order_relaxed);
+            if(block && head == shared(uring.cq_tail).load(::std::memory_order_acquire))
+                ::syscall(__NR_io_uring_enter, uring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+            u32 tail = shared(uring.cq_tail).load(::std::memory_order_acquire);
+            const io_uring_cqe* cqes = static_cast<const io_uring_cqe*>(uring.cqes);
+            for(; head != tail; head++)
+            {
+                const io_uring_cqe& cqe = cqes[head & *uring.cq_mask];
+                u32 slot = static_cast<u32>(cqe.user_data >> 1);
+                operation& op = operations[slot];
+                u32 expected = cqe.user_data & entry_bit ? sizeof(region_entry) : op.length;
+                if(op.error == 0 && cqe.res != static_cast<i32>(expected))
+                    op.error = cqe.res < 0 ? cqe.res : -EIO;
+                if(--op.waiting == 0)
+                {
+                    // The slot may be reused by a callback, so the head moves first.
+                    shared(uring.cq_head).store(head + 1, ::std::memory_order_release);
+                    finish(slot);
+                    count++;
+                }
+            }
+            shared(uring.cq_head).store(head, ::std::memory_order_release);
+            return count;
+        }
+#endif
+
+        u32 slot;
+        u32 seen = finished.load(::std::memory_order_acquire);
+        if(block && !done.try_pop(slot))
+        {
+            while(finished.load(::std::memory_order_acquire) == seen)
+                finished.wait(seen, ::std::memory_order_acquire);
+        }
+        else if(block)
+        {
+            finish(slot);
+            count++;
+        }
+
+        while(done.try_pop(slot))
+        {
+            finish(slot);
+            count++;
+        }
+        return count;
+    }
+
+    void region_io::finish(u32 slot) noexcept
+    {
+        operation& op = operations[slot];
+        bool ok = op.error == 0;
+        if(op.write)
+        {
+            if(ok)
+                op.region->update(op.index, op.sector, op.length);
+            else if(op.length != 0)
+                op.region->release(op.sector, op.length);
+        }
+
+        io_completion c { op.region, op.index, ok, utils::const_span<u8>(), op.user };
+        if(!op.write && ok)
+            c.payload = utils::const_span<u8>(buffers[slot].data(), op.length);
+        if(op.callback != nullptr)
+            op.callback(c);
+
+        in_flight--;
+        free.push(slot);
+    }
+
+    void region_io::work() noexcept
+    {
+        while(true)
+        {
+            u32 e = epoch.load(::std::memory_order_acquire);
+            u32 slot;
+            if(!runnable.try_pop(slot))
+            {
+                if(stopping.load(::std::memory_order_acquire))
+                    return;
+                epoch.wait(e, ::std::memory_order_acquire);
+                continue;
+            }
+
+            // The positional reads and writes of region_file are safe to run side by side.
+            operation& op = operations[slot];
+            u8* p = buffers[slot].data();
+            bool ok;
+            if(!op.write)
+                ok = op.region->read_at(p, op.length, u64(op.sector) * sector_size);
+            else
+                ok = op.region->write_at(p, op.length, u64(op.sector) * sector_size) &&
+                     op.region->write_at(p + buffer_size - sizeof(region_entry), sizeof(region_entry), region_entry::offset(op.index));
+            op.error = ok ? 0 : -EIO;
+
+            done.try_push(slot);
+            finished.fetch_add(1, ::std::memory_order_release);
+            finished.notify_all();
+        }
+    }
+
+    bool region_io::start_ring() noexcept
+    {
+#ifdef VOXEL_REGION_IO_URING
+        // Every operation takes at most two entries: a payload and its table entry.
+        io_uring_params params;
+        ::std::memset(&params, 0, sizeof(params));
+        long fd = ::syscall(__NR_io_uring_setup, static_cast<u32>(2 * buffers.size()), &params);
+        if(fd < 0)
+            return false;
+
+        uring.fd = static_cast<int>(fd);
+        uring.sq_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        uring.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if(single)
+            uring.sq_size = uring.cq_size = uring.sq_size > uring.cq_size ? uring.sq_size : uring.cq_size;
+
+        uring.sq_ring = ::mmap(nullptr, uring.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.fd, IORING_OFF_SQ_RING);
+        uring.cq_ring = single ? uring.sq_ring :
+                        ::mmap(nullptr, uring.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.fd, IORING_OFF_CQ_RING);
+        uring.entries_size = params.sq_entries * sizeof(io_uring_sqe);
+        uring.entries = ::mmap(nullptr, uring.entries_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring.fd, IORING_OFF_SQES);
+        if(uring.sq_ring == MAP_FAILED || uring.cq_ring == MAP_FAILED || uring.entries == MAP_FAILED)
+        {
+            stop_ring();
+            return false;
+        }
+
+        u8* sq = static_cast<u8*>(uring.sq_ring);
+        u8* cq = static_cast<u8*>(uring.cq_ring);
+        uring.sq_head = reinterpret_cast<u32*>(sq + params.sq_off.head);
+        uring.sq_tail = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+        uring.sq_mask = reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+        uring.sq_array = reinterpret_cast<u32*>(sq + params.sq_off.array);
+        uring.cq_head = reinterpret_cast<u32*>(cq + params.cq_off.head);
+        uring.cq_tail = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+        uring.cq_mask = reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+        uring.cqes = cq + params.cq_off.cqes;
+        uring.sq_entries = params.sq_entries;
+
+        // Registered once, the buffers stay pinned instead of being mapped for every operation.
+        utils::array<iovec> vectors(buffers.size());
+        for(utils::buffer<u8>& b : buffers)
+            vectors.push(iovec { b.data(), b.size() });
+        if(::syscall(__NR_io_uring_register, uring.fd, IORING_REGISTER_BUFFERS, vectors.data(), static_cast<u32>(vectors.size())) < 0)
+        {
+            stop_ring();
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void region_io::stop_ring() noexcept
+    {
+#ifdef VOXEL_REGION_IO_URING
+        if(uring.fd < 0)
+            return;
+
+        if(uring.entries != nullptr && uring.entries != MAP_FAILED)
+            ::munmap(uring.entries, uring.entries_size);
+        if(uring.cq_ring != nullptr && uring.cq_ring != MAP_FAILED && uring.cq_ring != uring.sq_ring)
+            ::munmap(uring.cq_ring, uring.cq_size);
+        if(uring.sq_ring != nullptr && uring.sq_ring != MAP_FAILED)
+            ::munmap(uring.sq_ring, uring.sq_size);
+        ::close(uring.fd);
+        uring = ring();
+        uring.fd = -1;
+#endif
+    }
+
+    void region_io::start_threads(u32 threads) noexcept
+    {
+        workers.reserve(threads);
+        for(u32 i = 0; i != threads; i++)
+            workers.push(::std::thread([this]() { work(); }));
+    }
+
+    void region_io::stop_threads() noexcept
+    {
+        stopping.store(true, ::std::memory_order_release);
+        epoch.fetch_add(1, ::std::memory_order_release);
+        epoch.notify_all();
+        for(::std::thread& t : workers)
+            t.join();
+        workers.clear();
+    }
+};
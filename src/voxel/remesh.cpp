@@ -0,0 +1,212 @@
+#include <voxel/remesh.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace voxel
+{
+    namespace
+    {
+        /// Past this many dirty groups, meshing the whole chunk is cheaper than patching.
+        constexpr usize patch_limit = mesher::group_count / 8;
+
+        constexpr u32 all_slices = ~u32(0);
+    };
+
+    chunk_mesh::chunk_mesh() noexcept :
+        data()
+    {
+        ::std::memset(ends, 0, sizeof(ends));
+        mark_all();
+    }
+
+    void chunk_mesh::mark(local_coord c) noexcept
+    {
+        // The faces toward +axis of a slice look at the next slice, the faces toward -axis
+        // at the previous one, so an edit also changes the faces of one neighboring slice.
+        u32 coords[3] = { c.x, c.y, c.z };
+        for(u32 axis = 0; axis != 3; axis++)
+        {
+            u32 s = coords[axis];
+            slices[2 * axis] |= (u32(1) << s) | (s != 0 ? u32(1) << (s - 1) : 0);
+            slices[2 * axis + 1] |= (u32(1) << s) | (s != chunk_size - 1 ? u32(1) << (s + 1) : 0);
+        }
+    }
+
+    void chunk_mesh::mark_all() noexcept
+    {
+        for(u32& s : slices)
+            s = all_slices;
+    }
+
+    bool chunk_mesh::dirty() const noexcept
+    {
+        u32 any = 0;
+        for(u32 s : slices)
+            any |= s;
+        return any != 0;
+    }
+
+    void chunk_mesh::update(mesher& m) noexcept
+    {
+        usize count = 0;
+        for(u32 s : slices)
+            count += static_cast<usize>(::std::popcount(s));
+        if(count == 0)
+            return;
+
+        if(count > patch_limit)
+        {
+            data.clear();
+            m.mesh(data, utils::span<u32>(ends, mesher::group_count));
+        }
+        else
+            for(u32 f = 0; f != face_count; f++)
+                for(u32 bits = slices[f]; bits != 0; bits &= bits - 1)
+                {
+                    u32 s = static_cast<u32>(::std::countr_zero(bits));
+                    usize tail = data.size();
+                    m.mesh_slice(static_cast<face>(f), s, data);
+                    splice(f * chunk_size + s, tail);
+                }
+
+        for(u32& s : slices)
+            s = 0;
+    }
+
+    void chunk_mesh::splice(usize g, usize tail) noexcept
+    {
+        // The new quads of the group were appended at tail; move them over the old ones,
+        // shifting the groups in between by the difference in size.
+        usize first = g == 0 ? 0 : ends[g - 1];
+        usize last = ends[g];
+        usize added = data.size() - tail;
+        usize removed = last - first;
+
+        if(added > removed)
+        {
+            usize d = added - removed;
+            data.push_uninitialized(d);
+            quad* q = data.data();
+            ::std::memmove(q + tail + d, q + tail, added * sizeof(quad));
+            ::std::memmove(q + last + d, q + last, (tail - last) * sizeof(quad));
+            ::std::memcpy(q + first, q + tail + d, added * sizeof(quad));
+            data.pop_many(added);
+        }
+        else
+        {
+            usize d = removed - added;
+            quad* q = data.data();
+            ::std::memmove(q + last - d, q + last, (tail - last) * sizeof(quad));
+            ::std::memcpy(q + first, q + tail, added * sizeof(quad));
+            data.pop_many(added + d);
+        }
+
+        u32 delta = static_cast<u32>(added - removed);
+        for(usize h = g; h != mesher::group_count; h++)
+            ends[h] += delta;
+    }
+
+    remesher::remesher(chunk_map<chunk>& chunks) noexcept :
+        chunks(chunks), meshes(), queue(), m()
+    {
+    }
+
+    void remesher::changed(const chunk_coord& c, local_coord v) noexcept
+    {
+        if(chunk_mesh* mesh = touch(c))
+            mesh->mark(v);
+
+        // Only the layer of a neighbor that touches the voxel sees its faces change.
+        constexpr u32 last = chunk_size - 1;
+        if(v.x == 0)
+            if(chunk_mesh* mesh = touch(chunk_coord { c.x - 1, c.y, c.z }))
+                mesh->mark(face::pos_x, last);
+        if(v.x == last)
+            if(chunk_mesh* mesh = touch(chunk_coord { c.x + 1, c.y, c.z }))
+                mesh->mark(face::neg_x, 0);
+        if(v.y == 0)
+            if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y - 1, c.z }))
+                mesh->mark(face::pos_y, last);
+        if(v.y == last)
+            if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y + 1, c.z }))
+                mesh->mark(face::neg_y, 0);
+        if(v.z == 0)
+            if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y, c.z - 1 }))
+                mesh->mark(face::pos_z, last);
+        if(v.z == last)
+            if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y, c.z + 1 }))
+                mesh->mark(face::neg_z, 0);
+    }
+
+    void remesher::changed(const chunk_coord& c) noexcept
+    {
+        if(chunk_mesh* mesh = touch(c))
+            mesh->mark_all();
+
+        constexpr u32 last = chunk_size - 1;
+        if(chunk_mesh* mesh = touch(chunk_coord { c.x - 1, c.y, c.z }))
+            mesh->mark(face::pos_x, last);
+        if(chunk_mesh* mesh = touch(chunk_coord { c.x + 1, c.y, c.z }))
+            mesh->mark(face::neg_x, 0);
+        if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y - 1, c.z }))
+            mesh->mark(face::pos_y, last);
+        if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y + 1, c.z }))
+            mesh->mark(face::neg_y, 0);
+        if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y, c.z - 1 }))
+            mesh->mark(face::pos_z, last);
+        if(chunk_mesh* mesh = touch(chunk_coord { c.x, c.y, c.z + 1 }))
+            mesh->mark(face::neg_z, 0);
+    }
+
+    usize remesher::update(usize budget) noexcept
+    {
+        chunk* around[chunk_map<chunk>::neighborhood_size];
+        const chunk* loaded[chunk_map<chunk>::neighborhood_size];
+
+        usize meshed = 0;
+        while(meshed != budget && !queue.empty())
+        {
+            chunk_coord c = queue.front();
+            queue.pop_front();
+
+            chunk_mesh* mesh = meshes.get(c);
+            if(mesh == nullptr || !mesh->dirty())
+                continue;
+
+            if(!chunks.contains(c))
+            {
+                meshes.erase(c);
+                continue;
+            }
+
+            chunks.neighbors(c, utils::span<chunk*>(around, chunk_map<chunk>::neighborhood_size));
+            for(usize i = 0; i != chunk_map<chunk>::neighborhood_size; i++)
+                loaded[i] = around[i];
+
+            m.load(utils::const_span<const chunk*>(loaded, chunk_map<chunk>::neighborhood_size));
+            mesh->update(m);
+            meshed++;
+        }
+
+        return meshed;
+    }
+
+    chunk_mesh* remesher::touch(const chunk_coord& c) noexcept
+    {
+        chunk_mesh* mesh = meshes.get(c);
+        if(mesh == nullptr)
+        {
+            // Chunks that aren't loaded have nothing to mesh.
+            if(!chunks.contains(c))
+                return nullptr;
+
+            mesh = &meshes[meshes.insert(c)];
+            queue.push_back(c);
+        }
+        else if(!mesh->dirty())
+            queue.push_back(c);
+
+        return mesh;
+    }
+};
@@ -0,0 +1,274 @@
+#include <voxel/streaming.hpp>
+
+#include <cmath>
+
+namespace voxel
+{
+    namespace
+    {
+        /// How much further the chunks right behind an observer count, over the ones in front.
+        constexpr f32 behind_weight = 1.0f;
+
+        inline i64 distance2(const chunk_coord& a, const chunk_coord& b) noexcept
+        {
+            i64 dx = i64(a.x) - b.x, dy = i64(a.y) - b.y, dz = i64(a.z) - b.z;
+            return dx * dx + dy * dy + dz * dz;
+        }
+
+        inline chunk_coord chunk_of(const observer& o) noexcept
+        {
+            return chunk_coord::containing(i32(::std::floor(o.x)), i32(::std::floor(o.y)), i32(::std::floor(o.z)));
+        }
+    };
+
+    streamer::streamer(const stream_budget& b) noexcept :
+        entries(), heaps(), centers(), views(), scratch(), budget(b), active(0)
+    {
+        left[0] = budget.loads;
+        left[1] = budget.generations;
+        left[2] = budget.meshes;
+    }
+
+    void streamer::update(const utils::const_span<observer>& observers, utils::array<chunk_coord>& unloads) noexcept
+    {
+        left[0] = budget.loads;
+        left[1] = budget.generations;
+        left[2] = budget.meshes;
+
+        bool moved = observers.size() != centers.size();
+        for(usize i = 0; !moved && i != observers.size(); i++)
+            moved = !(chunk_of(observers[i]) == centers[i].coord) || observers[i].radius != centers[i].radius;
+
+        views.clear();
+        views.push_many(observers);
+        if(moved)
+        {
+            centers.clear();
+            for(const observer& o : observers)
+                centers.push(center { chunk_of(o), o.radius });
+            rescan(unloads);
+        }
+
+        // Observers turn every frame, so every waiting task is ordered again.
+        for(utils::array<node>& heap : heaps)
+        {
+            for(node& n : heap)
+                n.priority = priority(entries[n.index].coord);
+            for(usize i = heap.size() / 2; i-- != 0;)
+                sift_down(heap, i);
+        }
+    }
+
+    usize streamer::schedule(stream_task t, utils::array<chunk_coord>& out) noexcept
+    {
+        utils::array<node>& heap = heaps[static_cast<usize>(t)];
+        usize n = ::std::min<usize>(left[static_cast<usize>(t)], heap.size());
+        for(usize k = 0; k != n; k++)
+        {
+            entry& e = entries[heap[0].index];
+            e.state = phase::running;
+            out.push(e.coord);
+
+            heap[0] = heap.back();
+            heap.pop();
+            if(!heap.empty())
+                sift_down(heap, 0);
+        }
+
+        left[static_cast<usize>(t)] -= static_cast<u32>(n);
+        active += n;
+        return n;
+    }
+
+    bool streamer::loaded(const chunk_coord& c, bool found) noexcept
+    {
+        entry* e = complete(c, stream_task::load);
+        if(e == nullptr)
+            return false;
+
+        stream_task next = found ? stream_task::mesh : stream_task::generate;
+        e->task = next;
+        enqueue(entries.find(c), next, priority(c));
+        return true;
+    }
+
+    bool streamer::generated(const chunk_coord& c) noexcept
+    {
+        entry* e = complete(c, stream_task::generate);
+        if(e == nullptr)
+            return false;
+
+        e->task = stream_task::mesh;
+        enqueue(entries.find(c), stream_task::mesh, priority(c));
+        return true;
+    }
+
+    bool streamer::meshed(const chunk_coord& c) noexcept
+    {
+        entry* e = complete(c, stream_task::mesh);
+        if(e == nullptr)
+            return false;
+
+        e->state = phase::ready;
+        return true;
+    }
+
+    bool streamer::ready(const chunk_coord& c) const noexcept
+    {
+        const entry* e = entries.get(c);
+        return e != nullptr && e->state == phase::ready;
+    }
+
+    streamer::entry* streamer::complete(const chunk_coord& c, stream_task t) noexcept
+    {
+        entry* e = entries.get(c);
+        if(e == nullptr || e->task != t || (e->state != phase::running && e->state != phase::cancelled))
+            return nullptr;
+
+        active--;
+        if(e->state == phase::cancelled)
+        {
+            entries.erase(c);
+            return nullptr;
+        }
+        return e;
+    }
+
+    void streamer::enqueue(index_type i, stream_task t, f32 p) noexcept
+    {
+        utils::array<node>& heap = heaps[static_cast<usize>(t)];
+        entries[i].state = phase::waiting;
+        heap.push(node { p, i });
+        sift_up(heap, heap.size() - 1);
+    }
+
+    bool streamer::in_range(const chunk_coord& c) const noexcept
+    {
+        for(const center& o : centers)
+        {
+            i64 keep = i64(o.radius) + 1;
+            if(distance2(c, o.coord) <= keep * keep)
+                return true;
+        }
+        return false;
+    }
+
+    f32 streamer::priority(const chunk_coord& c) const noexcept
+    {
+        f32 best = INFINITY;
+        for(const observer& o : views)
+        {
+            f32 dx = (f32(c.x) + 0.5f) * chunk_size - o.x;
+            f32 dy = (f32(c.y) + 0.5f) * chunk_size - o.y;
+            f32 dz = (f32(c.z) + 0.5f) * chunk_size - o.z;
+            f32 d = ::std::sqrt(dx * dx + dy * dy + dz * dz);
+
+            // The cosine of the angle between the view and the chunk, 1 when looking at it.
+            f32 along = ::std::sqrt(o.dir_x * o.dir_x + o.dir_y * o.dir_y + o.dir_z * o.dir_z);
+            f32 cosine = 1.0f;
+            if(d * along > 0.0f)
+                cosine = (dx * o.dir_x + dy * o.dir_y + dz * o.dir_z) / (d * along);
+
+            f32 p = d / chunk_size * (1.0f + behind_weight * 0.5f * (1.0f - cosine));
+            best = ::std::min(best, p);
+        }
+        return best;
+    }
+
+    void streamer::rescan(utils::array<chunk_coord>& unloads) noexcept
+    {
+        // Waiting tasks out of range are cancelled by leaving their heap. Chunks waiting to
+        // be meshed already hold the blocks the caller loaded or generated, so they unload.
+        for(usize t = 0; t != stream_task_count; t++)
+        {
+            utils::array<node>& heap = heaps[t];
+            usize kept = 0;
+            for(usize k = 0; k != heap.size(); k++)
+            {
+                chunk_coord c = entries[heap[k].index].coord;
+                if(in_range(c))
+                    heap[kept++] = heap[k];
+                else
+                {
+                    if(static_cast<stream_task>(t) == stream_task::mesh)
+                        unloads.push(c);
+                    entries.erase(c);
+                }
+            }
+            heap.pop_many(heap.size() - kept);
+        }
+
+        scratch.clear();
+        entries.for_each([&](const chunk_coord& c, index_type) {
+            if(!in_range(c))
+                scratch.push(c);
+        });
+        for(const chunk_coord& c : scratch)
+        {
+            entry* e = entries.get(c);
+            if(e->state == phase::running)
+                e->state = phase::cancelled;
+            else if(e->state == phase::ready)
+            {
+                unloads.push(c);
+                entries.erase(c);
+            }
+        }
+
+        for(const center& o : centers)
+        {
+            i32 r = static_cast<i32>(o.radius);
+            for(i32 dz = -r; dz <= r; dz++)
+                for(i32 dy = -r; dy <= r; dy++)
+                    for(i32 dx = -r; dx <= r; dx++)
+                    {
+                        if(dx * dx + dy * dy + dz * dz > r * r)
+                            continue;
+
+                        chunk_coord c { o.coord.x + dx, o.coord.y + dy, o.coord.z + dz };
+                        index_type i = entries.find(c);
+                        if(i == chunk_map<entry>::none)
+                        {
+                            // Ordered with the others once the scan is done.
+                            i = entries.insert(c, entry { c, stream_task::load, phase::waiting });
+                            heaps[0].push(node { 0.0f, i });
+                        }
+                        else if(entries[i].state == phase::cancelled)
+                            entries[i].state = phase::running;
+                    }
+        }
+    }
+
+    void streamer::sift_up(utils::array<node>& heap, usize i) noexcept
+    {
+        node n = heap[i];
+        while(i != 0)
+        {
+            usize parent = (i - 1) / 2;
+            if(heap[parent].priority <= n.priority)
+                break;
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = n;
+    }
+
+    void streamer::sift_down(utils::array<node>& heap, usize i) noexcept
+    {
+        node n = heap[i];
+        usize size = heap.size();
+        while(true)
+        {
+            usize child = 2 * i + 1;
+            if(child >= size)
+                break;
+            if(child + 1 < size && heap[child + 1].priority < heap[child].priority)
+                child++;
+            if(n.priority <= heap[child].priority)
+                break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = n;
+    }
+};
@@ -0,0 +1,209 @@
+#include <voxel/visibility.hpp>
+
+namespace voxel
+{
+    namespace
+    {
+        constexpr u32 side = chunk_size;
+        constexpr u32 rows = side * side;
+
+        /// The mask of the connections between every pair of a set of faces.
+        constexpr u16 pairs_of(u32 faces) noexcept
+        {
+            u16 mask = 0;
+            for(u32 a = 0; a != face_count; a++)
+                for(u32 b = a + 1; b != face_count; b++)
+                    if((faces >> a) & (faces >> b) & 1)
+                        mask = static_cast<u16>(mask | (1 << face_pair(face(a), face(b))));
+            return mask;
+        }
+
+        struct pair_table
+        {
+            u16 masks[1 << face_count];
+
+            constexpr pair_table() noexcept :
+                masks()
+            {
+                for(u32 f = 0; f != 1 << face_count; f++)
+                    masks[f] = pairs_of(f);
+            }
+        };
+
+        constexpr pair_table pairs;
+
+        /// Spreads the bits of a row along the runs of bits of another it lies in, both
+        /// ways, with Kogge-Stone fills.
+        inline u32 fill(u32 seeds, u32 free) noexcept
+        {
+            u32 up = seeds, down = seeds, p = free, q = free;
+            up |= p & (up << 1);
+            p &= p << 1;
+            up |= p & (up << 2);
+            p &= p << 2;
+            up |= p & (up << 4);
+            p &= p << 4;
+            up |= p & (up << 8);
+            p &= p << 8;
+            up |= p & (up << 16);
+            down |= q & (down >> 1);
+            q &= q >> 1;
+            down |= q & (down >> 2);
+            q &= q >> 2;
+            down |= q & (down >> 4);
+            q &= q >> 4;
+            down |= q & (down >> 8);
+            q &= q >> 8;
+            down |= q & (down >> 16);
+            return up | down;
+        }
+
+        /// The faces touched by a set of voxels of a row.
+        inline u32 faces_of(u32 row, u32 bits) noexcept
+        {
+            u32 y = row & (chunk_size - 1), z = row / chunk_size;
+            u32 faces = 0;
+            faces |= (bits >> (chunk_size - 1)) << static_cast<u32>(face::pos_x);
+            faces |= (bits & 1) << static_cast<u32>(face::neg_x);
+            faces |= u32(y == chunk_size - 1) << static_cast<u32>(face::pos_y);
+            faces |= u32(y == 0) << static_cast<u32>(face::neg_y);
+            faces |= u32(z == chunk_size - 1) << static_cast<u32>(face::pos_z);
+            faces |= u32(z == 0) << static_cast<u32>(face::neg_z);
+            return faces;
+        }
+    };
+
+    u16 face_connections(const chunk_occupancy& o) noexcept
+    {
+        if(o.empty())
+            return all_connected;
+        if(o.full())
+            return 0;
+
+        // The rows are indexed by z * chunk_size + y like the occupancy. pending holds the
+        // voxels of every queued row reached since it was last spread.
+        u32 free[rows], reached[rows], pending[rows];
+        for(u32 r = 0; r != rows; r++)
+        {
+            free[r] = ~o.row(r & (chunk_size - 1), r / chunk_size);
+            reached[r] = 0;
+            pending[r] = 0;
+        }
+
+        thread_local utils::ring_buffer<u16> queue(rows);
+        u16 connections = 0;
+        for(u32 r = 0; r != rows; r++)
+        {
+            // Rows on the y and z faces start regions anywhere, the others at their ends.
+            u32 y = r & (chunk_size - 1), z = r / chunk_size;
+            bool border = y == 0 || y == chunk_size - 1 || z == 0 || z == chunk_size - 1;
+            u32 seeds = free[r] & ~reached[r] & (border ? ~u32(0) : 0x80000001);
+            while(seeds != 0)
+            {
+                u32 start = fill(seeds & -seeds, free[r]);
+                reached[r] |= start;
+                pending[r] = start;
+                queue.push_back(static_cast<u16>(r));
+                seeds &= ~start;
+
+                u32 faces = 0;
+                while(!queue.empty())
+                {
+                    u32 row = queue.front();
+                    queue.pop_front();
+                    u32 bits = pending[row];
+                    pending[row] = 0;
+                    faces |= faces_of(row, bits);
+
+                    u32 ry = row & (chunk_size - 1), rz = row / chunk_size;
+                    const u32 neighbors[4] = { ry != 0 ? row - 1 : rows, ry != side - 1 ? row + 1 : rows,
+                                               rz != 0 ? row - side : rows, rz != side - 1 ? row + side : rows };
+                    for(u32 n : neighbors)
+                    {
+                        if(n == rows)
+                            continue;
+                        u32 next = bits & free[n] & ~reached[n];
+                        if(next == 0)
+                            continue;
+
+                        next = fill(next, free[n]) & ~reached[n];
+                        reached[n] |= next;
+                        if(pending[n] == 0)
+                            queue.push_back(static_cast<u16>(n));
+                        pending[n] |= next;
+                    }
+                }
+                connections |= pairs.masks[faces];
+
+                if(connections == all_connected)
+                    return connections;
+            }
+        }
+        return connections;
+    }
+
+    visibility_graph::visibility_graph(const chunk_map<chunk_occupancy>& occupancy) noexcept :
+        occupancy(occupancy), nodes(), dirty(), reached(), queue()
+    {
+    }
+
+    void visibility_graph::chunk_added(const chunk_coord& c) noexcept
+    {
+        const chunk_occupancy* o = occupancy.get(c);
+        if(o == nullptr)
+            return;
+
+        u32 i = nodes.insert(c);
+        nodes[i] = node { face_connections(*o), false };
+    }
+
+    void visibility_graph::chunk_removed(const chunk_coord& c) noexcept
+    {
+        nodes.erase(c);
+    }
+
+    void visibility_graph::block_changed(const chunk_coord& c, local_coord v) noexcept
+    {
+        u32 i = nodes.find(c);
+        const chunk_occupancy* o = occupancy.get(c);
+        if(i == none || o == nullptr || nodes[i].dirty)
+            return;
+
+        bool opaque = o->get(v.x, v.y, v.z);
+        if((opaque && nodes[i].connections == 0) || (!opaque && nodes[i].connections == all_connected))
+            return;
+
+        nodes[i].dirty = true;
+        dirty.push(c);
+    }
+
+    usize visibility_graph::update() noexcept
+    {
+        usize count = 0;
+        for(const chunk_coord& c : dirty)
+        {
+            u32 i = nodes.find(c);
+            const chunk_occupancy* o = occupancy.get(c);
+            if(i == none || o == nullptr || !nodes[i].dirty)
+                continue;
+
+            nodes[i] = node { face_connections(*o), false };
+            count++;
+        }
+        dirty.clear();
+        return count;
+    }
+
+    u16 visibility_graph::connections(const chunk_coord& c) const noexcept
+    {
+        u32 i = nodes.find(c);
+        return i == none ? all_connected : nodes[i].connections;
+    }
+
+    chunk_coord visibility_graph::neighbor(const chunk_coord& c, u32 f) noexcept
+    {
+        i32 s = f & 1 ? -1 : 1;
+        u32 axis = f >> 1;
+        return chunk_coord { c.x + (axis == 0 ? s : 0), c.y + (axis == 1 ? s : 0), c.z + (axis == 2 ? s : 0) };
+    }
+};
@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include <jobs/deque.hpp>
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("basic work stealing deque check", "[jobs][deque]")
+{
+    jobs::work_stealing_deque<int> deque(6);
+    REQUIRE(deque.capacity() == 8);
+    REQUIRE(deque.size_approx() == 0);
+
+    SECTION("push pop")
+    {
+        int v;
+        REQUIRE(!deque.pop(v));
+
+        for(int i = 0; i < 8; i++)
+            REQUIRE(deque.push(i));
+        REQUIRE(!deque.push(8));
+
+        REQUIRE(deque.pop(v));
+        REQUIRE(v == 7);
+        REQUIRE(deque.pop(v));
+        REQUIRE(v == 6);
+        REQUIRE(deque.size_approx() == 6);
+    }
+
+    SECTION("steal")
+    {
+        int v;
+        REQUIRE(!deque.steal(v));
+
+        deque.push(1);
+        deque.push(2);
+        deque.push(3);
+
+        REQUIRE(deque.steal(v));
+        REQUIRE(v == 1);
+        REQUIRE(deque.pop(v));
+        REQUIRE(v == 3);
+        REQUIRE(deque.steal(v));
+        REQUIRE(v == 2);
+        REQUIRE(!deque.pop(v));
+        REQUIRE(!deque.steal(v));
+    }
+
+    SECTION("wrap around")
+    {
+        int v;
+        for(int i = 0; i < 100; i++)
+        {
+            REQUIRE(deque.push(i));
+            REQUIRE(deque.push(i + 1));
+            REQUIRE(deque.steal(v));
+            REQUIRE(v == i);
+            REQUIRE(deque.pop(v));
+            REQUIRE(v == i + 1);
+        }
+    }
+}
+
+TEST_CASE("work stealing deque threads", "[jobs][deque]")
+{
+    const int count = 100000;
+    const int thieves = 3;
+    jobs::work_stealing_deque<int> deque(1024);
+
+    std::atomic<bool> done = false;
+    std::atomic<long long> stolen_sum = 0;
+    std::atomic<int> stolen = 0;
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < thieves; t++)
+        threads.emplace_back([&]() {
+            int v;
+            while(!done.load())
+                if(deque.steal(v))
+                {
+                    stolen_sum += v;
+                    stolen++;
+                }
+        });
+
+    long long sum = 0;
+    int popped = 0;
+    int next = 0;
+    while(next < count)
+    {
+        if(deque.push(next))
+            next++;
+
+        int v;
+        if(next % 3 == 0 && deque.pop(v))
+        {
+            sum += v;
+            popped++;
+        }
+    }
+
+    int v;
+    while(popped + stolen.load() < count)
+        if(deque.pop(v))
+        {
+            sum += v;
+            popped++;
+        }
+
+    done = true;
+    for(std::thread& t : threads)
+        t.join();
+
+    REQUIRE(popped + stolen.load() == count);
+    REQUIRE(sum + stolen_sum.load() == (long long)count * (count - 1) / 2);
+}
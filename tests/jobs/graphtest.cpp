@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include <jobs/graph.hpp>
+
+struct record
+{
+    std::atomic<int> clock = 0;
+    int stamps[16] = {};
+};
+
+struct stamp
+{
+    record* r;
+    int id;
+
+    inline void operator()() noexcept { r->stamps[id] = ++r->clock; }
+};
+
+static void add_range(jobs::job& j)
+{
+    static_cast<std::atomic<int>*>(j.data)->fetch_add(int(j.end - j.begin));
+}
+
+TEST_CASE("basic task graph check", "[jobs][graph]")
+{
+    jobs::scheduler scheduler(4);
+    jobs::task_graph graph;
+
+    SECTION("empty")
+    {
+        graph.run(scheduler);
+        REQUIRE(graph.size() == 0);
+    }
+
+    SECTION("function nodes")
+    {
+        std::atomic<int> value = 0;
+        jobs::task_graph::node_index a = graph.add(&add_range, &value, 0, 3);
+        jobs::task_graph::node_index b = graph.add(&add_range, &value, 0, 4);
+        graph.precede(a, b);
+        REQUIRE(graph.dependencies(b) == 1);
+        REQUIRE(graph.successors(a).size() == 1);
+
+        graph.run(scheduler);
+        REQUIRE(value.load() == 7);
+    }
+
+    SECTION("diamond")
+    {
+        record r;
+        stamp s[4] = { { &r, 0 }, { &r, 1 }, { &r, 2 }, { &r, 3 } };
+        jobs::task_graph::node_index top = graph.add(s[0]);
+        jobs::task_graph::node_index left = graph.add(s[1]);
+        jobs::task_graph::node_index right = graph.add(s[2]);
+        jobs::task_graph::node_index bottom = graph.add(s[3]);
+        graph.precede(top, left);
+        graph.precede(top, right);
+        graph.precede(left, bottom);
+        graph.precede(right, bottom);
+
+        for(int frame = 0; frame < 50; frame++)
+        {
+            graph.run(scheduler);
+            REQUIRE(r.stamps[top] < r.stamps[left]);
+            REQUIRE(r.stamps[top] < r.stamps[right]);
+            REQUIRE(r.stamps[left] < r.stamps[bottom]);
+            REQUIRE(r.stamps[right] < r.stamps[bottom]);
+        }
+        REQUIRE(r.clock.load() == 200);
+    }
+
+    SECTION("chunk pipeline")
+    {
+        // generate -> decorate (needs both neighbours generated) -> light -> mesh
+        const int chunks = 64;
+        std::atomic<int> stage[4][chunks];
+        for(auto& row : stage)
+            for(auto& v : row)
+                v = 0;
+
+        std::atomic<bool> ordered = true;
+        struct step
+        {
+            std::atomic<int> (*stage)[chunks];
+            std::atomic<bool>* ordered;
+            int level;
+            int chunk;
+
+            inline void operator()() noexcept
+            {
+                if(level == 1)
+                {
+                    for(int n = chunk - 1; n <= chunk + 1; n++)
+                        if(n >= 0 && n < chunks && stage[0][n].load() == 0)
+                            *ordered = false;
+                }
+                else if(level > 1 && stage[level - 1][chunk].load() == 0)
+                    *ordered = false;
+
+                stage[level][chunk] = 1;
+            }
+        };
+
+        utils::array<step> steps(4 * chunks);
+        for(int level = 0; level < 4; level++)
+            for(int c = 0; c < chunks; c++)
+                steps.push_unchecked(step { stage, &ordered, level, c });
+
+        graph.reserve(4 * chunks);
+        for(usize i = 0; i < steps.size(); i++)
+            graph.add(steps[i]);
+
+        for(int c = 0; c < chunks; c++)
+        {
+            for(int n = c - 1; n <= c + 1; n++)
+                if(n >= 0 && n < chunks)
+                    graph.precede(n, chunks + c);
+            graph.precede(chunks + c, 2 * chunks + c);
+            graph.precede(2 * chunks + c, 3 * chunks + c);
+        }
+
+        graph.run(scheduler);
+        REQUIRE(ordered.load());
+        for(int c = 0; c < chunks; c++)
+            REQUIRE(stage[3][c].load() == 1);
+    }
+
+    SECTION("clear")
+    {
+        std::atomic<int> value = 0;
+        graph.add(&add_range, &value, 0, 1);
+        graph.clear();
+        REQUIRE(graph.size() == 0);
+
+        graph.add(&add_range, &value, 0, 2);
+        graph.run(scheduler);
+        REQUIRE(value.load() == 2);
+    }
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include <jobs/scheduler.hpp>
+
+#include <thread>
+
+static void increment(jobs::job& j)
+{
+    static_cast<std::atomic<int>*>(j.data)->fetch_add(int(j.end - j.begin));
+}
+
+TEST_CASE("basic scheduler check", "[jobs][scheduler]")
+{
+    jobs::scheduler scheduler(4);
+    REQUIRE(scheduler.worker_count() == 4);
+    REQUIRE(scheduler.thread_count() == 5);
+    REQUIRE(jobs::scheduler::current() == nullptr);
+
+    SECTION("submit")
+    {
+        std::atomic<int> value = 0;
+        jobs::job j(&increment, &value, 0, 5);
+        jobs::counter group;
+
+        scheduler.submit(j, group);
+        scheduler.wait(group);
+        REQUIRE(group.finished());
+        REQUIRE(value.load() == 5);
+    }
+
+    SECTION("submit many")
+    {
+        std::atomic<int> value = 0;
+        utils::array<jobs::job> batch(10000);
+        for(usize i = 0; i < 10000; i++)
+            batch.push_unchecked(&increment, &value, i, i + 1);
+
+        jobs::counter group;
+        scheduler.submit(batch, group);
+        scheduler.wait(group);
+        REQUIRE(value.load() == 10000);
+    }
+
+    SECTION("parallel for range")
+    {
+        utils::array<int> values;
+        values.push_many(0, 100000);
+
+        scheduler.parallel_for(values.size(), [&values](usize begin, usize end) {
+            for(usize i = begin; i != end; i++)
+                values[i] += int(i);
+        });
+
+        bool correct = true;
+        for(usize i = 0; i < values.size(); i++)
+            correct = correct && values[i] == int(i);
+        REQUIRE(correct);
+    }
+
+    SECTION("parallel for span")
+    {
+        utils::array<int> values;
+        values.push_many(3, 5000);
+
+        scheduler.parallel_for(utils::span<int>(values), [](int& v) { v *= 2; }, 7);
+
+        bool correct = true;
+        for(int v : values)
+            correct = correct && v == 6;
+        REQUIRE(correct);
+    }
+
+    SECTION("nested parallel for")
+    {
+        std::atomic<int> total = 0;
+        std::atomic<int> on_worker = 0;
+
+        scheduler.parallel_for(64, [&](usize begin, usize end) {
+            for(usize i = begin; i != end; i++)
+            {
+                if(jobs::scheduler::current() == &scheduler)
+                    on_worker++;
+
+                scheduler.parallel_for(1000, [&total](usize b, usize e) {
+                    total += int(e - b);
+                }, 10);
+            }
+        }, 1);
+
+        REQUIRE(total.load() == 64 * 1000);
+        REQUIRE(on_worker.load() <= 64);
+    }
+
+    SECTION("small ranges")
+    {
+        int calls = 0;
+        scheduler.parallel_for(0, [&calls](usize, usize) { calls++; });
+        REQUIRE(calls == 0);
+
+        scheduler.parallel_for(1, [&calls](usize b, usize e) { calls += int(e - b); });
+        REQUIRE(calls == 1);
+    }
+}
+
+TEST_CASE("scheduler from many threads", "[jobs][scheduler]")
+{
+    jobs::scheduler scheduler(3);
+    std::atomic<int> total = 0;
+
+    std::thread threads[4];
+    for(std::thread& t : threads)
+        t = std::thread([&scheduler, &total]() {
+            for(int k = 0; k < 20; k++)
+                scheduler.parallel_for(5000, [&total](usize b, usize e) { total += int(e - b); });
+        });
+
+    for(std::thread& t : threads)
+        t.join();
+
+    REQUIRE(total.load() == 4 * 20 * 5000);
+}
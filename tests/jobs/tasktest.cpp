@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <jobs/task.hpp>
+
+#include <thread>
+
+static jobs::task<int> constant(int v)
+{
+    co_return v;
+}
+
+static jobs::task<int> add(int a, int b)
+{
+    int x = co_await constant(a);
+    int y = co_await constant(b);
+    co_return x + y;
+}
+
+static jobs::task<int> deep(int n)
+{
+    if(n == 0)
+        co_return 0;
+    co_return 1 + co_await deep(n - 1);
+}
+
+static jobs::task<std::thread::id> on_scheduler(jobs::scheduler& s)
+{
+    co_await jobs::schedule(s);
+    co_return std::this_thread::get_id();
+}
+
+static jobs::task<int> square_on(jobs::scheduler& s, int v)
+{
+    co_await jobs::schedule(s);
+    co_return v * v;
+}
+
+static jobs::task<int> sum_of_squares(jobs::scheduler& s, int n)
+{
+    utils::array<jobs::task<int>> tasks;
+    for(int i = 0; i < n; i++)
+        tasks.push(square_on(s, i));
+
+    co_await jobs::when_all(tasks);
+
+    int total = 0;
+    for(jobs::task<int>& t : tasks)
+        total += t.result();
+    co_return total;
+}
+
+static jobs::task<> count_on(jobs::scheduler& s, std::atomic<int>& counter)
+{
+    co_await jobs::schedule(s);
+    counter++;
+}
+
+static jobs::task<> count_all(jobs::scheduler& s, std::atomic<int>& counter, int n)
+{
+    utils::array<jobs::task<>> tasks;
+    for(int i = 0; i < n; i++)
+        tasks.push(count_on(s, counter));
+
+    co_await jobs::when_all(tasks);
+}
+
+TEST_CASE("basic task check", "[jobs][task]")
+{
+    jobs::scheduler scheduler(4);
+
+    SECTION("value")
+    {
+        jobs::task<int> t = add(2, 3);
+        REQUIRE(!t.done());
+        jobs::sync_wait(scheduler, t);
+        REQUIRE(t.done());
+        REQUIRE(t.result() == 5);
+    }
+
+    SECTION("symmetric transfer")
+    {
+        jobs::task<int> t = deep(1000);
+        jobs::sync_wait(scheduler, t);
+        REQUIRE(t.result() == 1000);
+    }
+
+    SECTION("schedule")
+    {
+        jobs::task<std::thread::id> t = on_scheduler(scheduler);
+        jobs::sync_wait(scheduler, t);
+        REQUIRE(t.done());
+    }
+
+    SECTION("when all")
+    {
+        jobs::task<int> t = sum_of_squares(scheduler, 200);
+        jobs::sync_wait(scheduler, t);
+        REQUIRE(t.result() == 199 * 200 * 399 / 6);
+    }
+
+    SECTION("when all void")
+    {
+        std::atomic<int> counter = 0;
+        for(int round = 0; round < 20; round++)
+        {
+            jobs::task<> t = count_all(scheduler, counter, 100);
+            jobs::sync_wait(scheduler, t);
+        }
+        REQUIRE(counter.load() == 2000);
+    }
+
+    SECTION("when all empty")
+    {
+        std::atomic<int> counter = 0;
+        jobs::task<> t = count_all(scheduler, counter, 0);
+        jobs::sync_wait(scheduler, t);
+        REQUIRE(t.done());
+    }
+
+    SECTION("frame allocator")
+    {
+        void* a = jobs::allocate_frame(100);
+        jobs::deallocate_frame(a, 100);
+        void* b = jobs::allocate_frame(120);
+        REQUIRE(a == b);
+        jobs::deallocate_frame(b, 120);
+
+        void* big = jobs::allocate_frame(1 << 20);
+        REQUIRE(big != nullptr);
+        jobs::deallocate_frame(big, 1 << 20);
+    }
+}
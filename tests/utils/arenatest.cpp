@@ -158,6 +158,57 @@ TEST_CASE("basic basic arena check", "[arena][block_arena]")
             REQUIRE(!arena.has(i3));
         }
 
+        SECTION("create many")
+        {
+            utils::const_span<usize> indices = arena.create_many(100, 4);
+            REQUIRE(indices.size() == 100);
+            REQUIRE(arena.size() == 103);
+
+            for(usize i : indices)
+                REQUIRE((arena.has(i) && arena[i] == 4));
+
+            REQUIRE(arena[i1] == 2);
+            REQUIRE(arena[i2] == 7);
+            REQUIRE(arena[i3] == 5);
+        }
+
+        SECTION("create many unchecked")
+        {
+            arena.reserve(50);
+            utils::const_span<usize> indices = arena.create_many_unchecked(20, 8);
+            REQUIRE(indices.size() == 20);
+            REQUIRE(arena.size() == 23);
+
+            for(usize i : indices)
+                REQUIRE((arena.has(i) && arena[i] == 8));
+        }
+
+        SECTION("destroy many")
+        {
+            usize indices[] = { i1, i3, 2434, i1 };
+            arena.destroy_many(utils::const_span<usize>(indices, 4));
+            REQUIRE((!arena.has(i1) && arena.has(i2) && !arena.has(i3)));
+            REQUIRE(arena.size() == 1);
+
+            // Every index freed once, however many times it was passed.
+            usize i4 = arena.create(11);
+            usize i5 = arena.create(12);
+            REQUIRE(i4 != i5);
+            REQUIRE(arena.size() == 3);
+        }
+
+        SECTION("destroy many unchecked")
+        {
+            usize indices[] = { i1, i2 };
+            arena.destroy_many_unchecked(utils::const_span<usize>(indices, 2));
+            REQUIRE((!arena.has(i1) && !arena.has(i2) && arena.has(i3)));
+            REQUIRE(arena.size() == 1);
+
+            usize i4 = arena.create(11);
+            usize i5 = arena.create(12);
+            REQUIRE(((i4 == i1 || i4 == i2) && (i5 == i1 || i5 == i2)));
+        }
+
         SECTION("clear")
         {
             arena.clear();
@@ -204,6 +255,13 @@ TEST_CASE("basic basic arena check", "[arena][block_arena]")
 
         copy.clear();
         REQUIRE(ref_counter::get() == 3);
+
+        utils::const_span<usize> span = copy.create_many(50);
+        REQUIRE(ref_counter::get() == 53);
+
+        utils::array<usize> indices(span);
+        copy.destroy_many_unchecked(indices);
+        REQUIRE(ref_counter::get() == 3);
     }
 }
 
@@ -411,6 +411,25 @@ TEST_CASE("basic array check", "[array]")
             REQUIRE(arr.back() == 10);
         }
 
+        SECTION("uninitialized")
+        {
+            arr.push(1);
+
+            utils::span<int> span = arr.push_uninitialized(5);
+            REQUIRE(arr.size() == 6);
+            REQUIRE(span.data() == arr.data() + 1);
+            for(usize i = 0; i != span.size(); i++)
+                span[i] = int(i) + 2;
+            REQUIRE(arr.back() == 6);
+
+            arr.reserve(arr.size() + 3);
+            span = arr.push_uninitialized_unchecked(3);
+            span[0] = span[1] = span[2] = 0;
+            REQUIRE(arr.size() == 9);
+            REQUIRE(arr[5] == 6);
+            REQUIRE(arr[8] == 0);
+        }
+
         SECTION("erase")
         {
             arr.push_many(10, 20);
@@ -435,6 +454,16 @@ TEST_CASE("basic array check", "[array]")
             arr.clear();
             REQUIRE(arr.size() == 0);
         }
+
+        SECTION("assign")
+        {
+            arr.push_many(1, 3);
+            arr.assign(100, 7);
+            REQUIRE(arr.size() == 100);
+            REQUIRE(arr.capacity() >= 100);
+            REQUIRE(arr[0] == 7);
+            REQUIRE(arr[99] == 7);
+        }
     }
 
     SECTION("iteration")
@@ -819,6 +848,32 @@ TEST_CASE("basic sparse array check", "[array][sparse-array]")
             REQUIRE((!arr.has(2) && arr.has(5)));
         }
 
+        SECTION("insert many unchecked")
+        {
+            utils::sparse_array<int> arr;
+            arr.reserve(20);
+
+            usize indices[] = { 3, 7, 15 };
+            arr.insert_many_unchecked(utils::const_span<usize>(indices, 3), 9);
+            REQUIRE((arr.has(3) && arr.get(3) == 9));
+            REQUIRE((arr.has(7) && arr.get(7) == 9));
+            REQUIRE((arr.has(15) && arr.get(15) == 9));
+            REQUIRE((!arr.has(4) && !arr.has(16)));
+        }
+
+        SECTION("erase many unchecked")
+        {
+            utils::sparse_array<int> arr;
+            arr.reserve(20);
+            arr.insert_unchecked(2, 10);
+            arr.insert_unchecked(5, 20);
+            arr.insert_unchecked(9, 30);
+
+            usize indices[] = { 2, 9 };
+            arr.erase_many_unchecked(utils::const_span<usize>(indices, 2));
+            REQUIRE((!arr.has(2) && arr.has(5) && !arr.has(9)));
+        }
+
         SECTION("clear")
         {
             utils::sparse_array<int> arr;
@@ -905,6 +960,13 @@ TEST_CASE("basic sparse array check", "[array][sparse-array]")
         array.erase_unchecked(10);
         REQUIRE(ref_counter::get() == 1);
 
+        usize indices[] = { 30, 40, 50 };
+        array.insert_many_unchecked(utils::const_span<usize>(indices, 3));
+        REQUIRE(ref_counter::get() == 4);
+
+        array.erase_many_unchecked(utils::const_span<usize>(indices, 3));
+        REQUIRE(ref_counter::get() == 1);
+
         array = utils::sparse_array<ref_counter>();
         REQUIRE(ref_counter::get() == 0);
 
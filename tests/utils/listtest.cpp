@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/list.hpp>
+
+
+class ref_counter
+{
+public:
+    inline ref_counter() noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(const ref_counter& other) noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(ref_counter&& other) noexcept
+    {
+        count++;
+    }
+
+    inline ~ref_counter() noexcept
+    {
+        count--;
+    }
+
+    inline ref_counter& operator=(const ref_counter& other) noexcept
+    {
+        return *this;
+    }
+
+    inline ref_counter& operator=(ref_counter&& other) noexcept
+    {
+        return *this;
+    }
+
+    static inline int get() noexcept { return count; }
+
+private:
+    static inline int count = 0;
+};
+
+typedef utils::list_arena<int> arena_type;
+typedef arena_type::list_type list_type;
+
+static utils::array<int> collect(const arena_type& arena, const list_type& l)
+{
+    utils::array<int> values;
+    for(arena_type::index_type i = l.head; i != arena_type::null; i = arena.next(i))
+        values.push(arena[i]);
+    return values;
+}
+
+static bool equals(const utils::array<int>& values, ::std::initializer_list<int> expected)
+{
+    if(values.size() != expected.size())
+        return false;
+
+    usize i = 0;
+    for(int v : expected)
+        if(values[i++] != v)
+            return false;
+    return true;
+}
+
+TEST_CASE("basic list arena check", "[list]")
+{
+    arena_type arena;
+    list_type l;
+    arena_type::index_type a = arena.push_back(l, 1);
+    arena_type::index_type b = arena.push_back(l, 2);
+    arena_type::index_type c = arena.push_back(l, 3);
+    REQUIRE(l.size() == 3);
+    REQUIRE(equals(collect(arena, l), { 1, 2, 3 }));
+
+    SECTION("push")
+    {
+        arena.push_front(l, 0);
+        arena.insert(l, c, 5);
+        arena.insert(l, arena_type::null, 9);
+        REQUIRE(equals(collect(arena, l), { 0, 1, 2, 5, 3, 9 }));
+        REQUIRE(arena.size() == 6);
+    }
+
+    SECTION("erase")
+    {
+        arena.erase(l, b);
+        REQUIRE(equals(collect(arena, l), { 1, 3 }));
+        REQUIRE(!arena.has(b));
+
+        arena.pop_front(l);
+        arena.pop_back(l);
+        REQUIRE(l.empty());
+        REQUIRE(l.head == arena_type::null);
+        REQUIRE(l.tail == arena_type::null);
+        REQUIRE(arena.size() == 0);
+    }
+
+    SECTION("move to front")
+    {
+        arena.move_to_front(l, c);
+        REQUIRE(equals(collect(arena, l), { 3, 1, 2 }));
+        arena.move_to_front(l, c);
+        REQUIRE(equals(collect(arena, l), { 3, 1, 2 }));
+        arena.move_to_back(l, c);
+        REQUIRE(equals(collect(arena, l), { 1, 2, 3 }));
+        arena.move_to_front(l, b);
+        REQUIRE(equals(collect(arena, l), { 2, 1, 3 }));
+        REQUIRE(arena.prev(a) == b);
+        REQUIRE(arena.next(a) == c);
+    }
+
+    SECTION("splice")
+    {
+        list_type other;
+        arena_type::index_type d = arena.push_back(other, 4);
+        arena.push_back(other, 5);
+
+        SECTION("node")
+        {
+            arena.splice(l, b, other, d);
+            REQUIRE(equals(collect(arena, l), { 1, 4, 2, 3 }));
+            REQUIRE(equals(collect(arena, other), { 5 }));
+            REQUIRE(l.size() == 4);
+            REQUIRE(other.size() == 1);
+        }
+
+        SECTION("list middle")
+        {
+            arena.splice(l, b, other);
+            REQUIRE(equals(collect(arena, l), { 1, 4, 5, 2, 3 }));
+            REQUIRE(other.empty());
+        }
+
+        SECTION("list front")
+        {
+            arena.splice(l, l.head, other);
+            REQUIRE(equals(collect(arena, l), { 4, 5, 1, 2, 3 }));
+        }
+
+        SECTION("list back")
+        {
+            arena.splice(l, arena_type::null, other);
+            REQUIRE(equals(collect(arena, l), { 1, 2, 3, 4, 5 }));
+            REQUIRE(arena[l.tail] == 5);
+        }
+
+        SECTION("into empty")
+        {
+            list_type empty;
+            arena.splice(empty, arena_type::null, other);
+            REQUIRE(equals(collect(arena, empty), { 4, 5 }));
+        }
+    }
+
+    SECTION("unlink")
+    {
+        arena.unlink(l, a);
+        REQUIRE(equals(collect(arena, l), { 2, 3 }));
+        REQUIRE(arena.has(a));
+
+        arena.link_back(l, a);
+        REQUIRE(equals(collect(arena, l), { 2, 3, 1 }));
+    }
+
+    SECTION("clear")
+    {
+        list_type other;
+        arena.push_back(other, 7);
+        arena.clear(l);
+        REQUIRE(l.empty());
+        REQUIRE(arena.size() == 1);
+        REQUIRE(equals(collect(arena, other), { 7 }));
+    }
+
+    SECTION("lifetime")
+    {
+        utils::list_arena<ref_counter> arena;
+        utils::list_arena<ref_counter>::list_type l;
+        for(int i = 0; i < 100; i++)
+            arena.push_back(l);
+        REQUIRE(ref_counter::get() == 100);
+
+        arena.pop_front(l);
+        arena.pop_back(l);
+        REQUIRE(ref_counter::get() == 98);
+
+        arena.clear(l);
+        REQUIRE(ref_counter::get() == 0);
+    }
+}
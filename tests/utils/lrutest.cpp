@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/lru.hpp>
+
+
+class ref_counter
+{
+public:
+    inline ref_counter() noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(const ref_counter& other) noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(ref_counter&& other) noexcept
+    {
+        count++;
+    }
+
+    inline ~ref_counter() noexcept
+    {
+        count--;
+    }
+
+    inline ref_counter& operator=(const ref_counter& other) noexcept
+    {
+        return *this;
+    }
+
+    inline ref_counter& operator=(ref_counter&& other) noexcept
+    {
+        return *this;
+    }
+
+    static inline int get() noexcept { return count; }
+
+private:
+    static inline int count = 0;
+};
+
+TEST_CASE("basic lru cache check", "[lru]")
+{
+    utils::lru_cache<int> cache(3);
+    utils::lru_cache<int>::index_type a = cache.insert(1);
+    utils::lru_cache<int>::index_type b = cache.insert(2);
+    utils::lru_cache<int>::index_type c = cache.insert(3);
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.full());
+    REQUIRE(cache.least_recent() == a);
+    REQUIRE(cache.most_recent() == c);
+
+    SECTION("touch")
+    {
+        cache.touch(a);
+        REQUIRE(cache.most_recent() == a);
+        REQUIRE(cache.least_recent() == b);
+        REQUIRE(cache.older(a) == c);
+        REQUIRE(cache.newer(c) == a);
+    }
+
+    SECTION("insert evicts")
+    {
+        cache.touch(a);
+        utils::lru_cache<int>::index_type d = cache.insert(4);
+        REQUIRE(cache.size() == 3);
+        REQUIRE(cache.most_recent() == d);
+        REQUIRE(cache.least_recent() == c);
+        REQUIRE(cache[a] == 1);
+        REQUIRE(cache[d] == 4);
+    }
+
+    SECTION("evict")
+    {
+        int evicted = 0;
+        cache.evict([&evicted](int& v) { evicted = v; });
+        REQUIRE(evicted == 1);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(!cache.full());
+
+        cache.shrink(0, [&evicted](int& v) { evicted += v; });
+        REQUIRE(evicted == 6);
+        REQUIRE(cache.empty());
+        REQUIRE(cache.least_recent() == cache.null);
+    }
+
+    SECTION("erase")
+    {
+        cache.erase(b);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.older(c) == a);
+    }
+
+    SECTION("limit")
+    {
+        cache.set_limit(1);
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.most_recent() == c);
+        REQUIRE(cache.limit() == 1);
+    }
+
+    SECTION("lifetime")
+    {
+        {
+            utils::lru_cache<ref_counter> cache(10);
+            for(int i = 0; i < 25; i++)
+                cache.insert();
+            REQUIRE(ref_counter::get() == 10);
+
+            cache.evict();
+            REQUIRE(ref_counter::get() == 9);
+        }
+        REQUIRE(ref_counter::get() == 0);
+    }
+}
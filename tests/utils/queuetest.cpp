@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+#include <utils/concurrent_queue.hpp>
+
+#include <thread>
+#include <vector>
+
+TEMPLATE_TEST_CASE("basic concurrent queue check", "[queue]", utils::mpmc_queue<int>, utils::spsc_queue<int>)
+{
+    TestType queue(6);
+    REQUIRE(queue.capacity() == 8);
+    REQUIRE(queue.size_approx() == 0);
+
+    SECTION("push pop")
+    {
+        int v;
+        REQUIRE(!queue.try_pop(v));
+
+        for(int i = 0; i < 8; i++)
+            REQUIRE(queue.try_push(i));
+        REQUIRE(!queue.try_push(8));
+        REQUIRE(queue.size_approx() == 8);
+
+        for(int i = 0; i < 8; i++)
+        {
+            REQUIRE(queue.try_pop(v));
+            REQUIRE(v == i);
+        }
+        REQUIRE(!queue.try_pop(v));
+    }
+
+    SECTION("wrap around")
+    {
+        int v;
+        for(int i = 0; i < 100; i++)
+        {
+            REQUIRE(queue.try_push(i));
+            REQUIRE(queue.try_push(-i));
+            REQUIRE(queue.try_pop(v));
+            REQUIRE(v == i);
+            REQUIRE(queue.try_pop(v));
+            REQUIRE(v == -i);
+        }
+    }
+
+    SECTION("push pop many")
+    {
+        int values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        int v;
+        REQUIRE(queue.try_push(-1));
+        REQUIRE(queue.try_pop(v));
+
+        REQUIRE(queue.try_push_many(utils::const_span<int>(values, 10)) == 8);
+        REQUIRE(queue.try_push_many(utils::const_span<int>(values, 10)) == 0);
+
+        int out[5];
+        REQUIRE(queue.try_pop_many(utils::span<int>(out, 5)) == 5);
+        for(int i = 0; i < 5; i++)
+            REQUIRE(out[i] == i);
+
+        REQUIRE(queue.try_push_many(utils::const_span<int>(values, 2)) == 2);
+        REQUIRE(queue.try_pop_many(utils::span<int>(out, 5)) == 5);
+        REQUIRE(out[0] == 5);
+        REQUIRE(out[2] == 7);
+        REQUIRE(out[3] == 0);
+        REQUIRE(out[4] == 1);
+        REQUIRE(queue.try_pop_many(utils::span<int>(out, 5)) == 0);
+    }
+}
+
+TEST_CASE("spsc queue threads", "[queue][spsc]")
+{
+    const int count = 200000;
+    utils::spsc_queue<int> queue(256);
+
+    std::thread producer([&queue]() {
+        int batch[16];
+        int next = 0;
+        while(next < count)
+        {
+            if(next % 3 == 0)
+            {
+                if(queue.try_push(next))
+                    next++;
+                continue;
+            }
+
+            int n = ::std::min(16, count - next);
+            for(int i = 0; i < n; i++)
+                batch[i] = next + i;
+            next += int(queue.try_push_many(utils::const_span<int>(batch, n)));
+        }
+    });
+
+    long long sum = 0;
+    int expected = 0;
+    bool ordered = true;
+    int out[32];
+    while(expected < count)
+    {
+        usize n = queue.try_pop_many(utils::span<int>(out, 32));
+        for(usize i = 0; i < n; i++)
+        {
+            ordered = ordered && out[i] == expected;
+            sum += out[i];
+            expected++;
+        }
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(sum == (long long)count * (count - 1) / 2);
+}
+
+TEST_CASE("mpmc queue threads", "[queue][mpmc]")
+{
+    const int producers = 4;
+    const int consumers = 4;
+    const int per_producer = 50000;
+    utils::mpmc_queue<int> queue(1024);
+
+    std::atomic<long long> sum = 0;
+    std::atomic<int> popped = 0;
+
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; p++)
+        threads.emplace_back([&queue, p]() {
+            int batch[8];
+            int next = 0;
+            while(next < per_producer)
+            {
+                if(next % 2 == 0)
+                {
+                    if(queue.try_push(p * per_producer + next))
+                        next++;
+                    continue;
+                }
+
+                int n = ::std::min(8, per_producer - next);
+                for(int i = 0; i < n; i++)
+                    batch[i] = p * per_producer + next + i;
+                next += int(queue.try_push_many(utils::const_span<int>(batch, n)));
+            }
+        });
+
+    for(int c = 0; c < consumers; c++)
+        threads.emplace_back([&queue, &sum, &popped, c]() {
+            int out[8];
+            while(popped.load() < producers * per_producer)
+            {
+                usize n;
+                if(c % 2 == 0)
+                    n = queue.try_pop(out[0]) ? 1 : 0;
+                else n = queue.try_pop_many(utils::span<int>(out, 8));
+
+                for(usize i = 0; i < n; i++)
+                    sum += out[i];
+                popped += int(n);
+            }
+        });
+
+    for(std::thread& t : threads)
+        t.join();
+
+    const long long total = (long long)producers * per_producer;
+    REQUIRE(popped.load() == total);
+    REQUIRE(sum.load() == total * (total - 1) / 2);
+}
@@ -0,0 +1,232 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+#include <utils/ring.hpp>
+
+class ref_counter
+{
+public:
+    inline ref_counter() noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(const ref_counter& other) noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(ref_counter&& other) noexcept
+    {
+        count++;
+    }
+
+    inline ~ref_counter() noexcept
+    {
+        count--;
+    }
+
+    inline ref_counter& operator=(const ref_counter& other) noexcept
+    {
+        return *this;
+    }
+
+    inline ref_counter& operator=(ref_counter&& other) noexcept
+    {
+        return *this;
+    }
+
+    static inline int get() noexcept { return count; }
+
+private:
+    static inline int count = 0;
+};
+
+TEST_CASE("basic ring buffer check", "[ring][ring-buffer]")
+{
+    utils::ring_buffer<int> ring(6);
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(ring.empty());
+
+    SECTION("push")
+    {
+        for(int i = 0; i < 8; i++)
+            REQUIRE(ring.push_back(i));
+        REQUIRE(ring.full());
+        REQUIRE(!ring.push_back(8));
+        REQUIRE(!ring.push_front(8));
+        REQUIRE(ring.size() == 8);
+        REQUIRE(ring.front() == 0);
+        REQUIRE(ring.back() == 7);
+    }
+
+    SECTION("push front")
+    {
+        ring.push_back(1);
+        ring.push_front(0);
+        ring.push_front(-1);
+        REQUIRE(ring.size() == 3);
+        REQUIRE(ring[0] == -1);
+        REQUIRE(ring[1] == 0);
+        REQUIRE(ring[2] == 1);
+    }
+
+    SECTION("wrap around")
+    {
+        for(int i = 0; i < 100; i++)
+        {
+            REQUIRE(ring.push_back(i));
+            REQUIRE(ring.push_back(i + 1000));
+            REQUIRE(ring.front() == i);
+            ring.pop_front();
+            REQUIRE(ring.front() == i + 1000);
+            ring.pop_front();
+        }
+        REQUIRE(ring.empty());
+    }
+
+    SECTION("push many")
+    {
+        int values[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+        ring.push_back(0);
+        ring.push_back(0);
+        ring.pop_front();
+        ring.pop_front();
+
+        REQUIRE(ring.push_back_many(utils::const_span<int>(values, 10)) == 8);
+        REQUIRE(ring.full());
+        for(int i = 0; i < 8; i++)
+            REQUIRE(ring[i] == i + 1);
+
+        REQUIRE(ring.first_segment().size() == 6);
+        REQUIRE(ring.second_segment().size() == 2);
+        REQUIRE(ring.second_segment()[0] == 7);
+    }
+
+    SECTION("pop many")
+    {
+        for(int i = 0; i < 6; i++)
+            ring.push_back(i);
+        ring.pop_front_many(3);
+        for(int i = 6; i < 10; i++)
+            ring.push_back(i);
+
+        int out[5];
+        REQUIRE(ring.pop_front_many(utils::span<int>(out, 5)) == 5);
+        for(int i = 0; i < 5; i++)
+            REQUIRE(out[i] == i + 3);
+
+        REQUIRE(ring.pop_front_many(utils::span<int>(out, 5)) == 2);
+        REQUIRE(out[0] == 8);
+        REQUIRE(out[1] == 9);
+        REQUIRE(ring.empty());
+    }
+
+    SECTION("pop back")
+    {
+        ring.push_back(1);
+        ring.push_back(2);
+        ring.pop_back();
+        REQUIRE(ring.size() == 1);
+        REQUIRE(ring.back() == 1);
+    }
+
+    SECTION("copy")
+    {
+        ring.push_back(1);
+        ring.push_back(2);
+        utils::ring_buffer<int> copy(ring);
+        REQUIRE(copy.size() == 2);
+        REQUIRE(copy.capacity() == 8);
+        REQUIRE(copy[1] == 2);
+    }
+}
+
+TEST_CASE("basic deque check", "[ring][deque]")
+{
+    utils::deque<int> deque;
+    REQUIRE(deque.empty());
+
+    SECTION("grow")
+    {
+        for(int i = 0; i < 1000; i++)
+        {
+            deque.push_back(i);
+            deque.push_front(-i);
+        }
+        REQUIRE(deque.size() == 2000);
+        REQUIRE((deque.capacity() & (deque.capacity() - 1)) == 0);
+        REQUIRE(deque.front() == -999);
+        REQUIRE(deque.back() == 999);
+        REQUIRE(deque[999] == 0);
+        REQUIRE(deque[1000] == 0);
+        REQUIRE(deque[1001] == 1);
+    }
+
+    SECTION("grow wrapped")
+    {
+        deque.reserve(8);
+        for(int i = 0; i < 6; i++)
+            deque.push_back(i);
+        deque.pop_front_many(5);
+        for(int i = 6; i < 13; i++)
+            deque.push_back(i);
+        REQUIRE(deque.full());
+
+        deque.push_back(13);
+        REQUIRE(deque.capacity() == 16);
+        for(int i = 0; i < 9; i++)
+            REQUIRE(deque[i] == i + 5);
+    }
+
+    SECTION("push many")
+    {
+        int values[100];
+        for(int i = 0; i < 100; i++)
+            values[i] = i;
+
+        deque.push_back(-1);
+        deque.push_back_many(utils::const_span<int>(values, 100));
+        REQUIRE(deque.size() == 101);
+        REQUIRE(deque[0] == -1);
+        REQUIRE(deque[100] == 99);
+    }
+
+    SECTION("move")
+    {
+        deque.push_back(3);
+        utils::deque<int> other(::std::move(deque));
+        REQUIRE(other.size() == 1);
+        REQUIRE(other.front() == 3);
+        REQUIRE(deque.empty());
+
+        deque = ::std::move(other);
+        REQUIRE(deque.front() == 3);
+    }
+
+    SECTION("lifetime")
+    {
+        utils::deque<ref_counter> deque;
+        for(int i = 0; i < 50; i++)
+        {
+            deque.push_back();
+            deque.push_front();
+        }
+        REQUIRE(ref_counter::get() == 100);
+
+        deque.pop_front();
+        deque.pop_back();
+        deque.pop_front_many(8);
+        REQUIRE(ref_counter::get() == 90);
+
+        utils::deque<ref_counter> copy(deque);
+        REQUIRE(ref_counter::get() == 180);
+
+        ref_counter out[20];
+        REQUIRE(copy.pop_front_many(utils::span<ref_counter>(out, 20)) == 20);
+        REQUIRE(ref_counter::get() == 180);
+
+        copy.clear();
+        deque = utils::deque<ref_counter>();
+        REQUIRE(ref_counter::get() == 20);
+    }
+}
@@ -0,0 +1,183 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/serialize.hpp>
+
+struct particle
+{
+    f32 x;
+    f32 y;
+    f32 z;
+    u32 id;
+};
+
+struct pinned
+{
+    u64 value;
+};
+
+template<>
+struct utils::serial_traits<pinned>
+{
+    static constexpr u32 tag = 77;
+    static constexpr u16 version = 2;
+};
+
+TEST_CASE("serialize array check", "[serialize]")
+{
+    utils::array<particle> particles;
+    for(u32 i = 0; i != 1000; i++)
+        particles.push(particle { f32(i), f32(i) * 2.0f, -f32(i), i });
+    utils::array<u16> empty;
+
+    utils::array<u8> bytes;
+    utils::serial_writer writer(bytes);
+    writer.write(particles);
+    writer.write(empty);
+    writer.write(utils::const_span<particle>(particles.data() + 10, 3));
+    REQUIRE(bytes.size() % utils::serial_alignment == 0);
+
+    // Views point straight into the bytes.
+    utils::serial_reader reader(bytes);
+    utils::const_span<particle> view;
+    REQUIRE(reader.read(view));
+    REQUIRE(view.size() == 1000);
+    REQUIRE(reinterpret_cast<const u8*>(view.data()) >= bytes.data());
+    REQUIRE(reinterpret_cast<const u8*>(view.data()) < bytes.data() + bytes.size());
+    for(u32 i = 0; i != 1000; i++)
+        REQUIRE(view[i].id == i);
+    REQUIRE(view[999].y == 1998.0f);
+
+    // The next block is an array of u16, not of particles.
+    REQUIRE(reader.peek() != nullptr);
+    REQUIRE(reader.peek()->element_size == sizeof(u16));
+    REQUIRE_FALSE(reader.read(view));
+    utils::array<u16> copy;
+    copy.push(5);
+    REQUIRE(reader.read(copy));
+    REQUIRE(copy.empty());
+
+    utils::array<particle> tail;
+    REQUIRE(reader.read(tail));
+    REQUIRE(tail.size() == 3);
+    REQUIRE(tail[0].id == 10);
+    REQUIRE(reader.done());
+    REQUIRE_FALSE(reader.read(view));
+}
+
+TEST_CASE("serialize sparse array and arena check", "[serialize]")
+{
+    utils::sparse_array<u32> sparse;
+    sparse.insert(3, 30u);
+    sparse.insert(10, 100u);
+    sparse.insert(0, 7u);
+    sparse.insert(5, 55u);
+    sparse.erase(5);
+
+    utils::basic_arena<particle> arena;
+    utils::array<usize> ids;
+    for(u32 i = 0; i != 100; i++)
+        ids.push(arena.create(particle { 0.0f, 0.0f, 0.0f, i }));
+    for(u32 i = 0; i < 100; i += 3)
+        arena.destroy(ids[i]);
+
+    utils::array<u8> bytes;
+    utils::serial_writer writer(bytes);
+    writer.write(sparse);
+    writer.write(arena);
+
+    utils::serial_reader reader(bytes);
+    utils::sparse_view<u32> sv;
+    REQUIRE(reader.read(sv));
+    REQUIRE(sv.slots.size() == sparse.capacity());
+    REQUIRE(sv.has(0));
+    REQUIRE(sv.has(3));
+    REQUIRE(sv.has(10));
+    REQUIRE_FALSE(sv.has(4));
+    REQUIRE_FALSE(sv.has(5));
+    REQUIRE_FALSE(sv.has(1000));
+    REQUIRE(sv[10] == 100);
+
+    // Empty slots carry no stale bytes.
+    REQUIRE(sv.slots[5] == 0);
+
+    utils::arena_view<particle> av;
+    REQUIRE(reader.read(av));
+    REQUIRE(av.free.size() == arena.capacity());
+    for(u32 i = 0; i != 100; i++)
+    {
+        REQUIRE(av.elements.has(ids[i]) == (i % 3 != 0));
+        if(i % 3 != 0)
+            REQUIRE(av.elements[ids[i]].id == i);
+        else
+            REQUIRE(av.elements[ids[i]].id == 0);
+    }
+    REQUIRE(reader.done());
+
+    // Copies back into containers behave like the originals.
+    utils::serial_reader again(bytes);
+    utils::sparse_array<u32> sparse_copy;
+    REQUIRE(again.read(sparse_copy));
+    REQUIRE(sparse_copy.has(3));
+    REQUIRE(sparse_copy[3] == 30);
+    REQUIRE_FALSE(sparse_copy.has(4));
+
+    utils::basic_arena<particle> arena_copy;
+    REQUIRE(again.read(arena_copy));
+    REQUIRE(arena_copy.size() == arena.size());
+    REQUIRE(arena_copy[ids[1]].id == 1);
+    REQUIRE(arena_copy.create(particle {}) == arena.create(particle {}));
+    REQUIRE(arena_copy.create(particle {}) == arena.create(particle {}));
+}
+
+TEST_CASE("serialize validation check", "[serialize]")
+{
+    utils::array<pinned> values;
+    values.push(pinned { 1 });
+    values.push(pinned { 2 });
+
+    utils::array<u8> bytes;
+    utils::serial_writer(bytes).write(values);
+    REQUIRE(reinterpret_cast<const utils::serial_header*>(bytes.data())->tag == 77);
+    REQUIRE(reinterpret_cast<const utils::serial_header*>(bytes.data())->version == 2);
+
+    // Same size, other type.
+    utils::const_span<u64> wrong;
+    REQUIRE_FALSE(utils::serial_reader(bytes).read(wrong));
+    utils::sparse_view<pinned> other_kind;
+    REQUIRE_FALSE(utils::serial_reader(bytes).read(other_kind));
+
+    // Truncated blocks are rejected, and can't be skipped.
+    utils::const_span<pinned> view;
+    utils::serial_reader truncated(utils::const_span<u8>(bytes.data(), bytes.size() - 1));
+    REQUIRE_FALSE(truncated.read(view));
+    REQUIRE_FALSE(truncated.skip());
+
+    // Misaligned data can't be viewed in place.
+    utils::array<u8> shifted;
+    shifted.push(0);
+    shifted.push_many(bytes);
+    REQUIRE_FALSE(utils::serial_reader(utils::const_span<u8>(shifted.data() + 1, bytes.size())).read(view));
+
+    // A count too large for the block.
+    utils::array<u8> corrupt(bytes);
+    reinterpret_cast<utils::serial_header*>(corrupt.data())->count = u64(1) << 40;
+    REQUIRE_FALSE(utils::serial_reader(corrupt).read(view));
+
+    // An arena whose free indices point at an element.
+    utils::basic_arena<u32> arena;
+    arena.create(1u);
+    arena.create(2u);
+    arena.destroy(0);
+    utils::array<u8> arena_bytes;
+    utils::serial_writer(arena_bytes).write(arena);
+    utils::arena_view<u32> av;
+    REQUIRE(utils::serial_reader(arena_bytes).read(av));
+    usize* free = const_cast<usize*>(av.free.data());
+    free[0] = 1;
+    REQUIRE_FALSE(utils::serial_reader(arena_bytes).read(av));
+
+    utils::serial_reader skipping(bytes);
+    REQUIRE(skipping.skip());
+    REQUIRE(skipping.done());
+    REQUIRE(utils::serial_reader(bytes).read(view));
+    REQUIRE(view[1].value == 2);
+}
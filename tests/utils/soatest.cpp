@@ -0,0 +1,212 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/soa_array.hpp>
+
+class ref_counter
+{
+public:
+    inline ref_counter() noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(const ref_counter& other) noexcept
+    {
+        count++;
+    }
+
+    inline ref_counter(ref_counter&& other) noexcept
+    {
+        count++;
+    }
+
+    inline ~ref_counter() noexcept
+    {
+        count--;
+    }
+
+    inline ref_counter& operator=(const ref_counter& other) noexcept
+    {
+        return *this;
+    }
+
+    inline ref_counter& operator=(ref_counter&& other) noexcept
+    {
+        return *this;
+    }
+
+    static inline int get() noexcept { return count; }
+
+private:
+    static inline int count = 0;
+};
+
+TEST_CASE("basic soa array check", "[soa-array]")
+{
+    utils::soa_array<f32, u8, i64> arr;
+    arr.push(1.5f, 2, 30);
+    arr.push(2.5f, 4, 60);
+    arr.push(3.5f, 6, 90);
+    REQUIRE(arr.size() == 3);
+
+    SECTION("constructor")
+    {
+        SECTION("default")
+        {
+            utils::soa_array<f32, u8> arr;
+            REQUIRE(arr.size() == 0);
+            REQUIRE(arr.capacity() == 0);
+            REQUIRE(arr.empty());
+        }
+
+        SECTION("capacity")
+        {
+            utils::soa_array<f32, u8> arr(20);
+            REQUIRE(arr.size() == 0);
+            REQUIRE(arr.capacity() == 20);
+        }
+
+        SECTION("move")
+        {
+            utils::soa_array<f32, u8, i64> arr2(::std::move(arr));
+            REQUIRE(arr2.size() == 3);
+            REQUIRE(arr2.get<0>(1) == 2.5f);
+            REQUIRE(arr2.get<2>(2) == 90);
+            REQUIRE(arr.size() == 0);
+        }
+
+        SECTION("copy")
+        {
+            utils::soa_array<f32, u8, i64> arr2(arr);
+            REQUIRE(arr2.size() == 3);
+            REQUIRE(arr2.get<0>(0) == 1.5f);
+            REQUIRE(arr2.get<1>(1) == 4);
+            REQUIRE(arr2.get<2>(2) == 90);
+        }
+    }
+
+    SECTION("assignment")
+    {
+        utils::soa_array<f32, u8, i64> arr2;
+        arr2.push(9.0f, 9, 9);
+
+        SECTION("move")
+        {
+            arr2 = ::std::move(arr);
+            REQUIRE(arr2.size() == 3);
+            REQUIRE(arr2.get<1>(2) == 6);
+        }
+
+        SECTION("copy")
+        {
+            arr2 = arr;
+            REQUIRE(arr2.size() == 3);
+            REQUIRE(arr2.get<1>(2) == 6);
+            REQUIRE(arr.get<1>(2) == 6);
+        }
+    }
+
+    SECTION("modify")
+    {
+        SECTION("push")
+        {
+            for(int i = 0; i < 1000; i++)
+                arr.push(f32(i), u8(i), i64(i) * 3);
+
+            REQUIRE(arr.size() == 1003);
+            REQUIRE(arr.get<0>(500) == 497.0f);
+            REQUIRE(arr.get<1>(500) == u8(497));
+            REQUIRE(arr.get<2>(500) == 497 * 3);
+            REQUIRE(arr.get<0>(1) == 2.5f);
+        }
+
+        SECTION("push many")
+        {
+            usize first = arr.push_many(10);
+            REQUIRE(first == 3);
+            REQUIRE(arr.size() == 13);
+
+            utils::span<i64> column = arr.column<2>().suffix(10);
+            for(i64& v : column)
+                v = 7;
+            REQUIRE(arr.get<2>(12) == 7);
+        }
+
+        SECTION("pop")
+        {
+            arr.pop();
+            REQUIRE(arr.size() == 2);
+            REQUIRE(arr.get<2>(1) == 60);
+
+            arr.pop_many(2);
+            REQUIRE(arr.empty());
+        }
+
+        SECTION("erase unordered")
+        {
+            arr.erase_unordered(0);
+            REQUIRE(arr.size() == 2);
+            REQUIRE(arr.get<0>(0) == 3.5f);
+            REQUIRE(arr.get<1>(0) == 6);
+            REQUIRE(arr.get<2>(0) == 90);
+
+            arr.erase_unordered(1);
+            REQUIRE(arr.size() == 1);
+            REQUIRE(arr.get<0>(0) == 3.5f);
+        }
+
+        SECTION("clear")
+        {
+            arr.clear();
+            REQUIRE(arr.empty());
+            REQUIRE(arr.capacity() >= 3);
+        }
+    }
+
+    SECTION("access")
+    {
+        SECTION("column")
+        {
+            utils::span<f32> positions = arr.column<0>();
+            REQUIRE(positions.size() == 3);
+            REQUIRE(positions[2] == 3.5f);
+
+            for(f32& p : positions)
+                p *= 2.0f;
+            REQUIRE(arr.get<0>(1) == 5.0f);
+        }
+
+        SECTION("alignment")
+        {
+            arr.reserve(77);
+            REQUIRE(reinterpret_cast<usize>(arr.column<0>().data()) % arr.column_alignment == 0);
+            REQUIRE(reinterpret_cast<usize>(arr.column<1>().data()) % arr.column_alignment == 0);
+            REQUIRE(reinterpret_cast<usize>(arr.column<2>().data()) % arr.column_alignment == 0);
+        }
+    }
+
+    SECTION("lifetime")
+    {
+        utils::soa_array<int, ref_counter> arr;
+        REQUIRE(ref_counter::get() == 0);
+
+        for(int i = 0; i < 100; i++)
+            arr.push(i, ref_counter());
+        REQUIRE(ref_counter::get() == 100);
+
+        arr.erase_unordered(5);
+        arr.pop();
+        REQUIRE(ref_counter::get() == 98);
+
+        utils::soa_array<int, ref_counter> copy(arr);
+        REQUIRE(ref_counter::get() == 196);
+
+        copy.push_many(4);
+        REQUIRE(ref_counter::get() == 200);
+
+        copy = utils::soa_array<int, ref_counter>();
+        REQUIRE(ref_counter::get() == 98);
+
+        arr.clear();
+        REQUIRE(ref_counter::get() == 0);
+    }
+}
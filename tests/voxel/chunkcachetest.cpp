@@ -0,0 +1,132 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/chunk_cache.hpp>
+
+#include "chunkhelpers.hpp"
+
+// A disk standing in for region files.
+struct disk
+{
+    voxel::chunk_map<utils::array<u8>> payloads;
+    usize writes = 0;
+};
+
+static void spill(const voxel::chunk_coord& c, utils::array<u8>&& payload, void* user)
+{
+    disk& d = *static_cast<disk*>(user);
+    d.payloads[d.payloads.insert(c)] = ::std::move(payload);
+    d.writes++;
+}
+
+TEST_CASE("chunk cache tiers check", "[voxel][cache]")
+{
+    std::mt19937 rng(51);
+    utils::array<voxel::chunk> reference;
+    for(u32 i = 0; i != 64; i++)
+        random_chunk(reference.push(), 2 + i % 20, rng);
+
+    disk d;
+    const usize budget = 128 << 10, hot_budget = 96 << 10;
+    voxel::chunk_cache cache(budget, hot_budget, spill, &d);
+
+    for(i32 i = 0; i != 64; i++)
+    {
+        voxel::chunk copy = reference[i];
+        cache.insert(voxel::chunk_coord { i, 0, 0 }, ::std::move(copy), true);
+        REQUIRE(cache.memory() <= budget);
+        REQUIRE(cache.hot_memory() <= hot_budget);
+    }
+
+    // The most recent chunks stay hot, older ones went cold, and the oldest to disk.
+    REQUIRE(cache.hot(voxel::chunk_coord { 63, 0, 0 }));
+    REQUIRE(cache.cold_size() > 0);
+    REQUIRE(d.writes > 0);
+    REQUIRE_FALSE(cache.contains(voxel::chunk_coord { 0, 0, 0 }));
+    REQUIRE(cache.size() + d.writes == 64);
+
+    // Nothing is lost: every chunk is either cached or written.
+    for(i32 i = 0; i != 64; i++)
+    {
+        voxel::chunk_coord c { i, 0, 0 };
+        if(cache.contains(c))
+        {
+            voxel::chunk* value = cache.get(c);
+            REQUIRE(value != nullptr);
+            REQUIRE(same(*value, reference[i]));
+            REQUIRE(cache.hot(c));
+        }
+        else
+        {
+            utils::array<u8>* payload = d.payloads.get(c);
+            REQUIRE(payload != nullptr);
+            voxel::chunk value;
+            REQUIRE(voxel::decompress_chunk(*payload, value));
+            REQUIRE(same(value, reference[i]));
+        }
+        REQUIRE(cache.memory() <= budget);
+    }
+    REQUIRE(cache.get(voxel::chunk_coord { 0, 1, 0 }) == nullptr);
+}
+
+TEST_CASE("chunk cache writes check", "[voxel][cache]")
+{
+    std::mt19937 rng(52);
+    disk d;
+    voxel::chunk_cache cache(1 << 20, 512 << 10, spill, &d);
+
+    // Chunks read from disk are clean, and dropped without a write.
+    utils::array<u8> payload;
+    voxel::chunk original;
+    random_chunk(original, 6, rng);
+    voxel::compress_chunk(original, payload);
+    cache.insert(voxel::chunk_coord { 1, 2, 3 }, ::std::move(payload));
+    REQUIRE(cache.contains(voxel::chunk_coord { 1, 2, 3 }));
+    REQUIRE_FALSE(cache.hot(voxel::chunk_coord { 1, 2, 3 }));
+    REQUIRE(same(*cache.get(voxel::chunk_coord { 1, 2, 3 }), original));
+
+    voxel::chunk clean;
+    random_chunk(clean, 4, rng);
+    cache.insert(voxel::chunk_coord { 0, 0, 0 }, ::std::move(clean), false);
+    REQUIRE(cache.flush() == 0);
+
+    // Edits make them dirty.
+    cache.get(voxel::chunk_coord { 0, 0, 0 })->set(voxel::local_coord { 1, 1, 1 }, 999);
+    cache.changed(voxel::chunk_coord { 0, 0, 0 });
+    REQUIRE(cache.flush() == 1);
+    REQUIRE(d.payloads.get(voxel::chunk_coord { 0, 0, 0 }) != nullptr);
+    REQUIRE(cache.flush() == 0);
+
+    voxel::chunk generated;
+    random_chunk(generated, 3, rng);
+    cache.insert(voxel::chunk_coord { 5, 5, 5 }, ::std::move(generated), true);
+    REQUIRE(cache.erase(voxel::chunk_coord { 5, 5, 5 }));
+    REQUIRE_FALSE(cache.erase(voxel::chunk_coord { 5, 5, 5 }));
+    REQUIRE(cache.size() == 2);
+
+    // Shrinking the budget pushes everything but the last used chunk out.
+    cache.get(voxel::chunk_coord { 0, 0, 0 })->set(voxel::local_coord { 2, 1, 1 }, 998);
+    cache.changed(voxel::chunk_coord { 0, 0, 0 });
+    cache.get(voxel::chunk_coord { 1, 2, 3 });
+    usize writes = d.writes;
+    cache.set_budget(0, 0);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.hot(voxel::chunk_coord { 1, 2, 3 }));
+    REQUIRE(d.writes == writes + 1);
+
+    voxel::chunk written;
+    REQUIRE(voxel::decompress_chunk(*d.payloads.get(voxel::chunk_coord { 0, 0, 0 }), written));
+    REQUIRE(written.get(voxel::local_coord { 2, 1, 1 }) == 998);
+
+    cache.erase(voxel::chunk_coord { 1, 2, 3 });
+    REQUIRE(cache.memory() == 0);
+
+    // A corrupt payload is dropped rather than written back over the chunk on disk.
+    cache.set_budget(1 << 20, 512 << 10);
+    utils::array<u8> corrupt;
+    corrupt.push_many(7, 40);
+    cache.insert(voxel::chunk_coord { 9, 9, 9 }, ::std::move(corrupt));
+    REQUIRE(cache.get(voxel::chunk_coord { 9, 9, 9 }) == nullptr);
+    REQUIRE_FALSE(cache.contains(voxel::chunk_coord { 9, 9, 9 }));
+    REQUIRE(cache.flush() == 0);
+    REQUIRE(d.payloads.get(voxel::chunk_coord { 9, 9, 9 }) == nullptr);
+    REQUIRE(cache.memory() == 0);
+}
@@ -0,0 +1,38 @@
+/**
+ * @file
+ * @brief Chunks shared by the tests of regions and caches.
+ */
+#pragma once
+
+#include <voxel/chunk.hpp>
+
+#include <random>
+
+/// @brief Compares two chunks voxel by voxel.
+/// @param a The first chunk.
+/// @param b The second chunk.
+/// @return true if every voxel holds the same block, false otherwise.
+inline bool same(const voxel::chunk& a, const voxel::chunk& b)
+{
+    for(usize i = 0; i != voxel::chunk_volume; i++)
+        if(a.get(i) != b.get(i))
+            return false;
+    return true;
+}
+
+/// @brief Fills a chunk with blocks drawn from a number of distinct ones, in runs like terrain.
+/// @param c The chunk.
+/// @param distinct The number of distinct blocks.
+/// @param rng The generator the blocks and the lengths of the runs are drawn from.
+inline void random_chunk(voxel::chunk& c, u32 distinct, std::mt19937& rng)
+{
+    std::uniform_int_distribution<u32> pick(0, distinct - 1), run(1, 300);
+    utils::array<voxel::block> blocks;
+    while(blocks.size() != voxel::chunk_volume)
+    {
+        voxel::block b = static_cast<voxel::block>(pick(rng) * 5 + 1);
+        for(u32 n = run(rng); n != 0 && blocks.size() != voxel::chunk_volume; n--)
+            blocks.push(b);
+    }
+    c.encode(blocks);
+}
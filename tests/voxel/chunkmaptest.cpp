@@ -0,0 +1,175 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/chunk_map.hpp>
+
+#include <random>
+#include <thread>
+
+TEST_CASE("basic chunk map check", "[voxel][chunk_map]")
+{
+    voxel::chunk_map<int> map;
+
+    SECTION("morton codes")
+    {
+        voxel::chunk_coord coords[] = { { 0, 0, 0 }, { -1, 2, -3 }, { (1 << 20) - 1, -(1 << 20), 12345 } };
+        for(const voxel::chunk_coord& c : coords)
+            REQUIRE(voxel::chunk_map<int>::decode(voxel::chunk_map<int>::encode(c)) == c);
+
+        REQUIRE(voxel::chunk_coord::containing(-1, 31, 32) == voxel::chunk_coord { -1, 0, 1 });
+    }
+
+    SECTION("insert and find")
+    {
+        REQUIRE(map.empty());
+        REQUIRE(map.find({ 1, 2, 3 }) == map.none);
+
+        u32 a = map.insert({ 1, 2, 3 }, 10);
+        u32 b = map.insert({ -1, 2, 3 }, 20);
+        REQUIRE(map.size() == 2);
+        REQUIRE(map.insert({ 1, 2, 3 }, 30) == a);
+        REQUIRE(map[a] == 10);
+        REQUIRE(map.find({ -1, 2, 3 }) == b);
+        REQUIRE(*map.get({ 1, 2, 3 }) == 10);
+        REQUIRE(map.get({ 0, 0, 0 }) == nullptr);
+    }
+
+    SECTION("erase")
+    {
+        for(i32 i = 0; i != 1000; i++)
+            map.insert({ i, -i, i / 2 }, int(i));
+
+        for(i32 i = 0; i != 1000; i += 2)
+            REQUIRE(map.erase({ i, -i, i / 2 }));
+        REQUIRE(!map.erase({ 0, 0, 0 }));
+        REQUIRE(map.size() == 500);
+
+        for(i32 i = 0; i != 1000; i++)
+        {
+            const int* v = map.get({ i, -i, i / 2 });
+            if(i % 2 == 0)
+                REQUIRE(v == nullptr);
+            else
+                REQUIRE((v != nullptr && *v == i));
+        }
+
+        usize visited = 0;
+        map.for_each([&](const voxel::chunk_coord& c, u32 index) {
+            REQUIRE(c.x == map[index]);
+            visited++;
+        });
+        REQUIRE(visited == 500);
+
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(map.find({ 1, -1, 0 }) == map.none);
+    }
+
+    SECTION("last hit cache")
+    {
+        u32 a = map.insert({ 4, 4, 4 }, 1);
+        REQUIRE(map.find({ 4, 4, 4 }) == a);
+        REQUIRE(map.find({ 4, 4, 4 }) == a);
+
+        map.erase({ 4, 4, 4 });
+        REQUIRE(map.find({ 4, 4, 4 }) == map.none);
+
+        voxel::chunk_map<int> other;
+        other.insert({ 4, 4, 4 }, 2);
+        REQUIRE(*other.get({ 4, 4, 4 }) == 2);
+        REQUIRE(map.find({ 4, 4, 4 }) == map.none);
+    }
+
+    SECTION("neighbors")
+    {
+        for(i32 z = -1; z <= 1; z++)
+            for(i32 y = -1; y <= 1; y++)
+                for(i32 x = -1; x <= 1; x++)
+                    if((x + y + z) % 2 == 0)
+                        map.insert({ 10 + x, y, -5 + z }, (x + 1) + 3 * (y + 1) + 9 * (z + 1));
+
+        u32 indices[27];
+        map.neighbors({ 10, 0, -5 }, utils::span<u32>(indices, 27));
+
+        int* values[27];
+        map.neighbors({ 10, 0, -5 }, utils::span<int*>(values, 27));
+
+        for(int i = 0; i != 27; i++)
+        {
+            int x = i % 3 - 1, y = i / 3 % 3 - 1, z = i / 9 - 1;
+            if((x + y + z) % 2 == 0)
+            {
+                REQUIRE(indices[i] != map.none);
+                REQUIRE(map[indices[i]] == i);
+                REQUIRE(*values[i] == i);
+            }
+            else
+            {
+                REQUIRE(indices[i] == map.none);
+                REQUIRE(values[i] == nullptr);
+            }
+        }
+    }
+
+    SECTION("random")
+    {
+        std::mt19937 rng(1);
+        utils::array<voxel::chunk_coord> coords;
+        for(int i = 0; i != 5000; i++)
+        {
+            voxel::chunk_coord c = { i32(rng() % 64) - 32, i32(rng() % 16) - 8, i32(rng() % 64) - 32 };
+            map.insert(c, i);
+            coords.push(c);
+        }
+
+        utils::array<u32> found;
+        found.push_many(0, coords.size());
+        map.find_many(coords, found);
+        for(usize i = 0; i != coords.size(); i++)
+            REQUIRE(found[i] == map.find(coords[i]));
+
+        for(usize i = 0; i < coords.size(); i += 3)
+            map.erase(coords[i]);
+
+        map.find_many(coords, found);
+        usize present = 0;
+        for(usize i = 0; i != coords.size(); i++)
+        {
+            REQUIRE(found[i] == map.find(coords[i]));
+            present += found[i] != map.none;
+        }
+        REQUIRE(present > 0);
+    }
+
+    SECTION("concurrent lookups")
+    {
+        for(i32 i = 0; i != 100; i++)
+            map.insert({ i, 0, 0 }, int(i));
+
+        std::atomic<int> errors = 0;
+        std::thread threads[4];
+        for(int t = 0; t != 4; t++)
+            threads[t] = std::thread([&map, &errors, t]() {
+                for(int k = 0; k != 10000; k++)
+                {
+                    i32 i = (k * (t + 1)) % 100;
+                    const int* v = map.get({ i, 0, 0 });
+                    if(v == nullptr || *v != i)
+                        errors++;
+                }
+            });
+
+        for(std::thread& t : threads)
+            t.join();
+        REQUIRE(errors == 0);
+    }
+}
+
+TEST_CASE("chunk map of chunks check", "[voxel][chunk_map]")
+{
+    voxel::chunk_map<> world;
+
+    u32 index = world.insert({ 0, -1, 0 }, voxel::block(3));
+    REQUIRE(world[index].get(0) == 3);
+
+    world.get({ 0, -1, 0 })->set(5, 1);
+    REQUIRE(world[index].get(5) == 1);
+}
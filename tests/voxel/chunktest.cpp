@@ -0,0 +1,208 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/chunk.hpp>
+
+#include <random>
+
+static bool matches(const voxel::chunk& c, const utils::array<voxel::block>& expected)
+{
+    utils::array<voxel::block> decoded;
+    decoded.push_many(0, voxel::chunk_volume);
+    c.decode(decoded);
+
+    for(usize i = 0; i != voxel::chunk_volume; i++)
+        if(decoded[i] != expected[i] || c.get(i) != expected[i])
+            return false;
+    return true;
+}
+
+TEST_CASE("basic chunk check", "[voxel][chunk]")
+{
+    voxel::chunk c(7);
+    utils::array<voxel::block> expected;
+    expected.push_many(7, voxel::chunk_volume);
+
+    SECTION("uniform")
+    {
+        REQUIRE(c.uniform());
+        REQUIRE(c.bits_per_voxel() == 0);
+        REQUIRE(c.palette_size() == 1);
+        REQUIRE(c.words().empty());
+        REQUIRE(c.get(voxel::local_coord { 31, 31, 31 }) == 7);
+        REQUIRE(matches(c, expected));
+
+        c.set(voxel::voxel_index(1, 2, 3), 7);
+        REQUIRE(c.uniform());
+    }
+
+    SECTION("widen")
+    {
+        c.set(voxel::local_coord { 1, 2, 3 }, 1);
+        expected[voxel::voxel_index(1, 2, 3)] = 1;
+        REQUIRE(c.bits_per_voxel() == 1);
+        REQUIRE(c.palette_size() == 2);
+        REQUIRE(c.words().size() == voxel::chunk_volume / 64);
+        REQUIRE(matches(c, expected));
+
+        for(voxel::block b = 2; b != 5; b++)
+        {
+            c.set(b, b);
+            expected[b] = b;
+        }
+        REQUIRE(c.bits_per_voxel() == 4);
+        REQUIRE(matches(c, expected));
+
+        for(voxel::block b = 5; b != 300; b++)
+        {
+            c.set(b, b);
+            expected[b] = b;
+        }
+        REQUIRE(c.bits_per_voxel() == voxel::chunk::direct_bits);
+        REQUIRE(c.palette_size() == 0);
+        REQUIRE(matches(c, expected));
+    }
+
+    SECTION("narrow")
+    {
+        for(voxel::block b = 1; b != 17; b++)
+            c.set(b, 100 + b);
+        REQUIRE(c.bits_per_voxel() == 8);
+
+        for(voxel::block b = 1; b != 10; b++)
+            c.set(b, 7);
+        REQUIRE(c.palette_size() == 8);
+        REQUIRE(c.bits_per_voxel() == 4);
+
+        for(voxel::block b = 10; b != 15; b++)
+            c.set(b, 7);
+        REQUIRE(c.palette_size() == 3);
+        REQUIRE(c.bits_per_voxel() == 4);
+
+        c.set(15, 7);
+        REQUIRE(c.bits_per_voxel() == 1);
+        c.set(16, 7);
+        REQUIRE(c.uniform());
+        REQUIRE(c.get(16) == 7);
+        REQUIRE(matches(c, expected));
+    }
+
+    SECTION("hysteresis")
+    {
+        c.set(0, 1);
+        c.set(1, 2);
+        REQUIRE(c.bits_per_voxel() == 2);
+
+        for(int i = 0; i != 10; i++)
+        {
+            c.set(1, 7);
+            REQUIRE(c.bits_per_voxel() == 2);
+            c.set(1, 2);
+            REQUIRE(c.bits_per_voxel() == 2);
+        }
+
+        c.set(1, 7);
+        c.set(0, 7);
+        REQUIRE(c.uniform());
+    }
+
+    SECTION("free entries are reused")
+    {
+        for(voxel::block b = 1; b != 4; b++)
+            c.set(b, b);
+        REQUIRE(c.bits_per_voxel() == 2);
+
+        c.set(2, 7);
+        c.set(2, 9);
+        REQUIRE(c.bits_per_voxel() == 2);
+        REQUIRE(c.palette().size() == 4);
+        REQUIRE(c.get(2) == 9);
+    }
+
+    SECTION("encode and decode")
+    {
+        std::mt19937 rng(3);
+        for(usize i = 0; i != voxel::chunk_volume; i++)
+            expected[i] = voxel::block(rng() % 12);
+
+        c.encode(expected);
+        REQUIRE(c.bits_per_voxel() == 4);
+        REQUIRE(c.palette_size() == 12);
+        REQUIRE(matches(c, expected));
+        REQUIRE(c.memory_usage() < voxel::chunk_volume * sizeof(voxel::block) / 3);
+
+        for(usize i = 0; i != voxel::chunk_volume; i++)
+            expected[i] = voxel::block(rng() % 1000);
+        c.encode(expected);
+        REQUIRE(c.bits_per_voxel() == voxel::chunk::direct_bits);
+        REQUIRE(matches(c, expected));
+
+        for(usize i = 0; i != voxel::chunk_volume; i++)
+            expected[i] = voxel::block(i < voxel::chunk_volume / 2 ? 1 : 2);
+        c.encode(expected);
+        REQUIRE(c.bits_per_voxel() == 1);
+        REQUIRE(matches(c, expected));
+    }
+
+    SECTION("shrink to fit")
+    {
+        for(voxel::block b = 1; b != 300; b++)
+            c.set(b, b);
+        REQUIRE(c.bits_per_voxel() == voxel::chunk::direct_bits);
+
+        for(voxel::block b = 1; b != 300; b++)
+            c.set(b, b % 3 == 0 ? 7 : 3);
+        REQUIRE(c.bits_per_voxel() == voxel::chunk::direct_bits);
+
+        c.shrink_to_fit();
+        REQUIRE(c.bits_per_voxel() == 1);
+        REQUIRE(c.palette_size() == 2);
+        REQUIRE(c.get(3) == 7);
+        REQUIRE(c.get(4) == 3);
+    }
+
+    SECTION("bulk")
+    {
+        utils::array<voxel::local_coord> coords;
+        utils::array<voxel::block> blocks;
+        for(u8 x = 0; x != 32; x++)
+        {
+            coords.push(voxel::local_coord { x, u8(x / 2), 5 });
+            blocks.push(voxel::block(x % 20));
+        }
+
+        c.set_many(coords, blocks);
+        REQUIRE(c.bits_per_voxel() == 8);
+        for(usize i = 0; i != coords.size(); i++)
+            expected[coords[i].index()] = blocks[i];
+        REQUIRE(matches(c, expected));
+
+        utils::array<voxel::block> read;
+        read.push_many(0, coords.size());
+        c.get_many(coords, read);
+        for(usize i = 0; i != coords.size(); i++)
+            REQUIRE(read[i] == blocks[i]);
+
+        c.set_many(coords, 7);
+        REQUIRE(c.uniform());
+
+        c.fill(2);
+        REQUIRE(c.uniform());
+        REQUIRE(c.get(100) == 2);
+    }
+
+    SECTION("random edits")
+    {
+        std::mt19937 rng(11);
+        for(int i = 0; i != 20000; i++)
+        {
+            usize index = rng() % voxel::chunk_volume;
+            voxel::block b = voxel::block(rng() % (i < 10000 ? 40 : 3));
+            c.set(index, b);
+            expected[index] = b;
+        }
+        REQUIRE(matches(c, expected));
+
+        c.shrink_to_fit();
+        REQUIRE(c.bits_per_voxel() <= 8);
+        REQUIRE(matches(c, expected));
+    }
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/culling.hpp>
+
+#include <cmath>
+#include <random>
+
+// A camera at the origin looking down -z, with a 90 degree field of view.
+static void perspective(f32* m, f32 aspect)
+{
+    const f32 near = 0.1f, far = 500;
+    for(u32 i = 0; i != 16; i++)
+        m[i] = 0;
+    m[0] = 1 / aspect;
+    m[5] = 1;
+    m[10] = (far + near) / (near - far);
+    m[11] = 2 * far * near / (near - far);
+    m[14] = -1;
+}
+
+static voxel::chunk_bounds box(f32 x0, f32 y0, f32 z0, f32 x1, f32 y1, f32 z1, bool occluder = false)
+{
+    return voxel::chunk_bounds { x0, y0, z0, x1, y1, z1, occluder };
+}
+
+static bool contains(const utils::array<u32>& a, u32 v)
+{
+    for(u32 x : a)
+        if(x == v)
+            return true;
+    return false;
+}
+
+TEST_CASE("frustum culling check", "[voxel][culling]")
+{
+    f32 m[16];
+    perspective(m, 2);
+    voxel::frustum f = voxel::frustum::from_matrix(m);
+
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<f32> position(-300, 300), size(0.5f, 40);
+    utils::array<voxel::chunk_bounds> boxes;
+    for(u32 i = 0; i != 1003; i++)
+    {
+        f32 x = position(rng), y = position(rng), z = position(rng), s = size(rng);
+        boxes.push(box(x, y, z, x + s, y + s, z + s));
+    }
+
+    utils::array<u32> visible;
+    voxel::frustum_cull(f, boxes, visible);
+
+    // A box is outside if all its corners are outside the same plane.
+    utils::array<u32> expected;
+    for(u32 i = 0; i != boxes.size(); i++)
+    {
+        const voxel::chunk_bounds& b = boxes[i];
+        bool inside = true;
+        for(const f32* p : f.planes)
+        {
+            bool any = false;
+            for(u32 c = 0; c != 8; c++)
+            {
+                f32 x = c & 1 ? b.max_x : b.min_x, y = c & 2 ? b.max_y : b.min_y, z = c & 4 ? b.max_z : b.min_z;
+                any = any || p[0] * x + p[1] * y + p[2] * z + p[3] >= 0;
+            }
+            inside = inside && any;
+        }
+        if(inside)
+            expected.push(i);
+    }
+
+    REQUIRE(visible.size() == expected.size());
+    bool same = true;
+    for(usize i = 0; i != visible.size(); i++)
+        same = same && visible[i] == expected[i];
+    REQUIRE(same);
+    REQUIRE(visible.size() > 50);
+    REQUIRE(visible.size() < 500);
+
+    // Straight ahead, behind, past the far plane, and inside and outside the left plane.
+    utils::array<voxel::chunk_bounds> simple;
+    simple.push(box(-1, -1, -10, 1, 1, -8));
+    simple.push(box(-1, -1, 8, 1, 1, 10));
+    simple.push(box(-1, -1, -600, 1, 1, -550));
+    simple.push(box(-19, -1, -10, -15, 1, -8));
+    simple.push(box(-25, -1, -10, -21, 1, -8));
+    visible.clear();
+    voxel::frustum_cull(f, simple, visible);
+    REQUIRE(visible.size() == 2);
+    REQUIRE(visible[0] == 0);
+    REQUIRE(visible[1] == 3);
+}
+
+TEST_CASE("occlusion culling check", "[voxel][culling]")
+{
+    f32 m[16];
+    perspective(m, 1);
+
+    // A wall of occluders covering x and y in [-10, 10] at z = -20.
+    utils::array<voxel::chunk_bounds> boxes;
+    for(i32 y = -2; y != 2; y++)
+        for(i32 x = -2; x != 2; x++)
+            boxes.push(box(f32(x) * 5, f32(y) * 5, -21, f32(x + 1) * 5, f32(y + 1) * 5, -20, true));
+    u32 wall = static_cast<u32>(boxes.size());
+
+    boxes.push(box(-5, -5, -65, 5, 5, -55));          // hidden behind the wall
+    boxes.push(box(40, -5, -65, 45, 5, -55));         // beside the wall
+    boxes.push(box(-5, 35, -65, 5, 40, -55));         // above the wall
+    boxes.push(box(-2, -2, -12, 2, 2, -10));          // in front of the wall
+    boxes.push(box(-1, -1, -1, 1, 1, 1));             // around the camera
+    boxes.push(box(-3, -3, -100, 3, 3, -90, true));   // hidden occluder
+    boxes.push(box(-1, -1, -150, 1, 1, -140));        // hidden behind both
+
+    voxel::culler culler(128, 128);
+    utils::array<u32> visible;
+    culler.cull(m, boxes, visible);
+
+    for(u32 i = 0; i != wall; i++)
+        REQUIRE(contains(visible, i));
+    REQUIRE_FALSE(contains(visible, wall));
+    REQUIRE(contains(visible, wall + 1));
+    REQUIRE(contains(visible, wall + 2));
+    REQUIRE(contains(visible, wall + 3));
+    REQUIRE(contains(visible, wall + 4));
+    REQUIRE_FALSE(contains(visible, wall + 5));
+    REQUIRE_FALSE(contains(visible, wall + 6));
+    REQUIRE(visible.size() == wall + 4);
+
+    // From front to back.
+    auto depth = [&](u32 i) { return -(boxes[i].min_z + boxes[i].max_z) / 2; };
+    for(usize i = 1; i != visible.size(); i++)
+        REQUIRE(depth(visible[i - 1]) <= depth(visible[i]));
+
+    // The wall is drawn in the middle of the depth buffer.
+    REQUIRE(culler.depth()[64 * 128 + 64] < 1);
+    REQUIRE(culler.depth()[64 * 128 + 2] == 1);
+
+    SECTION("boxes that aren't occluders hide nothing")
+    {
+        for(u32 i = 0; i != wall; i++)
+            boxes[i].occluder = false;
+        visible.clear();
+        culler.cull(m, boxes, visible);
+        REQUIRE(visible.size() == boxes.size() - 1);
+        REQUIRE(contains(visible, wall));
+        REQUIRE(contains(visible, wall + 5));
+        REQUIRE_FALSE(contains(visible, wall + 6));
+    }
+
+    SECTION("a gap in the wall")
+    {
+        boxes[5].occluder = false;
+        visible.clear();
+        culler.cull(m, boxes, visible);
+        REQUIRE(contains(visible, wall));
+        REQUIRE(contains(visible, wall + 5));
+    }
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/light.hpp>
+
+#include <cstring>
+#include <random>
+
+static constexpr voxel::block stone = 1;
+static constexpr voxel::block torch = 2;
+static constexpr voxel::block glass = 3;
+
+static void setup(voxel::light_engine& engine)
+{
+    engine.set_emission(torch, 14);
+    engine.set_transparent(glass, true);
+}
+
+// Lights the whole map from scratch with a new engine and compares it with another engine.
+static bool same_light(voxel::chunk_map<>& world, const voxel::light_engine& engine)
+{
+    voxel::light_engine fresh(world);
+    setup(fresh);
+    world.for_each([&](const voxel::chunk_coord& c, u32) { fresh.chunk_added(c); });
+    fresh.update();
+
+    bool same = true;
+    world.for_each([&](const voxel::chunk_coord& c, u32) {
+        utils::const_span<u8> a = fresh.find(c)->data(), b = engine.find(c)->data();
+        same = same && std::memcmp(a.data(), b.data(), a.size()) == 0;
+    });
+    return same;
+}
+
+TEST_CASE("basic light check", "[voxel][light]")
+{
+    // A 3x2x3 world with the ground in the lower layer of chunks.
+    voxel::chunk_map<> world;
+    for(i32 z = -1; z <= 1; z++)
+        for(i32 y = -1; y <= 0; y++)
+            for(i32 x = -1; x <= 1; x++)
+            {
+                voxel::chunk& c = world[world.insert(voxel::chunk_coord { x, y, z })];
+                if(y < 0)
+                    for(u32 vz = 0; vz != 32; vz++)
+                        for(u32 vx = 0; vx != 32; vx++)
+                            for(u32 vy = 0; vy != 20 + (vx + vz) % 5; vy++)
+                                c.set(voxel::voxel_index(vx, vy, vz), stone);
+            }
+
+    voxel::light_engine engine(world);
+    setup(engine);
+    world.for_each([&](const voxel::chunk_coord& c, u32) { engine.chunk_added(c); });
+    engine.update();
+
+    voxel::chunk_coord sky_chunk { 0, 0, 0 };
+    voxel::chunk_coord ground { 0, -1, 0 };
+
+    SECTION("sky")
+    {
+        REQUIRE(engine.get(sky_chunk, { 5, 31, 5 }, voxel::light_channel::sky) == voxel::max_light);
+        REQUIRE(engine.get(sky_chunk, { 5, 0, 5 }, voxel::light_channel::sky) == voxel::max_light);
+        REQUIRE(engine.get(ground, { 0, 25, 0 }, voxel::light_channel::sky) == voxel::max_light);
+        REQUIRE(engine.get(ground, { 0, 10, 0 }, voxel::light_channel::sky) == 0);
+        REQUIRE(engine.get(sky_chunk, { 5, 0, 5 }, voxel::light_channel::block) == 0);
+    }
+
+    SECTION("torch")
+    {
+        voxel::local_coord v { 30, 10, 16 };
+        world.get(sky_chunk)->set(v, torch);
+        engine.block_changed(sky_chunk, v);
+        engine.update();
+
+        REQUIRE(engine.get(sky_chunk, v, voxel::light_channel::block) == 14);
+        REQUIRE(engine.get(sky_chunk, { 31, 10, 16 }, voxel::light_channel::block) == 13);
+        REQUIRE(engine.get(sky_chunk, { 25, 10, 16 }, voxel::light_channel::block) == 9);
+        REQUIRE(engine.get(voxel::chunk_coord { 1, 0, 0 }, { 2, 10, 16 }, voxel::light_channel::block) == 10);
+        REQUIRE(same_light(world, engine));
+
+        // Removing the torch only visits the voxels it lit.
+        world.get(sky_chunk)->set(v, voxel::air);
+        engine.block_changed(sky_chunk, v);
+        usize visited = engine.update();
+        REQUIRE(visited < 2 * 14 * 14 * 14);
+        REQUIRE(engine.get(sky_chunk, { 31, 10, 16 }, voxel::light_channel::block) == 0);
+        REQUIRE(same_light(world, engine));
+    }
+
+    SECTION("shadow")
+    {
+        // A roof over a column of air casts a shadow that fades in from the sides.
+        for(u32 x = 10; x != 15; x++)
+            for(u32 z = 10; z != 15; z++)
+            {
+                world.get(sky_chunk)->set(voxel::local_coord { u8(x), 20, u8(z) }, stone);
+                engine.block_changed(sky_chunk, voxel::local_coord { u8(x), 20, u8(z) });
+            }
+        engine.update();
+
+        REQUIRE(engine.get(sky_chunk, { 12, 19, 12 }, voxel::light_channel::sky) == 12);
+        REQUIRE(engine.get(sky_chunk, { 12, 21, 12 }, voxel::light_channel::sky) == voxel::max_light);
+        REQUIRE(same_light(world, engine));
+
+        world.get(sky_chunk)->set(voxel::local_coord { 12, 20, 12 }, glass);
+        engine.block_changed(sky_chunk, voxel::local_coord { 12, 20, 12 });
+        engine.update();
+        REQUIRE(engine.get(sky_chunk, { 12, 19, 12 }, voxel::light_channel::sky) == voxel::max_light);
+        REQUIRE(same_light(world, engine));
+    }
+
+    SECTION("chunks")
+    {
+        // A chunk added above the world takes its sky light away from below.
+        voxel::chunk_coord top { 0, 1, 0 };
+        world.insert(top, stone);
+        engine.chunk_added(top);
+        engine.update();
+        REQUIRE(engine.get(sky_chunk, { 16, 31, 16 }, voxel::light_channel::sky) < voxel::max_light);
+        REQUIRE(same_light(world, engine));
+
+        engine.chunk_removed(top);
+        world.erase(top);
+        engine.update();
+        REQUIRE(engine.get(sky_chunk, { 16, 31, 16 }, voxel::light_channel::sky) == voxel::max_light);
+        REQUIRE(same_light(world, engine));
+    }
+
+    SECTION("random edits")
+    {
+        std::mt19937 rng(40);
+        voxel::block blocks[] = { voxel::air, stone, torch, glass };
+        for(u32 round = 0; round != 10; round++)
+        {
+            for(u32 i = 0; i != 20; i++)
+            {
+                voxel::chunk_coord c { i32(rng() % 3) - 1, i32(rng() % 2) - 1, i32(rng() % 3) - 1 };
+                voxel::local_coord v { u8(rng() % 32), u8(rng() % 32), u8(rng() % 32) };
+                if(c.y < 0)
+                    v.y = u8(16 + rng() % 16);
+                world.get(c)->set(v, blocks[rng() % 4]);
+                engine.block_changed(c, v);
+            }
+
+            engine.update();
+            REQUIRE(same_light(world, engine));
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/lod.hpp>
+
+#include <random>
+
+static constexpr voxel::block stone = 1, dirt = 2, grass = 3;
+
+// Downsamples the chunk level by level, picking every voxel with the same rules.
+static void reference(const voxel::chunk& c, voxel::lod_filter filter, utils::array<voxel::block>* levels)
+{
+    utils::array<voxel::block> source;
+    for(usize i = 0; i != voxel::chunk_volume; i++)
+        source.push(c.get(i));
+
+    for(u32 l = 1; l <= voxel::chunk_lod::level_count; l++)
+    {
+        u32 s = voxel::chunk_lod::size(l);
+        levels[l - 1].clear();
+        for(u32 z = 0; z != s; z++)
+            for(u32 y = 0; y != s; y++)
+                for(u32 x = 0; x != s; x++)
+                {
+                    u32 counts[4] = { 0, 0, 0, 0 };
+                    for(u32 k = 0; k != 8; k++)
+                        counts[source[(2 * x + (k & 1)) + (2 * y + ((k >> 1) & 1)) * 2 * s + (2 * z + (k >> 2)) * 4 * s * s]]++;
+
+                    voxel::block best = voxel::air;
+                    u32 most = filter == voxel::lod_filter::majority ? counts[voxel::air] : 0;
+                    for(voxel::block b = 1; b != 4; b++)
+                        if(counts[b] != 0 && (counts[b] > most || (counts[b] == most && best == voxel::air)))
+                        {
+                            best = b;
+                            most = counts[b];
+                        }
+                    // Among opaque blocks tied for the most, the first sample of them wins.
+                    for(u32 k = 0; k != 8 && best != voxel::air; k++)
+                    {
+                        voxel::block b = source[(2 * x + (k & 1)) + (2 * y + ((k >> 1) & 1)) * 2 * s + (2 * z + (k >> 2)) * 4 * s * s];
+                        if(b != voxel::air && counts[b] == most)
+                        {
+                            best = b;
+                            break;
+                        }
+                    }
+                    levels[l - 1].push(best);
+                }
+        source = levels[l - 1];
+    }
+}
+
+static bool same(const voxel::chunk_lod& lod, const utils::array<voxel::block>* levels)
+{
+    for(u32 l = 1; l <= voxel::chunk_lod::level_count; l++)
+    {
+        utils::const_span<voxel::block> level = lod.level(l);
+        if(level.size() != levels[l - 1].size())
+            return false;
+        for(usize i = 0; i != level.size(); i++)
+            if(level[i] != levels[l - 1][i])
+                return false;
+    }
+    return true;
+}
+
+static void terrain(voxel::chunk& c, std::mt19937& rng)
+{
+    std::uniform_int_distribution<u32> height(8, 24), percent(0, 99);
+    for(u8 z = 0; z != 32; z++)
+        for(u8 x = 0; x != 32; x++)
+        {
+            u8 h = u8(height(rng));
+            for(u8 y = 0; y != 32; y++)
+            {
+                voxel::block b = y > h ? voxel::air : y == h ? grass : y + 3 > h ? dirt : stone;
+                if(b != voxel::air && percent(rng) < 10)
+                    b = voxel::air;
+                c.set(voxel::local_coord { x, y, z }, b);
+            }
+        }
+}
+
+TEST_CASE("lod build check", "[voxel][lod]")
+{
+    for(u32 l = 1; l <= voxel::chunk_lod::level_count; l++)
+        REQUIRE(voxel::chunk_lod::size(l) == 32u >> l);
+    REQUIRE(voxel::chunk_lod::size(voxel::chunk_lod::level_count) == 1);
+
+    voxel::chunk_lod lod;
+    REQUIRE(lod.level(1).size() == 16 * 16 * 16);
+    REQUIRE(lod.get(3, 1, 2, 3) == voxel::air);
+
+    voxel::chunk c(stone);
+    lod.build(c);
+    for(u32 l = 1; l <= voxel::chunk_lod::level_count; l++)
+        for(voxel::block b : lod.level(l))
+            REQUIRE(b == stone);
+
+    std::mt19937 rng(45);
+    utils::array<voxel::block> levels[voxel::chunk_lod::level_count];
+    for(voxel::lod_filter filter : { voxel::lod_filter::majority, voxel::lod_filter::surface })
+    {
+        voxel::chunk_lod filtered(filter);
+        REQUIRE(filtered.filter() == filter);
+        for(u32 i = 0; i != 4; i++)
+        {
+            terrain(c, rng);
+            filtered.build(c);
+            reference(c, filter, levels);
+            REQUIRE(same(filtered, levels));
+        }
+    }
+}
+
+TEST_CASE("lod filters check", "[voxel][lod]")
+{
+    // A pillar one voxel thick along y.
+    voxel::chunk c;
+    for(u8 y = 0; y != 32; y++)
+        c.set(voxel::local_coord { 3, y, 6 }, stone);
+
+    voxel::chunk_lod majority(voxel::lod_filter::majority), surface(voxel::lod_filter::surface);
+    majority.build(c);
+    surface.build(c);
+    for(u32 l = 1; l <= voxel::chunk_lod::level_count; l++)
+        for(u32 y = 0; y != voxel::chunk_lod::size(l); y++)
+        {
+            REQUIRE(majority.get(l, 3 >> l, y, 6 >> l) == voxel::air);
+            REQUIRE(surface.get(l, 3 >> l, y, 6 >> l) == stone);
+        }
+    REQUIRE(surface.get(1, 0, 0, 0) == voxel::air);
+
+    // Three stone, two dirt and three air: opaque blocks win ties against air.
+    c.fill(voxel::air);
+    const voxel::block cell[8] = { stone, stone, stone, dirt, dirt, voxel::air, voxel::air, voxel::air };
+    for(u8 k = 0; k != 8; k++)
+        c.set(voxel::local_coord { u8(k & 1), u8((k >> 1) & 1), u8(k >> 2) }, cell[k]);
+    majority.build(c);
+    REQUIRE(majority.get(1, 0, 0, 0) == stone);
+    c.set(voxel::local_coord { 0, 1, 0 }, voxel::air);
+    majority.build(c);
+    REQUIRE(majority.get(1, 0, 0, 0) == voxel::air);
+    surface.build(c);
+    REQUIRE(surface.get(1, 0, 0, 0) == stone);
+}
+
+TEST_CASE("lod update check", "[voxel][lod]")
+{
+    std::mt19937 rng(46);
+    voxel::chunk c;
+    terrain(c, rng);
+
+    utils::array<voxel::block> levels[voxel::chunk_lod::level_count];
+    for(voxel::lod_filter filter : { voxel::lod_filter::majority, voxel::lod_filter::surface })
+    {
+        voxel::chunk_lod lod(filter);
+        lod.build(c);
+        REQUIRE_FALSE(lod.dirty());
+        REQUIRE(lod.update(c) == 0);
+
+        std::uniform_int_distribution<u32> coordinate(0, 31), block(0, 3);
+        for(u32 round = 0; round != 30; round++)
+        {
+            u32 edits = round % 3 == 0 ? 1 : 300;
+            for(u32 e = 0; e != edits; e++)
+            {
+                voxel::local_coord v { u8(coordinate(rng)), u8(coordinate(rng)), u8(coordinate(rng)) };
+                c.set(v, voxel::block(block(rng)));
+                lod.changed(v);
+            }
+            REQUIRE(lod.dirty());
+            usize count = lod.update(c);
+            REQUIRE_FALSE(lod.dirty());
+            REQUIRE(count >= 1);
+            REQUIRE(count <= edits * voxel::chunk_lod::level_count);
+
+            reference(c, filter, levels);
+            REQUIRE(same(lod, levels));
+        }
+
+        // An edit that doesn't change the first level stops there.
+        voxel::local_coord v { 0, 0, 0 };
+        voxel::block b = c.get(v);
+        c.set(v, b);
+        lod.changed(v);
+        REQUIRE(lod.update(c) == 1);
+    }
+}
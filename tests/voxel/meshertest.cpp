@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/mesher.hpp>
+
+#include <random>
+
+// Reads a voxel of the 3x3x3 neighborhood, with coordinates relative to the middle chunk.
+static voxel::block neighborhood_get(const voxel::chunk* const* neighborhood, int x, int y, int z)
+{
+    int cx = (x + 32) / 32, cy = (y + 32) / 32, cz = (z + 32) / 32;
+    const voxel::chunk* c = neighborhood[cx + 3 * cy + 9 * cz];
+    if(c == nullptr)
+        return voxel::air;
+    return c->get(voxel::voxel_index(usize(x + 32) % 32, usize(y + 32) % 32, usize(z + 32) % 32));
+}
+
+// Checks that the quads cover exactly the visible faces of the middle chunk, with the right blocks.
+static bool covers_visible_faces(const voxel::chunk* const* neighborhood, const utils::array<voxel::quad>& quads)
+{
+    utils::array<voxel::block> covered;
+    covered.push_many(voxel::air, voxel::chunk_volume * voxel::face_count);
+
+    for(const voxel::quad& q : quads)
+    {
+        u32 f = u32(q.direction()), axis = f >> 1, u = (axis + 1) % 3, v = (axis + 2) % 3;
+        for(u32 i = 0; i != q.width(); i++)
+            for(u32 j = 0; j != q.height(); j++)
+            {
+                u32 p[3] = { q.x(), q.y(), q.z() };
+                p[u] += i;
+                p[v] += j;
+                if(p[0] >= 32 || p[1] >= 32 || p[2] >= 32)
+                    return false;
+
+                voxel::block& slot = covered[voxel::voxel_index(p[0], p[1], p[2]) * voxel::face_count + f];
+                if(slot != voxel::air)
+                    return false;
+                slot = q.type();
+            }
+    }
+
+    for(int z = 0; z != 32; z++)
+        for(int y = 0; y != 32; y++)
+            for(int x = 0; x != 32; x++)
+            {
+                voxel::block b = neighborhood_get(neighborhood, x, y, z);
+                for(u32 f = 0; f != voxel::face_count; f++)
+                {
+                    int d[3] = { 0, 0, 0 };
+                    d[f >> 1] = f & 1 ? -1 : 1;
+                    bool visible = b != voxel::air && neighborhood_get(neighborhood, x + d[0], y + d[1], z + d[2]) == voxel::air;
+                    voxel::block expected = visible ? b : voxel::air;
+                    if(covered[voxel::voxel_index(x, y, z) * voxel::face_count + f] != expected)
+                        return false;
+                }
+            }
+
+    return true;
+}
+
+TEST_CASE("basic mesher check", "[voxel][mesher]")
+{
+    voxel::mesher mesher;
+    const voxel::chunk* neighborhood[27] = {};
+    utils::const_span<const voxel::chunk*> around(neighborhood, 27);
+    utils::array<voxel::quad> quads;
+
+    SECTION("quad packing")
+    {
+        voxel::quad q = voxel::quad::make(31, 2, 17, 32, 1, voxel::face::neg_z, 4000);
+        REQUIRE(q.x() == 31);
+        REQUIRE(q.y() == 2);
+        REQUIRE(q.z() == 17);
+        REQUIRE(q.width() == 32);
+        REQUIRE(q.height() == 1);
+        REQUIRE(q.direction() == voxel::face::neg_z);
+        REQUIRE(q.type() == 4000);
+    }
+
+    SECTION("empty")
+    {
+        voxel::chunk c;
+        neighborhood[13] = &c;
+        mesher.mesh(around, quads);
+        REQUIRE(quads.empty());
+    }
+
+    SECTION("single block")
+    {
+        voxel::chunk c;
+        c.set(voxel::local_coord { 3, 4, 5 }, 1);
+        neighborhood[13] = &c;
+        mesher.mesh(around, quads);
+        REQUIRE(quads.size() == 6);
+        REQUIRE(covers_visible_faces(neighborhood, quads));
+    }
+
+    SECTION("solid chunk")
+    {
+        voxel::chunk c(1);
+        neighborhood[13] = &c;
+        mesher.mesh(around, quads);
+        REQUIRE(quads.size() == 6);
+        for(const voxel::quad& q : quads)
+            REQUIRE(q.width() * q.height() == 32 * 32);
+
+        voxel::chunk stone(2);
+        for(usize i : { 4, 10, 12, 14, 16, 22 })
+            neighborhood[i] = &stone;
+
+        quads.clear();
+        mesher.mesh(around, quads);
+        REQUIRE(quads.empty());
+    }
+
+    SECTION("terrain")
+    {
+        std::mt19937 rng(7);
+        utils::array<voxel::block> blocks;
+        for(usize z = 0; z != 32; z++)
+            for(usize y = 0; y != 32; y++)
+                for(usize x = 0; x != 32; x++)
+                {
+                    usize height = 10 + (x * 7 + z * 3) % 9;
+                    blocks.push(y < height ? voxel::block(y < height - 2 ? 1 : 2) : voxel::air);
+                }
+
+        voxel::chunk c;
+        c.encode(blocks);
+        neighborhood[13] = &c;
+
+        voxel::chunk below(1), side;
+        side.encode(blocks);
+        neighborhood[10] = &below;
+        neighborhood[12] = &side;
+
+        utils::array<u32> ends;
+        ends.push_many(0, voxel::mesher::group_count);
+        mesher.load(around);
+        mesher.mesh(quads, ends);
+        REQUIRE(covers_visible_faces(neighborhood, quads));
+        REQUIRE(ends.back() == quads.size());
+
+        for(u32 f = 0; f != voxel::face_count; f++)
+            for(u32 s = 0; s != 32; s++)
+            {
+                u32 begin = f == 0 && s == 0 ? 0 : ends[f * 32 + s - 1];
+                utils::array<voxel::quad> slice;
+                mesher.mesh_slice(static_cast<voxel::face>(f), s, slice);
+                REQUIRE(slice.size() == ends[f * 32 + s] - begin);
+                for(usize i = 0; i != slice.size(); i++)
+                    REQUIRE(slice[i].data == quads[begin + i].data);
+            }
+    }
+
+    SECTION("random")
+    {
+        std::mt19937 rng(3);
+        voxel::chunk chunks[27];
+        for(usize i = 0; i != 27; i++)
+        {
+            for(int k = 0; k != 4000; k++)
+                chunks[i].set(rng() % voxel::chunk_volume, voxel::block(rng() % 4));
+            neighborhood[i] = &chunks[i];
+        }
+        neighborhood[14] = nullptr;
+
+        mesher.mesh(around, quads);
+        REQUIRE(covers_visible_faces(neighborhood, quads));
+    }
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/noise.hpp>
+
+#include <cstring>
+
+static const voxel::noise kinds[] = { voxel::noise::simplex, voxel::noise::value, voxel::noise::cellular };
+static const voxel::simd_level levels[] = { voxel::simd_level::scalar, voxel::simd_level::sse, voxel::simd_level::avx2 };
+
+static bool same_bits(const utils::array<f32>& a, const utils::array<f32>& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(f32)) == 0;
+}
+
+static bool in_range(const utils::array<f32>& a)
+{
+    for(f32 v : a)
+        if(!(v >= -1.0f && v <= 1.0f))
+            return false;
+    return true;
+}
+
+TEST_CASE("basic noise check", "[voxel][noise]")
+{
+    // A width that isn't a multiple of any vector width, so every row ends with scalar points.
+    voxel::noise_grid grid;
+    grid.x = -100.25f;
+    grid.y = 13.5f;
+    grid.z = 7.75f;
+    grid.step = 0.173f;
+    grid.width = 37;
+    grid.height = 11;
+    grid.depth = 5;
+
+    utils::array<f32> reference, other;
+    reference.push_many(0.0f, grid.volume());
+    other.push_many(0.0f, grid.volume());
+
+    SECTION("levels agree")
+    {
+        for(voxel::noise type : kinds)
+            for(voxel::simd_level level : levels)
+            {
+                voxel::noise_2d(type, 3, 0.5f, grid, reference.prefix(grid.area()), voxel::simd_level::scalar);
+                voxel::noise_2d(type, 3, 0.5f, grid, other.prefix(grid.area()), level);
+                REQUIRE(same_bits(reference, other));
+
+                voxel::noise_3d(type, 3, 0.5f, grid, reference, voxel::simd_level::scalar);
+                voxel::noise_3d(type, 3, 0.5f, grid, other, level);
+                REQUIRE(same_bits(reference, other));
+
+                voxel::fractal f;
+                voxel::fbm_3d(type, 3, 0.5f, f, grid, reference, voxel::simd_level::scalar);
+                voxel::fbm_3d(type, 3, 0.5f, f, grid, other, level);
+                REQUIRE(same_bits(reference, other));
+
+                voxel::ridged_2d(type, 3, 0.5f, f, grid, reference.prefix(grid.area()), voxel::simd_level::scalar);
+                voxel::ridged_2d(type, 3, 0.5f, f, grid, other.prefix(grid.area()), level);
+                REQUIRE(same_bits(reference, other));
+            }
+    }
+
+    SECTION("ranges")
+    {
+        voxel::fractal f;
+        f.octaves = 5;
+        for(voxel::noise type : kinds)
+        {
+            voxel::noise_3d(type, 11, 1.0f, grid, reference);
+            REQUIRE(in_range(reference));
+
+            voxel::fbm_3d(type, 11, 1.0f, f, grid, reference);
+            REQUIRE(in_range(reference));
+
+            voxel::ridged_3d(type, 11, 1.0f, f, grid, reference);
+            REQUIRE(in_range(reference));
+
+            voxel::noise_2d(type, 11, 1.0f, grid, reference.prefix(grid.area()));
+            f32 low = 1.0f, high = -1.0f;
+            for(usize i = 0; i != grid.area(); i++)
+            {
+                low = std::min(low, reference[i]);
+                high = std::max(high, reference[i]);
+            }
+            REQUIRE(low < high);
+        }
+    }
+
+    SECTION("points don't depend on the grid")
+    {
+        // Sampling a grid of a single point at the position of every point of a larger
+        // grid gives the same values.
+        for(voxel::noise type : kinds)
+        {
+            voxel::noise_3d(type, 5, 0.25f, grid, reference);
+            for(u32 k = 0; k < grid.depth; k += 2)
+                for(u32 j = 0; j < grid.height; j += 3)
+                    for(u32 i = 0; i < grid.width; i += 5)
+                    {
+                        voxel::noise_grid point;
+                        point.x = grid.x + f32(i) * grid.step;
+                        point.y = grid.y + f32(j) * grid.step;
+                        point.z = grid.z + f32(k) * grid.step;
+                        point.step = grid.step;
+                        point.width = point.height = point.depth = 1;
+
+                        f32 v;
+                        voxel::noise_3d(type, 5, 0.25f, point, utils::span<f32>(&v, 1));
+                        REQUIRE(v == reference[i + grid.width * (j + grid.height * k)]);
+                    }
+        }
+    }
+
+    SECTION("seeds")
+    {
+        for(voxel::noise type : kinds)
+        {
+            voxel::noise_3d(type, 1, 1.0f, grid, reference);
+            voxel::noise_3d(type, 1, 1.0f, grid, other);
+            REQUIRE(same_bits(reference, other));
+
+            voxel::noise_3d(type, 2, 1.0f, grid, other);
+            REQUIRE(!same_bits(reference, other));
+        }
+    }
+
+    SECTION("no octaves")
+    {
+        voxel::fractal f;
+        f.octaves = 0;
+        voxel::fbm_2d(voxel::noise::simplex, 0, 1.0f, f, grid, reference.prefix(grid.area()));
+        for(usize i = 0; i != grid.area(); i++)
+            REQUIRE(reference[i] == 0.0f);
+    }
+}
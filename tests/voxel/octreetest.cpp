@@ -0,0 +1,155 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/octree.hpp>
+
+#include <random>
+
+TEST_CASE("basic octree check", "[voxel][octree]")
+{
+    voxel::sparse_octree tree(6);
+
+    SECTION("uniform")
+    {
+        REQUIRE(tree.edge() == 64);
+        REQUIRE(tree.group_count() == 0);
+        REQUIRE(tree.get(10, 20, 30) == 0);
+
+        tree.set(10, 20, 30, 0);
+        REQUIRE(tree.group_count() == 0);
+    }
+
+    SECTION("set and collapse")
+    {
+        tree.set(10, 20, 30, 5);
+        REQUIRE(tree.get(10, 20, 30) == 5);
+        REQUIRE(tree.get(11, 20, 30) == 0);
+        REQUIRE(tree.group_count() == 6);
+
+        tree.set(10, 20, 30, 0);
+        REQUIRE(tree.group_count() == 0);
+
+        for(u32 x = 0; x != 2; x++)
+            for(u32 y = 0; y != 2; y++)
+                for(u32 z = 0; z != 2; z++)
+                    tree.set(x, y, z, 3);
+        REQUIRE(tree.group_count() == 5);
+        REQUIRE(tree.get(1, 1, 1) == 3);
+    }
+
+    SECTION("random edits")
+    {
+        std::mt19937 rng(5);
+        utils::array<voxel::block> expected;
+        expected.push_many(0, 64 * 64 * 64);
+
+        for(int i = 0; i != 20000; i++)
+        {
+            u32 x = rng() % 64, y = rng() % 64, z = rng() % 64;
+            voxel::block b = voxel::block(rng() % 3);
+            tree.set(x, y, z, b);
+            expected[x + 64 * (y + 64 * z)] = b;
+        }
+
+        for(u32 z = 0; z != 64; z++)
+            for(u32 y = 0; y != 64; y++)
+                for(u32 x = 0; x != 64; x++)
+                    REQUIRE(tree.get(x, y, z) == expected[x + 64 * (y + 64 * z)]);
+
+        for(u32 z = 0; z != 64; z++)
+            for(u32 y = 0; y != 64; y++)
+                for(u32 x = 0; x != 64; x++)
+                    tree.set(x, y, z, 1);
+        REQUIRE(tree.group_count() == 0);
+        REQUIRE(tree.get(0, 0, 0) == 1);
+    }
+
+    SECTION("build from chunk")
+    {
+        utils::array<voxel::block> blocks;
+        for(usize z = 0; z != voxel::chunk_size; z++)
+            for(usize y = 0; y != voxel::chunk_size; y++)
+                for(usize x = 0; x != voxel::chunk_size; x++)
+                    blocks.push(y < 13 ? 1 : 0);
+
+        voxel::chunk c;
+        c.encode(blocks);
+        tree.build(c, 32, 0, 32);
+
+        REQUIRE(tree.get(40, 12, 40) == 1);
+        REQUIRE(tree.get(40, 13, 40) == 0);
+        REQUIRE(tree.get(10, 5, 10) == 0);
+
+        // A flat surface only needs groups along the boundary layer: 16 x 16 at the
+        // finest level, where a full tree over the chunk would need 4681.
+        REQUIRE(tree.group_count() < 400);
+
+        tree.build(voxel::chunk(2), 0, 0, 0);
+        REQUIRE(tree.get(31, 31, 31) == 2);
+        REQUIRE(tree.get(40, 12, 40) == 1);
+
+        tree.build(voxel::chunk(0), 32, 0, 32);
+        tree.build(voxel::chunk(0), 0, 0, 0);
+        REQUIRE(tree.group_count() == 0);
+    }
+
+    SECTION("box query")
+    {
+        tree.set(1, 1, 1, 4);
+        tree.set(50, 50, 50, 4);
+
+        usize solid = 0;
+        tree.query({ 0, 0, 0, 8, 8, 8 }, [&solid](u32, u32, u32, u32 size, voxel::block b) {
+            if(b != 0)
+                solid += size * size * size;
+            return true;
+        });
+        REQUIRE(solid == 1);
+
+        bool any = !tree.query({ 40, 40, 40, 64, 64, 64 }, [](u32, u32, u32, u32, voxel::block b) { return b == 0; });
+        REQUIRE(any);
+
+        bool none = tree.query({ 10, 10, 10, 40, 40, 40 }, [](u32, u32, u32, u32, voxel::block b) { return b == 0; });
+        REQUIRE(none);
+    }
+
+    SECTION("serialization")
+    {
+        std::mt19937 rng(9);
+        for(int i = 0; i != 500; i++)
+            tree.set(rng() % 64, rng() % 64, rng() % 64, voxel::block(1 + rng() % 4));
+
+        utils::array<u32> entries;
+        tree.serialize(entries);
+        REQUIRE(entries.size() == 1 + 8 * tree.group_count());
+
+        voxel::sparse_octree copy(6);
+        REQUIRE(copy.deserialize(entries));
+        REQUIRE(copy.group_count() == tree.group_count());
+        for(u32 z = 0; z != 64; z++)
+            for(u32 y = 0; y != 64; y++)
+                for(u32 x = 0; x != 64; x++)
+                    REQUIRE(copy.get(x, y, z) == tree.get(x, y, z));
+
+        utils::array<u32> again;
+        copy.serialize(again);
+        REQUIRE(again.size() == entries.size());
+        for(usize i = 0; i != entries.size(); i++)
+            REQUIRE(again[i] == entries[i]);
+
+        // Groups past the depth of the octree would be walked out of its bounds.
+        voxel::sparse_octree shallow(5);
+        REQUIRE(!shallow.deserialize(entries));
+        REQUIRE(voxel::sparse_octree(200).depth() == voxel::sparse_octree::max_depth);
+
+        entries[0] = 1;
+        REQUIRE(!copy.deserialize(entries));
+        entries.pop();
+        REQUIRE(!copy.deserialize(entries));
+
+        tree.fill(3);
+        entries.clear();
+        tree.serialize(entries);
+        REQUIRE(entries.size() == 1);
+        REQUIRE(copy.deserialize(entries));
+        REQUIRE(copy.get(5, 5, 5) == 3);
+    }
+}
@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/physics.hpp>
+#include <utils/soa_array.hpp>
+
+#include <cmath>
+#include <random>
+
+static constexpr voxel::block stone = 1;
+
+typedef utils::soa_array<f32, f32, f32, f32, f32, f32, f32, f32, f32, u8> entity_array;
+
+static voxel::entity_spans spans(entity_array& e)
+{
+    return voxel::entity_spans { e.column<0>(), e.column<1>(), e.column<2>(), e.column<3>(), e.column<4>(), e.column<5>(),
+                                 e.column<6>(), e.column<7>(), e.column<8>(), e.column<9>() };
+}
+
+// A 4x2x4 world with the lower layer of chunks full of stone.
+static void ground(voxel::chunk_map<>& world)
+{
+    for(i32 z = -2; z <= 1; z++)
+        for(i32 y = -1; y <= 0; y++)
+            for(i32 x = -2; x <= 1; x++)
+            {
+                voxel::chunk& c = world[world.insert(voxel::chunk_coord { x, y, z })];
+                if(y < 0)
+                    c.fill(stone);
+            }
+}
+
+static void build(const voxel::chunk_map<>& world, voxel::chunk_map<voxel::chunk_occupancy>& occupancy)
+{
+    world.for_each([&](const voxel::chunk_coord& c, u32 i) { occupancy.insert(c, world[i]); });
+}
+
+static bool approx(f32 a, f32 b)
+{
+    return std::abs(a - b) < 1e-3f;
+}
+
+TEST_CASE("basic physics check", "[voxel][physics]")
+{
+    voxel::chunk_map<> world;
+    voxel::chunk_map<voxel::chunk_occupancy> occ;
+    ground(world);
+    // A wall one voxel thick at x = 10.
+    for(u32 z = 0; z != 32; z++)
+        for(u32 y = 0; y != 32; y++)
+            world.get(voxel::chunk_coord { 0, 0, 0 })->set(voxel::voxel_index(10, y, z), stone);
+    build(world, occ);
+
+    REQUIRE(voxel::overlaps(occ, 10, 5, 5, 10, 5, 5));
+    REQUIRE_FALSE(voxel::overlaps(occ, 0, 0, 0, 9, 31, 31));
+    REQUIRE(voxel::overlaps(occ, 0, -1, 0, 0, 0, 0));
+    REQUIRE(voxel::overlaps(occ, 0, 70, 0, 0, 70, 0));
+
+    entity_array e;
+    voxel::entity_spans s = spans(e);
+    auto add = [&](f32 x, f32 y, f32 z, f32 vx, f32 vy, f32 vz) {
+        e.push(x, y, z, vx, vy, vz, 0.3f, 0.9f, 0.3f, u8(0));
+        s = spans(e);
+    };
+    constexpr u8 down = 1 << u32(voxel::face::neg_y);
+    constexpr u8 right = 1 << u32(voxel::face::pos_x);
+
+    SECTION("landing")
+    {
+        add(5.5f, 20, 5.5f, 0, -100, 0);
+        voxel::move_entities(occ, s, 1, 0, 1);
+        REQUIRE(approx(s.y[0], 0.9f));
+        REQUIRE(s.y[0] - 0.9f >= 0);
+        REQUIRE(s.velocity_y[0] == 0);
+        REQUIRE(s.contacts[0] == down);
+
+        // Resting on the ground, the entity can still slide along it.
+        s.velocity_y[0] = -1;
+        s.velocity_z[0] = 3;
+        voxel::move_entities(occ, s, 1, 0, 1);
+        REQUIRE(s.contacts[0] == down);
+        REQUIRE(approx(s.z[0], 8.5f));
+        REQUIRE(approx(s.y[0], 0.9f));
+    }
+
+    SECTION("thin wall")
+    {
+        add(2.5f, 5, 5.5f, 1000, 0, 0);
+        voxel::move_entities(occ, s, 1, 0, 1);
+        REQUIRE(approx(s.x[0], 9.7f));
+        REQUIRE(s.x[0] + 0.3f <= 10);
+        REQUIRE(s.contacts[0] == right);
+
+        // Pushing against the wall again doesn't move it.
+        s.velocity_x[0] = 1;
+        f32 x = s.x[0];
+        voxel::move_entities(occ, s, 1, 0, 1);
+        REQUIRE(s.x[0] == x);
+        REQUIRE(s.contacts[0] == right);
+    }
+
+    SECTION("unloaded chunks")
+    {
+        add(-60, 10, 0.5f, -100, 0, 0);
+        voxel::move_entities(occ, s, 1, 0, 1);
+        REQUIRE(approx(s.x[0], -63.7f));
+        REQUIRE(s.contacts[0] == 1 << u32(voxel::face::neg_x));
+    }
+
+    SECTION("free fall")
+    {
+        add(5.5f, 20, -20.5f, 1, -2, 3);
+        voxel::move_entities(occ, s, 0.5f, 0, 1);
+        REQUIRE(approx(s.x[0], 6));
+        REQUIRE(approx(s.y[0], 19));
+        REQUIRE(approx(s.z[0], -19));
+        REQUIRE(s.contacts[0] == 0);
+    }
+}
+
+TEST_CASE("physics in parallel", "[voxel][physics]")
+{
+    std::mt19937 rng(42);
+    voxel::chunk_map<> world;
+    voxel::chunk_map<voxel::chunk_occupancy> occ;
+    ground(world);
+    world.for_each([&](const voxel::chunk_coord& c, u32 i) {
+        if(c.y == 0)
+            for(u32 n = 0; n != 2000; n++)
+                world[i].set(rng() % voxel::chunk_volume, stone);
+    });
+    build(world, occ);
+
+    // Entities dropped in the free voxels of the world, moving randomly.
+    entity_array a;
+    std::uniform_real_distribution<f32> position(-60, 60), height(1, 30), speed(-20, 20);
+    while(a.size() != 5000)
+    {
+        f32 x = position(rng), y = height(rng), z = position(rng);
+        if(voxel::overlaps(occ, i32(std::floor(x - 0.3f)), i32(std::floor(y - 0.9f)), i32(std::floor(z - 0.3f)),
+                           i32(std::floor(x + 0.3f)), i32(std::floor(y + 0.9f)), i32(std::floor(z + 0.3f))))
+            continue;
+        a.push(x, y, z, speed(rng), speed(rng), speed(rng), 0.3f, 0.9f, 0.3f, u8(0));
+    }
+    entity_array b = a;
+    voxel::entity_spans sa = spans(a), sb = spans(b);
+
+    jobs::scheduler scheduler(3);
+    for(u32 frame = 0; frame != 20; frame++)
+    {
+        for(usize i = 0; i != a.size(); i++)
+        {
+            sa.velocity_y[i] -= 1;
+            sb.velocity_y[i] -= 1;
+        }
+        voxel::move_entities(occ, sa, 0.1f, 0, a.size());
+        voxel::move_entities(occ, sb, 0.1f, scheduler, 64);
+    }
+
+    bool same = true, clear = true;
+    for(usize i = 0; i != a.size(); i++)
+    {
+        same = same && sa.x[i] == sb.x[i] && sa.y[i] == sb.y[i] && sa.z[i] == sb.z[i] && sa.contacts[i] == sb.contacts[i];
+        // No box ends up inside an opaque voxel.
+        f32 skin = voxel::contact_skin / 2;
+        clear = clear && !voxel::overlaps(occ, i32(std::floor(sa.x[i] - 0.3f + skin)), i32(std::floor(sa.y[i] - 0.9f + skin)),
+                                          i32(std::floor(sa.z[i] - 0.3f + skin)), i32(std::ceil(sa.x[i] + 0.3f - skin)) - 1,
+                                          i32(std::ceil(sa.y[i] + 0.9f - skin)) - 1, i32(std::ceil(sa.z[i] + 0.3f - skin)) - 1);
+    }
+    REQUIRE(same);
+    REQUIRE(clear);
+}
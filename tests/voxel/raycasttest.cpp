@@ -0,0 +1,189 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/raycast.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+static constexpr voxel::block stone = 1;
+
+static bool opaque(const voxel::chunk_map<>& world, i32 x, i32 y, i32 z)
+{
+    const voxel::chunk* c = world.get(voxel::chunk_coord::containing(x, y, z));
+    return c != nullptr && c->get(voxel::voxel_index(x & 31, y & 31, z & 31)) != voxel::air;
+}
+
+static void build(const voxel::chunk_map<>& world, voxel::chunk_map<voxel::chunk_occupancy>& occupancy)
+{
+    world.for_each([&](const voxel::chunk_coord& c, u32 i) { occupancy.insert(c, world[i]); });
+}
+
+// Walks a ray voxel by voxel.
+static bool reference(const voxel::chunk_map<>& world, const voxel::ray& r, voxel::ray_hit& hit)
+{
+    const f32 o[3] = { r.origin_x, r.origin_y, r.origin_z };
+    const f32 d[3] = { r.direction_x, r.direction_y, r.direction_z };
+    i32 v[3], s[3];
+    f32 tmax[3];
+    u32 axis = 0;
+    auto boundary = [&](u32 a) {
+        return s[a] == 0 ? std::numeric_limits<f32>::infinity() : (f32(s[a] > 0 ? v[a] + 1 : v[a]) - o[a]) * (1 / d[a]);
+    };
+    for(u32 a = 0; a != 3; a++)
+    {
+        v[a] = i32(std::floor(o[a]));
+        s[a] = d[a] > 0 ? 1 : d[a] < 0 ? -1 : 0;
+        tmax[a] = boundary(a);
+        if(std::abs(d[a]) > std::abs(d[axis]))
+            axis = a;
+    }
+
+    f32 t = 0;
+    while(t <= r.length)
+    {
+        if(opaque(world, v[0], v[1], v[2]))
+        {
+            hit = voxel::ray_hit { 0, v[0], v[1], v[2], t, voxel::face(2 * axis + (s[axis] > 0 ? 1 : 0)) };
+            return true;
+        }
+
+        axis = tmax[0] <= tmax[1] ? (tmax[0] <= tmax[2] ? 0 : 2) : (tmax[1] <= tmax[2] ? 1 : 2);
+        t = tmax[axis];
+        v[axis] += s[axis];
+        tmax[axis] = boundary(axis);
+    }
+    return false;
+}
+
+TEST_CASE("occupancy check", "[voxel][raycast]")
+{
+    voxel::chunk c;
+    voxel::chunk_occupancy empty(c);
+    REQUIRE(empty.empty());
+    REQUIRE_FALSE(empty.full());
+
+    c.set(voxel::voxel_index(9, 17, 30), stone);
+    c.set(voxel::voxel_index(31, 0, 0), stone);
+    voxel::chunk_occupancy o(c);
+    REQUIRE_FALSE(o.empty());
+    REQUIRE(o.get(9, 17, 30));
+    REQUIRE(o.get(31, 0, 0));
+    REQUIRE_FALSE(o.get(9, 17, 29));
+    REQUIRE(o.row(0, 0) == 0x80000000u);
+    REQUIRE(o.brick(1, 2, 3));
+    REQUIRE(o.brick(3, 0, 0));
+    REQUIRE_FALSE(o.brick(0, 0, 0));
+
+    o.set({ 9, 17, 30 }, false);
+    REQUIRE_FALSE(o.get(9, 17, 30));
+    REQUIRE_FALSE(o.brick(1, 2, 3));
+    o.set({ 31, 0, 0 }, false);
+    REQUIRE(o.empty());
+
+    voxel::chunk full;
+    full.fill(stone);
+    voxel::chunk_occupancy f(full);
+    REQUIRE(f.full());
+    REQUIRE(f.get(0, 31, 7));
+}
+
+TEST_CASE("basic raycast check", "[voxel][raycast]")
+{
+    voxel::chunk_map<> world;
+    voxel::chunk& c = world[world.insert(voxel::chunk_coord { 0, 0, 0 })];
+    c.set(voxel::voxel_index(20, 5, 5), stone);
+    world.insert(voxel::chunk_coord { 1, 0, 0 });
+    world[world.insert(voxel::chunk_coord { -1, 0, 0 })].fill(stone);
+    voxel::chunk_map<voxel::chunk_occupancy> occ;
+    build(world, occ);
+
+    voxel::ray rays[] = {
+        { 0.5f, 5.5f, 5.5f, 1, 0, 0, 100 },
+        { 0.5f, 5.5f, 5.5f, 1, 0, 0, 10 },
+        { 40.5f, 5.5f, 5.5f, -1, 0, 0, 100 },
+        { 10.5f, 10.5f, 10.5f, 0, 1, 0, 100 },
+        { -3.5f, 5.5f, 5.5f, 0, 0, 1, 100 },
+    };
+    utils::array<voxel::ray_hit> hits;
+    voxel::raycast(occ, utils::const_span<voxel::ray>(rays, 5), hits);
+
+    REQUIRE(hits.size() == 3);
+    REQUIRE(hits[0].ray == 0);
+    REQUIRE((hits[0].x == 20 && hits[0].y == 5 && hits[0].z == 5));
+    REQUIRE(hits[0].side == voxel::face::neg_x);
+    REQUIRE(hits[0].t == 19.5f);
+    REQUIRE(hits[1].ray == 2);
+    REQUIRE(hits[1].x == 20);
+    REQUIRE(hits[1].side == voxel::face::pos_x);
+    REQUIRE(hits[1].t == 19.5f);
+    REQUIRE(hits[2].ray == 4);
+    REQUIRE(hits[2].x == -4);
+    REQUIRE(hits[2].t == 0);
+    REQUIRE(hits[2].side == voxel::face::neg_z);
+}
+
+TEST_CASE("raycast matches a voxel walk", "[voxel][raycast]")
+{
+    // Sparse chunks, dense chunks, empty chunks, full chunks and missing chunks.
+    std::mt19937 rng(41);
+    voxel::chunk_map<> world;
+    for(i32 z = -2; z <= 1; z++)
+        for(i32 y = -1; y <= 0; y++)
+            for(i32 x = -2; x <= 1; x++)
+            {
+                u32 kind = u32(x + 2 + 4 * (y + 1) + 8 * (z + 2)) % 5;
+                if(kind == 4)
+                    continue;
+                voxel::chunk& c = world[world.insert(voxel::chunk_coord { x, y, z })];
+                if(kind == 3)
+                    c.fill(stone);
+                else if(kind != 0)
+                {
+                    u32 n = kind == 1 ? 60 : 3000;
+                    for(u32 i = 0; i != n; i++)
+                        c.set(rng() % voxel::chunk_volume, stone);
+                }
+            }
+    voxel::chunk_map<voxel::chunk_occupancy> occ;
+    build(world, occ);
+
+    std::uniform_real_distribution<f32> position(-80, 80), unit(-1, 1);
+    utils::array<voxel::ray> rays;
+    for(u32 i = 0; i != 4000; i++)
+    {
+        f32 d[3];
+        do
+            for(f32& x : d)
+                x = unit(rng);
+        while(d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < 0.01f);
+        if(i % 7 == 0)
+            d[i % 3] = 0;
+        f32 l = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        rays.push(voxel::ray { position(rng), position(rng) * 0.5f, position(rng), d[0] / l, d[1] / l, d[2] / l, 150 });
+    }
+
+    utils::array<voxel::ray_hit> hits;
+    hits.push(voxel::ray_hit { 12345, 0, 0, 0, 0, voxel::face::pos_x });
+    voxel::raycast(occ, rays, hits);
+    REQUIRE(hits[0].ray == 12345);
+
+    usize next = 1;
+    bool same = true;
+    for(u32 i = 0; i != rays.size(); i++)
+    {
+        voxel::ray_hit expected;
+        if(!reference(world, rays[i], expected))
+            continue;
+        if(next == hits.size())
+        {
+            same = false;
+            break;
+        }
+        const voxel::ray_hit& h = hits[next++];
+        same = same && h.ray == i && h.x == expected.x && h.y == expected.y && h.z == expected.z
+            && h.t == expected.t && h.side == expected.side;
+    }
+    REQUIRE(same);
+    REQUIRE(next == hits.size());
+    REQUIRE(hits.size() > 1000);
+}
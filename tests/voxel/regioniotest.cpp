@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/region_io.hpp>
+
+#include "chunkhelpers.hpp"
+
+#include <filesystem>
+#include <string>
+
+struct loaded
+{
+    utils::array<voxel::chunk>* expected;
+    u32 reads;
+    u32 matches;
+    u32 writes;
+};
+
+static void check_read(const voxel::io_completion& done)
+{
+    loaded& l = *static_cast<loaded*>(done.user);
+    voxel::chunk c;
+    l.reads++;
+    if(done.ok && voxel::decompress_chunk(done.payload, c) && same(c, (*l.expected)[done.index / 7]))
+        l.matches++;
+}
+
+static void count_write(const voxel::io_completion& done)
+{
+    loaded& l = *static_cast<loaded*>(done.user);
+    l.writes += done.ok;
+}
+
+static void run(bool prefer_io_uring)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / (prefer_io_uring ? "voxel_io_uring.vxr" : "voxel_io_threads.vxr");
+    std::filesystem::remove(path);
+    std::mt19937 rng(49);
+
+    utils::array<voxel::chunk> chunks;
+    for(u32 i = 0; i != 300; i++)
+        random_chunk(chunks.push(), 1 + i % 30, rng);
+
+    voxel::region_file region;
+    REQUIRE(region.open(path.string().c_str()));
+
+    // More writes than buffers, so most of them wait in the queue.
+    voxel::region_io io(8, 3, prefer_io_uring);
+    if(!prefer_io_uring)
+        REQUIRE(io.kind() == voxel::region_io::backend::threads);
+
+    loaded l { &chunks, 0, 0, 0 };
+    for(u32 i = 0; i != chunks.size(); i++)
+    {
+        utils::array<u8> payload;
+        voxel::compress_chunk(chunks[i], payload);
+        io.write(region, i * 7, ::std::move(payload), count_write, &l);
+    }
+    REQUIRE(io.pending() == chunks.size());
+    io.poll();
+    io.wait();
+    REQUIRE(io.pending() == 0);
+    REQUIRE(l.writes == chunks.size());
+
+    // The table in memory and on disk both point at the payloads.
+    voxel::chunk c;
+    for(u32 i = 0; i != chunks.size(); i++)
+    {
+        REQUIRE(region.load(i * 7, c));
+        REQUIRE(same(c, chunks[i]));
+    }
+
+    for(u32 i = 0; i != chunks.size(); i++)
+        REQUIRE(io.read(region, i * 7, check_read, &l));
+    REQUIRE_FALSE(io.read(region, 1, check_read, &l));
+    while(io.pending() != 0)
+        io.poll();
+    REQUIRE(l.reads == chunks.size());
+    REQUIRE(l.matches == chunks.size());
+
+    // Overwrites free the old sectors, and an empty payload erases.
+    u32 sectors = region.sectors();
+    for(u32 i = 0; i != 50; i++)
+    {
+        utils::array<u8> payload;
+        voxel::compress_chunk(chunks[i], payload);
+        io.write(region, i * 7, ::std::move(payload));
+    }
+    io.write(region, 60 * 7, utils::array<u8>());
+    io.wait();
+    REQUIRE(region.sectors() <= sectors + 50);
+    REQUIRE_FALSE(region.contains(60 * 7));
+
+    region.close();
+    voxel::region_reader reader;
+    REQUIRE(reader.open(path.string().c_str()));
+    for(u32 i = 0; i != chunks.size(); i++)
+    {
+        if(i == 60)
+        {
+            REQUIRE_FALSE(reader.contains(i * 7));
+            continue;
+        }
+        REQUIRE(reader.load(i * 7, c));
+        REQUIRE(same(c, chunks[i]));
+    }
+    reader.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("region io check", "[voxel][region]")
+{
+    SECTION("io_uring, or the fallback where it's missing")
+    {
+        run(true);
+    }
+
+    SECTION("thread pool")
+    {
+        run(false);
+    }
+}
@@ -0,0 +1,233 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/region.hpp>
+
+#include "chunkhelpers.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+static std::string temporary(const char* name)
+{
+    std::filesystem::path p = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(p);
+    return p.string();
+}
+
+TEST_CASE("chunk compression check", "[voxel][region]")
+{
+    std::mt19937 rng(47);
+    utils::array<u8> payload;
+    voxel::chunk c, out(5);
+
+    // Uniform chunks are just their header.
+    c.fill(9);
+    voxel::compress_chunk(c, payload);
+    REQUIRE(payload.size() == 6);
+    REQUIRE(voxel::decompress_chunk(payload, out));
+    REQUIRE(out.uniform());
+    REQUIRE(out.get(123) == 9);
+
+    for(u32 distinct : { 2u, 3u, 16u, 200u, 400u })
+    {
+        random_chunk(c, distinct, rng);
+        payload.clear();
+        voxel::compress_chunk(c, payload);
+        REQUIRE(voxel::decompress_chunk(payload, out));
+        REQUIRE(out.bits_per_voxel() == c.bits_per_voxel());
+        REQUIRE(same(c, out));
+        // Runs compress well below the packed size.
+        REQUIRE(payload.size() < c.words().size() * sizeof(u64) / 2);
+
+        // Editing a decompressed chunk keeps its palette consistent.
+        out.set(voxel::local_coord { 1, 2, 3 }, 1000);
+        c.set(voxel::local_coord { 1, 2, 3 }, 1000);
+        REQUIRE(same(c, out));
+    }
+
+    // Noise doesn't compress, but still round trips.
+    utils::array<voxel::block> blocks;
+    std::uniform_int_distribution<u32> any(0, 65535);
+    for(usize i = 0; i != voxel::chunk_volume; i++)
+        blocks.push(static_cast<voxel::block>(any(rng)));
+    c.encode(blocks);
+    payload.clear();
+    voxel::compress_chunk(c, payload);
+    REQUIRE(voxel::decompress_chunk(payload, out));
+    REQUIRE(same(c, out));
+
+    // Corrupt payloads are rejected without reading out of bounds.
+    random_chunk(c, 10, rng);
+    payload.clear();
+    voxel::compress_chunk(c, payload);
+    utils::array<u8> broken(payload);
+    broken.pop_many(broken.size() / 2);
+    REQUIRE_FALSE(voxel::decompress_chunk(broken, out));
+    REQUIRE(out.uniform());
+    REQUIRE(out.get(0) == voxel::air);
+    REQUIRE_FALSE(voxel::decompress_chunk(utils::const_span<u8>(payload.data(), 3), out));
+
+    broken = payload;
+    broken[0] = 3;
+    REQUIRE_FALSE(voxel::decompress_chunk(broken, out));
+
+    std::uniform_int_distribution<u32> byte(0, 255);
+    for(u32 i = 0; i != 200; i++)
+    {
+        broken = payload;
+        broken[4 + byte(rng) % (broken.size() - 4)] = static_cast<u8>(byte(rng));
+        if(voxel::decompress_chunk(broken, out))
+            REQUIRE(out.get(0) == out.get(0));
+    }
+}
+
+TEST_CASE("region coordinates check", "[voxel][region]")
+{
+    REQUIRE(voxel::region_coord::containing(voxel::chunk_coord { 0, 15, -1 }) == (voxel::region_coord { 0, 0, -1 }));
+    REQUIRE(voxel::region_coord::containing(voxel::chunk_coord { 16, -16, -17 }) == (voxel::region_coord { 1, -1, -2 }));
+    REQUIRE(voxel::region_index(voxel::chunk_coord { 0, 0, 0 }) == 0);
+    REQUIRE(voxel::region_index(voxel::chunk_coord { -1, -1, -1 }) == voxel::region_volume - 1);
+    REQUIRE(voxel::region_index(voxel::chunk_coord { 17, 2, 3 }) == (1 | 2 << 4 | 3 << 8));
+}
+
+TEST_CASE("region file check", "[voxel][region]")
+{
+    std::string path = temporary("voxel_region_test.vxr");
+    std::mt19937 rng(48);
+
+    utils::array<voxel::chunk> chunks;
+    for(u32 i = 0; i != 40; i++)
+    {
+        voxel::chunk& c = chunks.push();
+        random_chunk(c, 1 + i % 20, rng);
+    }
+
+    {
+        voxel::region_file region;
+        REQUIRE_FALSE(region.open(path.c_str(), false));
+        REQUIRE(region.open(path.c_str()));
+        for(u32 i = 0; i != chunks.size(); i++)
+            REQUIRE_FALSE(region.contains(i * 97));
+        for(u32 i = 0; i != chunks.size(); i++)
+            REQUIRE(region.save(i * 97, chunks[i]));
+
+        voxel::chunk c;
+        for(u32 i = 0; i != chunks.size(); i++)
+        {
+            REQUIRE(region.load(i * 97, c));
+            REQUIRE(same(c, chunks[i]));
+        }
+        REQUIRE_FALSE(region.load(1, c));
+        REQUIRE(region.sync());
+
+        // Raw reads see the table as it's encoded.
+        u8 raw[sizeof(voxel::region_entry)], expected[sizeof(voxel::region_entry)];
+        REQUIRE(region.read_at(raw, sizeof(raw), voxel::region_entry::offset(97)));
+        region.entry(97).encode(expected);
+        REQUIRE(std::memcmp(raw, expected, sizeof(raw)) == 0);
+        REQUIRE_FALSE(voxel::region_file().read_at(raw, sizeof(raw), 0));
+    }
+
+    {
+        // Reopened, then edited: a chunk that shrinks frees sectors the next ones reuse.
+        voxel::region_file region;
+        REQUIRE(region.open(path.c_str(), false));
+        u32 sectors = region.sectors();
+        for(u32 i = 0; i != chunks.size(); i++)
+            REQUIRE(region.contains(i * 97));
+
+        voxel::chunk c;
+        REQUIRE(region.load(5 * 97, c));
+        REQUIRE(same(c, chunks[5]));
+
+        chunks[5].fill(2);
+        REQUIRE(region.save(5 * 97, chunks[5]));
+        REQUIRE(region.sectors() <= sectors + 1);
+        REQUIRE(region.erase(6 * 97));
+        REQUIRE_FALSE(region.contains(6 * 97));
+        random_chunk(chunks[7], 3, rng);
+        REQUIRE(region.save(7 * 97, chunks[7]));
+        REQUIRE(region.sectors() <= sectors + 1);
+
+        // Payloads never overlap.
+        utils::array<u8> owner;
+        owner.push_many(0, region.sectors());
+        for(u32 i = 0; i != voxel::region_volume; i++)
+            if(region.contains(i))
+            {
+                voxel::region_entry e = region.entry(i);
+                for(u32 s = e.sector; s != e.sector + (e.length + voxel::sector_size - 1) / voxel::sector_size; s++)
+                {
+                    REQUIRE(owner[s] == 0);
+                    owner[s] = 1;
+                }
+            }
+    }
+
+    {
+        voxel::region_reader reader;
+        REQUIRE(reader.open(path.c_str()));
+        voxel::chunk c;
+        for(u32 i = 0; i != chunks.size(); i++)
+        {
+            if(i == 6)
+            {
+                REQUIRE_FALSE(reader.contains(i * 97));
+                REQUIRE_FALSE(reader.load(i * 97, c));
+                continue;
+            }
+            REQUIRE(reader.load(i * 97, c));
+            REQUIRE(same(c, chunks[i]));
+        }
+        REQUIRE(reader.payload(3).empty());
+    }
+
+    {
+        // Corrupt entries are dropped on open, and their sectors reused.
+        voxel::region_file region;
+        REQUIRE(region.open(path.c_str(), false));
+        u32 sectors = region.sectors();
+        region.close();
+
+        std::FILE* f = std::fopen(path.c_str(), "r+b");
+        REQUIRE(f != nullptr);
+        const voxel::region_entry corrupt[] = { { 0xffffffffu, 8192 }, { 0x00ffffffu, 100 }, { 3, 0x7fffffffu }, { sectors + 10, 100 } };
+        for(u32 i = 0; i != 4; i++)
+        {
+            u8 e[sizeof(voxel::region_entry)];
+            corrupt[i].encode(e);
+            REQUIRE(std::fseek(f, static_cast<long>(voxel::region_entry::offset(i * 97)), SEEK_SET) == 0);
+            REQUIRE(std::fwrite(e, sizeof(e), 1, f) == 1);
+        }
+        std::fclose(f);
+
+        REQUIRE(region.open(path.c_str(), false));
+        for(u32 i = 0; i != 4; i++)
+            REQUIRE_FALSE(region.contains(i * 97));
+        REQUIRE(region.sectors() <= sectors);
+
+        voxel::chunk c;
+        REQUIRE(region.load(5 * 97, c));
+        REQUIRE(same(c, chunks[5]));
+        REQUIRE(region.save(0, chunks[0]));
+        REQUIRE(region.load(0, c));
+        REQUIRE(same(c, chunks[0]));
+        REQUIRE(region.sectors() <= sectors);
+    }
+
+    // Files that aren't regions are rejected.
+    std::string other = temporary("voxel_region_test.txt");
+    std::FILE* f = std::fopen(other.c_str(), "wb");
+    REQUIRE(f != nullptr);
+    std::fputs("not a region", f);
+    std::fclose(f);
+    voxel::region_file region;
+    REQUIRE_FALSE(region.open(other.c_str()));
+    REQUIRE_FALSE(region.is_open());
+    voxel::region_reader reader;
+    REQUIRE_FALSE(reader.open(other.c_str()));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(other);
+}
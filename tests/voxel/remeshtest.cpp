@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/remesh.hpp>
+
+#include <random>
+
+// Meshes a chunk of the map from scratch.
+static utils::array<voxel::quad> full_mesh(voxel::chunk_map<>& world, const voxel::chunk_coord& c)
+{
+    voxel::chunk* around[27];
+    const voxel::chunk* loaded[27];
+    world.neighbors(c, utils::span<voxel::chunk*>(around, 27));
+    for(usize i = 0; i != 27; i++)
+        loaded[i] = around[i];
+
+    voxel::mesher mesher;
+    utils::array<voxel::quad> quads;
+    mesher.mesh(utils::const_span<const voxel::chunk*>(loaded, 27), quads);
+    return quads;
+}
+
+static bool same_quads(const utils::const_span<voxel::quad>& a, const utils::const_span<voxel::quad>& b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(usize i = 0; i != a.size(); i++)
+        if(a[i].data != b[i].data)
+            return false;
+    return true;
+}
+
+TEST_CASE("basic remesh check", "[voxel][remesh]")
+{
+    voxel::chunk_map<> world;
+    for(i32 z = -1; z <= 1; z++)
+        for(i32 y = -1; y <= 1; y++)
+            for(i32 x = -1; x <= 1; x++)
+            {
+                voxel::chunk& c = world[world.insert(voxel::chunk_coord { x, y, z })];
+                for(u32 vz = 0; vz != 32; vz++)
+                    for(u32 vx = 0; vx != 32; vx++)
+                        for(i32 vy = 0; vy != 32 && y * 32 + vy < 8 + i32(vx + vz) / 8; vy++)
+                            c.set(voxel::voxel_index(vx, u32(vy), vz), y < 0 ? 1 : 2);
+            }
+
+    voxel::remesher remesher(world);
+    world.for_each([&](const voxel::chunk_coord& c, u32) { remesher.changed(c); });
+    REQUIRE(remesher.pending() == 27);
+    REQUIRE(remesher.update(10) == 10);
+    REQUIRE(remesher.update() == 17);
+    REQUIRE(remesher.pending() == 0);
+
+    voxel::chunk_coord middle { 0, 0, 0 };
+    REQUIRE(same_quads(remesher.find(middle)->quads(), full_mesh(world, middle)));
+
+    SECTION("missing chunk")
+    {
+        remesher.changed(voxel::chunk_coord { 5, 0, 0 }, voxel::local_coord { 0, 0, 0 });
+        REQUIRE(remesher.pending() == 0);
+        REQUIRE(remesher.find(voxel::chunk_coord { 5, 0, 0 }) == nullptr);
+    }
+
+    SECTION("inner edit")
+    {
+        world.get(middle)->set(voxel::local_coord { 10, 20, 10 }, 3);
+        remesher.changed(middle, voxel::local_coord { 10, 20, 10 });
+        REQUIRE(remesher.pending() == 1);
+        REQUIRE(remesher.update() == 1);
+        REQUIRE(same_quads(remesher.find(middle)->quads(), full_mesh(world, middle)));
+    }
+
+    SECTION("border edit")
+    {
+        world.get(middle)->set(voxel::local_coord { 31, 0, 5 }, voxel::air);
+        remesher.changed(middle, voxel::local_coord { 31, 0, 5 });
+        REQUIRE(remesher.pending() == 3);
+        REQUIRE(remesher.update() == 3);
+
+        voxel::chunk_coord coords[3] = { middle, { 1, 0, 0 }, { 0, -1, 0 } };
+        for(const voxel::chunk_coord& c : coords)
+            REQUIRE(same_quads(remesher.find(c)->quads(), full_mesh(world, c)));
+    }
+
+    SECTION("random edits")
+    {
+        std::mt19937 rng(38);
+        for(u32 round = 0; round != 20; round++)
+        {
+            for(u32 i = 0; i != 1 + round % 4; i++)
+            {
+                voxel::chunk_coord c { i32(rng() % 3) - 1, i32(rng() % 3) - 1, i32(rng() % 3) - 1 };
+                voxel::local_coord v { u8(rng() % 32), u8(rng() % 32), u8(rng() % 32) };
+                if(rng() % 4 == 0)
+                    v.y = rng() % 2 ? 0 : 31;
+                world.get(c)->set(v, voxel::block(rng() % 4));
+                remesher.changed(c, v);
+            }
+
+            remesher.update();
+            world.for_each([&](const voxel::chunk_coord& c, u32) {
+                REQUIRE(same_quads(remesher.find(c)->quads(), full_mesh(world, c)));
+            });
+        }
+    }
+
+    SECTION("erased chunk")
+    {
+        remesher.changed(middle, voxel::local_coord { 10, 10, 10 });
+        world.erase(middle);
+        REQUIRE(remesher.update() == 0);
+        REQUIRE(remesher.find(middle) == nullptr);
+    }
+}
@@ -0,0 +1,160 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/streaming.hpp>
+
+static voxel::observer looking(f32 x, f32 y, f32 z, f32 dx, f32 dy, f32 dz, u32 radius)
+{
+    return voxel::observer { x, y, z, dx, dy, dz, radius };
+}
+
+static usize sphere(i32 r)
+{
+    usize n = 0;
+    for(i32 z = -r; z <= r; z++)
+        for(i32 y = -r; y <= r; y++)
+            for(i32 x = -r; x <= r; x++)
+                n += x * x + y * y + z * z <= r * r;
+    return n;
+}
+
+TEST_CASE("streaming order check", "[voxel][streaming]")
+{
+    voxel::streamer s(voxel::stream_budget { 10, 4, 6 });
+    voxel::observer o = looking(16.0f, 16.0f, 16.0f, 1.0f, 0.0f, 0.0f, 3);
+    utils::array<voxel::chunk_coord> unloads, out;
+
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    REQUIRE(unloads.empty());
+    REQUIRE(s.size() == sphere(3));
+    REQUIRE(s.pending(voxel::stream_task::load) == sphere(3));
+
+    // The chunk of the observer first, then the one it looks at before the one behind it.
+    REQUIRE(s.schedule(voxel::stream_task::load, out) == 10);
+    REQUIRE(out[0] == (voxel::chunk_coord { 0, 0, 0 }));
+    REQUIRE(out[1] == (voxel::chunk_coord { 1, 0, 0 }));
+    bool behind = false;
+    for(const voxel::chunk_coord& c : out)
+        behind |= c == voxel::chunk_coord { -1, 0, 0 };
+    REQUIRE_FALSE(behind);
+
+    // The budget is spent for the frame.
+    REQUIRE(s.schedule(voxel::stream_task::load, out) == 0);
+    REQUIRE(s.running() == 10);
+
+    // Stored chunks go to meshing, missing ones to generation.
+    for(usize i = 0; i != 10; i++)
+        REQUIRE(s.loaded(out[i], i % 2 == 0));
+    REQUIRE(s.running() == 0);
+    REQUIRE(s.pending(voxel::stream_task::mesh) == 5);
+    REQUIRE(s.pending(voxel::stream_task::generate) == 5);
+    REQUIRE_FALSE(s.loaded(out[0], true));
+
+    // Turning around reorders the waiting loads without rescanning.
+    o = looking(16.0f, 16.0f, 16.0f, -1.0f, 0.0f, 0.0f, 3);
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    out.clear();
+    REQUIRE(s.schedule(voxel::stream_task::load, out) == 10);
+    REQUIRE(out[0] == (voxel::chunk_coord { -1, 0, 0 }));
+
+    utils::array<voxel::chunk_coord> generated;
+    REQUIRE(s.schedule(voxel::stream_task::generate, generated) == 4);
+    for(const voxel::chunk_coord& c : generated)
+        REQUIRE(s.generated(c));
+
+    utils::array<voxel::chunk_coord> meshed;
+    REQUIRE(s.schedule(voxel::stream_task::mesh, meshed) == 6);
+    for(const voxel::chunk_coord& c : meshed)
+    {
+        REQUIRE_FALSE(s.ready(c));
+        REQUIRE(s.meshed(c));
+        REQUIRE(s.ready(c));
+    }
+    REQUIRE(s.ready(voxel::chunk_coord { 0, 0, 0 }));
+}
+
+TEST_CASE("streaming cancellation check", "[voxel][streaming]")
+{
+    voxel::streamer s(voxel::stream_budget { 1000, 1000, 1000 });
+    voxel::observer o = looking(0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 2);
+    utils::array<voxel::chunk_coord> unloads, loads, meshes;
+
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    s.schedule(voxel::stream_task::load, loads);
+    REQUIRE(loads.size() == sphere(2));
+
+    // Half the chunks become ready, the other half is still loading.
+    for(usize i = 0; i != loads.size() / 2; i++)
+        REQUIRE(s.loaded(loads[i], true));
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    s.schedule(voxel::stream_task::mesh, meshes);
+    for(const voxel::chunk_coord& c : meshes)
+        REQUIRE(s.meshed(c));
+    REQUIRE(unloads.empty());
+
+    // Moving one chunk keeps everything within the extra chunk.
+    o.x += voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    REQUIRE(unloads.empty());
+
+    // Teleporting drops everything: ready chunks unload, running loads are cancelled.
+    o.x += 100.0f * voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    REQUIRE(unloads.size() == meshes.size());
+    for(usize i = loads.size() / 2; i != loads.size(); i++)
+        REQUIRE_FALSE(s.loaded(loads[i], true));
+    REQUIRE(s.running() == 0);
+    REQUIRE(s.size() == sphere(2));
+    REQUIRE(s.pending(voxel::stream_task::load) == sphere(2));
+
+    // A cancelled task revives if its chunk comes back into range before it finishes.
+    utils::array<voxel::chunk_coord> far;
+    s.schedule(voxel::stream_task::load, far);
+    o.x -= 100.0f * voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    o.x += 100.0f * voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    for(const voxel::chunk_coord& c : far)
+        REQUIRE(s.loaded(c, false));
+    REQUIRE(s.pending(voxel::stream_task::generate) == far.size());
+
+    // Two observers share the chunks between them.
+    voxel::observer both[2] = { o, o };
+    both[1].x += 3.0f * voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(both, 2), unloads);
+    REQUIRE(s.size() < 2 * sphere(2));
+    REQUIRE(s.size() > sphere(2));
+}
+
+TEST_CASE("streaming unload check", "[voxel][streaming]")
+{
+    voxel::streamer s(voxel::stream_budget { 1000, 1000, 1000 });
+    voxel::observer o = looking(0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1);
+    utils::array<voxel::chunk_coord> unloads, loads;
+
+    // Chunks whose blocks are known but not meshed yet unload too when teleporting away.
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    s.schedule(voxel::stream_task::load, loads);
+    REQUIRE(loads.size() == sphere(1));
+    for(const voxel::chunk_coord& c : loads)
+        REQUIRE(s.loaded(c, true));
+    REQUIRE(s.pending(voxel::stream_task::mesh) == sphere(1));
+
+    o.x += 100.0f * voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    REQUIRE(unloads.size() == sphere(1));
+    REQUIRE(s.pending(voxel::stream_task::mesh) == 0);
+    REQUIRE(s.size() == sphere(1));
+
+    // Chunks waiting to be generated hold no blocks yet, and are dropped silently.
+    unloads.clear();
+    loads.clear();
+    s.schedule(voxel::stream_task::load, loads);
+    for(const voxel::chunk_coord& c : loads)
+        REQUIRE(s.loaded(c, false));
+    REQUIRE(s.pending(voxel::stream_task::generate) == sphere(1));
+
+    o.x += 100.0f * voxel::chunk_size;
+    s.update(utils::const_span<voxel::observer>(&o, 1), unloads);
+    REQUIRE(unloads.empty());
+    REQUIRE(s.pending(voxel::stream_task::generate) == 0);
+    REQUIRE(s.size() == sphere(1));
+}
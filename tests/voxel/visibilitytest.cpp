@@ -0,0 +1,224 @@
+#include <catch2/catch_test_macros.hpp>
+#include <voxel/visibility.hpp>
+
+#include <random>
+
+static bool contains(const utils::array<voxel::chunk_coord>& a, const voxel::chunk_coord& c)
+{
+    for(const voxel::chunk_coord& x : a)
+        if(x == c)
+            return true;
+    return false;
+}
+
+// Flood fills the transparent voxels one at a time.
+static u16 reference(const voxel::chunk_occupancy& o)
+{
+    static u16 region[voxel::chunk_volume];
+    for(u16& r : region)
+        r = 0;
+
+    u16 connections = 0, next = 0;
+    utils::deque<u32> queue;
+    for(u32 start = 0; start != voxel::chunk_volume; start++)
+    {
+        if(region[start] != 0 || o.get(start & 31, (start >> 5) & 31, start >> 10))
+            continue;
+
+        region[start] = ++next;
+        queue.push_back(start);
+        u32 faces = 0;
+        while(!queue.empty())
+        {
+            u32 v = queue.front();
+            queue.pop_front();
+            i32 p[3] = { i32(v & 31), i32((v >> 5) & 31), i32(v >> 10) };
+            for(u32 f = 0; f != voxel::face_count; f++)
+            {
+                i32 q[3] = { p[0], p[1], p[2] };
+                q[f >> 1] += f & 1 ? -1 : 1;
+                if(q[f >> 1] < 0 || q[f >> 1] > 31)
+                {
+                    faces |= 1 << f;
+                    continue;
+                }
+
+                u32 n = u32(q[0]) | u32(q[1]) << 5 | u32(q[2]) << 10;
+                if(region[n] != 0 || o.get(q[0], q[1], q[2]))
+                    continue;
+                region[n] = next;
+                queue.push_back(n);
+            }
+        }
+
+        for(u32 a = 0; a != voxel::face_count; a++)
+            for(u32 b = a + 1; b != voxel::face_count; b++)
+                if((faces >> a) & (faces >> b) & 1)
+                    connections = u16(connections | 1 << voxel::face_pair(voxel::face(a), voxel::face(b)));
+    }
+    return connections;
+}
+
+static void fill(voxel::chunk_occupancy& o, bool opaque)
+{
+    for(u8 z = 0; z != 32; z++)
+        for(u8 y = 0; y != 32; y++)
+            for(u8 x = 0; x != 32; x++)
+                o.set(voxel::local_coord { x, y, z }, opaque);
+}
+
+TEST_CASE("face connections check", "[voxel][visibility]")
+{
+    // Every pair gets its own bit.
+    u16 seen = 0;
+    for(u32 a = 0; a != voxel::face_count; a++)
+        for(u32 b = a + 1; b != voxel::face_count; b++)
+        {
+            u32 bit = voxel::face_pair(voxel::face(a), voxel::face(b));
+            REQUIRE(bit < 15);
+            REQUIRE(bit == voxel::face_pair(voxel::face(b), voxel::face(a)));
+            REQUIRE(((seen >> bit) & 1) == 0);
+            seen = u16(seen | 1 << bit);
+        }
+    REQUIRE(seen == voxel::all_connected);
+
+    voxel::chunk_occupancy o;
+    REQUIRE(voxel::face_connections(o) == voxel::all_connected);
+    fill(o, true);
+    REQUIRE(voxel::face_connections(o) == 0);
+
+    // A wall across y = 10 cuts the chunk into a top and a bottom half.
+    fill(o, false);
+    for(u8 z = 0; z != 32; z++)
+        for(u8 x = 0; x != 32; x++)
+            o.set(voxel::local_coord { x, 10, z }, true);
+    u16 c = voxel::face_connections(o);
+    REQUIRE(c == reference(o));
+    REQUIRE_FALSE((c >> voxel::face_pair(voxel::face::pos_y, voxel::face::neg_y)) & 1);
+    REQUIRE((c >> voxel::face_pair(voxel::face::pos_y, voxel::face::pos_x)) & 1);
+    REQUIRE((c >> voxel::face_pair(voxel::face::neg_y, voxel::face::neg_z)) & 1);
+    REQUIRE((c >> voxel::face_pair(voxel::face::pos_x, voxel::face::neg_z)) & 1);
+
+    // A hole through the wall joins them.
+    o.set(voxel::local_coord { 5, 10, 7 }, false);
+    c = voxel::face_connections(o);
+    REQUIRE(c == voxel::all_connected);
+
+    // A winding tunnel through solid rock between -x and +z.
+    fill(o, true);
+    for(u8 x = 0; x != 20; x++)
+        o.set(voxel::local_coord { x, 4, 3 }, false);
+    for(u8 y = 4; y != 25; y++)
+        o.set(voxel::local_coord { 19, y, 3 }, false);
+    for(u8 z = 3; z != 32; z++)
+        o.set(voxel::local_coord { 19, 24, z }, false);
+    c = voxel::face_connections(o);
+    REQUIRE(c == 1 << voxel::face_pair(voxel::face::neg_x, voxel::face::pos_z));
+    REQUIRE(c == reference(o));
+
+    // Random caves, from sparse to dense.
+    std::mt19937 rng(44);
+    for(u32 density : { 20u, 45u, 60u, 70u, 80u })
+        for(u32 i = 0; i != 6; i++)
+        {
+            std::uniform_int_distribution<u32> percent(0, 99);
+            for(u8 z = 0; z != 32; z++)
+                for(u8 y = 0; y != 32; y++)
+                    for(u8 x = 0; x != 32; x++)
+                        o.set(voxel::local_coord { x, y, z }, percent(rng) < density);
+            REQUIRE(voxel::face_connections(o) == reference(o));
+        }
+}
+
+TEST_CASE("visibility graph updates check", "[voxel][visibility]")
+{
+    voxel::chunk_map<voxel::chunk_occupancy> occupancy;
+    voxel::visibility_graph graph(occupancy);
+    voxel::chunk_coord c { 0, 0, 0 };
+    u32 i = occupancy.insert(c);
+    fill(occupancy[i], true);
+    graph.chunk_added(c);
+    REQUIRE(graph.connections(c) == 0);
+    REQUIRE(graph.connections(voxel::chunk_coord { 1, 0, 0 }) == voxel::all_connected);
+
+    // Filling a voxel of a solid chunk is skipped.
+    graph.block_changed(c, voxel::local_coord { 1, 2, 3 });
+    REQUIRE(graph.update() == 0);
+
+    // Digging a shaft along y, one voxel at a time.
+    for(u8 y = 0; y != 32; y++)
+    {
+        voxel::local_coord v { 8, y, 8 };
+        occupancy[i].set(v, false);
+        graph.block_changed(c, v);
+    }
+    REQUIRE(graph.update() == 1);
+    REQUIRE(graph.connections(c) == 1 << voxel::face_pair(voxel::face::pos_y, voxel::face::neg_y));
+
+    std::mt19937 rng(45);
+    std::uniform_int_distribution<u32> coordinate(0, 31);
+    for(u32 round = 0; round != 20; round++)
+    {
+        for(u32 edit = 0; edit != 200; edit++)
+        {
+            voxel::local_coord v { u8(coordinate(rng)), u8(coordinate(rng)), u8(coordinate(rng)) };
+            occupancy[i].set(v, round % 2 == 0 ? edit % 3 == 0 : edit % 3 != 0);
+            graph.block_changed(c, v);
+        }
+        graph.update();
+        REQUIRE(graph.connections(c) == voxel::face_connections(occupancy[i]));
+    }
+
+    graph.chunk_removed(c);
+    REQUIRE(graph.connections(c) == voxel::all_connected);
+}
+
+TEST_CASE("visibility traversal check", "[voxel][visibility]")
+{
+    // A 5 x 5 x 5 block of chunks, with a layer of solid rock at y = 2 and empty air elsewhere.
+    voxel::chunk_map<voxel::chunk_occupancy> occupancy;
+    voxel::visibility_graph graph(occupancy);
+    for(i32 z = 0; z != 5; z++)
+        for(i32 y = 0; y != 5; y++)
+            for(i32 x = 0; x != 5; x++)
+            {
+                u32 i = occupancy.insert(voxel::chunk_coord { x, y, z });
+                if(y == 2)
+                    fill(occupancy[i], true);
+            }
+    occupancy.for_each([&](const voxel::chunk_coord& c, u32) { graph.chunk_added(c); });
+
+    utils::array<voxel::chunk_coord> visible;
+    graph.traverse(voxel::chunk_coord { 2, 4, 2 }, visible);
+    REQUIRE(visible[0] == (voxel::chunk_coord { 2, 4, 2 }));
+    REQUIRE(contains(visible, voxel::chunk_coord { 0, 3, 0 }));
+    REQUIRE(contains(visible, voxel::chunk_coord { 4, 4, 4 }));
+    // The rock itself is visible, but nothing behind it.
+    REQUIRE(contains(visible, voxel::chunk_coord { 2, 2, 2 }));
+    REQUIRE_FALSE(contains(visible, voxel::chunk_coord { 2, 1, 2 }));
+    REQUIRE(visible.size() == 75);
+
+    // A shaft through the rock of chunk (2, 2, 2) lets the camera see below it.
+    voxel::chunk_coord rock { 2, 2, 2 };
+    voxel::chunk_occupancy& o = *occupancy.get(rock);
+    for(u8 y = 0; y != 32; y++)
+    {
+        o.set(voxel::local_coord { 16, y, 16 }, false);
+        graph.block_changed(rock, voxel::local_coord { 16, y, 16 });
+    }
+    REQUIRE(graph.update() == 1);
+
+    visible.clear();
+    graph.traverse(voxel::chunk_coord { 2, 4, 2 }, visible);
+    REQUIRE(contains(visible, voxel::chunk_coord { 2, 1, 2 }));
+    REQUIRE(contains(visible, voxel::chunk_coord { 0, 0, 0 }));
+    // Every other rock chunk is entered from above and hides what's under it.
+    REQUIRE(visible.size() == 125);
+
+    // The predicate stops the traversal at chunks outside the view.
+    visible.clear();
+    graph.traverse(voxel::chunk_coord { 2, 4, 2 }, visible, [](const voxel::chunk_coord& c) { return c.x >= 2; });
+    for(const voxel::chunk_coord& c : visible)
+        REQUIRE(c.x >= 2);
+    REQUIRE_FALSE(contains(visible, voxel::chunk_coord { 1, 4, 2 }));
+}